@@ -10,6 +10,14 @@ struct AppSettings {
     wxString projectName;     // Project name
     wxString version;         // Version of the project
     wxString detectedDistro;  // Detected Linux distribution
+
+    // Squashfs build profile picked in SecondWindow (see BuildProfile), and
+    // the mksquashfs settings the last ISO was built with
+    wxString buildProfile;
+    wxString squashfsComp;
+    int squashfsLevel = 0;
+    wxString squashfsBlockSize;
+    int squashfsProcessors = 0;
 };
 
 #endif // APPSETTINGS_H
\ No newline at end of file
@@ -0,0 +1,245 @@
+#include "ArtifactDownloadThread.h"
+#include "DockerClient.h"
+#include "Sha256.h"
+#include <wx/file.h>
+#include <wx/filename.h>
+#include <vector>
+
+wxDEFINE_EVENT(ARTIFACT_DOWNLOAD_PROGRESS, wxCommandEvent);
+wxDEFINE_EVENT(ARTIFACT_DOWNLOAD_COMPLETE, wxCommandEvent);
+
+namespace
+{
+
+const size_t HASH_CHUNK_SIZE = 1024 * 1024;
+
+} // namespace
+
+ArtifactDownloadThread::ArtifactDownloadThread(wxEvtHandler *handler, const wxString &containerId,
+                                               const wxString &containerPath, const wxString &destDir,
+                                               const wxString &hostPath)
+    : wxThread(wxTHREAD_JOINABLE), m_handler(handler), m_containerId(containerId.Clone()),
+      m_containerPath(containerPath.Clone()), m_destDir(destDir.Clone()), m_hostPath(hostPath.Clone()),
+      m_cancel(false), m_lastPercent(-1)
+{
+}
+
+wxThread::ExitCode ArtifactDownloadThread::Entry()
+{
+    auto *result = new ArtifactDownloadResult();
+    const wxString name = wxFileName(m_containerPath, wxPATH_UNIX).GetFullName();
+    result->path = wxFileName(m_destDir, name).GetFullPath();
+    const wxString partPath = result->path + ".part";
+
+    bool ok;
+    if (!m_hostPath.IsEmpty() && wxFileExists(m_hostPath))
+    {
+        PostProgress(0, "Verifying " + name + "...");
+        ok = MoveHostFile(partPath, *result);
+    }
+    else
+    {
+        PostProgress(0, "Copying " + name + " from the container...");
+        ok = DockerClient::Get().IsApiAvailable() ? Download(partPath, *result) : CopyWithCli(partPath, *result);
+    }
+    if (ok)
+    {
+        // Replacing the previous artifact only once the new one is complete
+        // means an interrupted copy never leaves a truncated ISO behind
+        if (!wxRenameFile(partPath, result->path, true))
+        {
+            result->error = "Failed to move the download into place: " + result->path;
+        }
+        else
+        {
+            wxFile checksum;
+            if (!checksum.Create(result->path + ".sha256", true) ||
+                !checksum.Write(result->sha256 + "  " + name + "\n"))
+            {
+                wxLogWarning("Failed to write %s.sha256", result->path);
+            }
+        }
+    }
+    else if (m_cancel)
+    {
+        result->cancelled = true;
+    }
+    else if (result->error.IsEmpty())
+    {
+        result->error = "Failed to copy the ISO from the container";
+    }
+    if (!result->error.IsEmpty() || result->cancelled)
+    {
+        result->sha256.Clear();
+        if (wxFileExists(partPath))
+            wxRemoveFile(partPath);
+    }
+
+    wxCommandEvent event(ARTIFACT_DOWNLOAD_COMPLETE);
+    event.SetClientData(result);
+    wxQueueEvent(m_handler, event.Clone());
+    return (wxThread::ExitCode)0;
+}
+
+// Over the API the archive is unpacked, hashed and written in one pass
+bool ArtifactDownloadThread::Download(const wxString &partPath, ArtifactDownloadResult &result)
+{
+    wxFile out;
+    if (!out.Create(partPath, true))
+    {
+        result.error = "Cannot create " + partPath;
+        return false;
+    }
+
+    Sha256 hash;
+    std::uint64_t total = 0;
+    bool writeFailed = false;
+    DockerClient &docker = DockerClient::Get();
+    bool ok = docker.ReadFile(
+        m_containerId, m_containerPath,
+        [&total](std::uint64_t size)
+        { total = size; },
+        [&](const char *data, size_t size)
+        {
+            if (m_cancel || TestDestroy())
+                return false;
+            if (out.Write(data, size) != size)
+            {
+                writeFailed = true;
+                return false;
+            }
+            hash.Update(data, size);
+            result.size += size;
+            OnProgress("Copying", result.size, total);
+            return true;
+        },
+        &m_cancel);
+
+    if (ok && !out.Flush())
+        writeFailed = true;
+    out.Close();
+
+    if (writeFailed)
+        result.error = "Failed writing " + partPath;
+    else if (!ok && !m_cancel)
+        result.error = docker.GetLastError();
+    if (!ok || writeFailed)
+        return false;
+
+    result.sha256 = wxString::FromUTF8(hash.HexDigest().c_str());
+    return true;
+}
+
+// Without the API "docker cp" does the copy into a staging directory next
+// to the destination, and the file is hashed afterwards
+bool ArtifactDownloadThread::CopyWithCli(const wxString &partPath, ArtifactDownloadResult &result)
+{
+    const wxString name = wxFileName(m_containerPath, wxPATH_UNIX).GetFullName();
+    const wxString stagingDir = wxFileName(m_destDir, "." + name + ".download").GetFullPath();
+    wxFileName::Rmdir(stagingDir, wxPATH_RMDIR_RECURSIVE);
+    if (!wxFileName::Mkdir(stagingDir, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL))
+    {
+        result.error = "Cannot create " + stagingDir;
+        return false;
+    }
+
+    const wxString command = wxString::Format("docker cp \"%s:%s\" \"%s\"", m_containerId, m_containerPath, stagingDir);
+    wxString lastLine;
+    int exitCode = -1;
+    DockerClient &docker = DockerClient::Get();
+    bool ok = docker.StreamCommand(
+        command,
+        [&lastLine](int, const wxString &line)
+        { lastLine = line; },
+        exitCode, &m_cancel);
+    if (!ok)
+        result.error = m_cancel ? wxString() : docker.GetLastError();
+    else if (exitCode != 0)
+        result.error = lastLine.IsEmpty() ? wxString::Format("docker cp exited with %d", exitCode) : lastLine;
+    ok = ok && exitCode == 0;
+
+    const wxString stagedPath = wxFileName(stagingDir, name).GetFullPath();
+    ok = ok && HashFile(stagedPath, result);
+    if (ok && !wxRenameFile(stagedPath, partPath, true))
+    {
+        result.error = "Failed to move " + stagedPath;
+        ok = false;
+    }
+
+    wxFileName::Rmdir(stagingDir, wxPATH_RMDIR_RECURSIVE);
+    return ok;
+}
+
+// The container wrote the file straight into a host directory, so it only
+// needs hashing and moving into the destination
+bool ArtifactDownloadThread::MoveHostFile(const wxString &partPath, ArtifactDownloadResult &result)
+{
+    if (!HashFile(m_hostPath, result))
+        return false;
+    if (!wxRenameFile(m_hostPath, partPath, true))
+    {
+        result.error = "Failed to move " + m_hostPath;
+        return false;
+    }
+    return true;
+}
+
+// Sets result's size and checksum, reporting the progress as verifying
+bool ArtifactDownloadThread::HashFile(const wxString &path, ArtifactDownloadResult &result)
+{
+    wxFile in;
+    if (!in.Open(path))
+    {
+        result.error = "Cannot open " + path;
+        return false;
+    }
+
+    Sha256 hash;
+    const std::uint64_t total = static_cast<std::uint64_t>(in.Length());
+    std::vector<char> buffer(HASH_CHUNK_SIZE);
+    result.size = 0;
+    while (!m_cancel && !TestDestroy())
+    {
+        ssize_t count = in.Read(buffer.data(), buffer.size());
+        if (count == wxInvalidOffset)
+        {
+            result.error = "Failed reading " + path;
+            break;
+        }
+        if (count == 0)
+            break;
+        hash.Update(buffer.data(), static_cast<size_t>(count));
+        result.size += static_cast<std::uint64_t>(count);
+        OnProgress("Verifying", result.size, total);
+    }
+    in.Close();
+
+    if (result.error.IsEmpty() && !m_cancel && result.size != total)
+        result.error = "Short read of " + path;
+    if (!result.error.IsEmpty() || m_cancel)
+        return false;
+    result.sha256 = wxString::FromUTF8(hash.HexDigest().c_str());
+    return true;
+}
+
+// Only posts when the percentage changes, so a multi-gigabyte copy doesn't
+// flood the event queue
+void ArtifactDownloadThread::OnProgress(const char *action, std::uint64_t position, std::uint64_t total)
+{
+    int percent = total > 0 ? static_cast<int>(position * 100 / total) : 0;
+    if (percent != m_lastPercent)
+    {
+        m_lastPercent = percent;
+        PostProgress(percent, wxString::Format("%s ISO: %s of %s", action,
+                                               wxFileName::GetHumanReadableSize(wxULongLong(position)),
+                                               wxFileName::GetHumanReadableSize(wxULongLong(total))));
+    }
+}
+
+void ArtifactDownloadThread::PostProgress(int percent, const wxString &status)
+{
+    wxCommandEvent event(ARTIFACT_DOWNLOAD_PROGRESS);
+    event.SetInt(percent);
+    event.SetString(status);
+    wxQueueEvent(m_handler, event.Clone());
+}
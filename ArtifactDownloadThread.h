@@ -0,0 +1,62 @@
+#ifndef ARTIFACT_DOWNLOAD_THREAD_H
+#define ARTIFACT_DOWNLOAD_THREAD_H
+
+#include <wx/wx.h>
+#include <wx/thread.h>
+#include <atomic>
+#include <cstdint>
+#include "CustomEvents.h"
+
+// Carried by ARTIFACT_DOWNLOAD_COMPLETE as client data; the handler takes
+// ownership
+struct ArtifactDownloadResult
+{
+    wxString path;          // Where the file ends up on the host
+    wxString sha256;        // Lower-case hex, empty on failure
+    std::uint64_t size = 0;
+    bool cancelled = false;
+    wxString error;         // Empty on success
+};
+
+// Copies a file out of a container into a host directory off the GUI
+// thread, hashing it with SHA-256 as it streams. It is written under a
+// ".part" name and renamed into place once complete, with the checksum
+// next to it in sha256sum format ("<name>.sha256"). Posts
+// ARTIFACT_DOWNLOAD_PROGRESS with the percentage in GetInt() and a status
+// line in GetString(), then exactly one ARTIFACT_DOWNLOAD_COMPLETE.
+// Joinable: the owner must Wait() before deleting it.
+//
+// When the file lies in a directory bind-mounted from the host, hostPath
+// names it on the host: it is hashed and moved there instead of being
+// copied out of the container.
+class ArtifactDownloadThread : public wxThread
+{
+public:
+    ArtifactDownloadThread(wxEvtHandler *handler, const wxString &containerId,
+                           const wxString &containerPath, const wxString &destDir,
+                           const wxString &hostPath = wxEmptyString);
+
+    // Safe to call from the GUI thread at any time
+    void Cancel() { m_cancel = true; }
+
+protected:
+    virtual ExitCode Entry() override;
+
+private:
+    bool Download(const wxString &partPath, ArtifactDownloadResult &result);
+    bool CopyWithCli(const wxString &partPath, ArtifactDownloadResult &result);
+    bool MoveHostFile(const wxString &partPath, ArtifactDownloadResult &result);
+    bool HashFile(const wxString &path, ArtifactDownloadResult &result);
+    void OnProgress(const char *action, std::uint64_t position, std::uint64_t total);
+    void PostProgress(int percent, const wxString &status);
+
+    wxEvtHandler *m_handler;
+    wxString m_containerId;
+    wxString m_containerPath;
+    wxString m_destDir;
+    wxString m_hostPath;
+    std::atomic<bool> m_cancel;
+    int m_lastPercent;
+};
+
+#endif // ARTIFACT_DOWNLOAD_THREAD_H
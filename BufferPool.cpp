@@ -0,0 +1,59 @@
+#include "BufferPool.h"
+
+BufferPool::BufferPool(std::size_t count, std::size_t bufferSize)
+    : buffer_size(bufferSize) {
+    free_buffers.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        free_buffers.push_back(std::make_unique<std::vector<char>>(bufferSize));
+    }
+}
+
+BufferPool& BufferPool::shared() {
+    static BufferPool pool(DEFAULT_BUFFER_COUNT, DEFAULT_BUFFER_SIZE);
+    return pool;
+}
+
+BufferPool::Lease BufferPool::acquire() {
+    std::unique_lock<std::mutex> lock(mutex);
+    available.wait(lock, [this] { return !free_buffers.empty(); });
+    std::unique_ptr<std::vector<char>> buffer = std::move(free_buffers.back());
+    free_buffers.pop_back();
+    return Lease(this, std::move(buffer));
+}
+
+void BufferPool::giveBack(std::unique_ptr<std::vector<char>> buffer) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        free_buffers.push_back(std::move(buffer));
+    }
+    available.notify_one();
+}
+
+BufferPool::Lease::Lease(BufferPool* pool, std::unique_ptr<std::vector<char>> buffer)
+    : pool(pool), buffer(std::move(buffer)) {}
+
+BufferPool::Lease::Lease(Lease&& other) noexcept
+    : pool(other.pool), buffer(std::move(other.buffer)) {
+    other.pool = nullptr;
+}
+
+BufferPool::Lease& BufferPool::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        release();
+        pool = other.pool;
+        buffer = std::move(other.buffer);
+        other.pool = nullptr;
+    }
+    return *this;
+}
+
+BufferPool::Lease::~Lease() {
+    release();
+}
+
+void BufferPool::Lease::release() {
+    if (pool && buffer) {
+        pool->giveBack(std::move(buffer));
+    }
+    pool = nullptr;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Fixed set of equally sized buffers that readers borrow for streaming.
+// acquire() blocks while every buffer is out, which caps the memory used by
+// concurrent extractions at count * bufferSize no matter how large files are.
+class BufferPool {
+public:
+    // RAII handle; returns the buffer to the pool when destroyed
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+        ~Lease();
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        char* data() const { return buffer ? buffer->data() : nullptr; }
+        std::size_t size() const { return buffer ? buffer->size() : 0; }
+
+    private:
+        friend class BufferPool;
+        Lease(BufferPool* pool, std::unique_ptr<std::vector<char>> buffer);
+        void release();
+
+        BufferPool* pool = nullptr;
+        std::unique_ptr<std::vector<char>> buffer;
+    };
+
+    BufferPool(std::size_t count, std::size_t bufferSize);
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    Lease acquire();
+    std::size_t bufferSize() const { return buffer_size; }
+
+    // Pool used by ISOReader unless one is given explicitly
+    static BufferPool& shared();
+
+    static constexpr std::size_t DEFAULT_BUFFER_SIZE = 1024 * 1024;
+    static constexpr std::size_t DEFAULT_BUFFER_COUNT = 8;
+
+private:
+    void giveBack(std::unique_ptr<std::vector<char>> buffer);
+
+    std::size_t buffer_size;
+    std::mutex mutex;
+    std::condition_variable available;
+    std::vector<std::unique_ptr<std::vector<char>>> free_buffers;
+};
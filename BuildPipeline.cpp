@@ -0,0 +1,536 @@
+#include "BuildPipeline.h"
+#include "AppSettings.h"
+#include "DockerClient.h"
+#include "ScriptManager.h"
+#include "SettingsManager.h"
+#include <wx/file.h>
+#include <wx/filename.h>
+#include <wx/time.h>
+#include <thread>
+
+namespace
+{
+
+const char *const ISO_MOUNT_PATH = "/base.iso";
+const char *const DEFAULT_IMAGE = "ubuntu:latest";
+const char *const DEFAULT_FILESYSTEM = "casper/filesystem.squashfs";
+const char *const GUI_PREFIX = "Detected GUI environment:";
+
+// Written to the project directory and copied to the container's root
+const char *const SCRIPTS[] = {"setup_output.sh", "setup_chroot.sh", "install_packages.sh", "detect_gui.sh",
+                               "create_iso.sh"};
+
+// Stages of the chroot scripts, each building on the one before
+const char *const CHROOT_STAGES[] = {"iso_tree", "rootfs", "packages"};
+
+// Docker names match [a-zA-Z0-9][a-zA-Z0-9_.-]*
+wxString SanitizeContainerName(const wxString &name)
+{
+    wxString sanitized;
+    for (wxUniChar c : name)
+    {
+        const bool valid = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                           c == '_' || c == '.' || c == '-';
+        sanitized += valid ? c : wxUniChar('_');
+    }
+    if (sanitized.IsEmpty() || !wxIsalnum(sanitized[0]))
+        sanitized = "project_" + sanitized;
+    return sanitized.Left(64);
+}
+
+wxString AbsolutePath(const wxString &path)
+{
+    wxFileName name(path);
+    name.MakeAbsolute();
+    return name.GetFullPath();
+}
+
+} // namespace
+
+const char *const BuildPipeline::ISO_TREE_PATH = "/root/custom_iso";
+
+BuildPipeline::BuildPipeline(wxEvtHandler *handler, int id, const Options &options)
+    : wxThread(wxTHREAD_JOINABLE), m_handler(handler), m_id(id), m_cancel(false), m_abort(false),
+      m_useIsoTree(false), m_isoMounted(false), m_state(options.projectDir.Clone())
+{
+    m_options.projectDir = options.projectDir.Clone();
+    m_options.isoPath = options.isoPath.Clone();
+    m_options.isoTreeDir = options.isoTreeDir.Clone();
+    m_options.isoTreeComplete = options.isoTreeComplete;
+    m_options.selectedFs = options.selectedFs.Clone();
+    m_options.image = options.image.Clone();
+    m_options.pooledContainerId = options.pooledContainerId.Clone();
+}
+
+wxThread::ExitCode BuildPipeline::Entry()
+{
+    const long long start = wxGetUTCTimeMillis().GetValue();
+    PostEvent(BuildStage::Event::Started, "backend");
+    wxString error;
+    const bool ok = Run(error);
+    PostOutput(1, wxString::Format("Build container %s after %.1f s", ok ? "ready" : "failed",
+                                   (wxGetUTCTimeMillis().GetValue() - start) / 1000.0));
+    PostEvent(BuildStage::Event::Finished, "backend", ok, error);
+
+    wxCommandEvent event(DOCKER_EXEC_COMPLETE, m_id);
+    event.SetInt(ok ? 0 : -1);
+    event.SetExtraLong(m_cancel ? 1 : 0);
+    event.SetString(error);
+    wxQueueEvent(m_handler, event.Clone());
+    return (wxThread::ExitCode)0;
+}
+
+// The ISO upload only writes /base.iso while setup_output.sh installs the
+// tools, and the desktop is detected from files installing packages leaves
+// alone, so those pairs overlap
+bool BuildPipeline::Run(wxString &error)
+{
+    if (!wxFileExists(m_options.isoPath))
+    {
+        error = "ISO file not found: " + m_options.isoPath;
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        m_state.Load();
+    }
+
+    return RunStage("scripts", [this](wxString &message) { return WriteScripts(message); }, error) &&
+           RunStage("container", [this](wxString &message) { return SetUpContainer(message); }, error) &&
+           RunStage("copy", [this](wxString &message) { return CopyScripts(message); }, error) &&
+           RunConcurrently("iso_upload", [this](wxString &message) { return UploadIso(message); },
+                           "setup", [this](wxString &message) { return RunSetup(message); }, error) &&
+           RunStage("chroot", [this](wxString &message) { return RunChroot(message); }, error) &&
+           RunConcurrently("packages", [this](wxString &message) { return InstallPackages(message); },
+                           "gui", [this](wxString &message) { return DetectGui(message); }, error);
+}
+
+bool BuildPipeline::RunStage(const wxString &name, const Step &step, wxString &error)
+{
+    PostEvent(BuildStage::Event::Started, name);
+    wxString message;
+    const bool ok = !m_abort && step(message);
+    if (!ok && (m_cancel || message.IsEmpty()))
+        message = m_cancel ? wxString("Cancelled") : name + " failed";
+    PostEvent(BuildStage::Event::Finished, name, ok, message);
+    if (!ok)
+        error = message;
+    return ok;
+}
+
+bool BuildPipeline::RunConcurrently(const wxString &first, const Step &firstStep, const wxString &second,
+                                    const Step &secondStep, wxString &error)
+{
+    wxString secondError;
+    bool secondOk = false;
+    std::thread worker([&]()
+                       {
+                           secondOk = RunStage(second, secondStep, secondError);
+                           if (!secondOk)
+                               m_abort = true;
+                       });
+    const bool firstOk = RunStage(first, firstStep, error);
+    if (!firstOk)
+        m_abort = true;
+    worker.join();
+
+    // The stage that failed first is the one to report
+    if (firstOk && !secondOk)
+        error = secondError;
+    return firstOk && secondOk;
+}
+
+bool BuildPipeline::WriteScripts(wxString &message)
+{
+    AppSettings settings;
+    SettingsManager().LoadSettings(settings, wxFileName(m_options.projectDir, "settings.json").GetFullPath());
+    m_containerName = SanitizeContainerName(settings.projectName.IsEmpty() ? wxString("default_project")
+                                                                           : settings.projectName);
+
+    wxString selectedFs = m_options.selectedFs.IsEmpty() ? wxString(DEFAULT_FILESYSTEM) : m_options.selectedFs;
+    selectedFs.Replace("\\", "/");
+    m_useIsoTree = !m_options.isoTreeDir.IsEmpty() && wxDirExists(m_options.isoTreeDir);
+    if (!m_options.isoTreeDir.IsEmpty() && !m_useIsoTree)
+        PostOutput(2, "ISO tree not found at " + m_options.isoTreeDir + ", copying inside the container");
+
+    const std::map<wxString, wxString> values = {
+        {"SELECTED_FS", selectedFs},
+        {"ISO_TREE", m_useIsoTree ? (m_options.isoTreeComplete ? "2" : "1") : "0"},
+        {"INSTALL_TOOLS", m_options.image.IsEmpty() ? "1" : "0"}};
+    for (const char *name : SCRIPTS)
+    {
+        const wxString content = ScriptManager::Get().Render(name, values);
+        const wxString path = wxFileName(m_options.projectDir, name).GetFullPath();
+        wxFile file;
+        if (content.IsEmpty() || !file.Create(path, true) || !file.Write(content, wxConvUTF8))
+        {
+            message = "Could not write " + path;
+            return false;
+        }
+        m_scripts[name] = content;
+    }
+    return true;
+}
+
+// The container is reused while the image, the ISO and the tree the GUI
+// extracted are the same; the stages in it are keyed by its ID
+bool BuildPipeline::SetUpContainer(wxString &message)
+{
+    DockerClient &docker = DockerClient::Get();
+    const wxString image = m_options.image.IsEmpty() ? wxString(DEFAULT_IMAGE) : m_options.image;
+    m_isoFingerprint = PipelineState::Fingerprint(m_options.isoPath);
+
+    wxString containerKey;
+    PipelineState::Stage previous;
+    bool current;
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        wxString treeInput = "none";
+        bool treeKnown = true;
+        if (m_useIsoTree)
+        {
+            PipelineState::Stage extract;
+            treeKnown = m_state.Find("extract_iso", extract) && extract.outputs["tree"] == m_options.isoTreeDir;
+            treeInput = wxString::Format("%s:%s:%lld", m_options.isoTreeDir, extract.key, extract.finished);
+        }
+        if (treeKnown && !m_isoFingerprint.IsEmpty())
+            containerKey = PipelineState::Key({"container", image, m_isoFingerprint, treeInput, m_containerName});
+        current = m_state.IsCurrent("container", containerKey) && m_state.Find("container", previous);
+    }
+
+    DockerClient::ContainerInfo info;
+    bool resumed = false;
+    if (current && docker.InspectContainer(previous.outputs["id"], info))
+    {
+        if (!info.running)
+        {
+            PostOutput(1, "Starting container " + info.id.Left(12) + " again");
+            if (!docker.StartContainer(info.id) || !docker.InspectContainer(info.id, info))
+                info.running = false;
+        }
+        resumed = info.running;
+        if (!resumed)
+            PostOutput(2, "Container " + info.id.Left(12) + " is not running, creating a new one");
+    }
+    if (!resumed)
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        for (const char *name : {"container", "iso_copy", "setup"})
+            m_state.Invalidate(name);
+        for (const char *name : CHROOT_STAGES)
+            m_state.Invalidate(name);
+    }
+
+    bool pooled = false;
+    if (!resumed && !m_options.pooledContainerId.IsEmpty())
+    {
+        pooled = docker.InspectContainer(m_options.pooledContainerId, info) && info.running;
+        if (!pooled)
+            PostOutput(2, "Pooled container " + m_options.pooledContainerId.Left(12) +
+                              " is not running, creating a new one");
+    }
+
+    // A container of an earlier build may still hold the project's name
+    DockerClient::ContainerInfo old;
+    if (docker.InspectContainer(m_containerName, old) && (!(resumed || pooled) || old.id != info.id))
+    {
+        PostOutput(1, "Removing old container " + old.id.Left(12));
+        if (!docker.RemoveContainer(old.id, true, &m_abort))
+        {
+            message = "Could not remove the old container: " + docker.GetLastError();
+            return false;
+        }
+    }
+
+    if (resumed)
+    {
+        PostOutput(1, "Resuming the build in container " + info.id.Left(12));
+    }
+    else if (pooled)
+    {
+        // The pool created it with the ISO tree directory already mounted
+        PostOutput(1, "Using pooled container " + info.id.Left(12));
+        if (info.name != m_containerName && !docker.RenameContainer(info.id, m_containerName))
+            PostOutput(2, "Could not rename the pooled container: " + docker.GetLastError());
+    }
+    else
+    {
+        // The ISO is only read, so it's mounted read-only rather than copied
+        DockerClient::ContainerConfig config;
+        config.image = image;
+        config.name = m_containerName;
+        config.command.Add("sleep");
+        config.command.Add("infinity");
+        config.privileged = true;
+        config.binds.Add(AbsolutePath(m_options.isoPath) + ":" + ISO_MOUNT_PATH + ":ro");
+        if (m_useIsoTree)
+            config.binds.Add(AbsolutePath(m_options.isoTreeDir) + ":" + ISO_TREE_PATH);
+
+        PostOutput(1, "Creating new container from " + image);
+        wxString containerId;
+        if (!docker.CreateContainer(config, containerId) || !docker.StartContainer(containerId) ||
+            !docker.InspectContainer(containerId, info))
+        {
+            message = "Could not start the build container: " + docker.GetLastError();
+            return false;
+        }
+    }
+    if (!info.running)
+    {
+        message = "The build container stopped right after it started";
+        return false;
+    }
+
+    m_containerId = info.id;
+    m_isoMounted = info.mounts.Index(ISO_MOUNT_PATH) != wxNOT_FOUND;
+    if (!containerKey.IsEmpty() && !resumed)
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        m_state.Record("container", containerKey, {{"id", m_containerId}});
+    }
+
+    const wxString idPath = wxFileName(m_options.projectDir, "container_id.txt").GetFullPath();
+    wxFile idFile;
+    if (!idFile.Create(idPath, true) || !idFile.Write(m_containerId))
+        PostOutput(2, "Could not write " + idPath);
+    PostArtifact("container", "container", m_containerId);
+    if (resumed)
+        message = "Resumed from the last run";
+    return true;
+}
+
+bool BuildPipeline::CopyScripts(wxString &message)
+{
+    DockerClient &docker = DockerClient::Get();
+    wxArrayString chmod;
+    chmod.Add("chmod");
+    chmod.Add("+x");
+    for (const char *name : SCRIPTS)
+    {
+        const wxString target = wxString("/") + name;
+        if (!docker.CopyToContainer(m_containerId, wxFileName(m_options.projectDir, name).GetFullPath(), target,
+                                    nullptr, &m_abort))
+        {
+            message = wxString::Format("Could not copy %s to the container: %s", name, docker.GetLastError());
+            return false;
+        }
+        chmod.Add(target);
+    }
+
+    DockerClient::ExecResult result;
+    if (!docker.Exec(m_containerId, chmod, result) || result.exitCode != 0)
+    {
+        message = "Permission setup failed: " + (result.errors.IsEmpty() ? docker.GetLastError() : result.errors);
+        return false;
+    }
+    return true;
+}
+
+// Only needed when the ISO couldn't be bind-mounted, i.e. for a pooled
+// container that was started before the ISO was known, and even then not
+// once the host wrote the selected filesystem into the pooled tree
+bool BuildPipeline::UploadIso(wxString &message)
+{
+    if (m_isoMounted)
+    {
+        message = wxString::Format("Bind-mounted read-only at %s", ISO_MOUNT_PATH);
+        return true;
+    }
+    if (m_useIsoTree && m_options.isoTreeComplete)
+    {
+        message = "Not needed, the host extracted the whole tree";
+        return true;
+    }
+    const wxString key = m_isoFingerprint.IsEmpty()
+                             ? wxString()
+                             : PipelineState::Key({"iso_copy", m_containerId, m_isoFingerprint});
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        if (m_state.IsCurrent("iso_copy", key))
+        {
+            message = "Copied to the container by the last run";
+            return true;
+        }
+    }
+
+    int lastPercent = -1;
+    auto onProgress = [this, &lastPercent](std::uint64_t sent, std::uint64_t size)
+    {
+        const int percent = size > 0 ? static_cast<int>(sent * 100 / size) : 100;
+        if (percent == lastPercent)
+            return;
+        lastPercent = percent;
+        BuildStage stage;
+        stage.event = BuildStage::Event::Progress;
+        stage.stage = "iso_upload";
+        stage.percent = percent;
+        PostStage(stage);
+    };
+    if (!DockerClient::Get().CopyToContainer(m_containerId, m_options.isoPath, ISO_MOUNT_PATH, onProgress, &m_abort))
+    {
+        message = "Failed to copy the ISO to the container: " + DockerClient::Get().GetLastError();
+        return false;
+    }
+    if (!key.IsEmpty())
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        m_state.Record("iso_copy", key, {});
+    }
+    return true;
+}
+
+bool BuildPipeline::RunSetup(wxString &message)
+{
+    const wxString key =
+        PipelineState::Key({"setup", m_containerId, PipelineState::Key({m_scripts["setup_output.sh"]})});
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        if (m_state.IsCurrent("setup", key))
+        {
+            message = "Unchanged since the last run";
+            return true;
+        }
+    }
+
+    wxArrayString command;
+    command.Add("/setup_output.sh");
+    if (!ExecScript(command, message))
+        return false;
+    std::lock_guard<std::mutex> lock(m_stateMutex);
+    m_state.Record("setup", key, {});
+    return true;
+}
+
+// Works out which of the chroot stages needn't run again. Once one has to
+// run, every later one does, since it builds on it.
+bool BuildPipeline::RunChroot(wxString &message)
+{
+    wxString key = PipelineState::Key(
+        {m_containerId, m_isoFingerprint, m_useIsoTree ? m_options.isoTreeDir : wxString(),
+         PipelineState::Key({m_scripts["setup_chroot.sh"], m_scripts["install_packages.sh"]})});
+    wxArrayString done;
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        for (const char *name : CHROOT_STAGES)
+        {
+            key = PipelineState::Key({name, key});
+            m_chrootKeys[name] = key;
+            if (done.size() + 1 == m_chrootKeys.size() && m_state.IsCurrent(name, key))
+                done.Add(name);
+        }
+        for (const char *name : CHROOT_STAGES)
+        {
+            if (done.Index(name) == wxNOT_FOUND)
+                m_state.Invalidate(name);
+        }
+    }
+    m_doneStages = wxJoin(done, ' ', '\0');
+    if (!done.IsEmpty())
+        PostOutput(1, "Skipping the chroot stages done by the last run: " + wxJoin(done, ',', '\0'));
+
+    return ExecScript(ChrootCommand("/setup_chroot.sh"), message);
+}
+
+bool BuildPipeline::InstallPackages(wxString &message)
+{
+    return ExecScript(ChrootCommand("/install_packages.sh"), message);
+}
+
+bool BuildPipeline::DetectGui(wxString &message)
+{
+    wxArrayString command;
+    command.Add("/detect_gui.sh");
+    return ExecScript(command, message);
+}
+
+bool BuildPipeline::ExecScript(const wxArrayString &command, wxString &message)
+{
+    int exitCode = -1;
+    auto onLine = [this](int stream, const wxString &line) { OnScriptLine(stream, line); };
+    if (!DockerClient::Get().ExecStream(m_containerId, command, onLine, exitCode, &m_abort))
+    {
+        message = DockerClient::Get().GetLastError();
+        return false;
+    }
+    if (exitCode != 0)
+    {
+        message = wxString::Format("%s exited with %d", command.Last(), exitCode);
+        return false;
+    }
+    return true;
+}
+
+// The stages to skip and the keys to report are passed in the environment
+wxArrayString BuildPipeline::ChrootCommand(const wxString &script) const
+{
+    wxArrayString command;
+    command.Add("env");
+    command.Add("DONE_STAGES=" + m_doneStages);
+    for (const auto &key : m_chrootKeys)
+        command.Add("KEY_" + key.first + "=" + key.second);
+    command.Add(script);
+    return command;
+}
+
+// Called on the thread of the exec that printed the line
+void BuildPipeline::OnScriptLine(int stream, const wxString &line)
+{
+    BuildStage stage;
+    if (stream == 1 && BuildStage::Parse(line, stage))
+    {
+        if (stage.event != BuildStage::Event::Artifact || stage.kind != "checkpoint")
+        {
+            PostStage(stage);
+            return;
+        }
+        auto it = m_chrootKeys.find(stage.stage);
+        if (it != m_chrootKeys.end() && it->second == stage.value)
+        {
+            std::lock_guard<std::mutex> lock(m_stateMutex);
+            m_state.Record(stage.stage, stage.value, {{"container", m_containerId}});
+        }
+        return;
+    }
+
+    wxString gui;
+    if (stream == 1 && line.StartsWith(GUI_PREFIX, &gui))
+        PostArtifact("gui", "gui", gui.Trim(true).Trim(false));
+    PostOutput(stream, line);
+}
+
+void BuildPipeline::PostStage(BuildStage stage)
+{
+    if (stage.timestamp == 0)
+        stage.timestamp = wxGetUTCTimeMillis().GetValue();
+    wxCommandEvent event(BUILD_STAGE, m_id);
+    event.SetClientData(new BuildStage(stage));
+    wxQueueEvent(m_handler, event.Clone());
+}
+
+void BuildPipeline::PostEvent(BuildStage::Event type, const wxString &stage, bool ok, const wxString &message)
+{
+    BuildStage event;
+    event.event = type;
+    event.stage = stage;
+    event.ok = ok;
+    event.message = message;
+    PostStage(event);
+}
+
+void BuildPipeline::PostArtifact(const wxString &stage, const wxString &kind, const wxString &value)
+{
+    BuildStage event;
+    event.event = BuildStage::Event::Artifact;
+    event.stage = stage;
+    event.kind = kind;
+    event.value = value;
+    PostStage(event);
+}
+
+void BuildPipeline::PostOutput(int stream, const wxString &line)
+{
+    wxCommandEvent event(DOCKER_EXEC_OUTPUT, m_id);
+    event.SetInt(stream);
+    event.SetString(line);
+    wxQueueEvent(m_handler, event.Clone());
+}
@@ -0,0 +1,109 @@
+#ifndef BUILD_PIPELINE_H
+#define BUILD_PIPELINE_H
+
+#include <wx/wx.h>
+#include <wx/thread.h>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include "BuildStage.h"
+#include "CustomEvents.h"
+#include "PipelineState.h"
+
+// Sets up a project's build container off the GUI thread: writes the
+// scripts ScriptManager embeds, creates or resumes the container, copies
+// the ISO and the scripts in and prepares the chroot, checkpointing each
+// stage in the project's PipelineState. Stages that don't depend on each
+// other run at the same time.
+//
+// Posts BUILD_STAGE for every stage event, its own and those of the
+// scripts (see BuildStage), DOCKER_EXEC_OUTPUT per line of output with the
+// stream in GetInt(), then exactly one DOCKER_EXEC_COMPLETE: GetInt() is 0
+// once the container is ready and -1 otherwise, with the error in
+// GetString() and GetExtraLong() 1 on cancel. All carry the id given to the
+// constructor. Joinable: the owner must Wait() before deleting it.
+class BuildPipeline : public wxThread
+{
+public:
+    struct Options
+    {
+        wxString projectDir;
+        wxString isoPath;
+        wxString isoTreeDir;        // Extracted on the host, bind-mounted; may be empty
+        bool isoTreeComplete = false; // The tree holds the selected filesystem too
+        wxString selectedFs;        // Filesystem of the chroot, inside the ISO
+        wxString image;             // Builder image, empty for a plain Ubuntu
+        wxString pooledContainerId; // Running idle container to use, if any
+    };
+
+    // Where Options::isoTreeDir is bind-mounted in the container
+    static const char *const ISO_TREE_PATH;
+
+    BuildPipeline(wxEvtHandler *handler, int id, const Options &options);
+
+    // Safe to call from the GUI thread at any time. The command running in
+    // the container at the time keeps running.
+    void Cancel()
+    {
+        m_cancel = true;
+        m_abort = true;
+    }
+
+protected:
+    virtual ExitCode Entry() override;
+
+private:
+    using Step = std::function<bool(wxString &message)>;
+
+    bool Run(wxString &error);
+    // Brackets a step with its stage events. The step returns false with
+    // the reason in message; on success message is an optional note.
+    bool RunStage(const wxString &name, const Step &step, wxString &error);
+    // Runs the second stage on a thread of its own meanwhile; a failure of
+    // either aborts the other
+    bool RunConcurrently(const wxString &first, const Step &firstStep, const wxString &second,
+                         const Step &secondStep, wxString &error);
+
+    bool WriteScripts(wxString &message);
+    bool SetUpContainer(wxString &message);
+    bool CopyScripts(wxString &message);
+    bool UploadIso(wxString &message);
+    bool RunSetup(wxString &message);
+    bool RunChroot(wxString &message);
+    bool InstallPackages(wxString &message);
+    bool DetectGui(wxString &message);
+
+    bool ExecScript(const wxArrayString &command, wxString &message);
+    // setup_chroot.sh and install_packages.sh with their checkpoint keys
+    wxArrayString ChrootCommand(const wxString &script) const;
+    void OnScriptLine(int stream, const wxString &line);
+
+    void PostStage(BuildStage stage);
+    void PostEvent(BuildStage::Event type, const wxString &stage, bool ok = true,
+                   const wxString &message = wxEmptyString);
+    void PostArtifact(const wxString &stage, const wxString &kind, const wxString &value);
+    void PostOutput(int stream, const wxString &line);
+
+    wxEvtHandler *m_handler;
+    int m_id;
+    Options m_options;
+    std::atomic<bool> m_cancel;
+    std::atomic<bool> m_abort;    // Stops the transfers and execs in progress
+
+    // Worked out by the stages, in order
+    wxString m_containerName;
+    bool m_useIsoTree;
+    std::map<wxString, wxString> m_scripts;    // Name to content
+    wxString m_isoFingerprint;
+    wxString m_containerId;
+    bool m_isoMounted;
+    std::map<wxString, wxString> m_chrootKeys;
+    wxString m_doneStages;
+
+    // Stages running at the same time checkpoint through it
+    PipelineState m_state;
+    std::mutex m_stateMutex;
+};
+
+#endif // BUILD_PIPELINE_H
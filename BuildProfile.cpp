@@ -0,0 +1,70 @@
+#include "BuildProfile.h"
+#include <wx/thread.h>
+
+namespace {
+
+int ProcessorCount() {
+    int count = wxThread::GetCPUCount();
+    return count > 0 ? count : 1;
+}
+
+} // namespace
+
+const char* const BuildProfile::DEFAULT_NAME = "release";
+
+// zstd at level 1 compresses several times faster than xz and still
+// decompresses quickly at boot; the larger blocks give the threads more
+// work per task
+BuildProfile BuildProfile::Dev() {
+    BuildProfile profile;
+    profile.name = "dev";
+    profile.delta = true;
+    profile.compressor = "zstd";
+    profile.level = 1;
+    profile.blockSize = "1M";
+    profile.processors = ProcessorCount();
+    return profile;
+}
+
+BuildProfile BuildProfile::Release() {
+    BuildProfile profile;
+    profile.name = "release";
+    profile.compressor = "xz";
+    profile.blockSize = "1M";
+    profile.processors = ProcessorCount();
+    return profile;
+}
+
+BuildProfile BuildProfile::FromName(const wxString& name) {
+    if (name == "dev") {
+        return Dev();
+    }
+    return Release();
+}
+
+wxArrayString BuildProfile::CreateIsoArgs() const {
+    wxArrayString args;
+    if (delta) {
+        args.Add("--delta");
+    }
+    args.Add("-comp");
+    args.Add(compressor);
+    if (level > 0) {
+        args.Add("-Xcompression-level");
+        args.Add(wxString::Format("%d", level));
+    }
+    args.Add("-b");
+    args.Add(blockSize);
+    args.Add("-processors");
+    args.Add(wxString::Format("%d", processors));
+    return args;
+}
+
+wxString BuildProfile::Describe() const {
+    wxString text = name + ": " + compressor;
+    if (level > 0) {
+        text += wxString::Format(" -%d", level);
+    }
+    text += wxString::Format(", %s blocks, %d threads", blockSize, processors);
+    return delta ? text + ", changes only" : text;
+}
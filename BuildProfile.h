@@ -0,0 +1,31 @@
+#ifndef BUILD_PROFILE_H
+#define BUILD_PROFILE_H
+
+#include <wx/string.h>
+#include <wx/arrstr.h>
+
+// How create_iso.sh rebuilds the squashfs. "dev" trades size for speed in
+// the edit-and-boot loop and only packs the changes made in the chroot
+// when the ISO can layer them; "release" makes the smallest single image.
+// Both use every core.
+struct BuildProfile {
+    wxString name;          // "dev" or "release"
+    bool delta = false;     // create_iso.sh --delta
+    wxString compressor;    // mksquashfs -comp
+    int level = 0;          // -Xcompression-level, 0 for the compressor's default
+    wxString blockSize;     // mksquashfs -b
+    int processors = 0;     // mksquashfs -processors
+
+    static const char* const DEFAULT_NAME;
+
+    static BuildProfile Dev();
+    static BuildProfile Release();
+    // Unknown names get the default profile
+    static BuildProfile FromName(const wxString& name);
+
+    // Arguments for create_iso.sh: --delta, then the mksquashfs options
+    wxArrayString CreateIsoArgs() const;
+    wxString Describe() const;
+};
+
+#endif // BUILD_PROFILE_H
@@ -0,0 +1,65 @@
+#include "BuildStage.h"
+#include <rapidjson/document.h>
+
+namespace
+{
+
+const char PREFIX[] = "@@STAGE ";
+
+wxString GetString(const rapidjson::Value &object, const char *name)
+{
+    auto member = object.FindMember(name);
+    if (member == object.MemberEnd() || !member->value.IsString())
+        return wxEmptyString;
+    return wxString::FromUTF8(member->value.GetString(), member->value.GetStringLength());
+}
+
+long long GetNumber(const rapidjson::Value &object, const char *name, long long fallback)
+{
+    auto member = object.FindMember(name);
+    if (member == object.MemberEnd() || !member->value.IsNumber())
+        return fallback;
+    return member->value.IsInt64() ? member->value.GetInt64() : static_cast<long long>(member->value.GetDouble());
+}
+
+} // namespace
+
+bool BuildStage::Parse(const wxString &line, BuildStage &stage)
+{
+    if (!line.StartsWith(PREFIX))
+        return false;
+
+    const wxScopedCharBuffer json = line.Mid(sizeof(PREFIX) - 1).utf8_str();
+    rapidjson::Document doc;
+    doc.Parse(json.data(), json.length());
+    if (doc.HasParseError() || !doc.IsObject())
+        return false;
+
+    const wxString event = GetString(doc, "event");
+    if (event == "started")
+        stage.event = Event::Started;
+    else if (event == "progress")
+        stage.event = Event::Progress;
+    else if (event == "finished")
+        stage.event = Event::Finished;
+    else if (event == "artifact")
+        stage.event = Event::Artifact;
+    else
+        return false;
+
+    stage.stage = GetString(doc, "stage");
+    stage.message = GetString(doc, "message");
+    stage.kind = GetString(doc, "kind");
+    stage.value = GetString(doc, "value");
+    if (doc.HasMember("percent") && doc["percent"].IsNumber())
+        stage.percent = static_cast<int>(doc["percent"].GetDouble());
+    if (doc.HasMember("ok") && doc["ok"].IsBool())
+        stage.ok = doc["ok"].GetBool();
+    stage.timestamp = GetNumber(doc, "ts_ms", 0);
+    stage.startTime = GetNumber(doc, "start_ms", 0);
+    stage.cpuMs = GetNumber(doc, "cpu_ms", -1);
+    stage.peakRssKb = GetNumber(doc, "peak_rss_kb", -1);
+    stage.readBytes = GetNumber(doc, "read_bytes", -1);
+    stage.writtenBytes = GetNumber(doc, "written_bytes", -1);
+    return !stage.stage.IsEmpty();
+}
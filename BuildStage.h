@@ -0,0 +1,44 @@
+#ifndef BUILD_STAGE_H
+#define BUILD_STAGE_H
+
+#include <wx/string.h>
+
+// One event of the build pipeline's stage stream. BuildPipeline makes them
+// for its own stages; the scripts it runs in the container print them on
+// stdout, between their ordinary output, as
+//   @@STAGE {"event": "started", "stage": "chroot"}
+// BuildPipeline and DockerExecThread post each as BUILD_STAGE with a
+// BuildStage as client data; the handler takes ownership.
+struct BuildStage
+{
+    enum class Event
+    {
+        Started,
+        Progress,
+        Finished,
+        Artifact
+    };
+
+    Event event = Event::Started;
+    wxString stage;
+    int percent = -1;    // Progress
+    bool ok = true;      // Finished
+    wxString message;    // Progress, or Finished on failure
+    wxString kind;       // Artifact: "container", "gui" or "iso"
+    wxString value;      // Artifact: container ID, desktop name or path
+
+    // Milliseconds since the epoch; 0 when the line had none
+    long long timestamp = 0;
+    long long startTime = 0; // Finished, the matching start
+
+    // Measured cost of a finished stage, -1 if unknown
+    long long cpuMs = -1;
+    long long peakRssKb = -1;
+    long long readBytes = -1;
+    long long writtenBytes = -1;
+
+    // Returns false if the line isn't a stage line
+    static bool Parse(const wxString &line, BuildStage &stage);
+};
+
+#endif // BUILD_STAGE_H
@@ -0,0 +1,220 @@
+#include "BuildTimeline.h"
+#include <wx/datetime.h>
+#include <wx/file.h>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+#include <wx/log.h>
+#include <wx/time.h>
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+#include <algorithm>
+
+namespace
+{
+
+using JsonWriter = rapidjson::PrettyWriter<rapidjson::StringBuffer>;
+
+void WriteString(JsonWriter &writer, const char *key, const wxString &value)
+{
+    const wxScopedCharBuffer utf8 = value.utf8_str();
+    writer.Key(key);
+    writer.String(utf8.data(), static_cast<rapidjson::SizeType>(utf8.length()));
+}
+
+void WriteMeasure(JsonWriter &writer, const char *key, long long value)
+{
+    if (value < 0)
+        return;
+    writer.Key(key);
+    writer.Int64(value);
+}
+
+// A span that only wraps stages of its own group, such as the backend's
+// "chroot" around the flatpak install, isn't a bottleneck by itself
+bool ContainsOther(const std::vector<BuildTimeline::Span> &spans, size_t index)
+{
+    const BuildTimeline::Span &outer = spans[index];
+    for (size_t i = 0; i < spans.size(); ++i)
+    {
+        const BuildTimeline::Span &inner = spans[i];
+        if (i != index && inner.group == outer.group && inner.end != 0 &&
+            inner.start >= outer.start && inner.end <= outer.end)
+            return true;
+    }
+    return false;
+}
+
+} // namespace
+
+BuildTimeline::BuildTimeline(const wxString &path) : m_path(path)
+{
+}
+
+wxString BuildTimeline::NewPath(const wxString &projectDir)
+{
+    wxFileName path(projectDir, wxDateTime::Now().Format("build-%Y%m%d-%H%M%S.json"));
+    path.AppendDir("build_timelines");
+    return path.GetFullPath();
+}
+
+void BuildTimeline::Begin(const wxString &group, const wxString &stage)
+{
+    Span span;
+    span.group = group;
+    span.stage = stage;
+    span.start = wxGetUTCTimeMillis().GetValue();
+    m_spans.push_back(span);
+}
+
+void BuildTimeline::End(const wxString &group, const wxString &stage, bool ok, const wxString &message)
+{
+    BuildStage event;
+    event.event = BuildStage::Event::Finished;
+    event.stage = stage;
+    event.ok = ok;
+    event.message = message;
+    Record(group, event);
+}
+
+void BuildTimeline::Record(const wxString &group, const BuildStage &event)
+{
+    const long long now = wxGetUTCTimeMillis().GetValue();
+    const long long timestamp = event.timestamp > 0 ? event.timestamp : now;
+
+    if (event.event == BuildStage::Event::Started)
+    {
+        Span span;
+        span.group = group;
+        span.stage = event.stage;
+        span.start = timestamp;
+        m_spans.push_back(span);
+        return;
+    }
+    if (event.event != BuildStage::Event::Finished)
+        return;
+
+    Span *span = FindRunning(group, event.stage);
+    if (!span)
+    {
+        // Only the end was reported
+        m_spans.emplace_back();
+        span = &m_spans.back();
+        span->group = group;
+        span->stage = event.stage;
+        span->start = event.startTime > 0 ? event.startTime : timestamp;
+    }
+    span->end = std::max(timestamp, span->start);
+    span->ok = event.ok;
+    span->message = event.message;
+    span->cpuMs = event.cpuMs;
+    span->peakRssKb = event.peakRssKb;
+    span->readBytes = event.readBytes;
+    span->writtenBytes = event.writtenBytes;
+}
+
+BuildTimeline::Span *BuildTimeline::FindRunning(const wxString &group, const wxString &stage)
+{
+    for (auto it = m_spans.rbegin(); it != m_spans.rend(); ++it)
+    {
+        if (it->end == 0 && it->group == group && it->stage == stage)
+            return &*it;
+    }
+    return nullptr;
+}
+
+int BuildTimeline::GetBottleneck() const
+{
+    int bottleneck = -1;
+    long long longest = -1;
+    for (size_t i = 0; i < m_spans.size(); ++i)
+    {
+        const Span &span = m_spans[i];
+        if (span.end == 0 || ContainsOther(m_spans, i))
+            continue;
+        if (span.end - span.start > longest)
+        {
+            longest = span.end - span.start;
+            bottleneck = static_cast<int>(i);
+        }
+    }
+    return bottleneck;
+}
+
+bool BuildTimeline::Save() const
+{
+    rapidjson::StringBuffer buffer;
+    JsonWriter writer(buffer);
+    writer.SetIndent(' ', 4);
+    writer.StartObject();
+
+    long long started = 0;
+    long long finished = 0;
+    for (const Span &span : m_spans)
+    {
+        started = started == 0 ? span.start : std::min(started, span.start);
+        finished = std::max(finished, span.end);
+    }
+    writer.Key("started_ms");
+    writer.Int64(started);
+    writer.Key("finished_ms");
+    writer.Int64(finished);
+
+    const int bottleneck = GetBottleneck();
+    if (bottleneck >= 0)
+    {
+        const Span &span = m_spans[bottleneck];
+        writer.Key("bottleneck");
+        writer.StartObject();
+        WriteString(writer, "group", span.group);
+        WriteString(writer, "stage", span.stage);
+        writer.Key("duration_ms");
+        writer.Int64(span.end - span.start);
+        writer.EndObject();
+    }
+
+    writer.Key("stages");
+    writer.StartArray();
+    for (const Span &span : m_spans)
+    {
+        writer.StartObject();
+        WriteString(writer, "group", span.group);
+        WriteString(writer, "stage", span.stage);
+        writer.Key("start_ms");
+        writer.Int64(span.start);
+        if (span.end != 0)
+        {
+            writer.Key("end_ms");
+            writer.Int64(span.end);
+            writer.Key("duration_ms");
+            writer.Int64(span.end - span.start);
+            writer.Key("ok");
+            writer.Bool(span.ok);
+        }
+        if (!span.message.IsEmpty())
+            WriteString(writer, "message", span.message);
+        WriteMeasure(writer, "cpu_ms", span.cpuMs);
+        WriteMeasure(writer, "peak_rss_kb", span.peakRssKb);
+        WriteMeasure(writer, "read_bytes", span.readBytes);
+        WriteMeasure(writer, "written_bytes", span.writtenBytes);
+        writer.EndObject();
+    }
+    writer.EndArray();
+    writer.EndObject();
+
+    wxFileName::Mkdir(wxFileName(m_path).GetPath(), wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+    const wxString tempPath = m_path + ".tmp";
+    wxFile file;
+    if (!file.Create(tempPath, true) || file.Write(buffer.GetString(), buffer.GetSize()) != buffer.GetSize() ||
+        !file.Close())
+    {
+        wxLogDebug("Could not write the build timeline to %s", tempPath);
+        wxRemoveFile(tempPath);
+        return false;
+    }
+    if (!wxRenameFile(tempPath, m_path, true))
+    {
+        wxRemoveFile(tempPath);
+        return false;
+    }
+    return true;
+}
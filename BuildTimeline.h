@@ -0,0 +1,55 @@
+#ifndef BUILD_TIMELINE_H
+#define BUILD_TIMELINE_H
+
+#include <wx/string.h>
+#include <vector>
+#include "BuildStage.h"
+
+// When each stage of a build ran and what it cost, gathered from the
+// host-side steps and the stage lines of the backend and create_iso.sh.
+// The owner saves it as a JSON timeline in the project directory, which
+// also names the bottleneck: the longest stage that doesn't just wrap
+// others.
+class BuildTimeline
+{
+public:
+    struct Span
+    {
+        wxString group;          // "host", "backend", "iso 1", ...
+        wxString stage;
+        long long start = 0;     // Milliseconds since the epoch
+        long long end = 0;       // 0 while running
+        bool ok = true;
+        wxString message;
+        long long cpuMs = -1;    // -1 if not measured
+        long long peakRssKb = -1;
+        long long readBytes = -1;
+        long long writtenBytes = -1;
+    };
+
+    explicit BuildTimeline(const wxString &path);
+
+    // <projectDir>/build_timelines/build-<local time>.json
+    static wxString NewPath(const wxString &projectDir);
+
+    void Begin(const wxString &group, const wxString &stage);
+    void End(const wxString &group, const wxString &stage, bool ok, const wxString &message = wxEmptyString);
+    // Takes Started and Finished events and ignores the rest
+    void Record(const wxString &group, const BuildStage &event);
+
+    const std::vector<Span> &GetSpans() const { return m_spans; }
+    // Index into GetSpans(), -1 while no stage has finished
+    int GetBottleneck() const;
+    const wxString &GetPath() const { return m_path; }
+
+    // Replaces the file as a whole, so readers never see half of it
+    bool Save() const;
+
+private:
+    Span *FindRunning(const wxString &group, const wxString &stage);
+
+    wxString m_path;
+    std::vector<Span> m_spans;
+};
+
+#endif // BUILD_TIMELINE_H
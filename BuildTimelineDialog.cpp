@@ -0,0 +1,175 @@
+#include "BuildTimelineDialog.h"
+#include <wx/dcbuffer.h>
+#include <wx/filename.h>
+#include <wx/scrolwin.h>
+#include <wx/time.h>
+#include <algorithm>
+
+namespace
+{
+
+const int ROW_HEIGHT = 24;
+const int LABEL_WIDTH = 190;
+const int DETAILS_WIDTH = 330;
+const int MARGIN = 8;
+
+const wxColour BACKGROUND(30, 30, 30);
+const wxColour TEXT(220, 220, 220);
+const wxColour DIM_TEXT(156, 163, 175);
+const wxColour BAR_OK(80, 160, 120);
+const wxColour BAR_FAILED(220, 80, 80);
+const wxColour BAR_RUNNING(100, 140, 220);
+const wxColour BAR_BOTTLENECK(240, 170, 60);
+
+wxString FormatDuration(long long ms)
+{
+    if (ms < 1000)
+        return wxString::Format("%lld ms", ms);
+    if (ms < 60000)
+        return wxString::Format("%.1f s", ms / 1000.0);
+    return wxString::Format("%lld:%02lld min", ms / 60000, (ms / 1000) % 60);
+}
+
+wxString FormatBytes(long long bytes)
+{
+    return wxFileName::GetHumanReadableSize(wxULongLong(static_cast<unsigned long long>(bytes)), "0 B");
+}
+
+} // namespace
+
+// The rows of the waterfall, scrolled vertically when there are many
+class WaterfallCanvas : public wxScrolledWindow
+{
+public:
+    WaterfallCanvas(wxWindow *parent, const BuildTimeline &timeline)
+        : wxScrolledWindow(parent, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxVSCROLL),
+          m_timeline(timeline)
+    {
+        SetBackgroundStyle(wxBG_STYLE_PAINT);
+        SetBackgroundColour(BACKGROUND);
+        SetScrollRate(0, ROW_HEIGHT);
+        Bind(wxEVT_PAINT, &WaterfallCanvas::OnPaint, this);
+        Bind(wxEVT_SIZE, [this](wxSizeEvent &event)
+             {
+                 Refresh();
+                 event.Skip();
+             });
+        UpdateVirtualSize();
+    }
+
+    void UpdateVirtualSize()
+    {
+        SetVirtualSize(-1, static_cast<int>(m_timeline.GetSpans().size()) * ROW_HEIGHT + 2 * MARGIN);
+        Refresh();
+    }
+
+private:
+    void OnPaint(wxPaintEvent &)
+    {
+        wxAutoBufferedPaintDC dc(this);
+        DoPrepareDC(dc);
+        dc.SetBackground(wxBrush(BACKGROUND));
+        dc.Clear();
+
+        const auto &spans = m_timeline.GetSpans();
+        if (spans.empty())
+            return;
+
+        // Running stages extend to now
+        const long long now = wxGetUTCTimeMillis().GetValue();
+        long long first = spans.front().start;
+        long long last = first;
+        for (const auto &span : spans)
+        {
+            first = std::min(first, span.start);
+            last = std::max(last, span.end != 0 ? span.end : now);
+        }
+        const double total = static_cast<double>(std::max(last - first, 1LL));
+
+        const int width = GetClientSize().GetWidth();
+        const int barLeft = LABEL_WIDTH;
+        const int barWidth = std::max(width - LABEL_WIDTH - DETAILS_WIDTH - 2 * MARGIN, 20);
+        const int bottleneck = m_timeline.GetBottleneck();
+
+        dc.SetFont(GetFont());
+        for (size_t i = 0; i < spans.size(); ++i)
+        {
+            const auto &span = spans[i];
+            const int y = MARGIN + static_cast<int>(i) * ROW_HEIGHT;
+            const long long end = span.end != 0 ? span.end : now;
+
+            dc.SetTextForeground(DIM_TEXT);
+            dc.DrawText(span.group, MARGIN, y + 4);
+            dc.SetTextForeground(TEXT);
+            dc.DrawText(span.stage, MARGIN + 70, y + 4);
+
+            wxColour colour = span.end == 0 ? BAR_RUNNING : (span.ok ? BAR_OK : BAR_FAILED);
+            if (static_cast<int>(i) == bottleneck)
+                colour = BAR_BOTTLENECK;
+            const int x = barLeft + static_cast<int>((span.start - first) / total * barWidth);
+            const int w = std::max(static_cast<int>((end - span.start) / total * barWidth), 2);
+            dc.SetBrush(wxBrush(colour));
+            dc.SetPen(*wxTRANSPARENT_PEN);
+            dc.DrawRectangle(x, y + 4, w, ROW_HEIGHT - 8);
+
+            wxString details = FormatDuration(end - span.start);
+            if (span.cpuMs >= 0)
+                details += "  cpu " + FormatDuration(span.cpuMs);
+            if (span.readBytes >= 0)
+                details += "  rd " + FormatBytes(span.readBytes);
+            if (span.writtenBytes >= 0)
+                details += "  wr " + FormatBytes(span.writtenBytes);
+            if (span.peakRssKb >= 0)
+                details += "  rss " + FormatBytes(span.peakRssKb * 1024);
+            dc.SetTextForeground(span.ok ? TEXT : BAR_FAILED);
+            dc.DrawText(details, barLeft + barWidth + MARGIN, y + 4);
+        }
+    }
+
+    const BuildTimeline &m_timeline;
+};
+
+BuildTimelineDialog::BuildTimelineDialog(wxWindow *parent, const BuildTimeline &timeline)
+    : wxDialog(parent, wxID_ANY, "Build Timeline", wxDefaultPosition, wxSize(900, 420),
+               wxDEFAULT_DIALOG_STYLE | wxRESIZE_BORDER),
+      m_timeline(timeline)
+{
+    SetBackgroundColour(BACKGROUND);
+
+    wxBoxSizer *sizer = new wxBoxSizer(wxVERTICAL);
+    m_summary = new wxStaticText(this, wxID_ANY, wxEmptyString);
+    m_summary->SetForegroundColour(TEXT);
+    sizer->Add(m_summary, 0, wxEXPAND | wxALL, MARGIN);
+    m_canvas = new WaterfallCanvas(this, timeline);
+    sizer->Add(m_canvas, 1, wxEXPAND);
+    SetSizer(sizer);
+
+    m_timer.SetOwner(this);
+    Bind(wxEVT_TIMER, &BuildTimelineDialog::OnTimer, this);
+    m_timer.Start(1000);
+    UpdateTimeline();
+}
+
+void BuildTimelineDialog::UpdateTimeline()
+{
+    const auto &spans = m_timeline.GetSpans();
+    const int bottleneck = m_timeline.GetBottleneck();
+    wxString summary = wxString::Format("%zu stages, saved to %s", spans.size(), m_timeline.GetPath());
+    if (bottleneck >= 0)
+    {
+        const auto &span = spans[bottleneck];
+        summary += wxString::Format("\nBottleneck: %s / %s, %s", span.group, span.stage,
+                                    FormatDuration(span.end - span.start));
+    }
+    m_summary->SetLabel(summary);
+    m_canvas->UpdateVirtualSize();
+    Layout();
+}
+
+void BuildTimelineDialog::OnTimer(wxTimerEvent &)
+{
+    const auto &spans = m_timeline.GetSpans();
+    if (std::any_of(spans.begin(), spans.end(), [](const BuildTimeline::Span &span)
+                    { return span.end == 0; }))
+        m_canvas->Refresh();
+}
@@ -0,0 +1,29 @@
+#ifndef BUILD_TIMELINE_DIALOG_H
+#define BUILD_TIMELINE_DIALOG_H
+
+#include <wx/wx.h>
+#include "BuildTimeline.h"
+
+class WaterfallCanvas;
+
+// Shows a BuildTimeline as a waterfall: one bar per stage on a shared time
+// axis, with its duration, CPU time, I/O and peak RSS. The bottleneck is
+// highlighted. Modeless; the owner keeps the timeline alive and calls
+// UpdateTimeline() when it changes.
+class BuildTimelineDialog : public wxDialog
+{
+public:
+    BuildTimelineDialog(wxWindow *parent, const BuildTimeline &timeline);
+
+    void UpdateTimeline();
+
+private:
+    void OnTimer(wxTimerEvent &event);
+
+    const BuildTimeline &m_timeline;
+    WaterfallCanvas *m_canvas;
+    wxStaticText *m_summary;
+    wxTimer m_timer; // Grows the bars of running stages
+};
+
+#endif // BUILD_TIMELINE_DIALOG_H
@@ -0,0 +1,55 @@
+#include "BuilderImage.h"
+#include <wx/log.h>
+#include <mutex>
+
+namespace {
+
+// FNV-1a, 64 bit
+const unsigned long long FNV_OFFSET = 1469598103934665603ULL;
+const unsigned long long FNV_PRIME = 1099511628211ULL;
+
+// Packages the scripts in the container rely on; keep in step with the
+// fallback in setup_output.sh (ScriptContents.cpp)
+const char* const TOOLS = "squashfs-tools xorriso isolinux syslinux-utils genisoimage e2fsprogs time";
+
+} // namespace
+
+const char* const BuilderImage::BASE_IMAGE = "ubuntu:latest";
+
+std::string BuilderImage::Dockerfile() {
+    std::string dockerfile;
+    dockerfile += "FROM " + std::string(BASE_IMAGE) + "\n";
+    dockerfile += "ENV DEBIAN_FRONTEND=noninteractive\n";
+    dockerfile += "RUN apt-get update && apt-get install -y " + std::string(TOOLS) +
+                  " && rm -rf /var/lib/apt/lists/*\n";
+    dockerfile += "RUN mkdir -p /root/custom_iso\n";
+    dockerfile += "WORKDIR /root\n";
+    return dockerfile;
+}
+
+wxString BuilderImage::Tag() {
+    unsigned long long hash = FNV_OFFSET;
+    for (unsigned char c : Dockerfile()) {
+        hash ^= c;
+        hash *= FNV_PRIME;
+    }
+    return wxString::Format("linuxisopro-builder:%016llx", hash);
+}
+
+bool BuilderImage::Ensure(const DockerClient::LineCallback& onLine, const std::atomic<bool>* cancel) {
+    // Concurrent callers wait for one build instead of starting their own
+    static std::mutex ensureMutex;
+    std::lock_guard<std::mutex> lock(ensureMutex);
+    DockerClient& docker = DockerClient::Get();
+    const wxString tag = Tag();
+    if (docker.ImageExists(tag)) {
+        return true;
+    }
+
+    wxLogMessage("Building builder image %s", tag);
+    if (!docker.BuildImage(tag, Dockerfile(), onLine, cancel)) {
+        wxLogWarning("Could not build %s: %s", tag, docker.GetLastError());
+        return false;
+    }
+    return true;
+}
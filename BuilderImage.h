@@ -0,0 +1,27 @@
+#ifndef BUILDER_IMAGE_H
+#define BUILDER_IMAGE_H
+
+#include <wx/string.h>
+#include <atomic>
+#include <string>
+#include "DockerClient.h"
+
+// The image project containers run from: the base image with the ISO tools
+// already installed, so a project start no longer runs apt-get. It is built
+// once from the Dockerfile below and tagged with a hash of it, so changing
+// the tool list gives a new tag and the next start builds that instead.
+// Building runs apt-get, so it needs the network; once built, the image is
+// reused offline.
+class BuilderImage {
+public:
+    static const char* const BASE_IMAGE;
+
+    static std::string Dockerfile();
+    static wxString Tag();
+
+    // Builds the image unless the current tag already exists. Blocks, so
+    // call it from a worker thread; onLine gets the build output.
+    static bool Ensure(const DockerClient::LineCallback& onLine, const std::atomic<bool>* cancel = nullptr);
+};
+
+#endif // BUILDER_IMAGE_H
@@ -0,0 +1,297 @@
+#include "ChrootAgent.h"
+#include <wx/log.h>
+#include <chrono>
+#include <cstdlib>
+
+namespace {
+
+thread_local wxString t_lastError;
+
+const char* const AGENT_PATH = "/run/linuxisopro-agent";
+const char* const AGENT_GREETING = "0 R linuxisopro-agent 1";
+const auto POLL_INTERVAL = std::chrono::milliseconds(50);
+
+bool Fail(const wxString& message) {
+    t_lastError = message;
+    return false;
+}
+
+// bash in the chroot, arguments to follow
+wxArrayString ChrootBash() {
+    wxArrayString command;
+    command.Add("chroot");
+    command.Add(ChrootAgent::ROOT);
+    command.Add("/bin/bash");
+    return command;
+}
+
+} // namespace
+
+const char* const ChrootAgent::ROOT = "/root/custom_iso/squashfs-root";
+
+ChrootAgent& ChrootAgent::Get() {
+    static ChrootAgent instance;
+    return instance;
+}
+
+// Creating DockerClient first makes it outlive the session
+ChrootAgent::ChrootAgent() : m_nextId(1) {
+    DockerClient::Get();
+}
+
+ChrootAgent::~ChrootAgent() {
+    Stop();
+}
+
+bool ChrootAgent::Run(const wxString& containerId, const wxString& script, const DockerClient::LineCallback& onLine,
+                      int& exitCode, const std::atomic<bool>* cancel) {
+    std::shared_ptr<DockerClient::ExecSession> session;
+    if (!EnsureSession(containerId, session)) {
+        return RunExec(containerId, script, onLine, exitCode, cancel);
+    }
+
+    auto request = std::make_shared<Request>();
+    request->onLine = onLine;
+    request->session = session.get();
+    unsigned long id;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_sessions.find(containerId);
+        if (it == m_sessions.end() || it->second.exec != session) {
+            return Fail("The chroot agent exited");
+        }
+        id = m_nextId++;
+        m_pending[id] = request;
+    }
+
+    // "<id> <bytes>\n<script>"; the reader fails the request if this breaks
+    const std::string body(script.utf8_str());
+    bool sent;
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        sent = session->Write(std::to_string(id) + " " + std::to_string(body.size()) + "\n" + body);
+    }
+    if (!sent) {
+        session->Close();
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    bool cancelled = false;
+    while (!request->done) {
+        m_finished.wait_for(lock, POLL_INTERVAL);
+        if (cancel && *cancel && !cancelled && !request->done) {
+            cancelled = true;
+            lock.unlock();
+            {
+                std::lock_guard<std::mutex> writeLock(m_writeMutex);
+                session->Write(std::to_string(id) + " -\n");
+            }
+            lock.lock();
+        }
+    }
+    if (request->lost) {
+        return Fail("The chroot agent exited");
+    }
+    exitCode = request->exitCode;
+    return !cancelled || Fail("Cancelled");
+}
+
+bool ChrootAgent::Run(const wxString& containerId, const wxString& script, DockerClient::ExecResult& result) {
+    wxArrayString output, errors;
+    auto onLine = [&output, &errors](int stream, const wxString& line) {
+        (stream == 2 ? errors : output).Add(line);
+    };
+    if (!Run(containerId, script, onLine, result.exitCode)) {
+        return false;
+    }
+    result.output = wxJoin(output, '\n', 0);
+    result.errors = wxJoin(errors, '\n', 0);
+    return true;
+}
+
+void ChrootAgent::Stop(const wxString& containerId) {
+    Session session;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_sessions.find(containerId);
+        if (it == m_sessions.end()) {
+            return;
+        }
+        session = std::move(it->second);
+        m_sessions.erase(it);
+    }
+    // The reader fails whatever was still running
+    if (session.exec) {
+        session.exec->Close();
+    }
+    if (session.reader.joinable()) {
+        session.reader.join();
+    }
+}
+
+void ChrootAgent::Stop() {
+    std::map<wxString, Session> sessions;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        sessions.swap(m_sessions);
+    }
+    for (auto& item : sessions) {
+        if (item.second.exec) {
+            item.second.exec->Close();
+        }
+    }
+    for (auto& item : sessions) {
+        if (item.second.reader.joinable()) {
+            item.second.reader.join();
+        }
+    }
+}
+
+wxString ChrootAgent::GetLastError() const {
+    return t_lastError;
+}
+
+// Returns false when scripts have to run through docker exec instead
+bool ChrootAgent::EnsureSession(const wxString& containerId, std::shared_ptr<DockerClient::ExecSession>& session) {
+    std::lock_guard<std::mutex> start(m_startMutex);
+    std::thread oldReader;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Session& entry = m_sessions[containerId];
+        if (entry.unavailable) {
+            return false;
+        }
+        if (entry.exec) {
+            session = entry.exec;
+            return true;
+        }
+
+        // A new container, or its agent exited: start over
+        oldReader = std::move(entry.reader);
+        entry.unavailable = true;
+    }
+    if (oldReader.joinable()) {
+        oldReader.join();
+    }
+
+    DockerClient& docker = DockerClient::Get();
+    std::unique_ptr<DockerClient::ExecSession> attached;
+    wxArrayString command = ChrootBash();
+    command.Add(AGENT_PATH);
+    if (!docker.IsApiAvailable() || !docker.ExecAttach(containerId, command, attached)) {
+        wxLogDebug("ChrootAgent: not attached, using docker exec: %s", docker.GetLastError());
+        return false;
+    }
+
+    // The agent greets first; a chroot without it just exits
+    std::string greeting, data;
+    int stream;
+    while (greeting.find('\n') == std::string::npos) {
+        if (!attached->Read(stream, data)) {
+            wxLogDebug("ChrootAgent: no agent in the chroot of %s, using docker exec", containerId);
+            return false;
+        }
+        if (stream == 1) {
+            greeting += data;
+        }
+    }
+    if (greeting.compare(0, greeting.find('\n'), AGENT_GREETING) != 0) {
+        wxLogDebug("ChrootAgent: unexpected agent greeting, using docker exec");
+        return false;
+    }
+
+    std::shared_ptr<DockerClient::ExecSession> shared(std::move(attached));
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Session& entry = m_sessions[containerId];
+    entry.exec = shared;
+    entry.unavailable = false;
+    entry.reader = std::thread(&ChrootAgent::ReadLoop, this, shared);
+    session = shared;
+    wxLogDebug("ChrootAgent: agent attached in %s", containerId);
+    return true;
+}
+
+void ChrootAgent::ReadLoop(std::shared_ptr<DockerClient::ExecSession> session) {
+    std::string lines, data;
+    int stream;
+    while (session->Read(stream, data)) {
+        if (stream == 2) {
+            wxLogDebug("ChrootAgent: %s", wxString::FromUTF8(data.data(), data.size()));
+            continue;
+        }
+        lines += data;
+        size_t start = 0, end;
+        while ((end = lines.find('\n', start)) != std::string::npos) {
+            Dispatch(lines.substr(start, end - start));
+            start = end + 1;
+        }
+        lines.erase(0, start);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    EndSession(session);
+}
+
+// "<id> O <text>" and "<id> E <text>" carry a line of output, "<id> X
+// <status>" ends the request
+void ChrootAgent::Dispatch(const std::string& line) {
+    char* rest = nullptr;
+    const unsigned long id = std::strtoul(line.c_str(), &rest, 10);
+    if (rest[0] != ' ' || rest[1] == '\0') {
+        return;
+    }
+    const char kind = rest[1];
+    const char* text = rest[2] == ' ' ? rest + 3 : "";
+
+    std::shared_ptr<Request> request;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_pending.find(id);
+        if (it == m_pending.end()) {
+            return;
+        }
+        request = it->second;
+        if (kind == 'X') {
+            request->exitCode = std::atoi(text);
+            request->done = true;
+            m_pending.erase(it);
+            m_finished.notify_all();
+            return;
+        }
+    }
+    if (kind == 'O' || kind == 'E') {
+        request->onLine(kind == 'E' ? 2 : 1, wxString::FromUTF8(text));
+    }
+}
+
+// Called by the session's reader, with m_mutex held, once it has delivered
+// everything
+void ChrootAgent::EndSession(const std::shared_ptr<DockerClient::ExecSession>& session) {
+    for (auto& item : m_sessions) {
+        if (item.second.exec == session) {
+            item.second.exec.reset();
+        }
+    }
+    for (auto it = m_pending.begin(); it != m_pending.end();) {
+        if (it->second->session == session.get()) {
+            it->second->lost = true;
+            it->second->done = true;
+            it = m_pending.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    m_finished.notify_all();
+}
+
+bool ChrootAgent::RunExec(const wxString& containerId, const wxString& script, const DockerClient::LineCallback& onLine,
+                          int& exitCode, const std::atomic<bool>* cancel) {
+    wxArrayString command = ChrootBash();
+    command.Add("-c");
+    command.Add(script);
+    DockerClient& docker = DockerClient::Get();
+    if (!docker.ExecStream(containerId, command, onLine, exitCode, cancel)) {
+        return Fail(docker.GetLastError());
+    }
+    return true;
+}
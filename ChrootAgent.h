@@ -0,0 +1,81 @@
+#ifndef CHROOT_AGENT_H
+#define CHROOT_AGENT_H
+
+#include "DockerClient.h"
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Runs scripts inside the build chroot through one long-lived agent
+// (installed by setup_chroot.sh) instead of a docker exec, chroot and bash
+// per command. Requests are written to the agent's stdin as they come, so
+// several can be in flight at once; the agent runs each in the background
+// and tags every line it sends back with the request's id.
+//
+// The agent is attached to over the Engine API, one session per container,
+// so windows building in different containers don't disturb each other.
+// Without the API, or when the chroot has no agent, each script runs in its
+// own docker exec as before.
+class ChrootAgent {
+public:
+    static const char* const ROOT;    // The chroot, inside the container
+
+    static ChrootAgent& Get();
+
+    // Same contract as DockerClient::ExecStream for a bash script run in
+    // the chroot, except that onLine is called on the agent's reader
+    // thread. Cancelling stops the script.
+    bool Run(const wxString& containerId, const wxString& script, const DockerClient::LineCallback& onLine,
+             int& exitCode, const std::atomic<bool>* cancel = nullptr);
+    // Collects the output instead
+    bool Run(const wxString& containerId, const wxString& script, DockerClient::ExecResult& result);
+
+    // Ends the container's session, failing the scripts still running in
+    // it; the next Run for it starts a new agent
+    void Stop(const wxString& containerId);
+    // Ends every session
+    void Stop();
+
+    // Error of the last failed call made by this thread
+    wxString GetLastError() const;
+
+private:
+    struct Request {
+        DockerClient::LineCallback onLine;
+        int exitCode = -1;
+        const DockerClient::ExecSession* session = nullptr;
+        bool done = false;
+        bool lost = false;    // The session ended first
+    };
+
+    struct Session {
+        std::shared_ptr<DockerClient::ExecSession> exec;    // Empty once the agent exited
+        std::thread reader;
+        bool unavailable = false;    // No agent in the container's chroot
+    };
+
+    ChrootAgent();
+    ~ChrootAgent();
+    ChrootAgent(const ChrootAgent&) = delete;
+    ChrootAgent& operator=(const ChrootAgent&) = delete;
+
+    bool EnsureSession(const wxString& containerId, std::shared_ptr<DockerClient::ExecSession>& session);
+    void ReadLoop(std::shared_ptr<DockerClient::ExecSession> session);
+    void Dispatch(const std::string& line);
+    void EndSession(const std::shared_ptr<DockerClient::ExecSession>& session);
+    bool RunExec(const wxString& containerId, const wxString& script, const DockerClient::LineCallback& onLine,
+                 int& exitCode, const std::atomic<bool>* cancel);
+
+    std::mutex m_mutex;                 // Guards everything below
+    std::condition_variable m_finished;
+    std::map<wxString, Session> m_sessions;    // By container ID
+    std::map<unsigned long, std::shared_ptr<Request>> m_pending;
+    unsigned long m_nextId;
+
+    std::mutex m_startMutex;            // Held while a session starts
+    std::mutex m_writeMutex;            // Keeps request frames whole
+};
+
+#endif // CHROOT_AGENT_H
@@ -1,55 +1,77 @@
 #include "ContainerManager.h"
+#include "ChrootAgent.h"
+#include "BuilderImage.h"
+#include "DockerClient.h"
+#include "PipelineState.h"
+#include <wx/datetime.h>
+#include <wx/dir.h>
 #include <wx/filename.h>
 #include <wx/stdpaths.h>
+#include <wx/thread.h>
+#include <algorithm>
 #include <fstream>
 
+namespace {
+
+const char* const POOL_PREFIX = "linuxisopro-pool-";
+
+} // namespace
+
 ContainerManager& ContainerManager::Get() {
     static ContainerManager instance;
     return instance;
 }
 
-bool ContainerManager::SaveContainerId(const wxString& containerId, const wxString& isoPath) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    
-    wxString appDataPath = wxStandardPaths::Get().GetUserDataDir();
-    if (!wxDirExists(appDataPath)) {
-        wxMkdir(appDataPath);
-    }
-    
-    wxString containerFile = appDataPath + wxFileName::GetPathSeparator() + "containers.dat";
-    std::ofstream file(containerFile.ToStdString(), std::ios::app);
-    if (!file) return false;
-    
-    wxString timestamp = wxDateTime::Now().Format("%Y-%m-%d %H:%M:%S");
-    file << containerId.ToStdString() << "|" 
-         << isoPath.ToStdString() << "|"
-         << timestamp.ToStdString() << "\n";
-             
-    wxString tempPath = wxFileName::GetTempDir() + wxFileName::GetPathSeparator() + "container_id.txt";
-    std::ofstream tempFile(tempPath.ToStdString());
-    if (tempFile) {
-        tempFile << containerId;
+ContainerManager::ContainerManager()
+    : m_registry(wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "containers.journal") {
+    m_registry.Open();
+    ImportLegacyList();
+    // Nothing runs yet, so whatever is registered was left by an earlier run
+    m_registry.OrphanAll();
+}
+
+ContainerManager::~ContainerManager() {
+    StopPool();
+}
+
+bool ContainerManager::SaveContainerId(const wxString& containerId, const wxString& isoPath,
+                                       const wxString& projectDir) {
+    ContainerRegistry::Entry entry;
+    if (!m_registry.Find(containerId, entry)) {
+        entry.id = containerId;
     }
-    
+    entry.state = ContainerRegistry::State::Ready;
+    entry.isoPath = isoPath;
+    entry.projectDir = projectDir;
+    const bool saved = m_registry.Set(entry);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
     m_currentContainerId = containerId;
-    return true;
+    return saved;
+}
+
+bool ContainerManager::SetContainerState(const wxString& containerId, ContainerRegistry::State state) {
+    return m_registry.SetState(containerId, state);
 }
 
 wxString ContainerManager::GetCurrentContainerId() const {
     return m_currentContainerId;
 }
 
-bool ContainerManager::CleanupContainer(const wxString& containerId) {
+bool ContainerManager::CleanupContainer(const wxString& containerId, const std::atomic<bool>* cancel) {
     if (containerId.IsEmpty()) return false;
     
-    wxString cmd = "docker rm -f " + containerId;
-    wxExecute(cmd, wxEXEC_SYNC);
-    
-    wxString tempPath = wxFileName::GetTempDir() + wxFileName::GetPathSeparator() + "container_id.txt";
-    if (wxFileExists(tempPath)) {
-        wxRemoveFile(tempPath);
+    ChrootAgent::Get().Stop(containerId);
+    if (!DockerClient::Get().RemoveContainer(containerId, true, cancel)) {
+        wxLogWarning("Could not remove container %s: %s", containerId, DockerClient::Get().GetLastError());
+        return false;  // Stays registered, so the next start removes it
     }
-    
+
+    ContainerRegistry::Entry entry;
+    if (m_registry.Find(containerId, entry) && !entry.treeDir.IsEmpty() && wxDirExists(entry.treeDir)) {
+        wxFileName::Rmdir(entry.treeDir, wxPATH_RMDIR_RECURSIVE);
+    }
+    m_registry.Remove(containerId);
     return true;
 }
 
@@ -57,19 +79,15 @@ bool ContainerManager::EnsureOutputDirectory(const wxString& containerId) {
     std::lock_guard<std::mutex> lock(m_mutex);
     wxLogMessage("Ensuring output directory exists for container: %s", containerId);
     
-    wxString mkdirCmd = wxString::Format(
-        "docker exec %s mkdir -p /output", containerId);
+    DockerClient& docker = DockerClient::Get();
+    DockerClient::ExecResult result;
     
-    wxArrayString output, errors;
-    if (wxExecute(mkdirCmd, output, errors, wxEXEC_SYNC) != 0) {
+    if (!docker.Exec(containerId, DockerClient::ShellCommand("mkdir -p /output"), result) || result.exitCode != 0) {
         wxLogError("Failed to create output directory");
         return false;
     }
     
-    wxString chmodCmd = wxString::Format(
-        "docker exec %s chmod 777 /output", containerId);
-    
-    if (wxExecute(chmodCmd, output, errors, wxEXEC_SYNC) != 0) {
+    if (!docker.Exec(containerId, DockerClient::ShellCommand("chmod 777 /output"), result) || result.exitCode != 0) {
         wxLogError("Failed to set directory permissions");
         return false;
     }
@@ -78,20 +96,265 @@ bool ContainerManager::EnsureOutputDirectory(const wxString& containerId) {
 }
 
 void ContainerManager::CleanupAllContainers() {
-    wxString appDataPath = wxStandardPaths::Get().GetUserDataDir();
-    wxString containerFile = appDataPath + wxFileName::GetPathSeparator() + "containers.dat";
-    
+    auto orphans = m_registry.GetEntries(ContainerRegistry::State::Orphaned);
+    orphans.erase(std::remove_if(orphans.begin(), orphans.end(), IsResumable), orphans.end());
+    if (orphans.empty()) {
+        return;
+    }
+
+    wxArrayString ids;
+    for (const auto& entry : orphans) {
+        ids.Add(entry.id);
+    }
+    std::vector<bool> removed;
+    DockerClient::Get().RemoveContainers(ids, removed);
+
+    size_t count = 0;
+    for (size_t i = 0; i < orphans.size(); ++i) {
+        if (!removed[i]) {
+            wxLogWarning("Could not remove orphaned container %s", orphans[i].id);
+            continue;
+        }
+        if (!orphans[i].treeDir.IsEmpty() && wxDirExists(orphans[i].treeDir)) {
+            wxFileName::Rmdir(orphans[i].treeDir, wxPATH_RMDIR_RECURSIVE);
+        }
+        m_registry.Remove(orphans[i].id);
+        ++count;
+    }
+    wxLogMessage("Removed %zu of %zu orphaned containers", count, orphans.size());
+}
+
+// A container whose project's build was interrupted, which reopening the
+// project resumes with. Orphaning stamps the entry, so the time counts from
+// the first start after the crash.
+bool ContainerManager::IsResumable(const ContainerRegistry::Entry& entry) {
+    if (entry.projectDir.IsEmpty() || !wxDirExists(entry.projectDir)) {
+        return false;
+    }
+    const long long age = static_cast<long long>(wxDateTime::Now().GetTicks()) - entry.updated;
+    if (age > std::chrono::duration_cast<std::chrono::seconds>(KEEP_RESUMABLE).count()) {
+        return false;
+    }
+    PipelineState state(entry.projectDir);
+    PipelineState::Stage container;
+    return state.Load() && state.Find("container", container) && container.outputs["id"] == entry.id;
+}
+
+// Moves the "id|iso|timestamp" list older versions kept into the registry
+void ContainerManager::ImportLegacyList() {
+    wxString containerFile = wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "containers.dat";
     if (!wxFileExists(containerFile)) return;
-    
+
     std::ifstream file(containerFile.ToStdString());
     std::string line;
     while (std::getline(file, line)) {
-        size_t pos = line.find('|');
-        if (pos != std::string::npos) {
-            wxString containerId = wxString::FromUTF8(line.substr(0, pos));
-            CleanupContainer(containerId);
+        wxArrayString fields = wxSplit(wxString::FromUTF8(line.c_str()), '|', '\0');
+        if (fields.size() >= 2 && !fields[0].IsEmpty()) {
+            ContainerRegistry::Entry entry;
+            entry.id = fields[0];
+            entry.isoPath = fields[1];
+            m_registry.Set(entry);
         }
     }
-    
+    file.close();
     wxRemoveFile(containerFile);
-}
\ No newline at end of file
+}
+
+void ContainerManager::StartPool(size_t size, std::chrono::seconds idleTtl) {
+    StopPool();
+
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+    m_poolSize = size;
+    m_idleTtl = idleTtl;
+    m_refill = true;
+    m_stopPool = false;
+    m_poolExited = false;
+    m_poolCancel = false;
+    m_poolRunId = wxDateTime::Now().Format("%Y%m%d%H%M%S");
+    m_poolThread = std::thread(&ContainerManager::PoolLoop, this);
+}
+
+// Removes the idle containers and waits for the pool thread. Its CLI calls
+// are launched and reaped by the main thread, so events are dispatched
+// meanwhile.
+void ContainerManager::StopPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_poolMutex);
+        if (!m_poolThread.joinable()) {
+            return;
+        }
+        m_stopPool = true;
+    }
+    m_poolWake.notify_all();
+
+    const auto deadline = std::chrono::steady_clock::now() + STOP_DEADLINE;
+    while (!m_poolExited) {
+        if (!m_poolCancel && std::chrono::steady_clock::now() >= deadline) {
+            wxLogWarning("Giving up on removing the pooled containers");
+            m_poolCancel = true;
+        }
+        if (wxIsMainThread()) {
+            DockerClient::DispatchCliEvents();
+        }
+        wxMilliSleep(10);
+    }
+    m_poolThread.join();
+}
+
+bool ContainerManager::ClaimPooledContainer(wxString& containerId, wxString& treeDir) {
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+    if (m_poolSize == 0 || m_stopPool) {
+        return false;
+    }
+    m_refill = true;
+    m_poolWake.notify_all();
+    if (m_pool.empty()) {
+        return false;
+    }
+
+    PooledContainer container = m_pool.front();
+    m_pool.erase(m_pool.begin());
+    m_registry.SetState(container.id, ContainerRegistry::State::Provisioning);  // Now set up for a project
+    containerId = container.id;
+    treeDir = container.treeDir;
+    wxLogMessage("Claimed pooled container %s", containerId);
+    return true;
+}
+
+void ContainerManager::PoolLoop() {
+    CleanupAllContainers();
+    RemoveStalePoolDirectories();
+
+    std::unique_lock<std::mutex> lock(m_poolMutex);
+    while (!m_stopPool && m_poolSize > 0) {
+        const auto now = std::chrono::steady_clock::now();
+        std::vector<PooledContainer> expired;
+        auto keep = std::stable_partition(m_pool.begin(), m_pool.end(), [&](const PooledContainer& container) {
+            return now - container.idleSince < m_idleTtl;
+        });
+        expired.assign(keep, m_pool.end());
+        m_pool.erase(keep, m_pool.end());
+        if (!expired.empty()) {
+            lock.unlock();
+            for (const auto& container : expired) {
+                wxLogMessage("Removing idle pooled container %s", container.id);
+                RemovePooledContainer(container);
+            }
+            lock.lock();
+            continue;
+        }
+
+        if (m_refill && m_pool.size() < m_poolSize) {
+            lock.unlock();
+            PooledContainer container;
+            const bool created = CreatePooledContainer(container);
+            lock.lock();
+            if (!created) {
+                m_refill = false;  // Try again on the next claim
+            } else if (m_stopPool) {
+                m_pool.push_back(container);  // Removed below
+            } else {
+                container.idleSince = std::chrono::steady_clock::now();
+                m_pool.push_back(container);
+            }
+            continue;
+        }
+        m_refill = false;
+
+        // Sleep until the oldest idle container expires or a claim arrives
+        if (m_pool.empty()) {
+            m_poolWake.wait(lock);
+        } else {
+            m_poolWake.wait_until(lock, m_pool.front().idleSince + m_idleTtl);
+        }
+    }
+
+    std::vector<PooledContainer> idle;
+    idle.swap(m_pool);
+    lock.unlock();
+    for (const auto& container : idle) {
+        RemovePooledContainer(container);
+    }
+    m_poolExited = true;
+}
+
+bool ContainerManager::CreatePooledContainer(PooledContainer& container) {
+    auto onLine = [](int, const wxString& line) {
+        wxLogDebug("Builder image: %s", line);
+    };
+    if (!BuilderImage::Ensure(onLine, &m_poolCancel)) {
+        return false;
+    }
+
+    const wxString name = wxString::Format("%s%s-%u", POOL_PREFIX, m_poolRunId, m_nextSlot++);
+    container.treeDir = GetPoolDirectory() + wxFileName::GetPathSeparator() + name;
+    if (!wxFileName::Mkdir(container.treeDir, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL)) {
+        wxLogWarning("Could not create %s", container.treeDir);
+        return false;
+    }
+
+    DockerClient& docker = DockerClient::Get();
+    DockerClient::ContainerConfig config;
+    config.image = BuilderImage::Tag();
+    config.name = name;
+    config.command.Add("sleep");
+    config.command.Add("infinity");
+    config.binds.Add(container.treeDir + ":/root/custom_iso");
+    config.privileged = true;
+    if (!docker.CreateContainer(config, container.id)) {
+        wxLogWarning("Could not create pooled container: %s", docker.GetLastError());
+        wxFileName::Rmdir(container.treeDir, wxPATH_RMDIR_RECURSIVE);
+        return false;
+    }
+
+    ContainerRegistry::Entry entry;
+    entry.id = container.id;
+    entry.treeDir = container.treeDir;
+    m_registry.Set(entry);
+    if (!docker.StartContainer(container.id)) {
+        wxLogWarning("Could not start pooled container: %s", docker.GetLastError());
+        RemovePooledContainer(container);
+        return false;
+    }
+    m_registry.SetState(container.id, ContainerRegistry::State::Ready);
+    wxLogMessage("Pooled container %s ready", name);
+    return true;
+}
+
+void ContainerManager::RemovePooledContainer(const PooledContainer& container) {
+    if (!DockerClient::Get().RemoveContainer(container.id, true, &m_poolCancel)) {
+        return;  // Stays registered, so the next start removes it
+    }
+    if (wxDirExists(container.treeDir)) {
+        wxFileName::Rmdir(container.treeDir, wxPATH_RMDIR_RECURSIVE);
+    }
+    m_registry.Remove(container.id);
+}
+
+// Removes tree directories no registered container owns, left when the
+// application stopped between creating one and its container
+void ContainerManager::RemoveStalePoolDirectories() {
+    wxDir dir(GetPoolDirectory());
+    if (!dir.IsOpened()) {
+        return;
+    }
+
+    wxArrayString owned;
+    for (const auto& entry : m_registry.GetEntries()) {
+        owned.Add(wxFileName(entry.treeDir).GetFullName());
+    }
+    wxArrayString stale;
+    wxString name;
+    for (bool found = dir.GetFirst(&name, wxString(POOL_PREFIX) + "*", wxDIR_DIRS); found; found = dir.GetNext(&name)) {
+        if (owned.Index(name) == wxNOT_FOUND) {
+            stale.Add(name);
+        }
+    }
+    for (const auto& staleName : stale) {
+        wxFileName::Rmdir(GetPoolDirectory() + wxFileName::GetPathSeparator() + staleName, wxPATH_RMDIR_RECURSIVE);
+    }
+}
+
+wxString ContainerManager::GetPoolDirectory() const {
+    return wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "container_pool";
+}
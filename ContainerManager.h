@@ -5,26 +5,82 @@
 #include <wx/utils.h>  // For wxExecute
 #include <wx/file.h>   // For file operations
 #include <wx/log.h>    // For wxLogError
+#include "ContainerRegistry.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 class ContainerManager {
 public:
     static ContainerManager& Get();
     
-    bool SaveContainerId(const wxString& containerId, const wxString& isoPath);
+    // Registers a project container as ready. Left behind by a crash, it is
+    // kept for resuming the project's build while the project's checkpoints
+    // name it, up to KEEP_RESUMABLE.
+    bool SaveContainerId(const wxString& containerId, const wxString& isoPath,
+                         const wxString& projectDir = wxEmptyString);
+    bool SetContainerState(const wxString& containerId, ContainerRegistry::State state);
     wxString GetCurrentContainerId() const;
-    bool CleanupContainer(const wxString& containerId);
+    bool CleanupContainer(const wxString& containerId, const std::atomic<bool>* cancel = nullptr);
+    // Removes the containers earlier runs left behind, in parallel
     void CleanupAllContainers();
     bool EnsureOutputDirectory(const wxString& containerId);
 
+    // Warm pool of idle builder containers, kept filled by a background
+    // thread that first removes orphaned containers. Each runs from the builder image with an empty host directory
+    // bind-mounted as /root/custom_iso, so a project that claims one only
+    // has to extract its ISO tree there. Claims trigger a refill; containers
+    // left idle for idleTtl are removed. A size of 0 only removes orphans.
+    void StartPool(size_t size, std::chrono::seconds idleTtl);
+    // Gives up on the pool thread's Docker calls after STOP_DEADLINE; the
+    // containers it could not remove stay registered for the next start
+    void StopPool();
+    // Returns false if no container is ready
+    bool ClaimPooledContainer(wxString& containerId, wxString& treeDir);
+
+    static constexpr std::chrono::hours KEEP_RESUMABLE{24 * 7};
+    static constexpr std::chrono::milliseconds STOP_DEADLINE{15000};
+
 private:
-    ContainerManager() = default;
+    struct PooledContainer {
+        wxString id;
+        wxString treeDir;
+        std::chrono::steady_clock::time_point idleSince;
+    };
+
+    ContainerManager();
+    ~ContainerManager();
     ContainerManager(const ContainerManager&) = delete;
     ContainerManager& operator=(const ContainerManager&) = delete;
 
+    void PoolLoop();
+    bool CreatePooledContainer(PooledContainer& container);
+    void RemovePooledContainer(const PooledContainer& container);
+    void RemoveStalePoolDirectories();
+    wxString GetPoolDirectory() const;
+    void ImportLegacyList();
+    static bool IsResumable(const ContainerRegistry::Entry& entry);
+
     wxString m_currentContainerId;
     std::mutex m_mutex;
+    ContainerRegistry m_registry;
+
+    std::mutex m_poolMutex;                     // Guards the pool members below
+    std::condition_variable m_poolWake;
+    std::thread m_poolThread;
+    std::vector<PooledContainer> m_pool;        // Ready, oldest first
+    size_t m_poolSize = 0;
+    std::chrono::seconds m_idleTtl{0};
+    bool m_refill = false;
+    bool m_stopPool = false;
+    std::atomic<bool> m_poolExited{true};
+    std::atomic<bool> m_poolCancel{false};      // Set once StopPool's deadline passed
+    wxString m_poolRunId;                       // Keeps names unique across runs
+    unsigned m_nextSlot = 0;                    // Pool thread only
 };
 
 #endif // CONTAINER_MANAGER_H
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include "ContainerReaper.h"
+#include "ContainerManager.h"
+#include "CustomEvents.h"
+#include "DockerClient.h"
+#include <wx/log.h>
+#include <wx/utils.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <thread>
+
+wxDEFINE_EVENT(CONTAINER_REMOVED, wxCommandEvent);
+
+struct ContainerReaper::Job {
+    wxString containerId;
+    std::chrono::steady_clock::time_point deadline;
+    std::atomic<bool> cancel{false};
+};
+
+struct ContainerReaper::Shared {
+    std::mutex mutex;                   // Guards everything below
+    std::condition_variable changed;
+    std::list<std::shared_ptr<Job>> jobs;
+    bool watching = false;              // Watch is running
+    wxEvtHandler* listener = nullptr;
+};
+
+ContainerReaper& ContainerReaper::Get() {
+    static ContainerReaper instance;
+    return instance;
+}
+
+ContainerReaper::ContainerReaper() : m_shared(std::make_shared<Shared>()) {}
+
+void ContainerReaper::Remove(const wxString& containerId, std::chrono::milliseconds deadline) {
+    auto job = std::make_shared<Job>();
+    job->containerId = containerId.Clone();
+    job->deadline = std::chrono::steady_clock::now() + deadline;
+
+    std::shared_ptr<Shared> shared = m_shared;
+    {
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        shared->jobs.push_back(job);
+        if (!shared->watching) {
+            shared->watching = true;
+            std::thread(&ContainerReaper::Watch, shared).detach();
+        }
+    }
+    shared->changed.notify_all();
+
+    std::thread([shared, job]() {
+        const bool removed = ContainerManager::Get().CleanupContainer(job->containerId, &job->cancel);
+        if (!removed) {
+            wxLogWarning("Container %s was not removed%s", job->containerId,
+                         job->cancel ? " before its deadline" : "");
+        }
+
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        shared->jobs.remove(job);
+        if (shared->listener) {
+            wxCommandEvent event(CONTAINER_REMOVED);
+            event.SetString(job->containerId.Clone());
+            event.SetInt(removed ? 1 : 0);
+            wxQueueEvent(shared->listener, event.Clone());
+        }
+        shared->changed.notify_all();
+    }).detach();
+}
+
+void ContainerReaper::SetListener(wxEvtHandler* listener) {
+    std::lock_guard<std::mutex> lock(m_shared->mutex);
+    m_shared->listener = listener;
+}
+
+// The CLI fallback launches and reaps its commands on the main thread, so
+// events are dispatched while waiting
+void ContainerReaper::Drain() {
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(m_shared->mutex);
+            if (m_shared->jobs.empty()) {
+                return;
+            }
+        }
+        DockerClient::DispatchCliEvents();
+        wxMilliSleep(10);
+    }
+}
+
+// Cancels each removal that outlives its deadline. Runs while there are
+// removals, one instance at a time.
+void ContainerReaper::Watch(std::shared_ptr<Shared> shared) {
+    std::unique_lock<std::mutex> lock(shared->mutex);
+    while (!shared->jobs.empty()) {
+        const auto now = std::chrono::steady_clock::now();
+        auto next = std::chrono::steady_clock::time_point::max();
+        for (const auto& job : shared->jobs) {
+            if (job->cancel) {
+                continue;
+            }
+            if (job->deadline <= now) {
+                job->cancel = true;
+            } else {
+                next = std::min(next, job->deadline);
+            }
+        }
+
+        if (next == std::chrono::steady_clock::time_point::max()) {
+            shared->changed.wait(lock);
+        } else {
+            shared->changed.wait_until(lock, next);
+        }
+    }
+    shared->watching = false;
+}
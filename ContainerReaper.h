@@ -0,0 +1,44 @@
+#ifndef CONTAINER_REAPER_H
+#define CONTAINER_REAPER_H
+
+#include <wx/event.h>
+#include <wx/string.h>
+#include <chrono>
+#include <memory>
+
+// Removes containers in the background so a window can close at once.
+// Every removal runs concurrently on a thread of its own and is given up
+// after its deadline; the container then stays in the registry and the
+// next start removes it. Each result is posted to the listener as
+// CONTAINER_REMOVED, with the ID in GetString() and GetInt() != 0 if the
+// container is gone.
+class ContainerReaper {
+public:
+    static ContainerReaper& Get();
+
+    void Remove(const wxString& containerId, std::chrono::milliseconds deadline = DEFAULT_DEADLINE);
+
+    // Receives CONTAINER_REMOVED; pass nullptr before the listener goes away
+    void SetListener(wxEvtHandler* listener);
+
+    // Waits for the outstanding removals, which the deadlines bound. Call
+    // it from the main thread before exiting.
+    void Drain();
+
+    static constexpr std::chrono::milliseconds DEFAULT_DEADLINE{15000};
+
+private:
+    struct Job;
+    struct Shared;
+
+    ContainerReaper();
+    ContainerReaper(const ContainerReaper&) = delete;
+    ContainerReaper& operator=(const ContainerReaper&) = delete;
+
+    static void Watch(std::shared_ptr<Shared> shared);
+
+    // Outlives the singleton while detached threads still use it
+    std::shared_ptr<Shared> m_shared;
+};
+
+#endif // CONTAINER_REAPER_H
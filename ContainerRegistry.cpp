@@ -0,0 +1,321 @@
+#include "ContainerRegistry.h"
+#include <wx/crt.h>
+#include <wx/file.h>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+#include <wx/log.h>
+#include <wx/tokenzr.h>
+#include <ctime>
+
+#ifdef __WXMSW__
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+// FNV-1a, 64 bit
+const unsigned long long FNV_OFFSET = 1469598103934665603ULL;
+const unsigned long long FNV_PRIME = 1099511628211ULL;
+
+const char* const REMOVED = "removed";
+const size_t CHECKSUM_LENGTH = 16;
+
+const ContainerRegistry::State ALL_STATES[] = {
+    ContainerRegistry::State::Provisioning, ContainerRegistry::State::Ready, ContainerRegistry::State::Building,
+    ContainerRegistry::State::Done, ContainerRegistry::State::Orphaned,
+};
+
+std::string Checksum(const std::string& payload) {
+    unsigned long long hash = FNV_OFFSET;
+    for (unsigned char c : payload) {
+        hash ^= c;
+        hash *= FNV_PRIME;
+    }
+    char text[CHECKSUM_LENGTH + 1];
+    std::snprintf(text, sizeof(text), "%016llx", hash);
+    return text;
+}
+
+// Flushes the stream and waits until the data is on disk
+bool Sync(std::FILE* file) {
+    if (std::fflush(file) != 0) {
+        return false;
+    }
+#ifdef __WXMSW__
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+} // namespace
+
+ContainerRegistry::ContainerRegistry(const wxString& journalPath) : m_path(journalPath) {}
+
+ContainerRegistry::~ContainerRegistry() {
+    if (m_journal) {
+        std::fclose(m_journal);
+    }
+}
+
+const char* ContainerRegistry::StateName(State state) {
+    switch (state) {
+    case State::Provisioning: return "provisioning";
+    case State::Ready:        return "ready";
+    case State::Building:     return "building";
+    case State::Done:         return "done";
+    case State::Orphaned:     return "orphaned";
+    }
+    return "";
+}
+
+bool ContainerRegistry::Open() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_journal) {
+        return true;
+    }
+
+    wxFileName::Mkdir(wxFileName(m_path).GetPath(), wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+
+    // Replay the journal; later records of an entry supersede earlier ones
+    bool damaged = false;
+    wxFile file;
+    if (wxFileExists(m_path) && file.Open(m_path)) {
+        std::string data(static_cast<size_t>(file.Length()), '\0');
+        if (!data.empty() && file.Read(&data[0], data.size()) != static_cast<ssize_t>(data.size())) {
+            wxLogWarning("Could not read %s", m_path);
+            data.clear();
+            damaged = true;
+        }
+        file.Close();
+
+        size_t start = 0, end;
+        while ((end = data.find('\n', start)) != std::string::npos) {
+            Entry entry;
+            bool removed = false;
+            if (Parse(data.substr(start, end - start), entry, removed)) {
+                if (removed) {
+                    m_entries.erase(entry.id);
+                } else {
+                    m_entries[entry.id] = entry;
+                }
+                ++m_records;
+            } else {
+                damaged = true;
+            }
+            start = end + 1;
+        }
+        damaged = damaged || start < data.size();  // Torn last record
+    }
+
+    m_journal = wxFopen(m_path, "ab");
+    if (!m_journal) {
+        wxLogWarning("Could not open %s; containers won't be tracked across runs", m_path);
+        return false;
+    }
+    if (damaged) {
+        wxLogWarning("Skipped damaged records in %s", m_path);
+        Compact();
+    } else {
+        MaybeCompact();
+    }
+    return true;
+}
+
+bool ContainerRegistry::Set(Entry entry) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    entry.updated = static_cast<long long>(std::time(nullptr));
+    m_entries[entry.id] = entry;
+    const bool ok = Append(Serialize(entry, false));
+    MaybeCompact();
+    return ok;
+}
+
+bool ContainerRegistry::SetState(const wxString& id, State state) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(id);
+    if (it == m_entries.end()) {
+        return false;
+    }
+    it->second.state = state;
+    it->second.updated = static_cast<long long>(std::time(nullptr));
+    const bool ok = Append(Serialize(it->second, false));
+    MaybeCompact();
+    return ok;
+}
+
+bool ContainerRegistry::Remove(const wxString& id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(id);
+    if (it == m_entries.end()) {
+        return true;
+    }
+    const std::string record = Serialize(it->second, true);
+    m_entries.erase(it);
+    const bool ok = Append(record);
+    MaybeCompact();
+    return ok;
+}
+
+bool ContainerRegistry::Find(const wxString& id, Entry& entry) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(id);
+    if (it == m_entries.end()) {
+        return false;
+    }
+    entry = it->second;
+    return true;
+}
+
+std::vector<ContainerRegistry::Entry> ContainerRegistry::GetEntries(State state) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<Entry> entries;
+    for (const auto& item : m_entries) {
+        if (item.second.state == state) {
+            entries.push_back(item.second);
+        }
+    }
+    return entries;
+}
+
+std::vector<ContainerRegistry::Entry> ContainerRegistry::GetEntries() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<Entry> entries;
+    for (const auto& item : m_entries) {
+        entries.push_back(item.second);
+    }
+    return entries;
+}
+
+void ContainerRegistry::OrphanAll() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_entries.empty()) {
+        return;
+    }
+    const long long now = static_cast<long long>(std::time(nullptr));
+    std::string records;
+    for (auto& item : m_entries) {
+        if (item.second.state != State::Orphaned) {
+            item.second.state = State::Orphaned;
+            item.second.updated = now;
+            records += Serialize(item.second, false);
+        }
+    }
+    if (!records.empty()) {
+        Append(records);
+    }
+    MaybeCompact();
+}
+
+// Called with m_mutex held. A record holds whole lines, possibly several.
+bool ContainerRegistry::Append(const std::string& record) {
+    if (!m_journal) {
+        return false;
+    }
+    if (std::fwrite(record.data(), 1, record.size(), m_journal) != record.size() || !Sync(m_journal)) {
+        wxLogWarning("Could not write to %s", m_path);
+        return false;
+    }
+    for (char c : record) {
+        m_records += c == '\n';
+    }
+    return true;
+}
+
+// Rewrites the journal with the live entries only: into a new file first,
+// which then replaces the old one, so a crash leaves one or the other.
+// Called with m_mutex held.
+bool ContainerRegistry::Compact() {
+    const wxString tempPath = m_path + ".tmp";
+    std::FILE* temp = wxFopen(tempPath, "wb");
+    if (!temp) {
+        return false;
+    }
+    std::string records;
+    for (const auto& item : m_entries) {
+        records += Serialize(item.second, false);
+    }
+    const bool written = std::fwrite(records.data(), 1, records.size(), temp) == records.size() && Sync(temp);
+    std::fclose(temp);
+    if (!written) {
+        wxRemoveFile(tempPath);
+        return false;
+    }
+
+    if (m_journal) {
+        std::fclose(m_journal);
+        m_journal = nullptr;
+    }
+    const bool renamed = wxRenameFile(tempPath, m_path, true);
+    if (!renamed) {
+        wxRemoveFile(tempPath);
+    }
+    m_journal = wxFopen(m_path, "ab");
+    if (renamed) {
+        m_records = m_entries.size();
+    }
+    return renamed && m_journal;
+}
+
+// Compacts once superseded records outnumber the live ones
+void ContainerRegistry::MaybeCompact() {
+    if (m_records >= MIN_COMPACT_RECORDS && m_records > 2 * m_entries.size()) {
+        Compact();
+    }
+}
+
+// "<checksum> <state>\t<id>\t<updated>\t<iso path>\t<tree dir>\t<project dir>";
+// the checksum covers everything after the space. Records written before
+// the project directory was added lack the last field.
+std::string ContainerRegistry::Serialize(const Entry& entry, bool removed) {
+    std::string payload = removed ? REMOVED : StateName(entry.state);
+    payload += '\t';
+    payload += entry.id.utf8_str();
+    payload += '\t';
+    payload += std::to_string(entry.updated);
+    payload += '\t';
+    payload += entry.isoPath.utf8_str();
+    payload += '\t';
+    payload += entry.treeDir.utf8_str();
+    payload += '\t';
+    payload += entry.projectDir.utf8_str();
+    return Checksum(payload) + " " + payload + "\n";
+}
+
+bool ContainerRegistry::Parse(const std::string& line, Entry& entry, bool& removed) {
+    if (line.size() <= CHECKSUM_LENGTH + 1 || line[CHECKSUM_LENGTH] != ' ') {
+        return false;
+    }
+    const std::string payload = line.substr(CHECKSUM_LENGTH + 1);
+    if (line.compare(0, CHECKSUM_LENGTH, Checksum(payload)) != 0) {
+        return false;
+    }
+
+    wxArrayString fields = wxStringTokenize(wxString::FromUTF8(payload.c_str()), "\t", wxTOKEN_RET_EMPTY_ALL);
+    if ((fields.size() != 5 && fields.size() != 6) || fields[1].IsEmpty()) {
+        return false;
+    }
+    removed = fields[0] == REMOVED;
+    if (!removed) {
+        bool known = false;
+        for (State state : ALL_STATES) {
+            if (fields[0] == StateName(state)) {
+                entry.state = state;
+                known = true;
+            }
+        }
+        if (!known) {
+            return false;
+        }
+    }
+    entry.id = fields[1];
+    fields[2].ToLongLong(&entry.updated);
+    entry.isoPath = fields[3];
+    entry.treeDir = fields[4];
+    if (fields.size() == 6) {
+        entry.projectDir = fields[5];
+    }
+    return true;
+}
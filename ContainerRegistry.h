@@ -0,0 +1,77 @@
+#ifndef CONTAINER_REGISTRY_H
+#define CONTAINER_REGISTRY_H
+
+#include <wx/string.h>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Containers created by the application and what they are doing, kept in
+// an append-only journal so a crash can't lose track of one. Every change
+// appends the entry's full record and syncs it to disk; a record torn by
+// a crash fails its checksum and is skipped on load. Once the journal
+// holds mostly superseded records it is rewritten with just the live
+// entries, so loading it costs O(containers), not O(history).
+//
+// Safe to use from any thread.
+class ContainerRegistry {
+public:
+    enum class State {
+        Provisioning,   // Created, not set up yet
+        Ready,          // Set up and usable
+        Building,       // Creating an ISO
+        Done,           // ISO created
+        Orphaned        // Left by an earlier run, to be removed
+    };
+
+    struct Entry {
+        wxString id;
+        State state = State::Provisioning;
+        wxString isoPath;
+        wxString treeDir;       // Host directory owned by the container, if any
+        wxString projectDir;    // Project whose build the container holds, if any
+        long long updated = 0;  // Seconds since the epoch
+    };
+
+    explicit ContainerRegistry(const wxString& journalPath);
+    ~ContainerRegistry();
+    ContainerRegistry(const ContainerRegistry&) = delete;
+    ContainerRegistry& operator=(const ContainerRegistry&) = delete;
+
+    // Loads the journal, compacting it if worthwhile
+    bool Open();
+
+    bool Set(Entry entry);
+    bool SetState(const wxString& id, State state);
+    bool Remove(const wxString& id);
+
+    bool Find(const wxString& id, Entry& entry) const;
+    std::vector<Entry> GetEntries(State state) const;
+    std::vector<Entry> GetEntries() const;
+
+    // Called once at startup: everything still registered belongs to an
+    // earlier run
+    void OrphanAll();
+
+    static const char* StateName(State state);
+
+private:
+    bool Append(const std::string& record);
+    bool Compact();
+    void MaybeCompact();
+
+    static std::string Serialize(const Entry& entry, bool removed);
+    static bool Parse(const std::string& line, Entry& entry, bool& removed);
+
+    wxString m_path;
+    mutable std::mutex m_mutex;
+    std::map<wxString, Entry> m_entries;
+    std::FILE* m_journal = nullptr;
+    size_t m_records = 0;   // Records in the journal, live or not
+
+    static const size_t MIN_COMPACT_RECORDS = 64;
+};
+
+#endif // CONTAINER_REGISTRY_H
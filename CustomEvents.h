@@ -7,5 +7,15 @@
 wxDECLARE_EVENT(FILE_COPY_COMPLETE_EVENT, wxCommandEvent); // Existing event
 wxDECLARE_EVENT(PYTHON_LOG_UPDATE, wxCommandEvent);        // New event for log updates
 wxDECLARE_EVENT(PYTHON_TASK_COMPLETED, wxCommandEvent);    // New event for task completion
+wxDECLARE_EVENT(ISO_DETECT_PROGRESS, wxCommandEvent);      // ISO detection progress, percent in GetInt()
+wxDECLARE_EVENT(ISO_DETECT_COMPLETE, wxCommandEvent);      // ISO detection result (ISODetectResult*)
+wxDECLARE_EVENT(ISO_EXTRACT_COMPLETE, wxCommandEvent);     // Host-side ISO tree extraction finished
+wxDECLARE_EVENT(BUILDER_IMAGE_READY, wxCommandEvent);      // Builder image checked or built, tag in GetString()
+wxDECLARE_EVENT(DOCKER_EXEC_OUTPUT, wxCommandEvent);       // One line of streamed exec output
+wxDECLARE_EVENT(DOCKER_EXEC_COMPLETE, wxCommandEvent);     // Streamed exec finished, exit code in GetInt()
+wxDECLARE_EVENT(CONTAINER_REMOVED, wxCommandEvent);        // ContainerReaper finished, ID in GetString()
+wxDECLARE_EVENT(BUILD_STAGE, wxCommandEvent);              // Build pipeline stage event (BuildStage*)
+wxDECLARE_EVENT(ARTIFACT_DOWNLOAD_PROGRESS, wxCommandEvent); // Artifact copy progress, percent in GetInt()
+wxDECLARE_EVENT(ARTIFACT_DOWNLOAD_COMPLETE, wxCommandEvent); // Artifact copied (ArtifactDownloadResult*)
 
 #endif // CUSTOM_EVENTS_H
\ No newline at end of file
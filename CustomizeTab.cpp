@@ -1,5 +1,6 @@
 #include "CustomizeTab.h"
 #include "SecondWindow.h"
+#include "ChrootAgent.h"
 #include <wx/filename.h>
 #include <wx/wfstream.h>
 #include <wx/dir.h>
@@ -549,29 +550,6 @@ wxString CustomizeTab::GetProjectDir()
     wxString cwd = wxGetCwd();
     return cwd;
 }
-wxString CustomizeTab::ExecuteCommandOnMainThread(const wxString &command, wxArrayString *output)
-{
-    wxString result;
-    wxSemaphore semaphore(0, 1);
-    CallAfter([this, command, output, &result, &semaphore]()
-              {
-        int exitCode;
-        if (output) {
-            exitCode = wxExecute(command, *output);
-        } else {
-            exitCode = wxExecute(command, wxEXEC_SYNC);
-        }
-        if (exitCode == 0) {
-            if (output && !output->IsEmpty()) {
-                result = (*output)[0];
-            } else {
-                result = "SUCCESS";
-            }
-        }
-        semaphore.Post(); });
-    semaphore.Wait();
-    return result;
-}
 wxString CustomizeTab::GetWallpaperDirFromCommand(const wxString &containerId, const wxString &detectedDE)
 {
     wxString command;
@@ -595,12 +573,13 @@ wxString CustomizeTab::GetWallpaperDirFromCommand(const wxString &containerId, c
     {
         return wxEmptyString;
     }
-    wxString fullCommand = wxString::Format(
-        "docker exec %s /bin/bash -c \"chroot /root/custom_iso/squashfs-root /bin/bash -c '%s'\"",
-        containerId, command);
-    wxArrayString output;
-    wxString result = ExecuteCommandOnMainThread(fullCommand, &output);
-    if (!result.IsEmpty() && !output.IsEmpty())
+    DockerClient::ExecResult result;
+    if (!ChrootAgent::Get().Run(containerId, command, result) || result.exitCode != 0)
+    {
+        return wxEmptyString;
+    }
+    wxArrayString output = result.GetOutputLines();
+    if (!output.IsEmpty())
     {
         wxString wallpaperPath = output[0].Trim();
         if (wallpaperPath.StartsWith("'file://"))
@@ -611,7 +590,7 @@ wxString CustomizeTab::GetWallpaperDirFromCommand(const wxString &containerId, c
         {
             wallpaperPath = wallpaperPath.Mid(7);
         }
-        wxString fullDirPath = "/root/custom_iso/squashfs-root" + wallpaperPath.BeforeLast('/');
+        wxString fullDirPath = ChrootAgent::ROOT + wallpaperPath.BeforeLast('/');
         if (!fullDirPath.EndsWith("/"))
         {
             fullDirPath += "/";
@@ -670,10 +649,9 @@ wxThread::ExitCode WallpaperLoadThread::Entry()
             cont = dir.GetNext(&filename);
         }
     }
-    wxString cpCommand = wxString::Format("docker cp %s:%s \"%s\"", containerId, wallpaperDir, localWallpaperDir);
-    wxString result = m_tab->ExecuteCommandOnMainThread(cpCommand);
-    if (result != "SUCCESS")
+    if (!DockerClient::Get().CopyFromContainer(containerId, wallpaperDir, localWallpaperDir))
     {
+        wxLogDebug("WallpaperLoadThread: %s", DockerClient::Get().GetLastError());
         return (ExitCode)1;
     }
     auto processDirectory = [&](wxDir &dir, const wxString &currentPath, auto &processDir) -> void
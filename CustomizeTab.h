@@ -17,7 +17,6 @@ public:
     // These methods need to be public or friend-accessible to WallpaperLoadThread
     wxString GetProjectDir();
     wxString GetWallpaperDirFromCommand(const wxString &containerId, const wxString &detectedDE);
-    wxString ExecuteCommandOnMainThread(const wxString &command, wxArrayString *output = nullptr);
 
 private:
     void CreateContent();
@@ -6,63 +6,29 @@
 #include <wx/file.h>
 #include <wx/wfstream.h>
 #include <wx/txtstrm.h>
-#include <wx/process.h>
 
 // Custom event declaration
 wxDEFINE_EVENT(FILE_COPY_COMPLETE_EVENT, wxCommandEvent);
 
-// Custom wxProcess subclass for async Docker commands
-class DesktopInstallProcess : public wxProcess
-{
-public:
-    DesktopInstallProcess(DesktopTab *parent, const wxString &newEnv, wxButton *button)
-        : wxProcess(parent), m_parent(parent), m_newEnv(newEnv), m_button(button) {}
-
-    virtual void OnTerminate(int pid, int status) override
-    {
-        if (m_parent)
-        {
-            if (status == 0)
-            {
-                wxLogDebug("DesktopInstallProcess::OnTerminate - Successfully installed %s", m_newEnv);
-                wxString guiFilePath = m_parent->GetGuiFilePath();
-                wxFile guiFile;
-                if (guiFile.Create(guiFilePath, true) && guiFile.IsOpened())
-                {
-                    guiFile.Write(m_newEnv);
-                    guiFile.Close();
-                    wxLogDebug("DesktopInstallProcess::OnTerminate - Updated detected_gui.txt with %s", m_newEnv);
-                }
-                m_parent->UpdateGUILabel(m_newEnv);
-                wxMessageBox(
-                    wxString::Format("%s installed successfully!", m_newEnv),
-                    "Success",
-                    wxOK | wxICON_INFORMATION,
-                    m_parent);
-            }
-            else
-            {
-                wxLogDebug("DesktopInstallProcess::OnTerminate - Failed to install %s, status: %d", m_newEnv, status);
-                wxMessageBox("Failed to install new environment! Check logs.", "Error", wxICON_ERROR, m_parent);
-            }
-            if (m_button)
-                m_button->Enable();
-            delete this; // Clean up process object
-        }
-    }
-
-private:
-    DesktopTab *m_parent;
-    wxString m_newEnv;
-    wxButton *m_button;
-};
-
 DesktopTab::DesktopTab(wxWindow *parent)
-    : wxPanel(parent), m_gridSizer(nullptr)
+    : wxPanel(parent), m_gridSizer(nullptr), m_installThread(nullptr), m_installButton(nullptr)
 {
     CreateDesktopTab();
     Bind(wxEVT_SIZE, &DesktopTab::OnSize, this);
     Bind(FILE_COPY_COMPLETE_EVENT, &DesktopTab::OnFileCopyComplete, this);
+    Bind(DOCKER_EXEC_OUTPUT, &DesktopTab::OnInstallOutput, this, ID_DESKTOP_INSTALL_EXEC);
+    Bind(DOCKER_EXEC_COMPLETE, &DesktopTab::OnInstallComplete, this, ID_DESKTOP_INSTALL_EXEC);
+}
+
+DesktopTab::~DesktopTab()
+{
+    if (m_installThread)
+    {
+        m_installThread->Cancel();
+        m_installThread->Wait();
+        delete m_installThread;
+        m_installThread = nullptr;
+    }
 }
 
 wxBitmap DesktopTab::LoadImage(const wxString &imageName)
@@ -327,6 +293,11 @@ void DesktopTab::CreateDesktopTab()
             wxString newPackage = packageNames[i];
             wxLogDebug("DesktopTab::InstallButton - Installing %s (package: %s)", newEnv, newPackage);
 
+            if (m_installThread) {
+                wxMessageBox(wxString::Format("%s is still being installed.", m_installEnv), "Info", wxOK | wxICON_INFORMATION);
+                return;
+            }
+
             wxWindow* parent = GetParent();
             SecondWindow* secondWindow = nullptr;
             wxString containerIdPath;
@@ -401,30 +372,35 @@ void DesktopTab::CreateDesktopTab()
             if (btn) btn->Disable();
             wxLogDebug("DesktopTab::InstallButton - Disabled install button for %s", newEnv);
 
-            // Updated command with purge and session configuration
-            wxString command;
+            // Updated command with purge and session configuration, run in the chroot
+            wxString script;
             if (currentEnv != "Not detected" && !currentPackage.IsEmpty()) {
-                command = wxString::Format(
-                    "docker exec %s /bin/bash -c \"chroot /root/custom_iso/squashfs-root /bin/bash -c 'apt-get update && apt-get purge -y %s && apt-get autoremove -y && apt-get install -y %s && echo -e \\\"[Seat:*]\\\\nuser-session=xfce\\\" > /etc/lightdm/lightdm.conf'\"",
-                    containerId, currentPackage, newPackage
+                script = wxString::Format(
+                    "apt-get update && apt-get purge -y %s && apt-get autoremove -y && apt-get install -y %s && echo -e \"[Seat:*]\\nuser-session=xfce\" > /etc/lightdm/lightdm.conf",
+                    currentPackage, newPackage
                 );
             } else {
-                command = wxString::Format(
-                    "docker exec %s /bin/bash -c \"chroot /root/custom_iso/squashfs-root /bin/bash -c 'apt-get update && apt-get install -y %s && echo -e \\\"[Seat:*]\\\\nuser-session=xfce\\\" > /etc/lightdm/lightdm.conf'\"",
-                    containerId, newPackage
+                script = wxString::Format(
+                    "apt-get update && apt-get install -y %s && echo -e \"[Seat:*]\\nuser-session=xfce\" > /etc/lightdm/lightdm.conf",
+                    newPackage
                 );
             }
-            wxLogDebug("DesktopTab::InstallButton - Executing command: %s", command);
+            wxLogDebug("DesktopTab::InstallButton - Executing script: %s", script);
 
-            DesktopInstallProcess* proc = new DesktopInstallProcess(this, newEnv, btn);
-            long pid = wxExecute(command, wxEXEC_ASYNC | wxEXEC_HIDE_CONSOLE, proc);
-            if (pid == 0) {
+            // apt's output is streamed into the header while it runs
+            m_installEnv = newEnv;
+            m_installButton = btn;
+            m_installThread = new DockerExecThread(this, ID_DESKTOP_INSTALL_EXEC, containerId, script);
+            if (m_installThread->Run() != wxTHREAD_NO_ERROR) {
                 wxLogDebug("DesktopTab::InstallButton - Failed to execute command for %s", newEnv);
                 wxMessageBox("Failed to start installation process!", "Error", wxICON_ERROR);
-                delete proc;
+                delete m_installThread;
+                m_installThread = nullptr;
+                m_installButton = nullptr;
                 if (btn) btn->Enable();
             } else {
-                wxLogDebug("DesktopTab::InstallButton - Started installation process for %s, PID: %ld", newEnv, pid);
+                m_textDisplay->SetLabel(wxString::Format("Installing %s...", newEnv));
+                wxLogDebug("DesktopTab::InstallButton - Started installation of %s", newEnv);
             } });
 
         card->SetSizer(cardSizer);
@@ -439,6 +415,57 @@ void DesktopTab::CreateDesktopTab()
     wxLogDebug("DesktopTab::CreateDesktopTab - Desktop tab created and laid out");
 }
 
+// Shows the line apt printed last so a long install visibly progresses
+void DesktopTab::OnInstallOutput(wxCommandEvent &event)
+{
+    wxString line = event.GetString();
+    line.Trim(true).Trim(false);
+    if (line.IsEmpty())
+        return;
+    wxLogDebug("DesktopTab::OnInstallOutput - %s", line);
+    if (line.length() > 80)
+        line = line.Left(77) + "...";
+    m_textDisplay->SetLabel(wxString::Format("Installing %s: %s", m_installEnv, line));
+}
+
+void DesktopTab::OnInstallComplete(wxCommandEvent &event)
+{
+    if (!m_installThread)
+        return;
+    m_installThread->Wait();
+    delete m_installThread;
+    m_installThread = nullptr;
+
+    int status = event.GetInt();
+    if (status == 0)
+    {
+        wxLogDebug("DesktopTab::OnInstallComplete - Successfully installed %s", m_installEnv);
+        wxString guiFilePath = GetGuiFilePath();
+        wxFile guiFile;
+        if (guiFile.Create(guiFilePath, true) && guiFile.IsOpened())
+        {
+            guiFile.Write(m_installEnv);
+            guiFile.Close();
+            wxLogDebug("DesktopTab::OnInstallComplete - Updated detected_gui.txt with %s", m_installEnv);
+        }
+        UpdateGUILabel(m_installEnv);
+        wxMessageBox(
+            wxString::Format("%s installed successfully!", m_installEnv),
+            "Success",
+            wxOK | wxICON_INFORMATION,
+            this);
+    }
+    else
+    {
+        wxLogDebug("DesktopTab::OnInstallComplete - Failed to install %s, status: %d %s", m_installEnv, status, event.GetString());
+        UpdateTextFromFile();
+        wxMessageBox("Failed to install new environment! Check logs.", "Error", wxICON_ERROR, this);
+    }
+    if (m_installButton)
+        m_installButton->Enable();
+    m_installButton = nullptr;
+}
+
 void DesktopTab::UpdateGUILabel(const wxString &guiName)
 {
     wxLogDebug("DesktopTab::UpdateGUILabel - Setting label with GUI name: %s", guiName);
@@ -3,6 +3,7 @@
 
 #include <wx/wx.h>
 #include "CustomEvents.h" // Include the shared header
+#include "DockerExecThread.h"
 
 // Forward declarations
 class SecondWindow;
@@ -10,6 +11,7 @@ class SecondWindow;
 class DesktopTab : public wxPanel {
 public:
     DesktopTab(wxWindow* parent);
+    ~DesktopTab();
     void RecalculateLayout(int windowWidth);
     void UpdateTextFromFile();
     void UpdateGUILabel(const wxString& guiName);
@@ -22,11 +24,18 @@ private:
     void OnFileCopyComplete(wxCommandEvent& event);
     wxBitmap ConvertToGrayscale(const wxBitmap& original);
     void ApplyGrayscaleToCards(const wxString& detectedEnv);
+    void OnInstallOutput(wxCommandEvent& event);
+    void OnInstallComplete(wxCommandEvent& event);
 
     wxFlexGridSizer* m_gridSizer;
     wxScrolledWindow* m_scrolledWindow;
     wxStaticText* m_textDisplay;
     wxButton* m_reloadButton;
+
+    // Desktop environment install streaming apt's output
+    DockerExecThread* m_installThread;
+    wxString m_installEnv;
+    wxButton* m_installButton;   // Re-enabled when the install ends
 };
 
 #endif // DESKTOPTAB_H
\ No newline at end of file
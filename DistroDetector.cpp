@@ -0,0 +1,208 @@
+#include "DistroDetector.h"
+#include <yaml-cpp/yaml.h>
+#include <algorithm>
+#include <cctype>
+#include <deque>
+#include <sstream>
+
+namespace {
+
+std::string trim(const std::string& text) {
+    const char* whitespace = " \t\r\n";
+    size_t begin = text.find_first_not_of(whitespace);
+    if (begin == std::string::npos) {
+        return "";
+    }
+    size_t end = text.find_last_not_of(whitespace);
+    return text.substr(begin, end - begin + 1);
+}
+
+std::string unquote(std::string value) {
+    value.erase(std::remove(value.begin(), value.end(), '"'), value.end());
+    return value;
+}
+
+unsigned char foldCase(unsigned char c) {
+    return static_cast<unsigned char>(std::tolower(c));
+}
+
+const std::string VERSION_KEYWORD = "version";
+
+} // namespace
+
+DistroDetector::DistroDetector(std::vector<Distribution> distributions)
+    : m_distributions(std::move(distributions)) {
+    compile();
+}
+
+DistroDetector DistroDetector::fromConfig(const YAML::Node& config) {
+    std::vector<Distribution> distributions;
+    const auto& node = config["distributions"];
+    if (node && node.IsSequence()) {
+        for (const auto& distro : node) {
+            if (!distro["pattern"] || !distro["name"]) {
+                continue;
+            }
+            distributions.push_back({distro["pattern"].as<std::string>(), distro["name"].as<std::string>()});
+        }
+    }
+    return DistroDetector(std::move(distributions));
+}
+
+std::string DistroDetector::detect(const std::string& releaseContent) const {
+    const ScanResult result = scan(releaseContent);
+    if (result.distribution < 0) {
+        return "Unknown Distribution";
+    }
+
+    const std::string& name = m_distributions[result.distribution].name;
+    std::string version;
+    if (result.versionEnd != std::string::npos) {
+        for (size_t i = result.versionEnd; i < releaseContent.size(); ++i) {
+            char c = releaseContent[i];
+            if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+                version += c;
+            } else if (!version.empty()) {
+                break;
+            }
+        }
+    }
+    return version.empty() ? name : name + " " + version;
+}
+
+int DistroDetector::match(const std::string& content) const {
+    return scan(content).distribution;
+}
+
+// Builds the automaton as a complete DFA: trie transitions first, then the
+// failure links folded into the missing ones breadth-first, so scanning
+// does exactly one table lookup per byte.
+void DistroDetector::compile() {
+    std::vector<std::string> patterns;
+    for (auto& distro : m_distributions) {
+        std::transform(distro.pattern.begin(), distro.pattern.end(), distro.pattern.begin(),
+                       [](unsigned char c) { return static_cast<char>(foldCase(c)); });
+        patterns.push_back(distro.pattern);
+    }
+    patterns.push_back(VERSION_KEYWORD);
+
+    m_byteClass.fill(0);
+    m_classCount = 1;
+    for (const auto& pattern : patterns) {
+        for (unsigned char c : pattern) {
+            if (m_byteClass[c] == 0) {
+                for (int b = 0; b < 256; ++b) {
+                    if (foldCase(static_cast<unsigned char>(b)) == c) {
+                        m_byteClass[b] = static_cast<std::uint8_t>(m_classCount);
+                    }
+                }
+                ++m_classCount;
+            }
+        }
+    }
+
+    m_transitions.assign(m_classCount, -1);
+    m_output.assign(1, -1);
+    m_versionOutput.assign(1, false);
+    for (size_t p = 0; p < patterns.size(); ++p) {
+        if (patterns[p].empty()) {
+            continue;
+        }
+        std::int32_t state = 0;
+        for (unsigned char c : patterns[p]) {
+            std::int32_t& next = m_transitions[state * m_classCount + m_byteClass[c]];
+            if (next < 0) {
+                next = static_cast<std::int32_t>(m_output.size());
+                m_transitions.resize(m_transitions.size() + m_classCount, -1);
+                m_output.push_back(-1);
+                m_versionOutput.push_back(false);
+            }
+            state = m_transitions[state * m_classCount + m_byteClass[c]];
+        }
+        if (p + 1 == patterns.size()) {
+            m_versionOutput[state] = true;
+        } else if (m_output[state] < 0) {
+            m_output[state] = static_cast<std::int32_t>(p);  // Duplicates keep the first entry
+        }
+    }
+
+    // A state's own pattern is the longest one ending there; otherwise the
+    // best output is inherited from its failure state
+    std::vector<std::int32_t> failure(m_output.size(), 0);
+    std::deque<std::int32_t> pending;
+    for (size_t c = 0; c < m_classCount; ++c) {
+        std::int32_t& next = m_transitions[c];
+        if (next < 0) {
+            next = 0;
+        } else {
+            pending.push_back(next);
+        }
+    }
+    while (!pending.empty()) {
+        const std::int32_t state = pending.front();
+        pending.pop_front();
+        const std::int32_t fail = failure[state];
+        if (m_output[state] < 0) {
+            m_output[state] = m_output[fail];
+        }
+        if (m_versionOutput[fail]) {
+            m_versionOutput[state] = true;
+        }
+        for (size_t c = 0; c < m_classCount; ++c) {
+            std::int32_t& next = m_transitions[state * m_classCount + c];
+            const std::int32_t fallback = m_transitions[fail * m_classCount + c];
+            if (next < 0) {
+                next = fallback;
+            } else {
+                failure[next] = fallback;
+                pending.push_back(next);
+            }
+        }
+    }
+}
+
+DistroDetector::ScanResult DistroDetector::scan(const std::string& content) const {
+    ScanResult result;
+    if (m_transitions.empty()) {
+        return result;
+    }
+
+    std::int32_t state = 0;
+    size_t bestLength = 0;
+    for (size_t i = 0; i < content.size(); ++i) {
+        state = m_transitions[state * m_classCount + m_byteClass[static_cast<unsigned char>(content[i])]];
+        const std::int32_t output = m_output[state];
+        if (output >= 0) {
+            const size_t length = m_distributions[output].pattern.size();
+            if (length > bestLength || (length == bestLength && output < result.distribution)) {
+                result.distribution = output;
+                bestLength = length;
+            }
+        }
+        if (result.versionEnd == std::string::npos && m_versionOutput[state]) {
+            result.versionEnd = i + 1;
+        }
+    }
+    return result;
+}
+
+std::string DistroDetector::nameFromOsRelease(const std::string& content) {
+    std::string name;
+    std::string version;
+
+    std::istringstream lines(content);
+    std::string line;
+    while (std::getline(lines, line)) {
+        line = trim(line);
+        if (line.compare(0, 5, "NAME=") == 0) {
+            name = unquote(line.substr(5));
+        } else if (line.compare(0, 8, "VERSION=") == 0) {
+            version = unquote(line.substr(8));
+        }
+    }
+
+    if (!name.empty() && !version.empty()) {
+        return name + " " + version;
+    }
+    return name;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace YAML {
+class Node;
+}
+
+// Maps release and os-release text to a distribution name using the
+// "distributions" table of config.yaml. Kept free of wx so it can be used
+// from worker threads and the benchmarks.
+//
+// The patterns are compiled once into an Aho-Corasick automaton over
+// case-folded bytes, so a text is scanned in a single pass however many
+// signatures the table holds.
+class DistroDetector {
+public:
+    struct Distribution {
+        std::string pattern;   // Lower-case substring searched for
+        std::string name;      // Display name reported on a match
+    };
+
+    DistroDetector() = default;
+    explicit DistroDetector(std::vector<Distribution> distributions);
+
+    // Reads the "distributions" sequence; entries without a pattern or a
+    // name are skipped
+    static DistroDetector fromConfig(const YAML::Node& config);
+
+    // Name of the distribution with the longest pattern occurring in the
+    // content (earlier table entries win ties), followed by the version
+    // found after "version" if there is one. Returns "Unknown Distribution"
+    // when nothing matches.
+    std::string detect(const std::string& releaseContent) const;
+
+    // Index into distributions() of the best match, -1 if there is none
+    int match(const std::string& content) const;
+
+    // "NAME VERSION" from os-release style KEY=value lines, empty without NAME
+    static std::string nameFromOsRelease(const std::string& content);
+
+    const std::vector<Distribution>& distributions() const { return m_distributions; }
+
+private:
+    struct ScanResult {
+        int distribution = -1;
+        std::size_t versionEnd = std::string::npos;  // Offset just past "version"
+    };
+
+    void compile();
+    ScanResult scan(const std::string& content) const;
+
+    std::vector<Distribution> m_distributions;
+
+    // Bytes that occur in no pattern share class 0, which keeps the
+    // transition table at states x classes instead of states x 256
+    std::array<std::uint8_t, 256> m_byteClass{};
+    std::size_t m_classCount = 1;
+    std::vector<std::int32_t> m_transitions;
+    std::vector<std::int32_t> m_output;       // Best distribution ending at each state
+    std::vector<bool> m_versionOutput;        // "version" ends at the state
+};
@@ -0,0 +1,1645 @@
+#include "DockerClient.h"
+#include <wx/app.h>
+#include <wx/evtloop.h>
+#include <wx/file.h>
+#include <wx/filename.h>
+#include <wx/log.h>
+#include <wx/process.h>
+#include <wx/stream.h>
+#include <wx/thread.h>
+#include <wx/tokenzr.h>
+#include <wx/utils.h>
+#include <curl/curl.h>
+#include <rapidjson/document.h>
+#include <rapidjson/writer.h>
+#include <rapidjson/stringbuffer.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef __WXMSW__
+#include <fcntl.h>
+#include <sys/socket.h>
+#endif
+
+namespace {
+
+thread_local wxString t_lastError;
+
+const long CONNECT_TIMEOUT_SECONDS = 5;
+const size_t TAR_BLOCK = 512;
+const std::uint64_t MAX_TAR_FILE_SIZE = 077777777777ULL;  // Eleven octal digits of a ustar header
+const size_t UPLOAD_CHUNK_SIZE = 1024 * 1024;
+const size_t MAX_EXTENDED_HEADER = 1024 * 1024;
+const size_t MAX_RESPONSE_HEADER = 64 * 1024;
+const size_t MAX_PARALLEL_REMOVALS = 4;
+
+#ifdef MSG_NOSIGNAL
+const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+const int SEND_FLAGS = 0;
+#endif
+
+using JsonWriter = rapidjson::Writer<rapidjson::StringBuffer>;
+
+std::string ToUtf8(const wxString& text) {
+    return std::string(text.utf8_str());
+}
+
+// Percent-encodes a path segment or query value
+std::string Escape(const wxString& text) {
+    static const char hex[] = "0123456789ABCDEF";
+    std::string escaped;
+    for (unsigned char c : ToUtf8(text)) {
+        if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+            escaped += static_cast<char>(c);
+        } else {
+            escaped += '%';
+            escaped += hex[c >> 4];
+            escaped += hex[c & 0x0F];
+        }
+    }
+    return escaped;
+}
+
+void WriteString(JsonWriter& writer, const wxString& value) {
+    std::string utf8 = ToUtf8(value);
+    writer.String(utf8.c_str(), static_cast<rapidjson::SizeType>(utf8.size()));
+}
+
+void WriteStrings(JsonWriter& writer, const wxArrayString& values) {
+    writer.StartArray();
+    for (const auto& value : values) {
+        WriteString(writer, value);
+    }
+    writer.EndArray();
+}
+
+// Quotes one argument for the command line wxExecute splits again
+wxString QuoteArgument(const wxString& arg) {
+    if (!arg.IsEmpty() && arg.find_first_of(" \t\"'\\") == wxString::npos) {
+        return arg;
+    }
+    wxString quoted = "\"";
+#ifdef __WXMSW__
+    // Backslashes are only special in front of a quote (CommandLineToArgvW)
+    size_t backslashes = 0;
+    for (wxUniChar c : arg) {
+        if (c == '\\') {
+            ++backslashes;
+            continue;
+        }
+        if (c == '"') {
+            quoted += wxString(2 * backslashes + 1, '\\');
+        } else {
+            quoted += wxString(backslashes, '\\');
+        }
+        quoted += c;
+        backslashes = 0;
+    }
+    quoted += wxString(2 * backslashes, '\\');
+#else
+    for (wxUniChar c : arg) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+#endif
+    quoted += "\"";
+    return quoted;
+}
+
+wxString JoinLines(const wxArrayString& lines) {
+    wxString joined;
+    for (const auto& line : lines) {
+        joined += line + "\n";
+    }
+    return joined;
+}
+
+// Splits the multiplexed exec stream: each frame is an 8 byte header
+// holding the stream (1 = stdout, 2 = stderr) and a big-endian length
+class StreamDemuxer {
+public:
+    using Handler = std::function<void(int stream, const char* data, size_t size)>;
+
+    explicit StreamDemuxer(Handler handler) : m_handler(std::move(handler)) {}
+
+    void Feed(const char* data, size_t size) {
+        while (size > 0) {
+            if (m_remaining == 0) {
+                size_t take = std::min(size, sizeof(m_header) - m_headerFill);
+                std::memcpy(m_header + m_headerFill, data, take);
+                m_headerFill += take;
+                data += take;
+                size -= take;
+                if (m_headerFill < sizeof(m_header)) {
+                    return;
+                }
+                m_headerFill = 0;
+                m_stream = m_header[0] == 2 ? 2 : 1;
+                m_remaining = (static_cast<size_t>(m_header[4]) << 24) | (static_cast<size_t>(m_header[5]) << 16) |
+                              (static_cast<size_t>(m_header[6]) << 8) | static_cast<size_t>(m_header[7]);
+                continue;
+            }
+            size_t take = std::min(size, m_remaining);
+            m_handler(m_stream, data, take);
+            m_remaining -= take;
+            data += take;
+            size -= take;
+        }
+    }
+
+private:
+    Handler m_handler;
+    unsigned char m_header[8];
+    size_t m_headerFill = 0;
+    size_t m_remaining = 0;
+    int m_stream = 1;
+};
+
+// Cuts a byte stream into lines at '\n' or '\r'. A partial line, including
+// a split UTF-8 sequence, waits for the next chunk.
+class LineSplitter {
+public:
+    LineSplitter(int stream, const DockerClient::LineCallback& onLine) : m_stream(stream), m_onLine(onLine) {}
+
+    void Feed(const char* data, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            const char c = data[i];
+            if (c == '\n' || c == '\r') {
+                if (!m_line.empty()) {
+                    m_onLine(m_stream, wxString::FromUTF8(m_line.data(), m_line.size()));
+                    m_line.clear();
+                }
+            } else {
+                m_line += c;
+            }
+        }
+    }
+
+    void Flush() {
+        Feed("\n", 1);
+    }
+
+private:
+    int m_stream;
+    const DockerClient::LineCallback& m_onLine;
+    std::string m_line;
+};
+
+// Keeps a CLI process object alive after the process exits so a worker can
+// drain its pipes. Whichever of termination and the worker comes second
+// deletes it.
+class StreamedProcess : public wxProcess {
+public:
+    StreamedProcess() : m_state(0), m_status(-1) { Redirect(); }
+
+    virtual void OnTerminate(int pid, int status) override {
+        m_status = status;
+        if (m_state.fetch_or(FINISHED) & RELEASED) {
+            delete this;
+        }
+    }
+
+    bool IsFinished() const { return (m_state & FINISHED) != 0; }
+    int GetStatus() const { return m_status; }
+
+    // Called once by the worker when it no longer needs the object
+    void Release() {
+        if (m_state.fetch_or(RELEASED) & FINISHED) {
+            wxTheApp->CallAfter([this]() { delete this; });
+        }
+    }
+
+private:
+    static const int FINISHED = 1;
+    static const int RELEASED = 2;
+    std::atomic<int> m_state;
+    std::atomic<int> m_status;
+};
+
+// Unpacks the tar stream of the archive endpoint below a host directory,
+// the way "docker cp" does. Regular files and directories are created;
+// links and special files are skipped.
+class TarExtractor {
+public:
+    using EntryCallback = std::function<bool(const std::string& name, std::uint64_t size)>;
+
+    explicit TarExtractor(std::filesystem::path root) : m_root(std::move(root)) {}
+
+    // Writes nothing and hands the contents of regular files to onData
+    // instead, each announced by onEntry. Any other kind of entry fails.
+    TarExtractor(EntryCallback onEntry, DockerClient::Sink onData)
+        : m_onEntry(std::move(onEntry)), m_onData(std::move(onData)) {}
+
+    bool Feed(const char* data, size_t size) {
+        while (size > 0) {
+            size_t take = 0;
+            switch (m_state) {
+            case State::Header:
+                take = std::min(size, TAR_BLOCK - m_blockFill);
+                std::memcpy(m_block + m_blockFill, data, take);
+                m_blockFill += take;
+                if (m_blockFill == TAR_BLOCK) {
+                    m_blockFill = 0;
+                    if (!ParseHeader()) {
+                        return false;
+                    }
+                }
+                break;
+            case State::Data:
+                take = static_cast<size_t>(std::min<std::uint64_t>(size, m_remaining));
+                if (m_streaming) {
+                    if (!m_onData(data, take)) {
+                        return Error("Transfer aborted");
+                    }
+                } else if (m_file.is_open()) {
+                    m_file.write(data, static_cast<std::streamsize>(take));
+                } else if (m_collect) {
+                    m_extended.append(data, take);
+                }
+                m_remaining -= take;
+                if (m_remaining == 0 && !EndEntry()) {
+                    return false;
+                }
+                break;
+            case State::Padding:
+                take = static_cast<size_t>(std::min<std::uint64_t>(size, m_remaining));
+                m_remaining -= take;
+                if (m_remaining == 0) {
+                    m_state = State::Header;
+                }
+                break;
+            }
+            data += take;
+            size -= take;
+        }
+        return true;
+    }
+
+    bool Finish() {
+        if (m_state != State::Header || m_blockFill != 0) {
+            return Error("Archive stream ended inside an entry");
+        }
+        return true;
+    }
+
+    const std::string& GetError() const { return m_error; }
+
+private:
+    enum class State { Header, Data, Padding };
+
+    bool Error(const std::string& message) {
+        m_error = message;
+        m_file.close();
+        return false;
+    }
+
+    static std::uint64_t ParseNumber(const char* field, size_t length) {
+        std::uint64_t value = 0;
+        if (static_cast<unsigned char>(field[0]) & 0x80) {
+            // GNU base-256 encoding, used for sizes of 8 GiB and more
+            value = static_cast<unsigned char>(field[0]) & 0x7F;
+            for (size_t i = 1; i < length; ++i) {
+                value = (value << 8) | static_cast<unsigned char>(field[i]);
+            }
+            return value;
+        }
+        for (size_t i = 0; i < length; ++i) {
+            if (field[i] >= '0' && field[i] <= '7') {
+                value = value * 8 + (field[i] - '0');
+            } else if (value != 0 || (field[i] != ' ' && field[i] != '\0')) {
+                break;
+            }
+        }
+        return value;
+    }
+
+    static std::string ParseText(const char* field, size_t length) {
+        return std::string(field, strnlen(field, length));
+    }
+
+    // Joins an archive path onto the root, refusing anything that would
+    // land outside it. Returns an empty path for the root itself.
+    bool TargetFor(const std::string& name, std::filesystem::path& target) {
+        target.clear();
+        std::filesystem::path relative;
+        size_t start = 0;
+        while (start <= name.size()) {
+            size_t end = name.find('/', start);
+            if (end == std::string::npos) {
+                end = name.size();
+            }
+            std::string part = name.substr(start, end - start);
+            if (part == "..") {
+                return Error("Archive entry escapes the destination: " + name);
+            }
+            if (!part.empty() && part != ".") {
+                relative /= std::filesystem::u8path(part);
+            }
+            start = end + 1;
+        }
+        if (!relative.empty()) {
+            target = m_root / relative;
+        }
+        return true;
+    }
+
+    void ParsePaxRecords() {
+        size_t pos = 0;
+        while (pos < m_extended.size()) {
+            size_t space = m_extended.find(' ', pos);
+            if (space == std::string::npos) {
+                break;
+            }
+            size_t length = std::strtoull(m_extended.c_str() + pos, nullptr, 10);
+            if (length == 0 || pos + length > m_extended.size() || space + 1 >= pos + length) {
+                break;
+            }
+            std::string record = m_extended.substr(space + 1, pos + length - space - 2);
+            size_t equals = record.find('=');
+            if (equals != std::string::npos) {
+                std::string key = record.substr(0, equals);
+                if (key == "path") {
+                    m_nextName = record.substr(equals + 1);
+                } else if (key == "size") {
+                    m_nextSize = std::strtoull(record.c_str() + equals + 1, nullptr, 10);
+                    m_hasNextSize = true;
+                }
+            }
+            pos += length;
+        }
+    }
+
+    bool ParseHeader() {
+        if (std::all_of(m_block, m_block + TAR_BLOCK, [](char c) { return c == 0; })) {
+            return true;  // End-of-archive marker
+        }
+
+        std::string name = ParseText(m_block, 100);
+        if (std::memcmp(m_block + 257, "ustar", 5) == 0 && m_block[345] != 0) {
+            name = ParseText(m_block + 345, 155) + "/" + name;
+        }
+        std::uint64_t size = ParseNumber(m_block + 124, 12);
+        const char type = m_block[156];
+
+        if (type == 'x' || type == 'L') {
+            if (size > MAX_EXTENDED_HEADER) {
+                return Error("Oversized extended tar header");
+            }
+            m_collect = true;
+            m_extendedType = type;
+            m_extended.clear();
+            return BeginData(size);
+        }
+        if (type == 'g' || type == 'K') {
+            return BeginData(size);  // Global headers and long link names don't matter here
+        }
+
+        if (!m_nextName.empty()) {
+            name = m_nextName;
+            m_nextName.clear();
+        }
+        if (m_hasNextSize) {
+            size = m_nextSize;
+            m_hasNextSize = false;
+        }
+
+        if (m_onEntry) {
+            if (type != '0' && type != '\0' && type != '7') {
+                return Error("Not a regular file: " + name);
+            }
+            if (!m_onEntry(name, size)) {
+                return Error("Transfer aborted");
+            }
+            m_streaming = true;
+            return BeginData(size);
+        }
+
+        std::filesystem::path target;
+        if (!TargetFor(name, target)) {
+            return false;
+        }
+        std::error_code ec;
+        if (type == '5') {
+            if (!target.empty()) {
+                std::filesystem::create_directories(target, ec);
+                if (ec) {
+                    return Error("Cannot create " + target.u8string() + ": " + ec.message());
+                }
+            }
+        } else if ((type == '0' || type == '\0' || type == '7') && !target.empty()) {
+            std::filesystem::create_directories(target.parent_path(), ec);
+            m_file.open(target, std::ios::binary | std::ios::trunc);
+            if (!m_file) {
+                return Error("Cannot create " + target.u8string());
+            }
+        }
+        return BeginData(size);
+    }
+
+    bool BeginData(std::uint64_t size) {
+        m_remaining = size;
+        m_padding = (TAR_BLOCK - size % TAR_BLOCK) % TAR_BLOCK;
+        if (size == 0) {
+            return EndEntry();
+        }
+        m_state = State::Data;
+        return true;
+    }
+
+    bool EndEntry() {
+        m_streaming = false;
+        if (m_file.is_open()) {
+            m_file.close();
+            if (!m_file) {
+                return Error("Failed writing extracted file");
+            }
+        }
+        if (m_collect) {
+            m_collect = false;
+            if (m_extendedType == 'x') {
+                ParsePaxRecords();
+            } else {
+                m_nextName = m_extended.substr(0, strnlen(m_extended.c_str(), m_extended.size()));
+            }
+        }
+        m_remaining = m_padding;
+        m_state = m_padding > 0 ? State::Padding : State::Header;
+        return true;
+    }
+
+    std::filesystem::path m_root;
+    EntryCallback m_onEntry;
+    DockerClient::Sink m_onData;
+    bool m_streaming = false;
+    std::string m_error;
+
+    State m_state = State::Header;
+    char m_block[TAR_BLOCK];
+    size_t m_blockFill = 0;
+    std::uint64_t m_remaining = 0;
+    std::uint64_t m_padding = 0;
+    std::ofstream m_file;
+
+    // Extended headers describe the entry that follows them
+    bool m_collect = false;
+    char m_extendedType = 0;
+    std::string m_extended;
+    std::string m_nextName;
+    std::uint64_t m_nextSize = 0;
+    bool m_hasNextSize = false;
+};
+
+// ustar header of a regular file, owned by root with mode 0644
+std::string TarHeader(const std::string& name, size_t size) {
+    std::string header(TAR_BLOCK, '\0');
+    std::memcpy(&header[0], name.data(), std::min<size_t>(name.size(), 100));
+    std::snprintf(&header[100], 8, "%07o", 0644);
+    std::snprintf(&header[108], 8, "%07o", 0);
+    std::snprintf(&header[116], 8, "%07o", 0);
+    std::snprintf(&header[124], 12, "%011llo", static_cast<unsigned long long>(size));
+    std::snprintf(&header[136], 12, "%011o", 0);
+    header[156] = '0';
+    std::memcpy(&header[257], "ustar\0" "00", 8);
+
+    // The checksum is taken with its own field filled with spaces
+    std::memset(&header[148], ' ', 8);
+    unsigned int checksum = 0;
+    for (unsigned char c : header) {
+        checksum += c;
+    }
+    std::snprintf(&header[148], 8, "%06o", checksum);
+    return header;
+}
+
+struct Transfer {
+    CURL* curl;
+    std::string* body;
+    const DockerClient::Sink* sink;
+    const DockerClient::Source* source;
+    const std::atomic<bool>* cancel;
+    bool aborted;
+};
+
+size_t WriteData(char* data, size_t size, size_t nmemb, void* userp) {
+    Transfer* transfer = static_cast<Transfer*>(userp);
+    const size_t length = size * nmemb;
+    if (transfer->sink) {
+        long status = 0;
+        curl_easy_getinfo(transfer->curl, CURLINFO_RESPONSE_CODE, &status);
+        if (status >= 200 && status < 300) {
+            if (!(*transfer->sink)(data, length)) {
+                transfer->aborted = true;
+                return 0;
+            }
+            return length;
+        }
+    }
+    transfer->body->append(data, length);  // Error responses are always kept
+    return length;
+}
+
+size_t ReadData(char* buffer, size_t size, size_t nitems, void* userp) {
+    Transfer* transfer = static_cast<Transfer*>(userp);
+    return (*transfer->source)(buffer, size * nitems);
+}
+
+// Also called while the connection is idle, so a silent command can still
+// be cancelled
+int CheckCancel(void* userp, curl_off_t, curl_off_t, curl_off_t, curl_off_t) {
+    Transfer* transfer = static_cast<Transfer*>(userp);
+    if (transfer->cancel->load()) {
+        transfer->aborted = true;
+        return 1;
+    }
+    return 0;
+}
+
+// CONNECT_ONLY leaves the socket non-blocking; ExecSession wants plain
+// blocking reads and writes
+void SetBlocking(curl_socket_t socket) {
+#ifdef __WXMSW__
+    u_long mode = 0;
+    ioctlsocket(socket, FIONBIO, &mode);
+#else
+    int flags = fcntl(socket, F_GETFL, 0);
+    fcntl(socket, F_SETFL, flags & ~O_NONBLOCK);
+#endif
+}
+
+} // namespace
+
+DockerClient::ExecSession::ExecSession(void* curl, std::intptr_t socket)
+    : m_curl(curl), m_socket(socket), m_closed(false) {}
+
+DockerClient::ExecSession::~ExecSession() {
+    Close();
+    curl_easy_cleanup(static_cast<CURL*>(m_curl));
+}
+
+bool DockerClient::ExecSession::Write(const std::string& data) {
+    const curl_socket_t socket = static_cast<curl_socket_t>(m_socket);
+    size_t offset = 0;
+    while (offset < data.size() && !m_closed) {
+        const int chunk = static_cast<int>(std::min<size_t>(data.size() - offset, 1 << 20));
+        const long sent = ::send(socket, data.data() + offset, chunk, SEND_FLAGS);
+        if (sent <= 0) {
+            return false;
+        }
+        offset += static_cast<size_t>(sent);
+    }
+    return offset == data.size();
+}
+
+bool DockerClient::ExecSession::Read(int& stream, std::string& data) {
+    for (;;) {
+        // Same framing as the exec start stream
+        if (m_buffer.size() >= 8) {
+            const unsigned char* header = reinterpret_cast<const unsigned char*>(m_buffer.data());
+            const size_t length = (static_cast<size_t>(header[4]) << 24) | (static_cast<size_t>(header[5]) << 16) |
+                                  (static_cast<size_t>(header[6]) << 8) | static_cast<size_t>(header[7]);
+            if (m_buffer.size() >= 8 + length) {
+                stream = header[0] == 2 ? 2 : 1;
+                data.assign(m_buffer, 8, length);
+                m_buffer.erase(0, 8 + length);
+                return true;
+            }
+        }
+        if (!Receive()) {
+            return false;
+        }
+    }
+}
+
+bool DockerClient::ExecSession::Receive() {
+    if (m_closed) {
+        return false;
+    }
+    char chunk[16384];
+    const long received = ::recv(static_cast<curl_socket_t>(m_socket), chunk, sizeof(chunk), 0);
+    if (received <= 0) {
+        return false;
+    }
+    m_buffer.append(chunk, static_cast<size_t>(received));
+    return true;
+}
+
+void DockerClient::ExecSession::Close() {
+    if (!m_closed.exchange(true)) {
+#ifdef __WXMSW__
+        ::shutdown(static_cast<curl_socket_t>(m_socket), SD_BOTH);
+#else
+        ::shutdown(static_cast<curl_socket_t>(m_socket), SHUT_RDWR);
+#endif
+    }
+}
+
+wxArrayString DockerClient::ExecResult::GetOutputLines() const {
+    return wxStringTokenize(output, "\r\n", wxTOKEN_STRTOK);
+}
+
+DockerClient& DockerClient::Get() {
+    static DockerClient instance;
+    return instance;
+}
+
+wxArrayString DockerClient::ShellCommand(const wxString& script) {
+    wxArrayString command;
+    command.Add("/bin/bash");
+    command.Add("-c");
+    command.Add(script);
+    return command;
+}
+
+DockerClient::DockerClient() : m_apiState(-1) {
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    // Same endpoint the CLI would use. TLS, ssh and named pipe hosts are
+    // left to the CLI.
+    wxString host, tlsVerify, rest;
+    if (wxGetEnv("DOCKER_HOST", &host) && !host.IsEmpty()) {
+        if (host.StartsWith("unix://", &rest)) {
+            m_socketPath = ToUtf8(rest);
+            m_baseUrl = "http://localhost";
+        } else if (host.StartsWith("tcp://", &rest) && !wxGetEnv("DOCKER_TLS_VERIFY", &tlsVerify)) {
+            m_baseUrl = "http://" + ToUtf8(rest);
+        }
+    } else {
+#ifndef __WXMSW__
+        m_socketPath = "/var/run/docker.sock";
+        m_baseUrl = "http://localhost";
+#endif
+    }
+}
+
+DockerClient::~DockerClient() {
+    for (void* handle : m_idleHandles) {
+        curl_easy_cleanup(static_cast<CURL*>(handle));
+    }
+}
+
+bool DockerClient::IsApiAvailable() {
+    int state = m_apiState.load();
+    if (state >= 0) {
+        return state == 1;
+    }
+
+    bool available = false;
+    if (!m_baseUrl.empty()) {
+        Response response;
+        available = Request("GET", "/_ping", std::string(), response) && response.status == 200;
+    }
+    if (!available) {
+        wxLogDebug("DockerClient: Engine API not reachable, falling back to the docker CLI");
+    }
+    m_apiState = available ? 1 : 0;
+    return available;
+}
+
+void* DockerClient::AcquireHandle() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_idleHandles.empty()) {
+            void* handle = m_idleHandles.back();
+            m_idleHandles.pop_back();
+            return handle;
+        }
+    }
+    return curl_easy_init();
+}
+
+void DockerClient::ReleaseHandle(void* handle) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_idleHandles.push_back(handle);
+}
+
+// Performs one request on a pooled handle. Returns false only when no HTTP
+// response arrived; the status is left for the caller to check.
+bool DockerClient::Request(const char* method, const std::string& path, const std::string& json,
+                           Response& response, const Sink* sink, const Source* source,
+                           const std::atomic<bool>* cancel) {
+    CURL* curl = static_cast<CURL*>(AcquireHandle());
+    if (!curl) {
+        return Fail("Could not initialise libcurl");
+    }
+
+    // Resetting keeps the handle's open connection for reuse
+    curl_easy_reset(curl);
+    const std::string url = m_baseUrl + path;
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    if (!m_socketPath.empty()) {
+        curl_easy_setopt(curl, CURLOPT_UNIX_SOCKET_PATH, m_socketPath.c_str());
+    }
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, CONNECT_TIMEOUT_SECONDS);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, method);
+
+    Transfer transfer{curl, &response.body, sink, source, cancel, false};
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteData);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer);
+    if (cancel) {
+        curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, CheckCancel);
+        curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &transfer);
+        curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+    }
+
+    struct curl_slist* headers = curl_slist_append(nullptr, "Expect:");
+    if (source) {
+        headers = curl_slist_append(headers, "Content-Type: application/x-tar");
+        curl_easy_setopt(curl, CURLOPT_UPLOAD, 1L);
+        curl_easy_setopt(curl, CURLOPT_READFUNCTION, ReadData);
+        curl_easy_setopt(curl, CURLOPT_READDATA, &transfer);
+    } else if (std::strcmp(method, "POST") == 0) {
+        if (!json.empty()) {
+            headers = curl_slist_append(headers, "Content-Type: application/json");
+        }
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, json.c_str());
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(json.size()));
+    }
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+
+    CURLcode result = curl_easy_perform(curl);
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response.status);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, nullptr);
+    curl_slist_free_all(headers);
+    ReleaseHandle(curl);
+
+    if (transfer.aborted) {
+        return Fail("Transfer cancelled");
+    }
+    if (result != CURLE_OK) {
+        return Fail(wxString::Format("Docker API request %s %s failed: %s",
+                                     method, wxString::FromUTF8(path), curl_easy_strerror(result)));
+    }
+    return true;
+}
+
+bool DockerClient::Fail(const wxString& message) const {
+    t_lastError = message;
+    return false;
+}
+
+bool DockerClient::FailResponse(const char* action, const Response& response) const {
+    wxString message = wxString::FromUTF8(response.body);
+    rapidjson::Document doc;
+    doc.Parse(response.body.c_str(), response.body.size());
+    if (!doc.HasParseError() && doc.IsObject() && doc.HasMember("message") && doc["message"].IsString()) {
+        message = wxString::FromUTF8(doc["message"].GetString());
+    }
+    return Fail(wxString::Format("%s failed (HTTP %ld): %s", action, response.status, message.Trim()));
+}
+
+wxString DockerClient::GetLastError() const {
+    return t_lastError;
+}
+
+// A synchronous wxExecute only works on the main thread. Other threads
+// stream the command instead and collect its lines, so the main thread is
+// only borrowed to start the process and cancel kills it. Returns -1 when
+// the command couldn't be run or was cancelled.
+long DockerClient::RunCommand(const wxString& command, wxArrayString& output, wxArrayString& errors,
+                              const std::atomic<bool>* cancel) {
+    if (wxIsMainThread() || !wxTheApp) {
+        return wxExecute(command, output, errors, wxEXEC_SYNC | wxEXEC_HIDE_CONSOLE);
+    }
+
+    auto collect = [&output, &errors](int stream, const wxString& line) {
+        (stream == 2 ? errors : output).Add(line);
+    };
+    int exitCode = -1;
+    if (!StreamCommand(command, collect, exitCode, cancel)) {
+        return -1;
+    }
+    return exitCode;
+}
+
+bool DockerClient::ExecCommand(const wxString& containerId, const wxArrayString& command, ExecResult& result) {
+    wxString cli = "docker exec " + QuoteArgument(containerId);
+    for (const auto& arg : command) {
+        cli += " " + QuoteArgument(arg);
+    }
+
+    wxArrayString output, errors;
+    long exitCode = RunCommand(cli, output, errors);
+    if (exitCode == -1) {
+        return Fail("Failed to run: " + cli);
+    }
+    result.exitCode = static_cast<int>(exitCode);
+    result.output = JoinLines(output);
+    result.errors = JoinLines(errors);
+    return true;
+}
+
+bool DockerClient::ExecCreate(const wxString& containerId, const wxArrayString& command, wxString& execId,
+                              bool attachStdin) {
+    if (!IsApiAvailable()) {
+        return Fail("Docker Engine API not reachable");
+    }
+
+    rapidjson::StringBuffer buffer;
+    JsonWriter writer(buffer);
+    writer.StartObject();
+    writer.Key("AttachStdin");
+    writer.Bool(attachStdin);
+    writer.Key("AttachStdout");
+    writer.Bool(true);
+    writer.Key("AttachStderr");
+    writer.Bool(true);
+    writer.Key("Tty");
+    writer.Bool(false);
+    writer.Key("Cmd");
+    WriteStrings(writer, command);
+    writer.EndObject();
+
+    Response response;
+    if (!Request("POST", "/containers/" + Escape(containerId) + "/exec", buffer.GetString(), response)) {
+        return false;
+    }
+    if (response.status != 201) {
+        return FailResponse("exec create", response);
+    }
+
+    rapidjson::Document doc;
+    doc.Parse(response.body.c_str(), response.body.size());
+    if (doc.HasParseError() || !doc.IsObject() || !doc.HasMember("Id") || !doc["Id"].IsString()) {
+        return Fail("Unexpected exec create response");
+    }
+    execId = wxString::FromUTF8(doc["Id"].GetString());
+    return true;
+}
+
+bool DockerClient::ExecStart(const wxString& execId, ExecResult& result) {
+    if (!IsApiAvailable()) {
+        return Fail("Docker Engine API not reachable");
+    }
+
+    std::string output, errors;
+    StreamDemuxer demuxer([&output, &errors](int stream, const char* data, size_t size) {
+        (stream == 2 ? errors : output).append(data, size);
+    });
+    Sink sink = [&demuxer](const char* data, size_t size) {
+        demuxer.Feed(data, size);
+        return true;
+    };
+
+    Response response;
+    if (!Request("POST", "/exec/" + Escape(execId) + "/start", "{\"Detach\":false,\"Tty\":false}", response, &sink)) {
+        return false;
+    }
+    if (response.status != 200) {
+        return FailResponse("exec start", response);
+    }
+    result.output = wxString::FromUTF8(output);
+    result.errors = wxString::FromUTF8(errors);
+
+    bool running = false;
+    return ExecInspect(execId, result.exitCode, running);
+}
+
+bool DockerClient::ExecInspect(const wxString& execId, int& exitCode, bool& running) {
+    if (!IsApiAvailable()) {
+        return Fail("Docker Engine API not reachable");
+    }
+
+    Response response;
+    if (!Request("GET", "/exec/" + Escape(execId) + "/json", std::string(), response)) {
+        return false;
+    }
+    if (response.status != 200) {
+        return FailResponse("exec inspect", response);
+    }
+
+    rapidjson::Document doc;
+    doc.Parse(response.body.c_str(), response.body.size());
+    if (doc.HasParseError() || !doc.IsObject()) {
+        return Fail("Unexpected exec inspect response");
+    }
+    running = doc.HasMember("Running") && doc["Running"].IsBool() && doc["Running"].GetBool();
+    exitCode = doc.HasMember("ExitCode") && doc["ExitCode"].IsInt() ? doc["ExitCode"].GetInt() : -1;
+    return true;
+}
+
+bool DockerClient::Exec(const wxString& containerId, const wxArrayString& command, ExecResult& result) {
+    if (!IsApiAvailable()) {
+        return ExecCommand(containerId, command, result);
+    }
+    wxString execId;
+    return ExecCreate(containerId, command, execId) && ExecStart(execId, result);
+}
+
+bool DockerClient::ExecStream(const wxString& containerId, const wxArrayString& command, const LineCallback& onLine,
+                              int& exitCode, const std::atomic<bool>* cancel) {
+    if (!IsApiAvailable()) {
+        return ExecStreamCommand(containerId, command, onLine, exitCode, cancel);
+    }
+
+    wxString execId;
+    if (!ExecCreate(containerId, command, execId)) {
+        return false;
+    }
+
+    LineSplitter output(1, onLine), errors(2, onLine);
+    StreamDemuxer demuxer([&output, &errors](int stream, const char* data, size_t size) {
+        (stream == 2 ? errors : output).Feed(data, size);
+    });
+    Sink sink = [&demuxer](const char* data, size_t size) {
+        demuxer.Feed(data, size);
+        return true;
+    };
+
+    Response response;
+    if (!Request("POST", "/exec/" + Escape(execId) + "/start", "{\"Detach\":false,\"Tty\":false}", response,
+                 &sink, nullptr, cancel)) {
+        return false;
+    }
+    if (response.status != 200) {
+        return FailResponse("exec start", response);
+    }
+    output.Flush();
+    errors.Flush();
+
+    bool running = false;
+    return ExecInspect(execId, exitCode, running);
+}
+
+// CLI version of ExecStream
+bool DockerClient::ExecStreamCommand(const wxString& containerId, const wxArrayString& command,
+                                     const LineCallback& onLine, int& exitCode, const std::atomic<bool>* cancel) {
+    wxString cli = "docker exec " + QuoteArgument(containerId);
+    for (const auto& arg : command) {
+        cli += " " + QuoteArgument(arg);
+    }
+    return StreamCommand(cli, onLine, exitCode, cancel);
+}
+
+// wxExecute learns that a process exited from the native event loop, so
+// processing the pending events alone never finishes a command on Windows.
+// User input stays queued; the windows may be closing.
+void DockerClient::DispatchCliEvents() {
+    wxEventLoopBase* loop = wxEventLoopBase::GetActive();
+    if (loop && !loop->IsYielding()) {
+        loop->YieldFor(wxEVT_CATEGORY_ALL & ~wxEVT_CATEGORY_USER_INPUT);
+    } else if (wxTheApp) {
+        wxTheApp->ProcessPendingEvents();
+    }
+}
+
+// Runs a docker CLI command and reports its output lines as they come.
+// wxExecute has to start the process on the main thread, but its pipes can
+// be drained from here.
+bool DockerClient::StreamCommand(const wxString& cli, const LineCallback& onLine, int& exitCode,
+                                 const std::atomic<bool>* cancel, const wxExecuteEnv* env) {
+    std::shared_ptr<wxExecuteEnv> processEnv;
+    if (env) {
+        processEnv = std::make_shared<wxExecuteEnv>(*env);
+    }
+
+    // Shared with the launch on the main thread, which may outlive this
+    // call if it is cancelled before the main thread gets to it. Exactly one
+    // side moves state away from PENDING: the launch once wxExecute returned,
+    // or the worker when it gives up waiting.
+    enum { PENDING, LAUNCHED, ABANDONED };
+    struct Launch {
+        wxSemaphore done{0, 1};
+        std::atomic<int> state{PENDING};
+        StreamedProcess* process = nullptr;
+        long pid = 0;
+    };
+    auto launch = std::make_shared<Launch>();
+    auto start = [launch, cli, processEnv]() {
+        if (launch->state == ABANDONED) {
+            return;
+        }
+        StreamedProcess* process = new StreamedProcess();
+        long pid = wxExecute(cli, wxEXEC_ASYNC | wxEXEC_HIDE_CONSOLE, process, processEnv.get());
+        if (pid == 0) {
+            delete process;
+            process = nullptr;
+        }
+        launch->process = process;
+        launch->pid = pid;
+        int expected = PENDING;
+        if (launch->state.compare_exchange_strong(expected, LAUNCHED)) {
+            launch->done.Post();
+        } else if (process) {
+            wxProcess::Kill(pid, wxSIGTERM, wxKILL_CHILDREN);
+            process->Release();
+        }
+    };
+    if (wxIsMainThread()) {
+        start();
+    } else {
+        wxTheApp->CallAfter(start);
+        while (launch->done.WaitTimeout(50) == wxSEMA_TIMEOUT) {
+            int expected = PENDING;
+            if (cancel && *cancel && launch->state.compare_exchange_strong(expected, ABANDONED)) {
+                return Fail("Cancelled");
+            }
+        }
+    }
+    if (!launch->process) {
+        return Fail("Failed to run: " + cli);
+    }
+
+    StreamedProcess* process = launch->process;
+    LineSplitter output(1, onLine), errors(2, onLine);
+    char buffer[4096];
+    auto drain = [&buffer](wxInputStream* stream, LineSplitter& splitter) {
+        while (stream && stream->CanRead()) {
+            stream->Read(buffer, sizeof(buffer));
+            size_t read = stream->LastRead();
+            if (read == 0) {
+                break;
+            }
+            splitter.Feed(buffer, read);
+        }
+    };
+
+    bool cancelled = false;
+    for (;;) {
+        const bool finished = process->IsFinished();
+        drain(process->GetInputStream(), output);
+        drain(process->GetErrorStream(), errors);
+        if (finished) {
+            break;
+        }
+        if (cancel && *cancel) {
+            wxProcess::Kill(launch->pid, wxSIGTERM, wxKILL_CHILDREN);
+            cancelled = true;
+            break;
+        }
+        wxMilliSleep(50);
+    }
+    output.Flush();
+    errors.Flush();
+    exitCode = process->GetStatus();
+    process->Release();
+    return !cancelled || Fail("Cancelled");
+}
+
+bool DockerClient::ExecAttach(const wxString& containerId, const wxArrayString& command,
+                              std::unique_ptr<ExecSession>& session) {
+    wxString execId;
+    if (!ExecCreate(containerId, command, execId, true)) {
+        return false;
+    }
+
+    // libcurl only connects; the upgraded stream is driven by hand
+    CURL* curl = curl_easy_init();
+    if (!curl) {
+        return Fail("Could not initialise libcurl");
+    }
+    curl_easy_setopt(curl, CURLOPT_URL, m_baseUrl.c_str());
+    if (!m_socketPath.empty()) {
+        curl_easy_setopt(curl, CURLOPT_UNIX_SOCKET_PATH, m_socketPath.c_str());
+    }
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, CONNECT_TIMEOUT_SECONDS);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_CONNECT_ONLY, 1L);
+    CURLcode result = curl_easy_perform(curl);
+    curl_socket_t socket = CURL_SOCKET_BAD;
+    if (result == CURLE_OK) {
+        result = curl_easy_getinfo(curl, CURLINFO_ACTIVESOCKET, &socket);
+    }
+    if (result != CURLE_OK || socket == CURL_SOCKET_BAD) {
+        curl_easy_cleanup(curl);
+        return Fail(wxString::Format("exec attach: could not connect: %s", curl_easy_strerror(result)));
+    }
+    SetBlocking(socket);
+    std::unique_ptr<ExecSession> attached(new ExecSession(curl, static_cast<std::intptr_t>(socket)));
+
+    // The daemon answers 101 and then carries stdin up as is and output
+    // down in the same frames as ExecStart
+    const std::string body = "{\"Detach\":false,\"Tty\":false}";
+    const std::string request = "POST /exec/" + Escape(execId) + "/start HTTP/1.1\r\n"
+                                "Host: " + m_baseUrl.substr(std::strlen("http://")) + "\r\n"
+                                "Content-Type: application/json\r\n"
+                                "Connection: Upgrade\r\n"
+                                "Upgrade: tcp\r\n"
+                                "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+    if (!attached->Write(request)) {
+        return Fail("exec attach: could not send the request");
+    }
+
+    size_t headerEnd;
+    while ((headerEnd = attached->m_buffer.find("\r\n\r\n")) == std::string::npos) {
+        if (attached->m_buffer.size() > MAX_RESPONSE_HEADER || !attached->Receive()) {
+            return Fail("exec attach: no response from the daemon");
+        }
+    }
+    Response response;
+    const size_t space = attached->m_buffer.find(' ');
+    if (space < headerEnd) {
+        response.status = std::strtol(attached->m_buffer.c_str() + space + 1, nullptr, 10);
+    }
+    attached->m_buffer.erase(0, headerEnd + 4);
+    if (response.status != 101 && response.status != 200) {
+        response.body = attached->m_buffer;
+        return FailResponse("exec attach", response);
+    }
+
+    session = std::move(attached);
+    return true;
+}
+
+bool DockerClient::GetArchive(const wxString& containerId, const wxString& path, const Sink& sink,
+                              const std::atomic<bool>* cancel) {
+    if (!IsApiAvailable()) {
+        return Fail("Docker Engine API not reachable");
+    }
+
+    Response response;
+    if (!Request("GET", "/containers/" + Escape(containerId) + "/archive?path=" + Escape(path),
+                 std::string(), response, &sink, nullptr, cancel)) {
+        return false;
+    }
+    if (response.status != 200) {
+        return FailResponse("archive get", response);
+    }
+    return true;
+}
+
+bool DockerClient::PutArchive(const wxString& containerId, const wxString& path, const Source& source,
+                              const std::atomic<bool>* cancel) {
+    if (!IsApiAvailable()) {
+        return Fail("Docker Engine API not reachable");
+    }
+
+    Response response;
+    if (!Request("PUT", "/containers/" + Escape(containerId) + "/archive?path=" + Escape(path),
+                 std::string(), response, nullptr, &source, cancel)) {
+        return false;
+    }
+    if (response.status != 200) {
+        return FailResponse("archive put", response);
+    }
+    return true;
+}
+
+bool DockerClient::ImageExists(const wxString& image) {
+    if (!IsApiAvailable()) {
+        wxArrayString output, errors;
+        return RunCommand("docker image inspect " + QuoteArgument(image), output, errors) == 0;
+    }
+
+    Response response;
+    if (!Request("GET", "/images/" + Escape(image) + "/json", std::string(), response)) {
+        return false;
+    }
+    if (response.status != 200) {
+        return FailResponse("image inspect", response);
+    }
+    return true;
+}
+
+bool DockerClient::BuildImage(const wxString& tag, const std::string& dockerfile, const LineCallback& onLine,
+                              const std::atomic<bool>* cancel) {
+    if (!IsApiAvailable()) {
+        return BuildImageCommand(tag, dockerfile, onLine, cancel);
+    }
+
+    // The build context is a tar holding just the Dockerfile
+    std::string context = TarHeader("Dockerfile", dockerfile.size());
+    context += dockerfile;
+    context.append((TAR_BLOCK - dockerfile.size() % TAR_BLOCK) % TAR_BLOCK, '\0');
+    context.append(2 * TAR_BLOCK, '\0');
+    size_t offset = 0;
+    Source source = [&context, &offset](char* buffer, size_t size) {
+        size = std::min(size, context.size() - offset);
+        std::memcpy(buffer, context.data() + offset, size);
+        offset += size;
+        return size;
+    };
+
+    // Progress arrives as one JSON object per line; a failed step is
+    // reported in an "error" member while the status stays 200
+    std::string pending;
+    wxString buildError;
+    LineSplitter output(1, onLine);
+    Sink sink = [&](const char* data, size_t size) {
+        pending.append(data, size);
+        size_t start = 0, end;
+        while ((end = pending.find('\n', start)) != std::string::npos) {
+            rapidjson::Document doc;
+            doc.Parse(pending.c_str() + start, end - start);
+            start = end + 1;
+            if (doc.HasParseError() || !doc.IsObject()) {
+                continue;
+            }
+            if (doc.HasMember("error") && doc["error"].IsString()) {
+                buildError = wxString::FromUTF8(doc["error"].GetString());
+            } else if (doc.HasMember("stream") && doc["stream"].IsString()) {
+                output.Feed(doc["stream"].GetString(), doc["stream"].GetStringLength());
+            } else if (doc.HasMember("status") && doc["status"].IsString()) {
+                output.Feed(doc["status"].GetString(), doc["status"].GetStringLength());
+                output.Flush();
+            }
+        }
+        pending.erase(0, start);
+        return true;
+    };
+
+    Response response;
+    if (!Request("POST", "/build?t=" + Escape(tag) + "&rm=1&forcerm=1", std::string(), response, &sink, &source,
+                 cancel)) {
+        return false;
+    }
+    output.Flush();
+    if (response.status != 200) {
+        return FailResponse("image build", response);
+    }
+    if (!buildError.IsEmpty()) {
+        return Fail("Image build failed: " + buildError);
+    }
+    return true;
+}
+
+// CLI version of BuildImage. It asks for the classic builder, which like
+// the API uses a base image that is already present without contacting the
+// registry; BuildKit checks the registry first and fails offline.
+bool DockerClient::BuildImageCommand(const wxString& tag, const std::string& dockerfile, const LineCallback& onLine,
+                                     const std::atomic<bool>* cancel) {
+    std::error_code ec;
+    std::filesystem::path dir = std::filesystem::temp_directory_path(ec) / "linuxisopro-build";
+    std::filesystem::create_directories(dir, ec);
+    const wxString dirName = wxString::FromUTF8(dir.u8string().c_str());
+    std::ofstream file(dir / "Dockerfile", std::ios::binary | std::ios::trunc);
+    file.write(dockerfile.data(), static_cast<std::streamsize>(dockerfile.size()));
+    file.close();
+    if (!file) {
+        return Fail("Could not write the Dockerfile to " + dirName);
+    }
+
+    wxExecuteEnv env;
+    wxGetEnvMap(&env.env);
+    env.env["DOCKER_BUILDKIT"] = "0";
+    const wxString cli = "docker build -t " + QuoteArgument(tag) + " " + QuoteArgument(dirName);
+    int exitCode = -1;
+    if (!StreamCommand(cli, onLine, exitCode, cancel, &env)) {
+        return false;
+    }
+    if (exitCode != 0) {
+        return Fail(wxString::Format("docker build exited with %d", exitCode));
+    }
+    return true;
+}
+
+bool DockerClient::CopyFromContainer(const wxString& containerId, const wxString& path, const wxString& hostDir) {
+    if (!IsApiAvailable()) {
+        wxArrayString output, errors;
+        wxString cli = "docker cp " + QuoteArgument(containerId + ":" + path) + " " + QuoteArgument(hostDir);
+        long exitCode = RunCommand(cli, output, errors);
+        return exitCode == 0 || Fail(errors.IsEmpty() ? "Failed to run: " + cli : errors[0]);
+    }
+
+    TarExtractor extractor(std::filesystem::u8path(ToUtf8(hostDir)));
+    Sink sink = [&extractor](const char* data, size_t size) {
+        return extractor.Feed(data, size);
+    };
+    if (!GetArchive(containerId, path, sink)) {
+        return extractor.GetError().empty() ? false : Fail(wxString::FromUTF8(extractor.GetError()));
+    }
+    return extractor.Finish() || Fail(wxString::FromUTF8(extractor.GetError()));
+}
+
+bool DockerClient::ReadFile(const wxString& containerId, const wxString& path,
+                            const std::function<void(std::uint64_t size)>& onSize, const Sink& sink,
+                            const std::atomic<bool>* cancel) {
+    bool found = false;
+    TarExtractor extractor(
+        [&found, &onSize](const std::string&, std::uint64_t size) {
+            if (found) {
+                return false;  // The archive of a single file has one entry
+            }
+            found = true;
+            onSize(size);
+            return true;
+        },
+        sink);
+    Sink feed = [&extractor](const char* data, size_t size) {
+        return extractor.Feed(data, size);
+    };
+    if (!GetArchive(containerId, path, feed, cancel)) {
+        return extractor.GetError().empty() ? false : Fail(wxString::FromUTF8(extractor.GetError()));
+    }
+    if (!extractor.Finish()) {
+        return Fail(wxString::FromUTF8(extractor.GetError()));
+    }
+    return found || Fail("Not found in the archive: " + path);
+}
+
+bool DockerClient::CopyToContainer(const wxString& containerId, const wxString& hostPath, const wxString& containerPath,
+                                   const std::function<void(std::uint64_t sent, std::uint64_t size)>& onProgress,
+                                   const std::atomic<bool>* cancel) {
+    // A ustar header can't describe larger files; docker cp writes its own
+    // extensions
+    if (!IsApiAvailable() || (wxFileExists(hostPath) && wxFileName::GetSize(hostPath).GetValue() > MAX_TAR_FILE_SIZE)) {
+        wxString lastError;
+        auto onLine = [&lastError](int stream, const wxString& line) {
+            if (stream == 2) {
+                lastError = line;
+            }
+        };
+        wxString cli = "docker cp " + QuoteArgument(hostPath) + " " + QuoteArgument(containerId + ":" + containerPath);
+        int exitCode = -1;
+        if (!StreamCommand(cli, onLine, exitCode, cancel)) {
+            return false;
+        }
+        return exitCode == 0 || Fail(lastError.IsEmpty() ? "Failed to run: " + cli : lastError);
+    }
+
+    wxFile file;
+    if (!wxFileExists(hostPath) || !file.Open(hostPath)) {
+        return Fail("Could not open " + hostPath);
+    }
+    const wxFileOffset length = file.Length();
+    if (length == wxInvalidOffset || static_cast<std::uint64_t>(length) > MAX_TAR_FILE_SIZE) {
+        return Fail("Could not read " + hostPath);
+    }
+
+    // A one-entry tar made up as it is sent: header, file, then padding to
+    // the block size and the two empty blocks that end the archive
+    const std::uint64_t size = static_cast<std::uint64_t>(length);
+    const std::string header = TarHeader(ToUtf8(containerPath.AfterLast('/')), static_cast<size_t>(size));
+    const std::uint64_t total = header.size() + size + (TAR_BLOCK - size % TAR_BLOCK) % TAR_BLOCK + 2 * TAR_BLOCK;
+    std::uint64_t offset = 0;
+    bool readFailed = false;
+    Source source = [&](char* buffer, size_t capacity) -> size_t {
+        if (offset < header.size()) {
+            const size_t count = std::min<size_t>(capacity, header.size() - offset);
+            std::memcpy(buffer, header.data() + offset, count);
+            offset += count;
+            return count;
+        }
+        if (offset < header.size() + size) {
+            const size_t count = static_cast<size_t>(
+                std::min<std::uint64_t>({capacity, UPLOAD_CHUNK_SIZE, header.size() + size - offset}));
+            const ssize_t read = file.Read(buffer, count);
+            if (read <= 0) {
+                readFailed = true;
+                return CURL_READFUNC_ABORT;
+            }
+            offset += read;
+            if (onProgress) {
+                onProgress(offset - header.size(), size);
+            }
+            return static_cast<size_t>(read);
+        }
+        const size_t count = static_cast<size_t>(std::min<std::uint64_t>(capacity, total - offset));
+        std::memset(buffer, 0, count);
+        offset += count;
+        return count;
+    };
+
+    wxString dir = containerPath.BeforeLast('/');
+    if (dir.IsEmpty()) {
+        dir = "/";
+    }
+    if (!PutArchive(containerId, dir, source, cancel)) {
+        return readFailed ? Fail("Could not read " + hostPath) : false;
+    }
+    return true;
+}
+
+bool DockerClient::CreateContainer(const ContainerConfig& config, wxString& containerId) {
+    if (!IsApiAvailable()) {
+        wxString cli = "docker create";
+        if (!config.name.IsEmpty()) cli += " --name " + QuoteArgument(config.name);
+        if (config.privileged) cli += " --privileged";
+        if (config.tty) cli += " -it";
+        for (const auto& bind : config.binds) {
+            cli += " -v " + QuoteArgument(bind);
+        }
+        cli += " " + QuoteArgument(config.image);
+        for (const auto& arg : config.command) {
+            cli += " " + QuoteArgument(arg);
+        }
+
+        wxArrayString output, errors;
+        if (RunCommand(cli, output, errors) != 0 || output.IsEmpty()) {
+            return Fail(errors.IsEmpty() ? "Failed to run: " + cli : errors[0]);
+        }
+        containerId = output.Last().Trim(true).Trim(false);
+        return true;
+    }
+
+    rapidjson::StringBuffer buffer;
+    JsonWriter writer(buffer);
+    writer.StartObject();
+    writer.Key("Image");
+    WriteString(writer, config.image);
+    if (!config.command.IsEmpty()) {
+        writer.Key("Cmd");
+        WriteStrings(writer, config.command);
+    }
+    writer.Key("Tty");
+    writer.Bool(config.tty);
+    writer.Key("OpenStdin");
+    writer.Bool(config.tty);
+    writer.Key("HostConfig");
+    writer.StartObject();
+    writer.Key("Binds");
+    WriteStrings(writer, config.binds);
+    writer.Key("Privileged");
+    writer.Bool(config.privileged);
+    writer.EndObject();
+    writer.EndObject();
+
+    std::string path = "/containers/create";
+    if (!config.name.IsEmpty()) {
+        path += "?name=" + Escape(config.name);
+    }
+    Response response;
+    if (!Request("POST", path, buffer.GetString(), response)) {
+        return false;
+    }
+    if (response.status != 201) {
+        return FailResponse("container create", response);
+    }
+
+    rapidjson::Document doc;
+    doc.Parse(response.body.c_str(), response.body.size());
+    if (doc.HasParseError() || !doc.IsObject() || !doc.HasMember("Id") || !doc["Id"].IsString()) {
+        return Fail("Unexpected container create response");
+    }
+    containerId = wxString::FromUTF8(doc["Id"].GetString());
+    return true;
+}
+
+bool DockerClient::StartContainer(const wxString& containerId) {
+    if (!IsApiAvailable()) {
+        wxArrayString output, errors;
+        wxString cli = "docker start " + QuoteArgument(containerId);
+        return RunCommand(cli, output, errors) == 0 || Fail(errors.IsEmpty() ? "Failed to run: " + cli : errors[0]);
+    }
+
+    Response response;
+    if (!Request("POST", "/containers/" + Escape(containerId) + "/start", std::string(), response)) {
+        return false;
+    }
+    // 304: already running
+    if (response.status != 204 && response.status != 304) {
+        return FailResponse("container start", response);
+    }
+    return true;
+}
+
+bool DockerClient::InspectContainer(const wxString& container, ContainerInfo& info) {
+    info = ContainerInfo();
+    if (!IsApiAvailable()) {
+        // One line: ID, state and name, then the mount destinations
+        wxArrayString output, errors;
+        wxString cli = "docker inspect --type container --format "
+                       "\"{{.Id}}|{{.State.Running}}|{{.Name}}{{range .Mounts}}|{{.Destination}}{{end}}\" " +
+                       QuoteArgument(container);
+        if (RunCommand(cli, output, errors) != 0 || output.IsEmpty()) {
+            return Fail(errors.IsEmpty() ? "Failed to run: " + cli : errors[0]);
+        }
+        wxArrayString fields = wxSplit(output[0].Trim(true), '|', '\0');
+        if (fields.size() < 3) {
+            return Fail("Unexpected docker inspect output: " + output[0]);
+        }
+        info.id = fields[0];
+        info.running = fields[1] == "true";
+        info.name = fields[2].AfterFirst('/');
+        for (size_t i = 3; i < fields.size(); ++i) {
+            info.mounts.Add(fields[i]);
+        }
+        return true;
+    }
+
+    Response response;
+    if (!Request("GET", "/containers/" + Escape(container) + "/json", std::string(), response)) {
+        return false;
+    }
+    if (response.status != 200) {
+        return FailResponse("container inspect", response);
+    }
+
+    rapidjson::Document doc;
+    doc.Parse(response.body.c_str(), response.body.size());
+    if (doc.HasParseError() || !doc.IsObject() || !doc.HasMember("Id") || !doc["Id"].IsString()) {
+        return Fail("Unexpected container inspect response");
+    }
+    info.id = wxString::FromUTF8(doc["Id"].GetString());
+    if (doc.HasMember("Name") && doc["Name"].IsString()) {
+        info.name = wxString::FromUTF8(doc["Name"].GetString()).AfterFirst('/');
+    }
+    if (doc.HasMember("State") && doc["State"].IsObject() && doc["State"].HasMember("Running") &&
+        doc["State"]["Running"].IsBool()) {
+        info.running = doc["State"]["Running"].GetBool();
+    }
+    if (doc.HasMember("Mounts") && doc["Mounts"].IsArray()) {
+        for (const auto& mount : doc["Mounts"].GetArray()) {
+            if (mount.IsObject() && mount.HasMember("Destination") && mount["Destination"].IsString()) {
+                info.mounts.Add(wxString::FromUTF8(mount["Destination"].GetString()));
+            }
+        }
+    }
+    return true;
+}
+
+bool DockerClient::RenameContainer(const wxString& containerId, const wxString& name) {
+    if (!IsApiAvailable()) {
+        wxArrayString output, errors;
+        wxString cli = "docker rename " + QuoteArgument(containerId) + " " + QuoteArgument(name);
+        return RunCommand(cli, output, errors) == 0 || Fail(errors.IsEmpty() ? "Failed to run: " + cli : errors[0]);
+    }
+
+    Response response;
+    if (!Request("POST", "/containers/" + Escape(containerId) + "/rename?name=" + Escape(name), std::string(),
+                 response)) {
+        return false;
+    }
+    if (response.status != 204) {
+        return FailResponse("container rename", response);
+    }
+    return true;
+}
+
+bool DockerClient::RemoveContainer(const wxString& containerId, bool force, const std::atomic<bool>* cancel) {
+    if (!IsApiAvailable()) {
+        wxString cli = wxString("docker rm ") + (force ? "-f " : "") + QuoteArgument(containerId);
+        wxArrayString output, errors;
+        if (RunCommand(cli, output, errors, cancel) == 0) {
+            return true;
+        }
+        if (cancel && *cancel) {
+            return Fail("Cancelled");
+        }
+        return Fail(errors.IsEmpty() ? "Failed to run: " + cli : errors[0]);
+    }
+
+    Response response;
+    if (!Request("DELETE", "/containers/" + Escape(containerId) + (force ? "?force=true" : ""),
+                 std::string(), response, nullptr, nullptr, cancel)) {
+        return false;
+    }
+    if (response.status != 204) {
+        return FailResponse("container remove", response);
+    }
+    return true;
+}
+
+void DockerClient::RemoveContainers(const wxArrayString& ids, std::vector<bool>& removed) {
+    removed.assign(ids.size(), false);
+    if (ids.IsEmpty()) {
+        return;
+    }
+
+    if (!IsApiAvailable()) {
+        wxString cli = "docker rm -f";
+        for (const auto& id : ids) {
+            cli += " " + QuoteArgument(id);
+        }
+        wxArrayString output, errors;
+        RunCommand(cli, output, errors);
+
+        // Each removed container is echoed as given; missing ones are
+        // reported on stderr
+        for (size_t i = 0; i < ids.size(); ++i) {
+            for (const auto& line : output) {
+                removed[i] = removed[i] || line.Strip(wxString::both) == ids[i];
+            }
+            for (const auto& line : errors) {
+                removed[i] = removed[i] || (line.Contains("No such container") && line.Contains(ids[i]));
+            }
+        }
+        return;
+    }
+
+    // Requests are independent, each on a pooled connection of its own
+    std::atomic<size_t> next(0);
+    std::vector<char> done(ids.size(), 0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < ids.size(); i = next++) {
+            Response response;
+            if (Request("DELETE", "/containers/" + Escape(ids[i]) + "?force=true", std::string(), response)) {
+                done[i] = response.status == 204 || response.status == 404;
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < std::min(ids.size(), MAX_PARALLEL_REMOVALS); ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    for (size_t i = 0; i < ids.size(); ++i) {
+        removed[i] = done[i] != 0;
+    }
+}
@@ -0,0 +1,199 @@
+#ifndef DOCKER_CLIENT_H
+#define DOCKER_CLIENT_H
+
+#include <wx/string.h>
+#include <wx/arrstr.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct wxExecuteEnv;
+
+// Talks to the Docker Engine API over the daemon's local socket instead of
+// starting the docker CLI for every call. Connections are pooled and kept
+// alive between requests. When the API can't be reached that way (Docker
+// Desktop's named pipe on Windows, or a DOCKER_HOST libcurl can't use) the
+// calls that have a CLI equivalent run that instead.
+//
+// Safe to use from any thread; each request takes its own connection.
+class DockerClient {
+public:
+    struct ExecResult {
+        int exitCode = -1;
+        wxString output;    // stdout
+        wxString errors;    // stderr
+
+        wxArrayString GetOutputLines() const;
+    };
+
+    struct ContainerConfig {
+        wxString image;
+        wxString name;                // Empty for a generated name
+        wxArrayString command;
+        wxArrayString binds;          // "host:container[:ro]"
+        bool privileged = false;
+        bool tty = false;
+    };
+
+    struct ContainerInfo {
+        wxString id;
+        wxString name;                // Without the leading slash
+        bool running = false;
+        wxArrayString mounts;         // Destinations inside the container
+    };
+
+    // Receives each line of exec output once it is complete; stream is 1
+    // for stdout and 2 for stderr. Carriage returns end a line as well, so
+    // progress bars that redraw in place arrive as they change.
+    using LineCallback = std::function<void(int stream, const wxString& line)>;
+
+    // Receives a tar stream as it arrives; returning false aborts it
+    using Sink = std::function<bool(const char* data, size_t size)>;
+    // Fills the buffer with the next part of a tar stream, 0 at the end
+    using Source = std::function<size_t(char* buffer, size_t size)>;
+
+    // Input and output of an exec started by ExecAttach. One thread may
+    // write while another reads; Close unblocks both.
+    class ExecSession {
+    public:
+        ~ExecSession();
+
+        bool Write(const std::string& data);
+        // Waits for the next chunk of output; stream is 1 for stdout and 2
+        // for stderr. Returns false once the command exited or the session
+        // was closed.
+        bool Read(int& stream, std::string& data);
+        void Close();
+
+    private:
+        friend class DockerClient;
+        ExecSession(void* curl, std::intptr_t socket);
+        bool Receive();
+
+        void* m_curl;
+        std::intptr_t m_socket;
+        std::string m_buffer;    // Received bytes not yet returned by Read
+        std::atomic<bool> m_closed;
+    };
+
+    static DockerClient& Get();
+
+    // Argument vector running a script through /bin/bash -c
+    static wxArrayString ShellCommand(const wxString& script);
+
+    // Lets the main thread launch and reap the CLI processes other threads
+    // wait for, while it waits for those threads itself
+    static void DispatchCliEvents();
+
+    // Pings the daemon once; afterwards the answer is cached
+    bool IsApiAvailable();
+
+    // Exec endpoints. ExecStart waits for the command and demultiplexes its
+    // output; Exec runs create, start and inspect in one go.
+    bool ExecCreate(const wxString& containerId, const wxArrayString& command, wxString& execId,
+                    bool attachStdin = false);
+    bool ExecStart(const wxString& execId, ExecResult& result);
+    bool ExecInspect(const wxString& execId, int& exitCode, bool& running);
+    bool Exec(const wxString& containerId, const wxArrayString& command, ExecResult& result);
+
+    // Runs a command and reports its output while it runs. Blocks until the
+    // command exits, so call it from a worker thread. Setting cancel stops
+    // waiting; the command itself keeps running in the container.
+    bool ExecStream(const wxString& containerId, const wxArrayString& command, const LineCallback& onLine,
+                    int& exitCode, const std::atomic<bool>* cancel = nullptr);
+
+    // Runs a program on the host the same way, for the docker CLI fallbacks
+    // and the backend. Setting cancel kills it.
+    bool StreamCommand(const wxString& command, const LineCallback& onLine, int& exitCode,
+                       const std::atomic<bool>* cancel = nullptr, const wxExecuteEnv* env = nullptr);
+
+    // Starts a command with stdin attached, on a connection of its own. API
+    // only.
+    bool ExecAttach(const wxString& containerId, const wxArrayString& command,
+                    std::unique_ptr<ExecSession>& session);
+
+    // Archive endpoints, API only
+    bool GetArchive(const wxString& containerId, const wxString& path, const Sink& sink,
+                    const std::atomic<bool>* cancel = nullptr);
+    bool PutArchive(const wxString& containerId, const wxString& path, const Source& source,
+                    const std::atomic<bool>* cancel = nullptr);
+
+    // Same result as "docker cp container:path hostDir" for an existing hostDir
+    bool CopyFromContainer(const wxString& containerId, const wxString& path, const wxString& hostDir);
+    // Streams a single regular file out of a container without writing it
+    // anywhere: onSize gets its length, then sink its contents in order.
+    // Setting cancel aborts the transfer. API only; call from a worker
+    // thread.
+    bool ReadFile(const wxString& containerId, const wxString& path,
+                  const std::function<void(std::uint64_t size)>& onSize, const Sink& sink,
+                  const std::atomic<bool>* cancel = nullptr);
+    // Streams a host file into a container as containerPath, without
+    // reading it into memory; onProgress gets the bytes sent so far and the
+    // file's size. Setting cancel aborts the transfer. Call from a worker
+    // thread.
+    bool CopyToContainer(const wxString& containerId, const wxString& hostPath, const wxString& containerPath,
+                         const std::function<void(std::uint64_t sent, std::uint64_t size)>& onProgress = nullptr,
+                         const std::atomic<bool>* cancel = nullptr);
+
+    // Image endpoints. BuildImage builds from a Dockerfile alone, without a
+    // context directory, and never pulls a base image that is present.
+    bool ImageExists(const wxString& image);
+    bool BuildImage(const wxString& tag, const std::string& dockerfile, const LineCallback& onLine,
+                    const std::atomic<bool>* cancel = nullptr);
+
+    bool CreateContainer(const ContainerConfig& config, wxString& containerId);
+    bool StartContainer(const wxString& containerId);
+    // Fails if the container doesn't exist
+    bool InspectContainer(const wxString& container, ContainerInfo& info);
+    bool RenameContainer(const wxString& containerId, const wxString& name);
+    // Setting cancel gives up on the removal; with it, call from a worker
+    // thread
+    bool RemoveContainer(const wxString& containerId, bool force = true, const std::atomic<bool>* cancel = nullptr);
+    // Force-removes several containers at once: in parallel over the API,
+    // in a single "docker rm" otherwise. removed[i] tells whether ids[i] is
+    // gone, including containers that no longer existed.
+    void RemoveContainers(const wxArrayString& ids, std::vector<bool>& removed);
+
+    // Error of the last failed call made by this thread
+    wxString GetLastError() const;
+
+private:
+    struct Response {
+        long status = 0;
+        std::string body;
+    };
+
+    DockerClient();
+    ~DockerClient();
+    DockerClient(const DockerClient&) = delete;
+    DockerClient& operator=(const DockerClient&) = delete;
+
+    bool Request(const char* method, const std::string& path, const std::string& json, Response& response,
+                 const Sink* sink = nullptr, const Source* source = nullptr,
+                 const std::atomic<bool>* cancel = nullptr);
+    void* AcquireHandle();
+    void ReleaseHandle(void* handle);
+    bool Fail(const wxString& message) const;
+    bool FailResponse(const char* action, const Response& response) const;
+
+    long RunCommand(const wxString& command, wxArrayString& output, wxArrayString& errors,
+                    const std::atomic<bool>* cancel = nullptr);
+    bool ExecCommand(const wxString& containerId, const wxArrayString& command, ExecResult& result);
+    bool ExecStreamCommand(const wxString& containerId, const wxArrayString& command, const LineCallback& onLine,
+                           int& exitCode, const std::atomic<bool>* cancel);
+    bool BuildImageCommand(const wxString& tag, const std::string& dockerfile, const LineCallback& onLine,
+                           const std::atomic<bool>* cancel);
+
+    std::string m_socketPath;    // Unix socket, empty for TCP
+    std::string m_baseUrl;       // Empty when only the CLI can be used
+    std::atomic<int> m_apiState; // -1 unknown, 0 unavailable, 1 available
+
+    std::mutex m_mutex;
+    std::vector<void*> m_idleHandles;
+};
+
+#endif // DOCKER_CLIENT_H
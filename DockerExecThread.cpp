@@ -0,0 +1,84 @@
+#include "DockerExecThread.h"
+#include "ChrootAgent.h"
+#include "BuildStage.h"
+
+wxDEFINE_EVENT(DOCKER_EXEC_OUTPUT, wxCommandEvent);
+wxDEFINE_EVENT(DOCKER_EXEC_COMPLETE, wxCommandEvent);
+wxDEFINE_EVENT(BUILD_STAGE, wxCommandEvent);
+
+DockerExecThread::DockerExecThread(wxEvtHandler *handler, int id, const wxString &containerId,
+                                   const wxArrayString &command)
+    : wxThread(wxTHREAD_JOINABLE), m_handler(handler), m_id(id),
+      m_containerId(containerId.Clone()), m_cancel(false)
+{
+    for (const auto &arg : command)
+        m_command.Add(arg.Clone());
+}
+
+DockerExecThread::DockerExecThread(wxEvtHandler *handler, int id, const wxString &containerId,
+                                   const wxString &chrootScript)
+    : wxThread(wxTHREAD_JOINABLE), m_handler(handler), m_id(id),
+      m_containerId(containerId.Clone()), m_chrootScript(chrootScript.Clone()), m_cancel(false)
+{
+}
+
+DockerExecThread::DockerExecThread(wxEvtHandler *handler, int id)
+    : wxThread(wxTHREAD_JOINABLE), m_handler(handler), m_id(id), m_cancel(false)
+{
+}
+
+DockerExecThread *DockerExecThread::ForHostCommand(wxEvtHandler *handler, int id, const wxString &command)
+{
+    DockerExecThread *thread = new DockerExecThread(handler, id);
+    thread->m_hostCommand = command.Clone();
+    return thread;
+}
+
+wxThread::ExitCode DockerExecThread::Entry()
+{
+    auto onLine = [this](int stream, const wxString &line)
+    {
+        BuildStage stage;
+        if (stream == 1 && BuildStage::Parse(line, stage))
+        {
+            wxCommandEvent event(BUILD_STAGE, m_id);
+            event.SetClientData(new BuildStage(stage));
+            wxQueueEvent(m_handler, event.Clone());
+            return;
+        }
+
+        wxCommandEvent event(DOCKER_EXEC_OUTPUT, m_id);
+        event.SetInt(stream);
+        event.SetString(line);
+        wxQueueEvent(m_handler, event.Clone());
+    };
+
+    int exitCode = -1;
+    bool ok;
+    wxString error;
+    if (!m_hostCommand.IsEmpty())
+    {
+        ok = DockerClient::Get().StreamCommand(m_hostCommand, onLine, exitCode, &m_cancel);
+        if (!ok)
+            error = DockerClient::Get().GetLastError();
+    }
+    else if (m_chrootScript.IsEmpty())
+    {
+        ok = DockerClient::Get().ExecStream(m_containerId, m_command, onLine, exitCode, &m_cancel);
+        if (!ok)
+            error = DockerClient::Get().GetLastError();
+    }
+    else
+    {
+        ok = ChrootAgent::Get().Run(m_containerId, m_chrootScript, onLine, exitCode, &m_cancel);
+        if (!ok)
+            error = ChrootAgent::Get().GetLastError();
+    }
+
+    wxCommandEvent event(DOCKER_EXEC_COMPLETE, m_id);
+    event.SetInt(ok ? exitCode : -1);
+    event.SetExtraLong(m_cancel ? 1 : 0);
+    event.SetString(error);
+    wxQueueEvent(m_handler, event.Clone());
+    return (wxThread::ExitCode)0;
+}
@@ -0,0 +1,47 @@
+#ifndef DOCKER_EXEC_THREAD_H
+#define DOCKER_EXEC_THREAD_H
+
+#include <wx/wx.h>
+#include <wx/thread.h>
+#include <atomic>
+#include "CustomEvents.h"
+
+// Runs a command in a container off the GUI thread and streams its output.
+// Posts DOCKER_EXEC_OUTPUT per line (line in GetString(), 1 = stdout or
+// 2 = stderr in GetInt()), then exactly one DOCKER_EXEC_COMPLETE with the
+// exit code in GetInt() (-1 if the command couldn't be run or was cancelled)
+// and the error, if any, in GetString(). GetExtraLong() is 1 on cancel.
+// Stage lines on stdout are posted as BUILD_STAGE instead (see BuildStage).
+// All carry the id given to the constructor. Joinable: the owner must
+// Wait() before deleting it.
+class DockerExecThread : public wxThread
+{
+public:
+    DockerExecThread(wxEvtHandler *handler, int id, const wxString &containerId,
+                     const wxArrayString &command);
+    // Runs a bash script inside the build chroot through ChrootAgent
+    DockerExecThread(wxEvtHandler *handler, int id, const wxString &containerId,
+                     const wxString &chrootScript);
+
+    // Runs a program on the host instead
+    static DockerExecThread *ForHostCommand(wxEvtHandler *handler, int id, const wxString &command);
+
+    // Safe to call from the GUI thread at any time
+    void Cancel() { m_cancel = true; }
+
+protected:
+    virtual ExitCode Entry() override;
+
+private:
+    DockerExecThread(wxEvtHandler *handler, int id);
+
+    wxEvtHandler *m_handler;
+    int m_id;
+    wxString m_containerId;
+    wxArrayString m_command;
+    wxString m_chrootScript;    // Used instead of m_command when set
+    wxString m_hostCommand;     // Used instead of both when set
+    std::atomic<bool> m_cancel;
+};
+
+#endif // DOCKER_EXEC_THREAD_H
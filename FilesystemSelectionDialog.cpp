@@ -13,7 +13,8 @@ wxBEGIN_EVENT_TABLE(FilesystemSelectionDialog, wxDialog)
                 EVT_CHECKBOX(wxID_ANY, FilesystemSelectionDialog::OnItemCheckbox) // Event for checkboxes
     wxEND_EVENT_TABLE()
 
-        FilesystemSelectionDialog::FilesystemSelectionDialog(wxWindow *parent, const wxString &title, const wxArrayString &choices)
+        FilesystemSelectionDialog::FilesystemSelectionDialog(wxWindow *parent, const wxString &title, const wxArrayString &choices,
+                                                     const wxArrayString &details)
     : wxDialog(parent, wxID_ANY, title, wxDefaultPosition, wxSize(450, 500), wxDEFAULT_DIALOG_STYLE | wxRESIZE_BORDER)
 {
     SetBackgroundStyle(wxBG_STYLE_PAINT);
@@ -44,7 +45,7 @@ wxBEGIN_EVENT_TABLE(FilesystemSelectionDialog, wxDialog)
     m_itemsPanel->SetSizer(itemsSizer);
     mainSizer->Add(m_itemsPanel, 1, wxEXPAND | wxLEFT | wxRIGHT | wxBOTTOM, 25);
 
-    CreateItemList(choices);
+    CreateItemList(choices, details);
 
     // OK and Cancel buttons with improved styling
     wxBoxSizer *buttonSizer = new wxBoxSizer(wxHORIZONTAL);
@@ -197,7 +198,7 @@ void FilesystemSelectionDialog::OnPaint(wxPaintEvent &event)
     }
 }
 
-void FilesystemSelectionDialog::CreateItemList(const wxArrayString &choices)
+void FilesystemSelectionDialog::CreateItemList(const wxArrayString &choices, const wxArrayString &details)
 {
     wxBoxSizer *itemsSizer = new wxBoxSizer(wxVERTICAL);
     m_itemsPanel->SetSizer(itemsSizer);
@@ -207,9 +208,10 @@ void FilesystemSelectionDialog::CreateItemList(const wxArrayString &choices)
     itemsSizer->AddSpacer(10);
 
     // Create panels for each item
-    for (const wxString &choiceText : choices)
+    for (size_t i = 0; i < choices.GetCount(); ++i)
     {
-        wxPanel *itemPanel = CreateItemPanel(m_itemsPanel, choiceText);
+        wxString detailText = i < details.GetCount() ? details[i] : wxString();
+        wxPanel *itemPanel = CreateItemPanel(m_itemsPanel, choices[i], detailText);
         itemsSizer->Add(itemPanel, 0, wxEXPAND | wxLEFT | wxRIGHT, 10);
         itemsSizer->AddSpacer(8); // Space between items
     }
@@ -222,7 +224,7 @@ void FilesystemSelectionDialog::CreateItemList(const wxArrayString &choices)
     m_itemsPanel->SetScrollRate(0, 10);
 }
 
-wxPanel *FilesystemSelectionDialog::CreateItemPanel(wxWindow *parent, const wxString &choiceText)
+wxPanel *FilesystemSelectionDialog::CreateItemPanel(wxWindow *parent, const wxString &choiceText, const wxString &detailText)
 {
     wxPanel *panel = new wxPanel(parent, wxID_ANY);
     panel->SetBackgroundColour(m_normalItemColor);
@@ -245,7 +247,26 @@ wxPanel *FilesystemSelectionDialog::CreateItemPanel(wxWindow *parent, const wxSt
     wxFont textFont = text->GetFont();
     textFont.SetPointSize(textFont.GetPointSize() + 1);
     text->SetFont(textFont);
-    sizer->Add(text, 1, wxALIGN_CENTER_VERTICAL);
+
+    if (detailText.IsEmpty())
+    {
+        sizer->Add(text, 1, wxALIGN_CENTER_VERTICAL);
+    }
+    else
+    {
+        // Name with the filesystem preview underneath
+        wxBoxSizer *textSizer = new wxBoxSizer(wxVERTICAL);
+        textSizer->Add(text, 0, wxEXPAND);
+
+        wxStaticText *detail = new wxStaticText(panel, wxID_ANY, detailText);
+        detail->SetForegroundColour(wxColour(200, 200, 200));
+        wxFont detailFont = detail->GetFont();
+        detailFont.SetPointSize(detailFont.GetPointSize() - 1);
+        detail->SetFont(detailFont);
+        textSizer->Add(detail, 0, wxEXPAND | wxTOP, 2);
+
+        sizer->Add(textSizer, 1, wxALIGN_CENTER_VERTICAL | wxTOP | wxBOTTOM, 6);
+    }
 
     // Add right padding
     sizer->AddSpacer(15);
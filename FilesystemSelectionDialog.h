@@ -11,14 +11,16 @@
 class FilesystemSelectionDialog : public wxDialog
 {
 public:
-    FilesystemSelectionDialog(wxWindow *parent, const wxString &title, const wxArrayString &choices);
+    // details[i], when given, is shown under choices[i] (size, compressor, release)
+    FilesystemSelectionDialog(wxWindow *parent, const wxString &title, const wxArrayString &choices,
+                              const wxArrayString &details = wxArrayString());
     wxString GetSelectedFilesystem() const;
 
 private:
     void OnOK(wxCommandEvent &event);
     void OnCancel(wxCommandEvent &event);
     void ApplyTheme();
-    void CreateItemList(const wxArrayString &choices);
+    void CreateItemList(const wxArrayString &choices, const wxArrayString &details);
     void OnItemCheckbox(wxCommandEvent &event); // Handler for checkbox clicks
     void OnPaint(wxPaintEvent &event);          // Add this line
 
@@ -30,7 +32,7 @@ private:
     wxColour m_hoverItemColor;  // Hover color for items
 
     void SetupColors();                                                     // Setup theme-aware colors
-    wxPanel *CreateItemPanel(wxWindow *parent, const wxString &choiceText); // Helper to create item panels
+    wxPanel *CreateItemPanel(wxWindow *parent, const wxString &choiceText, const wxString &detailText); // Helper to create item panels
 
     wxDECLARE_EVENT_TABLE();
 };
@@ -1,4 +1,5 @@
 #include "FlatpakStore.h"
+#include "ChrootAgent.h"
 #include <fstream>
 #include <sstream>
 #include <algorithm>
@@ -17,9 +18,6 @@ wxDEFINE_EVENT(wxEVT_RESULT_READY, wxCommandEvent);
 wxDEFINE_EVENT(wxEVT_IMAGE_READY, wxCommandEvent);
 wxDEFINE_EVENT(wxEVT_UPDATE_PROGRESS, wxCommandEvent);
 wxDEFINE_EVENT(wxEVT_BATCH_PROCESS, wxCommandEvent);
-wxDEFINE_EVENT(INSTALL_START_EVENT, wxCommandEvent);
-wxDEFINE_EVENT(INSTALL_COMPLETE_EVENT, wxCommandEvent);
-wxDEFINE_EVENT(INSTALL_CANCEL_EVENT, wxCommandEvent);
 
 // Event tables
 BEGIN_EVENT_TABLE(FlatpakStore, wxPanel)
@@ -31,10 +29,8 @@ EVT_COMMAND(wxID_ANY, wxEVT_IMAGE_READY, FlatpakStore::OnImageReady)
 EVT_COMMAND(wxID_ANY, wxEVT_UPDATE_PROGRESS, FlatpakStore::OnUpdateProgress)
 EVT_TIMER(ID_BATCH_TIMER, FlatpakStore::OnBatchTimer)
 EVT_TIMER(ID_LAYOUT_TIMER, FlatpakStore::OnLayoutTimer)
-EVT_COMMAND(wxID_ANY, INSTALL_START_EVENT, FlatpakStore::OnInstallStart)
-EVT_COMMAND(wxID_ANY, INSTALL_COMPLETE_EVENT, FlatpakStore::OnInstallComplete)
-EVT_COMMAND(wxID_ANY, INSTALL_CANCEL_EVENT, FlatpakStore::OnInstallCancel)
-EVT_END_PROCESS(wxID_ANY, FlatpakStore::OnProcessTerminated)
+EVT_COMMAND(wxID_ANY, DOCKER_EXEC_OUTPUT, FlatpakStore::OnExecOutput)
+EVT_COMMAND(wxID_ANY, DOCKER_EXEC_COMPLETE, FlatpakStore::OnExecComplete)
 EVT_BUTTON(ID_SHOW_INSTALLED_BUTTON, FlatpakStore::OnShowInstalledButtonClicked)
 END_EVENT_TABLE()
 
@@ -463,92 +459,6 @@ wxThread::ExitCode InitialLoadThread::Entry()
     }
 }
 
-// InstallThread Implementation
-wxThread::ExitCode InstallThread::Entry()
-{
-    wxLogDebug("InstallThread started for app: %s", m_appId);
-
-    // Updated command with output redirection to /dev/null
-    wxString command = wxString::Format(
-        "docker exec %s /bin/bash -c \"chroot /root/custom_iso/squashfs-root /bin/bash -c 'flatpak install -y flathub %s > /dev/null 2>&1'\"",
-        m_store->GetContainerId(), m_appId);
-    wxLogDebug("Command prepared: %s", command);
-
-    // Start the process asynchronously via a command event
-    wxCommandEvent startEvent(INSTALL_START_EVENT);
-    startEvent.SetString(command);
-    startEvent.SetClientData(m_state);
-    wxLogDebug("Queuing INSTALL_START_EVENT for app: %s", m_appId);
-    wxQueueEvent(m_store, startEvent.Clone());
-
-    // Poll for cancellation or process completion with a timeout
-    const int maxPolls = 6000; // 10 minutes timeout (6000 * 100ms = 600s)
-    int pollCount = 0;
-    while (!m_state->cancelFlag && !TestDestroy() && pollCount < maxPolls)
-    {
-        wxMilliSleep(100); // Check every 100ms
-        pollCount++;
-        if (m_state->process)
-        {
-            wxLogDebug("Polling: Process exists for PID %ld, poll count: %d", m_state->pid, pollCount);
-            if (!m_state->process->Exists(m_state->pid))
-            {
-                wxLogDebug("Process %ld has ended naturally for app: %s", m_state->pid, m_appId);
-                break; // Process has ended naturally
-            }
-        }
-        else
-        {
-            wxLogDebug("Polling: Process not yet started, poll count: %d", pollCount);
-        }
-    }
-
-    if (pollCount >= maxPolls)
-    {
-        wxLogDebug("Installation timed out for app: %s after %d polls", m_appId, maxPolls);
-        if (m_state->process && m_state->process->Exists(m_state->pid))
-        {
-            wxKill(m_state->pid, wxSIGTERM); // Try to terminate gracefully
-            wxLogDebug("Sent SIGTERM to PID: %ld due to timeout", m_state->pid);
-            wxMilliSleep(500);
-            if (m_state->process->Exists(m_state->pid))
-            {
-                wxKill(m_state->pid, wxSIGKILL); // Force kill if necessary
-                wxLogDebug("Sent SIGKILL to PID: %ld due to timeout", m_state->pid);
-            }
-        }
-        wxCommandEvent cancelEvent(INSTALL_CANCEL_EVENT);
-        cancelEvent.SetInt(2); // Indicate timeout (distinct from user cancel = 1)
-        cancelEvent.SetClientData(m_state);
-        wxLogDebug("Queuing INSTALL_CANCEL_EVENT due to timeout for app: %s", m_appId);
-        wxQueueEvent(m_store, cancelEvent.Clone());
-    }
-    else if (m_state->cancelFlag && m_state->process && m_state->process->Exists(m_state->pid))
-    {
-        wxLogDebug("Cancellation requested for app: %s, PID: %ld", m_appId, m_state->pid);
-        wxKill(m_state->pid, wxSIGTERM); // Try to terminate gracefully
-        wxLogDebug("Sent SIGTERM to PID: %ld", m_state->pid);
-        wxMilliSleep(500);
-        if (m_state->process->Exists(m_state->pid))
-        {
-            wxKill(m_state->pid, wxSIGKILL); // Force kill if necessary
-            wxLogDebug("Sent SIGKILL to PID: %ld", m_state->pid);
-        }
-        wxCommandEvent cancelEvent(INSTALL_CANCEL_EVENT);
-        cancelEvent.SetInt(1); // Indicate cancellation
-        cancelEvent.SetClientData(m_state);
-        wxLogDebug("Queuing INSTALL_CANCEL_EVENT for app: %s", m_appId);
-        wxQueueEvent(m_store, cancelEvent.Clone());
-    }
-    else if (m_state->cancelFlag)
-    {
-        wxLogDebug("Cancellation requested but process already ended or not started for app: %s", m_appId);
-    }
-
-    wxLogDebug("InstallThread exiting for app: %s", m_appId);
-    return (ExitCode)0;
-}
-
 // FlatpakStore Implementation
 FlatpakStore::FlatpakStore(wxWindow *parent, const wxString &workDir)
     : wxPanel(parent, wxID_ANY),
@@ -559,7 +469,10 @@ FlatpakStore::FlatpakStore(wxWindow *parent, const wxString &workDir)
       m_stopFlag(false),
       m_searchId(0),
       m_displayedResults(0),
-      m_pendingBatchSize(0)
+      m_pendingBatchSize(0),
+      m_nextInstallId(ID_INSTALL_EXEC_FIRST),
+      m_listThread(nullptr),
+      m_listedApps(0)
 {
     wxLogDebug("FlatpakStore constructor started");
     SetDoubleBuffered(true);
@@ -1031,10 +944,12 @@ void FlatpakStore::OnInstallButtonClicked(wxCommandEvent &event)
     }
     wxLogDebug("Container ID validated: %s", m_containerId);
 
-    // Create installation command
+    // Create installation command. It runs in the chroot and its output is
+    // streamed to drive the card's progress gauge.
+    wxString script = wxString::Format("flatpak install -y flathub %s", appId);
     wxString command = wxString::Format(
-        "docker exec %s /bin/bash -c \"chroot /root/custom_iso/squashfs-root /bin/bash -c 'flatpak install -y flathub %s > /dev/null 2>&1'\"",
-        m_containerId, appId);
+        "docker exec %s /bin/bash -c \"chroot %s /bin/bash -c '%s'\"",
+        m_containerId, ChrootAgent::ROOT, script);
 
     // Get the app name from the card
     wxString appName = card->GetName();
@@ -1044,31 +959,32 @@ void FlatpakStore::OnInstallButtonClicked(wxCommandEvent &event)
 
     // Create installation state
     InstallState *state = new InstallState(card);
+    int execId = m_nextInstallId++;
+    state->thread = new DockerExecThread(this, execId, m_containerId, script);
     wxLogDebug("Created InstallState for app: %s", appId);
 
-    // Update UI and bind cancel button
-    card->ShowInstalling(true);
-    auto cancelHandler = [state](wxCommandEvent &)
+    if (state->thread->Run() != wxTHREAD_NO_ERROR)
     {
-        wxLogDebug("Cancel button clicked for app: %s", state->card->GetAppId());
-        state->cancelFlag = true;
-    };
-    card->GetCancelButton()->Bind(wxEVT_BUTTON, cancelHandler);
-    wxLogDebug("Cancel button bound for app: %s", appId);
-
-    // Start installation thread
-    InstallThread *thread = new InstallThread(this, appId, state);
-    if (thread->Run() != wxTHREAD_NO_ERROR)
-    {
-        wxLogDebug("Failed to start InstallThread for app: %s", appId);
-        delete thread;
-        card->GetCancelButton()->Unbind(wxEVT_BUTTON, cancelHandler);
+        wxLogDebug("Failed to start install thread for app: %s", appId);
+        delete state->thread;
         delete state;
-        card->ShowInstalling(false);
         wxMessageBox("Failed to start installation thread", "Error", wxICON_ERROR);
         return;
     }
-    wxLogDebug("InstallThread started successfully for app: %s", appId);
+    m_activeInstalls[execId] = state;
+
+    // Update UI and bind cancel button; the card may outlive the install
+    // with the button still bound, so look the install up by id
+    card->ShowInstalling(true);
+    card->GetCancelButton()->Bind(wxEVT_BUTTON, [this, execId](wxCommandEvent &)
+                                  {
+        auto it = m_activeInstalls.find(execId);
+        if (it != m_activeInstalls.end())
+        {
+            wxLogDebug("Cancel button clicked for app: %s", it->second->appId);
+            it->second->thread->Cancel();
+        } });
+    wxLogDebug("Install thread started successfully for app: %s", appId);
 }
 
 void FlatpakStore::SaveInstallationPreferences(const wxString &appId, const wxString &command, const wxString &appName)
@@ -1142,156 +1058,143 @@ void FlatpakStore::SaveInstallationPreferences(const wxString &appId, const wxSt
     }
 }
 
-void FlatpakStore::OnInstallStart(wxCommandEvent &event)
+void FlatpakStore::OnExecOutput(wxCommandEvent &event)
 {
-    wxLogDebug("OnInstallStart triggered");
-    InstallState *state = static_cast<InstallState *>(event.GetClientData());
-    if (!state || !state->card)
+    if (event.GetId() == ID_LIST_INSTALLED_EXEC)
     {
-        wxLogDebug("Invalid InstallState or card in OnInstallStart");
+        // One application ID per line of "flatpak list --app"
+        wxString appId = event.GetString();
+        appId.Trim().Trim(false);
+        if (event.GetInt() != 1 || appId.IsEmpty())
+            return;
+        wxLogDebug("Adding installed AppCard - AppID: %s", appId);
+        AppCard *card = new AppCard(m_resultsPanel, appId, "Installed application", appId);
+        m_gridSizer->Add(card, 0, wxALL, 5);
+        m_progressText->SetLabel(wxString::Format("Fetching installed applications... %d found", ++m_listedApps));
+        m_progressBar->Pulse();
+        m_layoutTimer->StartOnce(50);
         return;
     }
 
-    wxLogDebug("Starting installation process for app: %s", state->card->GetAppId());
-    state->process = new wxProcess(this);
-    state->process->Redirect();
-    state->pid = wxExecute(event.GetString(), wxEXEC_ASYNC | wxEXEC_HIDE_CONSOLE, state->process);
-    wxLogDebug("wxExecute called with command: %s, PID: %ld", event.GetString(), state->pid);
+    auto it = m_activeInstalls.find(event.GetId());
+    if (it != m_activeInstalls.end())
+        OnInstallOutput(it->second, event.GetString());
+}
 
-    if (state->pid == 0)
+void FlatpakStore::OnExecComplete(wxCommandEvent &event)
+{
+    if (event.GetId() == ID_LIST_INSTALLED_EXEC)
     {
-        wxLogDebug("wxExecute failed to start process for app: %s", state->card->GetAppId());
-        delete state->process;
-        state->process = nullptr;
-        wxCommandEvent completeEvent(INSTALL_COMPLETE_EVENT);
-        completeEvent.SetInt(-1); // Indicate failure to start
-        completeEvent.SetClientData(state);
-        wxLogDebug("Queuing INSTALL_COMPLETE_EVENT with failure for app: %s", state->card->GetAppId());
-        wxQueueEvent(this, completeEvent.Clone());
+        OnListInstalledComplete(event);
+        return;
     }
-    else
+
+    auto it = m_activeInstalls.find(event.GetId());
+    if (it == m_activeInstalls.end())
     {
-        m_activeInstalls[state->pid] = state;
-        wxLogDebug("Process started successfully, PID: %ld added to active installs", state->pid);
+        wxLogDebug("No active install found for exec id: %d", event.GetId());
+        return;
     }
-}
+    InstallState *state = it->second;
+    m_activeInstalls.erase(it);
+    state->thread->Wait();
+    delete state->thread;
+    state->thread = nullptr;
 
-void FlatpakStore::OnProcessTerminated(wxProcessEvent &event)
-{
-    wxLogDebug("OnProcessTerminated triggered for PID: %ld", event.GetPid());
-    auto it = m_activeInstalls.find(event.GetPid());
-    if (it != m_activeInstalls.end())
+    if (event.GetExtraLong())
     {
-        InstallState *state = it->second;
-        int exitCode = event.GetExitCode();
-        wxLogDebug("Process terminated for app: %s, PID: %ld, ExitCode: %d", state->card->GetAppId(), event.GetPid(), exitCode);
-
-        wxCommandEvent completeEvent(INSTALL_COMPLETE_EVENT);
-        completeEvent.SetInt(exitCode);
-        completeEvent.SetClientData(state);
-        wxLogDebug("Queuing INSTALL_COMPLETE_EVENT for app: %s with exit code: %d", state->card->GetAppId(), exitCode);
-        wxQueueEvent(this, completeEvent.Clone());
-
-        m_activeInstalls.erase(it);
-        wxLogDebug("Removed PID: %ld from active installs", event.GetPid());
+        OnInstallCancel(state);
     }
     else
     {
-        wxLogDebug("No active install found for PID: %ld", event.GetPid());
+        if (!event.GetString().IsEmpty())
+            wxLogDebug("Install of %s failed: %s", state->appId, event.GetString());
+        OnInstallComplete(state, event.GetInt());
     }
 }
 
-void FlatpakStore::OnInstallComplete(wxCommandEvent &event)
+// flatpak reports each download step as a line ending in a percentage;
+// anything else just keeps the gauge moving
+void FlatpakStore::OnInstallOutput(InstallState *state, const wxString &line)
 {
-    wxLogDebug("OnInstallComplete triggered");
-    InstallState *state = static_cast<InstallState *>(event.GetClientData());
-    if (!state || !state->card)
-    {
-        wxLogDebug("Invalid InstallState or card in OnInstallComplete");
+    wxLogDebug("Install output for app %s: %s", state->appId, line);
+    if (!state->card)
         return;
+
+    wxGauge *gauge = state->card->GetProgressGauge();
+    wxString text = line;
+    text.Trim();
+    long percent = -1;
+    if (text.EndsWith("%"))
+    {
+        size_t start = text.length() - 1;
+        while (start > 0 && wxIsdigit(text[start - 1]))
+            --start;
+        text.Mid(start, text.length() - 1 - start).ToLong(&percent);
     }
+    if (percent >= 0 && percent <= 100)
+        gauge->SetValue(percent);
+    else
+        gauge->Pulse();
+}
 
-    int result = event.GetInt();
+void FlatpakStore::OnInstallComplete(InstallState *state, int result)
+{
+    wxLogDebug("Installation completed for app: %s with result: %d", state->appId, result);
     AppCard *card = state->card;
-    wxLogDebug("Installation completed for app: %s with result: %d", card->GetAppId(), result);
-
-    card->ShowInstalling(false);
-    auto cancelHandler = [state](wxCommandEvent &)
-    { state->cancelFlag = true; };
-    card->GetCancelButton()->Unbind(wxEVT_BUTTON, cancelHandler);
-    wxLogDebug("Unbound cancel button for app: %s", card->GetAppId());
+    if (card)
+    {
+        card->ShowInstalling(false);
+        if (result == 0)
+        {
+            card->SetInstallButtonLabel("Installed");
+            card->DisableInstallButton();
+        }
+    }
 
     if (result == 0)
     {
-        card->SetInstallButtonLabel("Installed");
-        card->DisableInstallButton();
-        wxLogDebug("Installation successful for app: %s", card->GetAppId());
+        wxLogDebug("Installation successful for app: %s", state->appId);
     }
     else if (result == 125) // new handling for exit code 125
     {
-        wxLogDebug("Installation failed for app: %s with exit code: %d (Possible Docker or Flatpak configuration issue)", card->GetAppId(), result);
-        wxMessageBox("Installation failed for " + card->GetAppId() +
+        wxLogDebug("Installation failed for app: %s with exit code: %d (Possible Docker or Flatpak configuration issue)", state->appId, result);
+        wxMessageBox("Installation failed for " + state->appId +
                          ". Please check Docker and Flatpak configurations. (Exit code: " +
                          wxString::Format("%d", result) + ")",
                      "Error", wxICON_ERROR);
     }
     else if (result != -1)
     {
-        wxLogDebug("Installation failed for app: %s with exit code: %d", card->GetAppId(), result);
-        wxMessageBox("Installation failed for " + card->GetAppId(),
+        wxLogDebug("Installation failed for app: %s with exit code: %d", state->appId, result);
+        wxMessageBox("Installation failed for " + state->appId,
                      "Error", wxICON_ERROR);
     }
     else
     {
-        wxLogDebug("Installation failed to start for app: %s", card->GetAppId());
-        wxMessageBox("Failed to start installation for " + card->GetAppId(),
+        wxLogDebug("Installation failed to start for app: %s", state->appId);
+        wxMessageBox("Failed to start installation for " + state->appId,
                      "Error", wxICON_ERROR);
     }
 
-    delete state->process;
     delete state;
-    wxLogDebug("Cleaned up InstallState for app: %s", card->GetAppId());
 }
 
-void FlatpakStore::OnInstallCancel(wxCommandEvent &event)
+void FlatpakStore::OnInstallCancel(InstallState *state)
 {
-    wxLogDebug("OnInstallCancel triggered");
-    InstallState *state = static_cast<InstallState *>(event.GetClientData());
-    if (!state || !state->card)
-    {
-        wxLogDebug("Invalid InstallState or card in OnInstallCancel");
-        return;
-    }
+    wxLogDebug("Cancellation completed for app: %s", state->appId);
+    if (state->card)
+        state->card->ShowInstalling(false);
 
-    AppCard *card = state->card;
-    int cancelReason = event.GetInt();
-    wxLogDebug("Cancellation completed for app: %s with reason: %d", card->GetAppId(), cancelReason);
-
-    card->ShowInstalling(false);
-    auto cancelHandler = [state](wxCommandEvent &)
-    { state->cancelFlag = true; };
-    card->GetCancelButton()->Unbind(wxEVT_BUTTON, cancelHandler);
-    wxLogDebug("Unbound cancel button for app: %s", card->GetAppId());
-
-    if (cancelReason == 1)
-    {
-        wxMessageBox("Installation of " + card->GetAppId() + " was canceled by user.", "Canceled", wxICON_INFORMATION);
-    }
-    else if (cancelReason == 2)
-    {
-        wxMessageBox("Installation of " + card->GetAppId() + " timed out.", "Timeout", wxICON_WARNING);
-    }
-
-    m_activeInstalls.erase(state->pid);
-    wxLogDebug("Removed PID: %ld from active installs due to cancellation", state->pid);
-    delete state->process;
+    wxMessageBox("Installation of " + state->appId + " was canceled by user.", "Canceled", wxICON_INFORMATION);
     delete state;
-    wxLogDebug("Cleaned up InstallState for app: %s after cancellation", card->GetAppId());
 }
 
 void FlatpakStore::OnShowInstalledButtonClicked(wxCommandEvent &event)
 {
     wxLogDebug("OnShowInstalledButtonClicked triggered");
+    if (m_listThread)
+        return;
     try
     {
         ClearResults();
@@ -1300,46 +1203,20 @@ void FlatpakStore::OnShowInstalledButtonClicked(wxCommandEvent &event)
         m_progressPanel->Show();
         Layout();
 
-        // Updated command to execute in the container and chroot
-        std::string command = wxString::Format(
-                                  "docker exec %s /bin/bash -c \"chroot /root/custom_iso/squashfs-root /bin/bash -c 'flatpak list --app'\"",
-                                  m_containerId)
-                                  .ToStdString();
-        wxArrayString output, errors;
-        int exitCode = wxExecute(command, output, errors, wxEXEC_SYNC | wxEXEC_HIDE_CONSOLE);
-
-        if (exitCode != 0)
+        // Cards are added as "flatpak list" prints them
+        m_listedApps = 0;
+        m_listThread = new DockerExecThread(this, ID_LIST_INSTALLED_EXEC, m_containerId, wxString("flatpak list --app"));
+        if (m_listThread->Run() != wxTHREAD_NO_ERROR)
         {
-            wxLogDebug("Failed to fetch installed applications");
+            delete m_listThread;
+            m_listThread = nullptr;
+            wxLogDebug("Failed to start thread fetching installed applications");
             wxMessageBox("Failed to fetch installed applications", "Error", wxICON_ERROR);
             m_progressPanel->Hide();
             Layout();
             return;
         }
-
-        if (output.IsEmpty())
-        {
-            wxLogDebug("No installed applications found");
-            wxStaticText *noResultsText = new wxStaticText(m_resultsPanel, wxID_ANY, "No results");
-            noResultsText->SetForegroundColour(wxColour(229, 229, 229));
-            m_gridSizer->Add(noResultsText, 0, wxALIGN_CENTER | wxALL, 15);
-        }
-        else
-        {
-            for (const auto &line : output)
-            {
-                wxString lineCopy = line;
-                wxString appId = lineCopy.Trim(); // appId only since --columns is removed
-                wxLogDebug("Adding installed AppCard - AppID: %s", appId);
-                AppCard *card = new AppCard(m_resultsPanel, appId, "Installed application", appId);
-                m_gridSizer->Add(card, 0, wxALL, 5);
-            }
-        }
-
-        m_gridSizer->Layout();
-        m_resultsPanel->Layout();
-        m_progressPanel->Hide();
-        Layout();
+        m_showInstalledButton->Disable();
     }
     catch (const std::exception &e)
     {
@@ -1350,6 +1227,34 @@ void FlatpakStore::OnShowInstalledButtonClicked(wxCommandEvent &event)
     }
 }
 
+void FlatpakStore::OnListInstalledComplete(wxCommandEvent &event)
+{
+    if (!m_listThread)
+        return;
+    m_listThread->Wait();
+    delete m_listThread;
+    m_listThread = nullptr;
+    m_showInstalledButton->Enable();
+
+    if (event.GetInt() != 0)
+    {
+        wxLogDebug("Failed to fetch installed applications: %s", event.GetString());
+        wxMessageBox("Failed to fetch installed applications", "Error", wxICON_ERROR);
+    }
+    else if (m_listedApps == 0)
+    {
+        wxLogDebug("No installed applications found");
+        wxStaticText *noResultsText = new wxStaticText(m_resultsPanel, wxID_ANY, "No results");
+        noResultsText->SetForegroundColour(wxColour(229, 229, 229));
+        m_gridSizer->Add(noResultsText, 0, wxALIGN_CENTER | wxALL, 15);
+    }
+
+    m_gridSizer->Layout();
+    m_resultsPanel->Layout();
+    m_progressPanel->Hide();
+    Layout();
+}
+
 void FlatpakStore::OnSearchButtonClicked(wxCommandEvent &event)
 {
     OnSearch(event); // Trigger the search functionality
@@ -1380,10 +1285,23 @@ FlatpakStore::~FlatpakStore()
             delete m_layoutTimer;
         }
 
-        for (auto &[pid, state] : m_activeInstalls)
+        // Stop waiting on every exec first so the threads wind down together
+        if (m_listThread)
+            m_listThread->Cancel();
+        for (auto &[execId, state] : m_activeInstalls)
+            state->thread->Cancel();
+
+        if (m_listThread)
+        {
+            m_listThread->Wait();
+            delete m_listThread;
+            m_listThread = nullptr;
+        }
+        for (auto &[execId, state] : m_activeInstalls)
         {
-            wxLogDebug("Cleaning up active install for PID: %ld", pid);
-            delete state->process;
+            wxLogDebug("Cleaning up active install for app: %s", state->appId);
+            state->thread->Wait();
+            delete state->thread;
             delete state;
         }
         m_activeInstalls.clear();
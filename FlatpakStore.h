@@ -18,7 +18,7 @@
 #include <wx/progdlg.h>
 #include <wx/dcbuffer.h>
 #include <wx/graphics.h>
-#include <wx/process.h>
+#include <wx/weakref.h>
 #include <curl/curl.h>
 #include <rapidjson/document.h>
 #include <rapidjson/error/en.h>
@@ -35,13 +35,13 @@
 #include <atomic>
 #include <memory>
 #include <map> // Added for std::map
+#include "DockerExecThread.h"
 
 // Forward declarations
 class AppCard;
 class FlatpakStore;
 class SearchThread;
 class InitialLoadThread;
-class InstallThread;
 class RoundedSearchPanel;
 
 // Custom event types
@@ -50,9 +50,6 @@ wxDECLARE_EVENT(wxEVT_RESULT_READY, wxCommandEvent);
 wxDECLARE_EVENT(wxEVT_IMAGE_READY, wxCommandEvent);
 wxDECLARE_EVENT(wxEVT_UPDATE_PROGRESS, wxCommandEvent);
 wxDECLARE_EVENT(wxEVT_BATCH_PROCESS, wxCommandEvent);
-wxDECLARE_EVENT(INSTALL_START_EVENT, wxCommandEvent);
-wxDECLARE_EVENT(INSTALL_COMPLETE_EVENT, wxCommandEvent);
-wxDECLARE_EVENT(INSTALL_CANCEL_EVENT, wxCommandEvent);
 
 // ThreadPool class declaration
 class ThreadPool
@@ -158,27 +155,10 @@ private:
 // InstallState structure
 struct InstallState
 {
-    AppCard *card;
-    std::atomic<bool> cancelFlag;
-    wxProcess *process;
-    long pid;
-    InstallState(AppCard *c) : card(c), cancelFlag(false), process(nullptr), pid(0) {}
-};
-
-// InstallThread class declaration
-class InstallThread : public wxThread
-{
-public:
-    InstallThread(FlatpakStore *store, const wxString &appId, InstallState *state)
-        : wxThread(wxTHREAD_DETACHED), m_store(store), m_appId(appId), m_state(state) {}
-
-protected:
-    virtual ExitCode Entry() override;
-
-private:
-    FlatpakStore *m_store;
-    wxString m_appId;
-    InstallState *m_state;
+    wxWeakRef<AppCard> card;   // Null once a new search clears the card
+    wxString appId;
+    DockerExecThread *thread;
+    InstallState(AppCard *c) : card(c), appId(c->GetAppId()), thread(nullptr) {}
 };
 
 // FlatpakStore class declaration
@@ -197,7 +177,9 @@ public:
     {
         ID_BATCH_TIMER = wxID_HIGHEST + 1,
         ID_LAYOUT_TIMER,
-        ID_SHOW_INSTALLED_BUTTON // Add new button ID
+        ID_SHOW_INSTALLED_BUTTON, // Add new button ID
+        ID_LIST_INSTALLED_EXEC,   // Exec id of "flatpak list"
+        ID_INSTALL_EXEC_FIRST     // Exec ids of installs start here
     };
 
 private:
@@ -240,8 +222,13 @@ private:
         wxBitmap bitmap;
     };
 
-    // Active installations tracking
-    std::map<long, InstallState *> m_activeInstalls; // Added declaration
+    // Active installations tracking, keyed by the exec id of their thread
+    std::map<int, InstallState *> m_activeInstalls;
+    int m_nextInstallId;
+
+    // Streams "flatpak list" into the results while it runs
+    DockerExecThread *m_listThread;
+    int m_listedApps;
 
     // Event handlers
     void OnSearch(wxCommandEvent &event);
@@ -250,10 +237,12 @@ private:
     void OnImageReady(wxCommandEvent &event);
     void OnUpdateProgress(wxCommandEvent &event);
     void OnInstallButtonClicked(wxCommandEvent &event);
-    void OnInstallStart(wxCommandEvent &event);
-    void OnInstallComplete(wxCommandEvent &event);
-    void OnInstallCancel(wxCommandEvent &event);
-    void OnProcessTerminated(wxProcessEvent &event);
+    void OnExecOutput(wxCommandEvent &event);
+    void OnExecComplete(wxCommandEvent &event);
+    void OnInstallOutput(InstallState *state, const wxString &line);
+    void OnInstallComplete(InstallState *state, int result);
+    void OnInstallCancel(InstallState *state);
+    void OnListInstalledComplete(wxCommandEvent &event);
     void OnLayoutTimer(wxTimerEvent &event);
     void OnBatchTimer(wxTimerEvent &event);
     void OnShowInstalledButtonClicked(wxCommandEvent &event); // Add new event handler declaration
@@ -0,0 +1,533 @@
+#include "ISO9660Image.h"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <set>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace {
+
+// Volume descriptor layout (ECMA-119 8.4)
+constexpr std::uint32_t FIRST_DESCRIPTOR_LBA = 16;
+constexpr std::uint32_t MAX_DESCRIPTORS = 64;
+constexpr std::size_t VD_VOLUME_ID = 40;
+constexpr std::size_t VD_ESCAPES = 88;
+constexpr std::size_t VD_PATH_TABLE_SIZE = 132;
+constexpr std::size_t VD_PATH_TABLE_L = 140;
+constexpr std::size_t VD_ROOT_RECORD = 156;
+constexpr std::size_t BOOT_CATALOG_POINTER = 71;
+
+// Directory record layout (ECMA-119 9.1)
+constexpr std::size_t DR_EXTENT = 2;
+constexpr std::size_t DR_SIZE = 10;
+constexpr std::size_t DR_FLAGS = 25;
+constexpr std::size_t DR_NAME_LEN = 32;
+constexpr std::size_t DR_NAME = 33;
+constexpr std::uint8_t FLAG_DIRECTORY = 0x02;
+constexpr std::uint8_t FLAG_MULTI_EXTENT = 0x80;
+
+constexpr int MAX_CONTINUATIONS = 16;
+
+// Rock Ridge PX and SL fields (RRIP 4.1.1, 4.1.3)
+constexpr std::uint32_t MODE_TYPE_MASK = 0170000;
+constexpr std::uint32_t MODE_SYMLINK = 0120000;
+constexpr std::uint8_t SL_CONTINUE = 0x01;
+constexpr std::uint8_t SL_CURRENT = 0x02;
+constexpr std::uint8_t SL_PARENT = 0x04;
+constexpr std::uint8_t SL_ROOT = 0x08;
+
+std::uint32_t le32(const std::uint8_t* p) {
+    return static_cast<std::uint32_t>(p[0]) |
+           (static_cast<std::uint32_t>(p[1]) << 8) |
+           (static_cast<std::uint32_t>(p[2]) << 16) |
+           (static_cast<std::uint32_t>(p[3]) << 24);
+}
+
+void appendUtf8(std::string& out, std::uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+std::uint64_t sectorsFor(std::uint64_t size) {
+    return (size + ISO9660Image::SECTOR_SIZE - 1) / ISO9660Image::SECTOR_SIZE;
+}
+
+} // namespace
+
+ISO9660Image::ISO9660Image(const std::string& path)
+    : m_path(path)
+    , m_base(nullptr)
+    , m_size(0)
+#ifdef _WIN32
+    , m_fileHandle(nullptr)
+    , m_mappingHandle(nullptr)
+#else
+    , m_fd(-1)
+#endif
+    , m_bootCatalogLba(0)
+    , m_suspSkip(0)
+    , m_rockRidge(false)
+    , m_joliet(false) {}
+
+ISO9660Image::~ISO9660Image() {
+    close();
+}
+
+bool ISO9660Image::open() {
+    close();
+    if (!map()) {
+        return false;
+    }
+
+    std::uint32_t pathTableLba = 0, pathTableSize = 0, rootLba = 0;
+    if (!parseVolumeDescriptors(pathTableLba, pathTableSize, rootLba)) {
+        close();
+        return false;
+    }
+
+    // Collect every directory extent listed in the path table. Entries are
+    // 8 bytes plus the identifier, padded to an even length (ECMA-119 9.4).
+    std::vector<std::uint32_t> directories;
+    const std::uint8_t* table = at(static_cast<std::uint64_t>(pathTableLba) * SECTOR_SIZE, pathTableSize);
+    if (!table) {
+        m_lastError = "Path table lies outside the image";
+        close();
+        return false;
+    }
+    for (std::size_t pos = 0; pos + 8 <= pathTableSize;) {
+        std::size_t idLength = table[pos];
+        if (idLength == 0) break;
+        directories.push_back(le32(table + pos + 2));
+        pos += 8 + idLength + (idLength & 1);
+    }
+    if (directories.empty() || directories.front() != rootLba) {
+        m_lastError = "Path table does not start at the root directory";
+        close();
+        return false;
+    }
+
+    std::map<std::uint32_t, std::vector<Record>> children;
+    for (std::uint32_t lba : directories) {
+        if (children.count(lba)) continue;
+        if (!parseDirectory(lba, 0, children[lba])) {
+            close();
+            return false;
+        }
+    }
+
+    // Rebuild full paths breadth-first from the root. Directories reached
+    // through a Rock Ridge CL link may be missing from the path table under
+    // that name, so unknown extents are parsed on demand.
+    std::set<std::uint32_t> visited{rootLba};
+    std::deque<std::pair<std::uint32_t, std::string>> pending{{rootLba, std::string()}};
+    while (!pending.empty()) {
+        auto [lba, prefix] = pending.front();
+        pending.pop_front();
+
+        auto it = children.find(lba);
+        if (it == children.end()) {
+            it = children.emplace(lba, std::vector<Record>()).first;
+            if (!parseDirectory(lba, 0, it->second)) {
+                close();
+                return false;
+            }
+        }
+
+        for (const Record& record : it->second) {
+            File file;
+            file.path = prefix.empty() ? record.name : prefix + "/" + record.name;
+            file.size = record.directory ? 0 : record.size;
+            file.lba = record.lba;
+            file.directory = record.directory;
+            file.contiguous = record.contiguous;
+            file.symlink = record.symlink;
+            file.mode = record.mode;
+            m_files.push_back(file);
+
+            if (record.directory && visited.insert(record.lba).second) {
+                pending.emplace_back(record.lba, file.path);
+            }
+        }
+    }
+    return true;
+}
+
+void ISO9660Image::close() {
+    unmap();
+    m_files.clear();
+    m_volumeId.clear();
+    m_bootCatalogLba = 0;
+    m_suspSkip = 0;
+    m_rockRidge = false;
+    m_joliet = false;
+}
+
+ByteSpan ISO9660Image::extent(const File& file) const {
+    if (file.directory || !file.contiguous) {
+        return ByteSpan();
+    }
+    const std::uint8_t* data = at(static_cast<std::uint64_t>(file.lba) * SECTOR_SIZE, file.size);
+    if (!data) {
+        return ByteSpan();
+    }
+    return ByteSpan(reinterpret_cast<const std::byte*>(data), static_cast<std::size_t>(file.size));
+}
+
+ByteSpan ISO9660Image::sectors(std::uint32_t lba, std::size_t count) const {
+    std::uint64_t offset = static_cast<std::uint64_t>(lba) * SECTOR_SIZE;
+    if (!m_base || offset >= m_size) {
+        return ByteSpan();
+    }
+    std::uint64_t length = std::min<std::uint64_t>(static_cast<std::uint64_t>(count) * SECTOR_SIZE,
+                                                   m_size - offset);
+    return ByteSpan(reinterpret_cast<const std::byte*>(m_base + offset), static_cast<std::size_t>(length));
+}
+
+const std::uint8_t* ISO9660Image::at(std::uint64_t offset, std::uint64_t length) const {
+    if (!m_base || offset > m_size || length > m_size - offset) {
+        return nullptr;
+    }
+    return m_base + offset;
+}
+
+bool ISO9660Image::map() {
+#ifdef _WIN32
+    int wideSize = MultiByteToWideChar(CP_UTF8, 0, m_path.c_str(), -1, nullptr, 0);
+    std::vector<wchar_t> widePath(wideSize > 0 ? wideSize : 1, L'\0');
+    if (wideSize > 0) {
+        MultiByteToWideChar(CP_UTF8, 0, m_path.c_str(), -1, widePath.data(), wideSize);
+    }
+
+    HANDLE file = CreateFileW(widePath.data(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        m_lastError = "Failed to open image for mapping";
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        m_lastError = "Failed to query image size";
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        m_lastError = "Failed to create file mapping";
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        m_lastError = "Failed to map image";
+        return false;
+    }
+    m_fileHandle = file;
+    m_mappingHandle = mapping;
+    m_base = static_cast<const std::uint8_t*>(view);
+    m_size = static_cast<std::uint64_t>(size.QuadPart);
+#else
+    int fd = ::open(m_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        m_lastError = "Failed to open image for mapping";
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        m_lastError = "Failed to query image size";
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (view == MAP_FAILED) {
+        ::close(fd);
+        m_lastError = "Failed to map image";
+        return false;
+    }
+    m_fd = fd;
+    m_base = static_cast<const std::uint8_t*>(view);
+    m_size = static_cast<std::uint64_t>(st.st_size);
+#endif
+    return true;
+}
+
+void ISO9660Image::unmap() {
+#ifdef _WIN32
+    if (m_base) UnmapViewOfFile(m_base);
+    if (m_mappingHandle) CloseHandle(static_cast<HANDLE>(m_mappingHandle));
+    if (m_fileHandle) CloseHandle(static_cast<HANDLE>(m_fileHandle));
+    m_mappingHandle = nullptr;
+    m_fileHandle = nullptr;
+#else
+    if (m_base) munmap(const_cast<std::uint8_t*>(m_base), static_cast<size_t>(m_size));
+    if (m_fd >= 0) ::close(m_fd);
+    m_fd = -1;
+#endif
+    m_base = nullptr;
+    m_size = 0;
+}
+
+bool ISO9660Image::parseVolumeDescriptors(std::uint32_t& pathTableLba, std::uint32_t& pathTableSize,
+                                          std::uint32_t& rootLba) {
+    const std::uint8_t* primary = nullptr;
+    const std::uint8_t* joliet = nullptr;
+
+    for (std::uint32_t i = 0; i < MAX_DESCRIPTORS; ++i) {
+        const std::uint8_t* vd = at(static_cast<std::uint64_t>(FIRST_DESCRIPTOR_LBA + i) * SECTOR_SIZE, SECTOR_SIZE);
+        if (!vd || std::memcmp(vd + 1, "CD001", 5) != 0) {
+            break;
+        }
+        const std::uint8_t type = vd[0];
+        if (type == 255) {
+            break;
+        } else if (type == 0 && std::memcmp(vd + 7, "EL TORITO SPECIFICATION", 23) == 0) {
+            m_bootCatalogLba = le32(vd + BOOT_CATALOG_POINTER);
+        } else if (type == 1 && !primary) {
+            primary = vd;
+        } else if (type == 2 && !joliet && vd[VD_ESCAPES] == '%' && vd[VD_ESCAPES + 1] == '/' &&
+                   (vd[VD_ESCAPES + 2] == '@' || vd[VD_ESCAPES + 2] == 'C' || vd[VD_ESCAPES + 2] == 'E')) {
+            joliet = vd;
+        }
+    }
+
+    if (!primary) {
+        m_lastError = "No ISO9660 primary volume descriptor";
+        return false;
+    }
+
+    m_volumeId.assign(reinterpret_cast<const char*>(primary + VD_VOLUME_ID), 32);
+    m_volumeId.erase(m_volumeId.find_last_not_of(' ') + 1);
+
+    // Rock Ridge is announced by a SUSP "SP" entry in the root's "." record
+    const std::uint8_t* root = primary + VD_ROOT_RECORD;
+    const std::uint8_t* dot = at(static_cast<std::uint64_t>(le32(root + DR_EXTENT)) * SECTOR_SIZE, SECTOR_SIZE);
+    if (dot && dot[0] >= 34 + 7) {
+        const std::uint8_t* sp = dot + 34;
+        if (sp[0] == 'S' && sp[1] == 'P' && sp[2] == 7 && sp[4] == 0xBE && sp[5] == 0xEF) {
+            m_rockRidge = true;
+            m_suspSkip = sp[6];
+        }
+    }
+
+    const std::uint8_t* descriptor = primary;
+    if (!m_rockRidge && joliet) {
+        descriptor = joliet;
+        m_joliet = true;
+    }
+
+    pathTableSize = le32(descriptor + VD_PATH_TABLE_SIZE);
+    pathTableLba = le32(descriptor + VD_PATH_TABLE_L);
+    rootLba = le32(descriptor + VD_ROOT_RECORD + DR_EXTENT);
+    return true;
+}
+
+bool ISO9660Image::parseDirectory(std::uint32_t lba, std::uint32_t size, std::vector<Record>& records) const {
+    const std::uint64_t base = static_cast<std::uint64_t>(lba) * SECTOR_SIZE;
+    if (size == 0) {
+        // The "." record carries the directory's own length
+        const std::uint8_t* self = at(base, 34);
+        if (!self || self[0] < 34) {
+            return false;
+        }
+        size = le32(self + DR_SIZE);
+    }
+    const std::uint8_t* extent = at(base, size);
+    if (!extent) {
+        return false;
+    }
+
+    Record pending;
+    bool hasPending = false;
+    std::uint64_t pendingEnd = 0;
+
+    for (std::uint32_t pos = 0; pos < size;) {
+        const std::uint8_t* rec = extent + pos;
+        const std::uint8_t length = rec[0];
+        if (length == 0) {
+            // Records never straddle sectors; padding runs to the next one
+            pos = (pos / SECTOR_SIZE + 1) * SECTOR_SIZE;
+            continue;
+        }
+        if (length < 34 || pos + length > size) {
+            return false;
+        }
+        pos += length;
+
+        const std::uint8_t flags = rec[DR_FLAGS];
+        const std::size_t nameLength = rec[DR_NAME_LEN];
+        if (DR_NAME + nameLength > length) {
+            return false;
+        }
+        if (nameLength == 1 && (rec[DR_NAME] == 0 || rec[DR_NAME] == 1)) {
+            continue;
+        }
+
+        SystemUse use;
+        if (m_rockRidge) {
+            std::size_t suOffset = DR_NAME + nameLength + ((nameLength & 1) ? 0 : 1) + m_suspSkip;
+            if (suOffset < length) {
+                readSystemUse(rec + suOffset, length - suOffset, use, 0);
+            }
+        }
+        if (use.relocated) {
+            continue;
+        }
+        std::string& name = use.name;
+        const std::uint32_t childLink = use.childLink;
+        if (name.empty()) {
+            name = decodeName(rec + DR_NAME, nameLength);
+        }
+        // Rock Ridge and Joliet names are free-form; one that isn't a single
+        // path component could point outside the tree it's extracted to
+        if (name.empty() || name == "." || name == ".." ||
+            name.find_first_of(std::string("/\\\0", 3)) != std::string::npos) {
+            continue;
+        }
+
+        const std::uint32_t extentLba = childLink ? childLink : le32(rec + DR_EXTENT);
+        const std::uint64_t extentSize = le32(rec + DR_SIZE);
+
+        if (hasPending && pending.name == name) {
+            // Further extent of a multi-extent file; views need them adjacent
+            if (pendingEnd != extentLba) {
+                pending.contiguous = false;
+            }
+            pending.size += extentSize;
+            pendingEnd = extentLba + sectorsFor(extentSize);
+        } else {
+            if (hasPending) {
+                records.push_back(pending);
+            }
+            pending.name = name;
+            pending.lba = extentLba;
+            pending.size = extentSize;
+            pending.directory = (flags & FLAG_DIRECTORY) != 0 || childLink != 0;
+            pending.contiguous = !use.compressed;
+            pending.symlink = use.isSymlink && !pending.directory ? use.symlink : std::string();
+            pending.mode = use.mode & 07777;
+            pendingEnd = extentLba + sectorsFor(extentSize);
+            hasPending = true;
+        }
+
+        if (!(flags & FLAG_MULTI_EXTENT)) {
+            records.push_back(pending);
+            hasPending = false;
+        }
+    }
+    if (hasPending) {
+        records.push_back(pending);
+    }
+    return true;
+}
+
+// Walks the SUSP entries of one system use area, following CE continuation
+// areas. Only the Rock Ridge entries that change naming, layout, the file
+// type or its permissions matter here.
+void ISO9660Image::readSystemUse(const std::uint8_t* area, std::size_t length, SystemUse& use, int depth) const {
+    if (depth > MAX_CONTINUATIONS) {
+        return;
+    }
+
+    const std::uint8_t* end = area + length;
+    for (const std::uint8_t* p = area; p + 4 <= end;) {
+        const std::uint8_t entryLength = p[2];
+        if (entryLength < 4 || p + entryLength > end) {
+            break;
+        }
+
+        if (p[0] == 'N' && p[1] == 'M' && entryLength >= 5) {
+            if (!(p[4] & 0x06)) {
+                use.name.append(reinterpret_cast<const char*>(p + 5), entryLength - 5);
+            }
+        } else if (p[0] == 'P' && p[1] == 'X' && entryLength >= 12) {
+            use.mode = le32(p + 4);
+            use.isSymlink = use.isSymlink || (use.mode & MODE_TYPE_MASK) == MODE_SYMLINK;
+        } else if (p[0] == 'S' && p[1] == 'L' && entryLength >= 5) {
+            // Component records; a link spanning several SL entries carries
+            // on where the previous one stopped
+            use.isSymlink = true;
+            const std::uint8_t* entryEnd = p + entryLength;
+            for (const std::uint8_t* c = p + 5; c + 2 <= entryEnd && c + 2 + c[1] <= entryEnd; c += 2 + c[1]) {
+                const std::uint8_t componentFlags = c[0];
+                if (!use.symlink.empty() && !use.linkContinues && use.symlink.back() != '/') {
+                    use.symlink += '/';
+                }
+                if (componentFlags & SL_CURRENT) {
+                    use.symlink += '.';
+                } else if (componentFlags & SL_PARENT) {
+                    use.symlink += "..";
+                } else if (componentFlags & SL_ROOT) {
+                    use.symlink = "/";
+                } else {
+                    use.symlink.append(reinterpret_cast<const char*>(c + 2), c[1]);
+                }
+                use.linkContinues = (componentFlags & SL_CONTINUE) != 0;
+            }
+        } else if (p[0] == 'C' && p[1] == 'E' && entryLength >= 28) {
+            const std::uint8_t* next = at(static_cast<std::uint64_t>(le32(p + 4)) * SECTOR_SIZE + le32(p + 12),
+                                          le32(p + 20));
+            if (next) {
+                readSystemUse(next, le32(p + 20), use, depth + 1);
+            }
+        } else if (p[0] == 'C' && p[1] == 'L' && entryLength >= 12) {
+            use.childLink = le32(p + 4);
+        } else if (p[0] == 'R' && p[1] == 'E') {
+            use.relocated = true;
+        } else if (p[0] == 'Z' && p[1] == 'F') {
+            use.compressed = true;
+        } else if (p[0] == 'S' && p[1] == 'T') {
+            break;
+        }
+        p += entryLength;
+    }
+}
+
+std::string ISO9660Image::decodeName(const std::uint8_t* id, std::size_t length) const {
+    std::string name;
+    if (m_joliet) {
+        for (std::size_t i = 0; i + 1 < length; i += 2) {
+            std::uint32_t cp = (static_cast<std::uint32_t>(id[i]) << 8) | id[i + 1];
+            if (cp >= 0xD800 && cp < 0xDC00 && i + 3 < length) {
+                std::uint32_t low = (static_cast<std::uint32_t>(id[i + 2]) << 8) | id[i + 3];
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                i += 2;
+            }
+            appendUtf8(name, cp);
+        }
+    } else {
+        name.assign(reinterpret_cast<const char*>(id), length);
+    }
+
+    // Drop the ";1" version suffix and the dot of extension-less names
+    std::size_t semicolon = name.rfind(';');
+    if (semicolon != std::string::npos) {
+        name.erase(semicolon);
+    }
+    if (!m_joliet && !name.empty() && name.back() == '.') {
+        name.pop_back();
+    }
+    return name;
+}
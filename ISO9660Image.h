@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Read-only view over a range of the mapped image. Mirrors the subset of the
+// std::span<const std::byte> interface we use, since the project builds as C++17.
+class ByteSpan {
+public:
+    ByteSpan() = default;
+    ByteSpan(const std::byte* data, std::size_t size) : m_data(data), m_size(size) {}
+
+    const std::byte* data() const { return m_data; }
+    std::size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    const std::byte* begin() const { return m_data; }
+    const std::byte* end() const { return m_data + m_size; }
+
+    ByteSpan subspan(std::size_t offset, std::size_t count = static_cast<std::size_t>(-1)) const {
+        if (offset >= m_size) return ByteSpan();
+        std::size_t available = m_size - offset;
+        return ByteSpan(m_data + offset, count < available ? count : available);
+    }
+
+private:
+    const std::byte* m_data = nullptr;
+    std::size_t m_size = 0;
+};
+
+// Memory-mapped ISO9660 parser with Joliet and Rock Ridge name support.
+// Files are returned as zero-copy views into the mapping, so reading a
+// small file costs a few page faults instead of a stream walk.
+class ISO9660Image {
+public:
+    struct File {
+        std::string path;       // Relative path, '/' separated, no leading slash
+        std::uint64_t size;     // Size in bytes (sum of all extents)
+        std::uint32_t lba;      // First extent
+        bool directory;
+        bool contiguous;        // False for zisofs or scattered multi-extent files
+        std::string symlink;    // Rock Ridge link target, empty unless a symlink
+        std::uint32_t mode;     // Rock Ridge permission bits, 0 without Rock Ridge
+    };
+
+    explicit ISO9660Image(const std::string& path);
+    ~ISO9660Image();
+
+    ISO9660Image(const ISO9660Image&) = delete;
+    ISO9660Image& operator=(const ISO9660Image&) = delete;
+
+    bool open();
+    void close();
+    bool isOpen() const { return m_base != nullptr; }
+
+    const std::vector<File>& files() const { return m_files; }
+
+    // Zero-copy view of a file's data; empty if the file isn't contiguous
+    ByteSpan extent(const File& file) const;
+    // Raw sectors starting at lba, clamped to the end of the image
+    ByteSpan sectors(std::uint32_t lba, std::size_t count) const;
+
+    std::uint64_t imageSize() const { return m_size; }
+    std::uint32_t bootCatalogLba() const { return m_bootCatalogLba; }
+    const std::string& volumeId() const { return m_volumeId; }
+    bool hasRockRidge() const { return m_rockRidge; }
+    bool hasJoliet() const { return m_joliet; }
+
+    std::string getLastError() const { return m_lastError; }
+
+    static constexpr std::size_t SECTOR_SIZE = 2048;
+
+private:
+    struct Record {
+        std::string name;
+        std::uint32_t lba;
+        std::uint64_t size;
+        bool directory;
+        bool contiguous;
+        std::string symlink;
+        std::uint32_t mode;
+    };
+
+    // What the Rock Ridge entries of one directory record say
+    struct SystemUse {
+        std::string name;
+        std::string symlink;
+        bool isSymlink = false;
+        bool linkContinues = false;    // The last SL component goes on in the next one
+        std::uint32_t mode = 0;
+        std::uint32_t childLink = 0;
+        bool relocated = false;
+        bool compressed = false;
+    };
+
+    bool map();
+    void unmap();
+    bool parseVolumeDescriptors(std::uint32_t& pathTableLba, std::uint32_t& pathTableSize,
+                                std::uint32_t& rootLba);
+    bool parseDirectory(std::uint32_t lba, std::uint32_t size, std::vector<Record>& records) const;
+    void readSystemUse(const std::uint8_t* area, std::size_t length, SystemUse& use, int depth) const;
+    std::string decodeName(const std::uint8_t* id, std::size_t length) const;
+
+    const std::uint8_t* at(std::uint64_t offset, std::uint64_t length) const;
+
+    std::string m_path;
+    const std::uint8_t* m_base;
+    std::uint64_t m_size;
+#ifdef _WIN32
+    void* m_fileHandle;
+    void* m_mappingHandle;
+#else
+    int m_fd;
+#endif
+
+    std::vector<File> m_files;
+    std::string m_volumeId;
+    std::string m_lastError;
+    std::uint32_t m_bootCatalogLba;
+    std::size_t m_suspSkip;
+    bool m_rockRidge;
+    bool m_joliet;
+};
@@ -0,0 +1,83 @@
+#include "ISODetectThread.h"
+#include <wx/filename.h>
+
+wxDEFINE_EVENT(ISO_DETECT_PROGRESS, wxCommandEvent);
+wxDEFINE_EVENT(ISO_DETECT_COMPLETE, wxCommandEvent);
+
+ISODetectThread::ISODetectThread(wxEvtHandler *handler, const wxString &isoPath,
+                                 const ISOInspector::Options &options, const IsoProfileCache &cache)
+    : wxThread(wxTHREAD_JOINABLE), m_handler(handler), m_isoPath(isoPath.Clone()),
+      m_options(options), m_cache(cache), m_cancel(false), m_lastPercent(-1)
+{
+    m_options.progress = [this](std::uint64_t position, std::uint64_t total)
+    {
+        return OnProgress(position, total);
+    };
+}
+
+wxThread::ExitCode ISODetectThread::Entry()
+{
+    auto *result = new ISODetectResult();
+    result->isoPath = m_isoPath;
+
+    PostProgress(0, "Analyzing ISO file...");
+    result->fingerprint = m_cache.Fingerprint(m_isoPath);
+
+    IsoProfileCache::Entry cached;
+    if (m_cache.Load(result->fingerprint, m_isoPath, cached))
+    {
+        result->profile = cached.profile;
+        result->distribution = cached.distribution;
+        result->fromCache = true;
+    }
+    else if (!m_cancel)
+    {
+        try
+        {
+            ISOInspector inspector(m_options);
+            result->profile = inspector.inspect(m_isoPath.ToStdString());
+            result->cancelled = inspector.wasCancelled();
+            if (!result->profile && !result->cancelled)
+            {
+                result->error = wxString::FromUTF8(inspector.getLastError().c_str());
+            }
+        }
+        catch (const std::exception &e)
+        {
+            result->profile.reset();
+            result->error = wxString::FromUTF8(e.what());
+        }
+    }
+    result->cancelled = result->cancelled || (m_cancel && !result->profile);
+
+    wxCommandEvent event(ISO_DETECT_COMPLETE);
+    event.SetClientData(result);
+    wxQueueEvent(m_handler, event.Clone());
+    return (wxThread::ExitCode)0;
+}
+
+// Only posts when the percentage changes, so a header walk over a large
+// image doesn't flood the event queue.
+bool ISODetectThread::OnProgress(std::uint64_t position, std::uint64_t total)
+{
+    if (m_cancel || TestDestroy())
+        return false;
+
+    int percent = total > 0 ? static_cast<int>(position * 100 / total) : 0;
+    if (percent != m_lastPercent)
+    {
+        m_lastPercent = percent;
+        PostProgress(percent, wxString::Format("Reading ISO: %s of %s",
+                                               wxFileName::GetHumanReadableSize(wxULongLong(position)),
+                                               wxFileName::GetHumanReadableSize(wxULongLong(total))));
+    }
+    return true;
+}
+
+void ISODetectThread::PostProgress(int percent, const wxString &status)
+{
+    wxCommandEvent event(ISO_DETECT_PROGRESS);
+    event.SetInt(percent);
+    event.SetString(status);
+    wxQueueEvent(m_handler, event.Clone());
+}
@@ -0,0 +1,51 @@
+#ifndef ISO_DETECT_THREAD_H
+#define ISO_DETECT_THREAD_H
+
+#include <wx/wx.h>
+#include <wx/thread.h>
+#include <atomic>
+#include <memory>
+#include "CustomEvents.h"
+#include "ISOInspector.h"
+#include "IsoProfileCache.h"
+
+// Carried by ISO_DETECT_COMPLETE as client data; the handler takes ownership
+struct ISODetectResult
+{
+    wxString isoPath;
+    wxString fingerprint;
+    std::shared_ptr<const IsoProfile> profile;  // Null on failure or cancel
+    wxString distribution;                      // Cached distribution, if any
+    bool fromCache = false;
+    bool cancelled = false;
+    wxString error;
+};
+
+// Inspects an ISO off the GUI thread. Posts ISO_DETECT_PROGRESS with the
+// percentage in GetInt() and a status line in GetString(), then exactly one
+// ISO_DETECT_COMPLETE. Joinable: the owner must Wait() before deleting it.
+class ISODetectThread : public wxThread
+{
+public:
+    ISODetectThread(wxEvtHandler *handler, const wxString &isoPath,
+                    const ISOInspector::Options &options, const IsoProfileCache &cache);
+
+    // Safe to call from the GUI thread at any time
+    void Cancel() { m_cancel = true; }
+
+protected:
+    virtual ExitCode Entry() override;
+
+private:
+    bool OnProgress(std::uint64_t position, std::uint64_t total);
+    void PostProgress(int percent, const wxString &status);
+
+    wxEvtHandler *m_handler;
+    wxString m_isoPath;
+    ISOInspector::Options m_options;
+    IsoProfileCache m_cache;
+    std::atomic<bool> m_cancel;
+    int m_lastPercent;
+};
+
+#endif // ISO_DETECT_THREAD_H
@@ -0,0 +1,395 @@
+#include "ISOExtractor.h"
+#include "ISOReader.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <utility>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <winioctl.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+namespace {
+
+// Output file that is sized up front and only receives the non-zero parts
+// of the data, so zero runs stay unallocated on filesystems with holes.
+class OutputFile {
+public:
+    ~OutputFile() { close(); }
+
+    bool open(const std::filesystem::path& path, std::uint64_t size) {
+    #ifdef _WIN32
+        handle = CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                             FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (handle == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        DWORD returned = 0;
+        DeviceIoControl(handle, FSCTL_SET_SPARSE, nullptr, 0, nullptr, 0, &returned, nullptr);
+        LARGE_INTEGER end;
+        end.QuadPart = static_cast<LONGLONG>(size);
+        return SetFilePointerEx(handle, end, nullptr, FILE_BEGIN) && SetEndOfFile(handle);
+    #else
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            return false;
+        }
+        return ::ftruncate(fd, static_cast<off_t>(size)) == 0;
+    #endif
+    }
+
+    bool write(std::uint64_t offset, const char* data, std::size_t size) {
+        static const char zeros[ISOExtractor::SPARSE_BLOCK] = {};
+
+        // Write the non-zero runs, leave whole zero blocks as holes
+        std::size_t run_start = 0;
+        std::size_t pos = 0;
+        while (pos < size) {
+            const std::size_t block = std::min(ISOExtractor::SPARSE_BLOCK, size - pos);
+            if (block == ISOExtractor::SPARSE_BLOCK && std::memcmp(data + pos, zeros, block) == 0) {
+                if (pos > run_start && !writeAt(offset + run_start, data + run_start, pos - run_start)) {
+                    return false;
+                }
+                run_start = pos + block;
+            }
+            pos += block;
+        }
+        return pos == run_start || writeAt(offset + run_start, data + run_start, pos - run_start);
+    }
+
+    bool close() {
+    #ifdef _WIN32
+        if (handle == INVALID_HANDLE_VALUE) {
+            return true;
+        }
+        const bool ok = CloseHandle(handle) != 0;
+        handle = INVALID_HANDLE_VALUE;
+        return ok;
+    #else
+        if (fd < 0) {
+            return true;
+        }
+        const bool ok = ::close(fd) == 0;
+        fd = -1;
+        return ok;
+    #endif
+    }
+
+private:
+    bool writeAt(std::uint64_t offset, const char* data, std::size_t size) {
+        while (size > 0) {
+        #ifdef _WIN32
+            OVERLAPPED overlapped = {};
+            overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFFu);
+            overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+            DWORD written = 0;
+            const DWORD chunk = static_cast<DWORD>(std::min<std::size_t>(size, 1u << 30));
+            if (!WriteFile(handle, data, chunk, &written, &overlapped) || written == 0) {
+                return false;
+            }
+        #else
+            const ssize_t written = ::pwrite(fd, data, size, static_cast<off_t>(offset));
+            if (written <= 0) {
+                return false;
+            }
+        #endif
+            data += written;
+            offset += static_cast<std::uint64_t>(written);
+            size -= static_cast<std::size_t>(written);
+        }
+        return true;
+    }
+
+#ifdef _WIN32
+    HANDLE handle = INVALID_HANDLE_VALUE;
+#else
+    int fd = -1;
+#endif
+};
+
+// Mapped files are written in pieces this large, so cancelling is quick
+constexpr std::size_t VIEW_CHUNK = 1024 * 1024;
+
+struct Link {
+    std::string path;
+    std::string target;
+};
+
+bool isWithin(const std::filesystem::path& root, const std::filesystem::path& path) {
+    const std::filesystem::path inside = path.lexically_relative(root);
+    return !inside.empty() && *inside.begin() != "..";
+}
+
+// Where an entry goes under root. Image paths come from Rock Ridge, Joliet
+// or libarchive names, so anything absolute or with "." or ".." components
+// is refused rather than allowed to escape root.
+bool resolveTarget(const std::filesystem::path& root, const std::string& entry, std::filesystem::path& target) {
+    const std::filesystem::path relative = std::filesystem::u8path(entry);
+    if (entry.empty() || relative.has_root_name() || relative.has_root_directory()) {
+        return false;
+    }
+    for (const auto& part : relative) {
+        if (part.empty() || part == "." || part == "..") {
+            return false;
+        }
+    }
+    target = (root / relative).lexically_normal();
+    return isWithin(root.lexically_normal(), target);
+}
+
+// Links are made once everything else is written, so no entry is ever
+// extracted through one, and only in directories that really lie under
+// root. Those the host refuses, e.g. NTFS without the symlink privilege,
+// are listed in SKIPPED_LINKS instead.
+bool createLinks(const std::filesystem::path& root, const std::vector<Link>& links, std::string& error) {
+    std::error_code ec;
+    const std::filesystem::path realRoot = std::filesystem::canonical(root, ec);
+    if (ec) {
+        error = "Failed to resolve " + root.u8string();
+        return false;
+    }
+
+    std::string skipped;
+    for (const auto& link : links) {
+        std::filesystem::path target;
+        if (!resolveTarget(root, link.path, target)) {
+            error = "Refusing to extract outside the destination: " + link.path;
+            return false;
+        }
+        std::filesystem::create_directories(target.parent_path(), ec);
+        const std::filesystem::path parent = std::filesystem::canonical(target.parent_path(), ec);
+        if (ec || (parent != realRoot && !isWithin(realRoot, parent))) {
+            error = "Refusing to extract outside the destination: " + link.path;
+            return false;
+        }
+        std::filesystem::create_symlink(std::filesystem::u8path(link.target), target, ec);
+        if (ec) {
+            skipped += std::filesystem::u8path(link.path).generic_u8string();
+            skipped += '\0';
+            skipped += link.target;
+            skipped += '\0';
+        }
+    }
+    if (skipped.empty()) {
+        return true;
+    }
+
+    std::ofstream list(root / ISOExtractor::SKIPPED_LINKS, std::ios::binary | std::ios::trunc);
+    if (!list.write(skipped.data(), static_cast<std::streamsize>(skipped.size())) || !list.flush()) {
+        error = "Failed to write the list of links the host couldn't create";
+        return false;
+    }
+    return true;
+}
+
+// Rock Ridge permissions, keeping the owner's write bit so the tree can
+// still be changed and removed on the host; xorriso -r rationalizes them
+// again when the ISO is rebuilt
+void applyModes(const std::vector<std::pair<std::filesystem::path, std::uint32_t>>& modes) {
+    for (const auto& item : modes) {
+        std::error_code ec;
+        std::filesystem::permissions(item.first, static_cast<std::filesystem::perms>(item.second | 0200), ec);
+    }
+}
+
+} // namespace
+
+const char* const ISOExtractor::SKIPPED_LINKS = ".linuxisopro-symlinks";
+
+ISOExtractor::ISOExtractor(const std::string& isoPath, Options options)
+    : iso_path(isoPath), options(std::move(options)), next_job(0), stopped(false),
+      cancelled(false), total_bytes(0), written_bytes(0) {}
+
+bool ISOExtractor::extractTo(const std::string& destination) {
+    next_job = 0;
+    stopped = false;
+    cancelled = false;
+    written_bytes = 0;
+    last_error.clear();
+
+    ISOReader reader(iso_path);
+    if (!reader.open()) {
+        last_error = reader.getLastError();
+        return false;
+    }
+
+    std::vector<const ISOReader::Entry*> excluded;
+    for (const auto& path : options.exclude) {
+        if (const ISOReader::Entry* entry = reader.findEntry(path)) {
+            excluded.push_back(entry);
+        }
+    }
+
+    // Directories first, so workers never race to create parents. Mapped
+    // files are read straight from the mapping, which any number of threads
+    // can share; the rest need the libarchive stream, which can't be shared.
+    const std::filesystem::path root = std::filesystem::u8path(destination);
+    std::vector<Job> mapped, streamed;
+    std::vector<Link> links;
+    std::vector<std::pair<std::filesystem::path, std::uint32_t>> modes;
+    total_bytes = 0;
+    try {
+        std::filesystem::create_directories(root);
+        std::filesystem::remove(root / SKIPPED_LINKS);
+        const auto& entries = reader.entries();
+        for (std::size_t i = 0; i < entries.size(); ++i) {
+            const ISOReader::Entry& entry = entries[i];
+            if (std::find(excluded.begin(), excluded.end(), &entry) != excluded.end()) {
+                continue;
+            }
+            std::filesystem::path target;
+            if (!resolveTarget(root, entry.path, target)) {
+                last_error = "Refusing to extract outside the destination: " + entry.path;
+                return false;
+            }
+            if (!entry.symlink.empty()) {
+                links.push_back({entry.path, entry.symlink});
+                continue;
+            }
+            if (entry.directory) {
+                std::filesystem::create_directories(target);
+            } else {
+                (entry.mapped ? mapped : streamed).push_back({i, entry.size});
+                total_bytes += entry.size;
+            }
+            if (entry.mode != 0) {
+                modes.emplace_back(target, entry.mode);
+            }
+        }
+    } catch (const std::filesystem::filesystem_error& e) {
+        last_error = e.what();
+        return false;
+    }
+
+    // Largest files first keeps the workers busy until the very end
+    std::sort(mapped.begin(), mapped.end(), [](const Job& a, const Job& b) { return a.size > b.size; });
+
+    // The workers share this reader, already open, so the directory tree is
+    // parsed once. Streamed files are extracted on this thread meanwhile.
+    unsigned thread_count = options.threads ? options.threads : std::thread::hardware_concurrency();
+    thread_count = static_cast<unsigned>(std::min<std::size_t>(std::max(thread_count, 1u), mapped.size()));
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count);
+    for (unsigned i = 0; i < thread_count; ++i) {
+        threads.emplace_back(&ISOExtractor::worker, this, std::ref(reader), std::cref(mapped), destination);
+    }
+    for (std::size_t i = 0; i < streamed.size() && !stopped; ++i) {
+        if (!extractFile(reader, streamed[i], destination)) {
+            break;
+        }
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (stopped) {
+        return false;
+    }
+
+    if (!createLinks(root, links, last_error)) {
+        return false;
+    }
+    applyModes(modes);
+    return true;
+}
+
+// Only ever given mapped files, so it just reads the shared mapping
+void ISOExtractor::worker(ISOReader& reader, const std::vector<Job>& jobs, const std::string& destination) {
+    for (std::size_t i = next_job++; i < jobs.size() && !stopped; i = next_job++) {
+        if (!extractFile(reader, jobs[i], destination)) {
+            return;
+        }
+    }
+}
+
+// Mapped files come straight from the mapping, which is all a worker may
+// touch of the shared reader; the others are streamed
+bool ISOExtractor::extractFile(ISOReader& reader, const Job& job, const std::string& destination) {
+    const ISOReader::Entry& entry = reader.entries()[job.entry];
+    std::filesystem::path target;
+    if (!resolveTarget(std::filesystem::u8path(destination), entry.path, target)) {
+        fail("Refusing to extract outside the destination: " + entry.path);
+        return false;
+    }
+
+    OutputFile file;
+    if (!file.open(target, entry.size)) {
+        fail("Failed to create " + target.u8string());
+        return false;
+    }
+
+    std::uint64_t offset = 0;
+    bool write_failed = false;
+    auto write = [&](const char* data, std::size_t size) {
+        if (stopped) {
+            return false;
+        }
+        if (!file.write(offset, data, size)) {
+            write_failed = true;
+            return false;
+        }
+        offset += size;
+        return addProgress(size);
+    };
+
+    bool ok;
+    std::string error;
+    if (entry.mapped) {
+        const ByteSpan data = reader.view(entry);
+        ok = data.size() == entry.size;
+        if (!ok) {
+            error = "Failed to read " + entry.path;
+        }
+        const char* bytes = reinterpret_cast<const char*>(data.data());
+        for (std::size_t done = 0; ok && done < data.size(); done += VIEW_CHUNK) {
+            ok = write(bytes + done, std::min(VIEW_CHUNK, data.size() - done));
+        }
+    } else {
+        ok = reader.extractTo(entry.path, write);
+        if (!ok) {
+            error = reader.getLastError();
+        }
+    }
+
+    if (!file.close() || write_failed) {
+        fail("Failed to write " + target.u8string());
+        return false;
+    }
+    if (!ok) {
+        if (!stopped) {
+            fail(error);
+        }
+        return false;
+    }
+    return true;
+}
+
+void ISOExtractor::fail(const std::string& message) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!stopped.exchange(true)) {
+        last_error = message;
+    }
+}
+
+bool ISOExtractor::addProgress(std::uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    written_bytes += bytes;
+    if (options.progress && !options.progress(written_bytes, total_bytes)) {
+        if (!stopped.exchange(true)) {
+            cancelled = true;
+            last_error = "Extraction cancelled";
+        }
+        return false;
+    }
+    return true;
+}
+
+std::string ISOExtractor::getLastError() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return last_error;
+}
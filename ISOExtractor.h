@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class ISOReader;
+
+// Writes the tree of an ISO to a host directory with several threads
+// sharing one reader. The container then gets the tree through a bind mount instead of
+// loop-mounting the image and copying it serially. Symlinks and Rock Ridge
+// permissions are kept; links the host can't create are listed in
+// SKIPPED_LINKS for the container to make.
+class ISOExtractor {
+public:
+    struct Options {
+        unsigned threads = 0;               // 0 = one per hardware thread
+        std::vector<std::string> exclude;   // Entries left out, e.g. the selected squashfs
+
+        // Bytes written so far; return false to cancel. Called from the
+        // worker threads, one call at a time.
+        std::function<bool(std::uint64_t written, std::uint64_t total)> progress;
+    };
+
+    ISOExtractor(const std::string& isoPath, Options options);
+
+    bool extractTo(const std::string& destination);
+
+    std::string getLastError() const;
+    bool wasCancelled() const { return cancelled; }
+
+    // Runs of zero bytes this long or longer become holes in the output
+    static constexpr std::size_t SPARSE_BLOCK = 4096;
+
+    // In the destination: pairs of '/' separated link path and target, each
+    // NUL terminated
+    static const char* const SKIPPED_LINKS;
+
+private:
+    struct Job {
+        std::size_t entry;    // In the reader's entries()
+        std::uint64_t size;
+    };
+
+    void worker(ISOReader& reader, const std::vector<Job>& jobs, const std::string& destination);
+    bool extractFile(ISOReader& reader, const Job& job, const std::string& destination);
+    void fail(const std::string& message);
+    bool addProgress(std::uint64_t bytes);
+
+    std::string iso_path;
+    Options options;
+
+    std::atomic<std::size_t> next_job;
+    std::atomic<bool> stopped;
+    bool cancelled;
+    std::uint64_t total_bytes;
+    std::uint64_t written_bytes;
+    mutable std::mutex mutex;  // Guards last_error, cancelled, written_bytes and progress calls
+    std::string last_error;
+};
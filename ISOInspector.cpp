@@ -0,0 +1,171 @@
+#include "ISOInspector.h"
+#include "ISOReader.h"
+#include <algorithm>
+#include <set>
+#include <unordered_map>
+
+namespace {
+
+std::string toLower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), ::tolower);
+    return text;
+}
+
+std::string extensionOf(const std::string& lowerPath) {
+    size_t slash = lowerPath.find_last_of("/\\");
+    size_t dot = lowerPath.rfind('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return "";
+    }
+    return lowerPath.substr(dot + 1);
+}
+
+std::uint16_t le16(const unsigned char* p) {
+    return static_cast<std::uint16_t>(p[0] | (p[1] << 8));
+}
+
+std::uint32_t le32(const unsigned char* p) {
+    return static_cast<std::uint32_t>(p[0]) | (static_cast<std::uint32_t>(p[1]) << 8) |
+           (static_cast<std::uint32_t>(p[2]) << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+}
+
+} // namespace
+
+ISOInspector::ISOInspector(Options options)
+    : m_options(std::move(options)), m_cancelled(false) {}
+
+std::shared_ptr<const IsoProfile> ISOInspector::inspect(const std::string& isoPath) {
+    m_cancelled = false;
+    ISOReader reader(isoPath);
+    reader.setProgressCallback(m_options.progress);
+    if (!reader.open()) {
+        m_lastError = reader.getLastError();
+        m_cancelled = reader.wasCancelled();
+        return nullptr;
+    }
+
+    std::shared_ptr<IsoProfile> profile(new IsoProfile());
+    profile->m_isoPath = isoPath;
+    profile->m_volumeId = reader.volumeId();
+
+    // Single pass over the index: classify every entry by name
+    std::vector<const ISOReader::Entry*> grubEnvMatches;
+    const ISOReader::Entry* releaseMatch = nullptr;
+    profile->m_files.reserve(reader.entries().size());
+    for (const auto& entry : reader.entries()) {
+        profile->m_files.push_back({entry.path, entry.size, entry.lba, entry.directory});
+        if (entry.directory) {
+            continue;
+        }
+        ++profile->m_fileCount;
+
+        std::string lowerPath = toLower(entry.path);
+        std::string extension = extensionOf(lowerPath);
+        if (extension == "squashfs" || extension == "sfs" || extension == "img" || extension == "cramfs") {
+            profile->m_filesystems.push_back({entry.path, entry.size});
+        }
+
+        if (entry.size > MAX_TEXT_FILE_SIZE) {
+            continue;
+        }
+        if (lowerPath.find("grubenv") != std::string::npos) {
+            grubEnvMatches.push_back(&entry);
+        }
+        if (!releaseMatch && (lowerPath.find("release") != std::string::npos ||
+                              lowerPath.find("version") != std::string::npos)) {
+            releaseMatch = &entry;
+        }
+    }
+
+    // Read configured paths first so their priority order is preserved
+    std::set<const ISOReader::Entry*> seen;
+    auto readText = [&](const ISOReader::Entry* entry, std::vector<IsoProfile::TextFile>& out) {
+        if (!entry || entry->directory || entry->size > MAX_TEXT_FILE_SIZE || !seen.insert(entry).second) {
+            return;
+        }
+        std::vector<char> content;
+        if (reader.readFile(entry->path, content)) {
+            out.push_back({entry->path, std::string(content.begin(), content.end())});
+        }
+    };
+
+    for (const auto& path : m_options.grubenvPaths) {
+        readText(reader.findEntry(path), profile->m_grubEnvFiles);
+    }
+    for (const auto* entry : grubEnvMatches) {
+        readText(entry, profile->m_grubEnvFiles);
+    }
+    for (const auto& path : m_options.releasePaths) {
+        readText(reader.findEntry(path), profile->m_releaseFiles);
+    }
+    readText(releaseMatch, profile->m_releaseFiles);
+
+    readBootCatalog(reader, *profile);
+
+    // A cancelled read leaves the profile incomplete, so it must not be used
+    if (reader.wasCancelled()) {
+        m_lastError = reader.getLastError();
+        m_cancelled = true;
+        return nullptr;
+    }
+    return profile;
+}
+
+// Decodes the El Torito catalog: a validation entry, the default entry and
+// optional section headers, each 32 bytes long.
+void ISOInspector::readBootCatalog(ISOReader& reader, IsoProfile& profile) {
+    std::vector<char> raw;
+    if (!reader.readBootCatalog(raw) || raw.size() < 64) {
+        return;
+    }
+    const unsigned char* catalog = reinterpret_cast<const unsigned char*>(raw.data());
+    if (catalog[0] != 0x01 || catalog[30] != 0x55 || catalog[31] != 0xAA) {
+        return;
+    }
+
+    std::unordered_map<std::int64_t, std::string> pathsByLba;
+    for (const auto& entry : reader.entries()) {
+        if (!entry.directory && entry.lba >= 0) {
+            pathsByLba.emplace(entry.lba, entry.path);
+        }
+    }
+
+    auto addEntry = [&](const unsigned char* p, std::uint8_t platform) {
+        IsoProfile::BootEntry boot;
+        boot.platform = platform;
+        boot.bootable = p[0] == 0x88;
+        boot.mediaType = p[1] & 0x0F;
+        boot.sectorCount = le16(p + 6);
+        boot.loadLba = le32(p + 8);
+        auto it = pathsByLba.find(boot.loadLba);
+        if (it != pathsByLba.end()) {
+            boot.path = it->second;
+        }
+        profile.m_bootCatalog.push_back(boot);
+    };
+
+    addEntry(catalog + 32, catalog[1]);
+
+    for (size_t offset = 64; offset + 32 <= raw.size();) {
+        const unsigned char* header = catalog + offset;
+        if (header[0] != 0x90 && header[0] != 0x91) {
+            break;
+        }
+        const std::uint8_t platform = header[1];
+        const std::uint16_t count = le16(header + 2);
+        offset += 32;
+        for (std::uint16_t i = 0; i < count && offset + 32 <= raw.size();) {
+            const unsigned char* p = catalog + offset;
+            offset += 32;
+            // Extension entries (0x44) continue the previous entry
+            if (p[0] == 0x44) {
+                continue;
+            }
+            addEntry(p, platform);
+            ++i;
+        }
+        if (header[0] == 0x91) {
+            break;
+        }
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+class ISOReader;
+
+// Everything MainFrame needs to know about an image, collected in one visit.
+// Instances are immutable once ISOInspector hands them out.
+class IsoProfile {
+public:
+    struct Filesystem {
+        std::string path;
+        std::uint64_t size;
+    };
+
+    // Directory index entry, kept so a cached profile can answer lookups
+    struct File {
+        std::string path;
+        std::uint64_t size;
+        std::int64_t lba;
+        bool directory;
+    };
+
+    struct TextFile {
+        std::string path;
+        std::string content;
+    };
+
+    // One El Torito boot catalog entry
+    struct BootEntry {
+        std::uint8_t platform;      // 0 = x86 BIOS, 0xEF = UEFI
+        bool bootable;
+        std::uint8_t mediaType;     // 0 = no emulation
+        std::uint32_t loadLba;
+        std::uint16_t sectorCount;
+        std::string path;           // Boot image path, empty if not resolvable
+    };
+
+    const std::string& isoPath() const { return m_isoPath; }
+    const std::string& volumeId() const { return m_volumeId; }
+    std::uint64_t fileCount() const { return m_fileCount; }
+
+    // squashfs/sfs/img/cramfs files, in image order
+    const std::vector<Filesystem>& filesystems() const { return m_filesystems; }
+    // grubenv files: configured paths first, then any other match
+    const std::vector<TextFile>& grubEnvFiles() const { return m_grubEnvFiles; }
+    // Release files: configured paths first, then the first name match
+    const std::vector<TextFile>& releaseFiles() const { return m_releaseFiles; }
+    const std::vector<BootEntry>& bootCatalog() const { return m_bootCatalog; }
+    const std::vector<File>& files() const { return m_files; }
+
+private:
+    friend class ISOInspector;
+    friend class IsoProfileCache;
+    IsoProfile() : m_fileCount(0) {}
+
+    std::string m_isoPath;
+    std::string m_volumeId;
+    std::uint64_t m_fileCount;
+    std::vector<Filesystem> m_filesystems;
+    std::vector<TextFile> m_grubEnvFiles;
+    std::vector<TextFile> m_releaseFiles;
+    std::vector<BootEntry> m_bootCatalog;
+    std::vector<File> m_files;
+};
+
+// Opens an image once and builds its IsoProfile in a single pass over the
+// directory index, replacing the per-probe scans MainFrame used to do.
+class ISOInspector {
+public:
+    struct Options {
+        std::vector<std::string> grubenvPaths;  // From config.yaml grubenv_paths
+        std::vector<std::string> releasePaths;  // From config.yaml release_paths
+
+        // Byte offset into the image; return false to cancel. Runs on the
+        // thread calling inspect().
+        std::function<bool(std::uint64_t position, std::uint64_t total)> progress;
+    };
+
+    explicit ISOInspector(Options options);
+
+    std::shared_ptr<const IsoProfile> inspect(const std::string& isoPath);
+    std::string getLastError() const { return m_lastError; }
+    bool wasCancelled() const { return m_cancelled; }
+
+    // Text files larger than this are never identification files
+    static constexpr std::uint64_t MAX_TEXT_FILE_SIZE = 64 * 1024;
+
+private:
+    void readBootCatalog(ISOReader& reader, IsoProfile& profile);
+
+    Options m_options;
+    std::string m_lastError;
+    bool m_cancelled;
+};
@@ -2,6 +2,7 @@
 #include <archive.h>
 #include <archive_entry.h>
 #include <algorithm>
+#include <filesystem>
 #include <stdexcept>
 
 #ifdef _WIN32
@@ -19,7 +20,8 @@
 #endif
 
 ISOReader::ISOReader(const std::string& path)
-    : iso_path(normalizePath(path)), archive(nullptr) {}
+    : iso_path(normalizePath(path)), archive(nullptr), next_ordinal(0), image_size(0), cancelled(false),
+      buffer_pool(&BufferPool::shared()) {}
 
 ISOReader::~ISOReader() {
     close();
@@ -27,24 +29,95 @@ ISOReader::~ISOReader() {
 
 ISOReader::ISOReader(ISOReader&& other) noexcept
     : iso_path(std::move(other.iso_path))
+    , image(std::move(other.image))
     , archive(other.archive)
-    , last_error(std::move(other.last_error)) {
+    , last_error(std::move(other.last_error))
+    , index(std::move(other.index))
+    , lookup(std::move(other.lookup))
+    , next_ordinal(other.next_ordinal)
+    , progress(std::move(other.progress))
+    , image_size(other.image_size)
+    , cancelled(other.cancelled)
+    , buffer_pool(other.buffer_pool) {
     other.archive = nullptr;
+    other.next_ordinal = 0;
 }
 
 ISOReader& ISOReader::operator=(ISOReader&& other) noexcept {
     if (this != &other) {
         close();
         iso_path = std::move(other.iso_path);
+        image = std::move(other.image);
         archive = other.archive;
         last_error = std::move(other.last_error);
+        index = std::move(other.index);
+        lookup = std::move(other.lookup);
+        next_ordinal = other.next_ordinal;
+        progress = std::move(other.progress);
+        image_size = other.image_size;
+        cancelled = other.cancelled;
+        buffer_pool = other.buffer_pool;
         other.archive = nullptr;
+        other.next_ordinal = 0;
     }
     return *this;
 }
 
 bool ISOReader::open() {
     close();
+    cancelled = false;
+
+    std::error_code ec;
+    image_size = std::filesystem::file_size(std::filesystem::u8path(iso_path), ec);
+    if (ec) {
+        image_size = 0;
+    }
+
+    // Prefer the memory-mapped parser; fall back to libarchive for images
+    // it doesn't understand (UDF-only, damaged descriptors, ...)
+    image = std::make_unique<ISO9660Image>(iso_path);
+    if (image->open() && buildNativeIndex()) {
+        // Everything the index needs came from a few mapped sectors
+        reportProgress(image_size);
+        return true;
+    }
+    image.reset();
+    index.clear();
+    lookup.clear();
+
+    if (!openArchive()) {
+        return false;
+    }
+    if (!buildIndex()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+// Forwards the stream position to the callback. Once cancelled, every
+// further call fails so the operation unwinds without more I/O.
+bool ISOReader::reportProgress(std::uint64_t position) {
+    if (cancelled) {
+        return false;
+    }
+    if (progress && !progress(std::min(position, image_size), image_size)) {
+        cancelled = true;
+        last_error = "Operation cancelled";
+        return false;
+    }
+    return true;
+}
+
+void ISOReader::close() {
+    closeArchive();
+    image.reset();
+    index.clear();
+    lookup.clear();
+}
+
+bool ISOReader::openArchive() {
+    closeArchive();
     archive = archive_read_new();
     if (!archive) {
         last_error = "Failed to create archive struct";
@@ -63,93 +136,345 @@ bool ISOReader::open() {
 
     if (r != ARCHIVE_OK) {
         last_error = archive_error_string(archive);
-        close();
+        closeArchive();
         return false;
     }
+    next_ordinal = 0;
     return true;
 }
 
-void ISOReader::close() {
+void ISOReader::closeArchive() {
     if (archive) {
         archive_read_close(archive);
         archive_read_free(archive);
         archive = nullptr;
     }
+    next_ordinal = 0;
 }
 
-std::vector<std::string> ISOReader::listFiles() {
-    std::vector<std::string> files;
-    if (!archive) {
-        last_error = "Archive not opened";
-        return files;
-    }
+// Walks every header once and records where each entry lives, so later
+// lookups never have to rescan the image to find out a path is missing.
+bool ISOReader::buildIndex() {
+    index.clear();
+    lookup.clear();
 
     struct archive_entry* entry;
-    while (archive_read_next_header(archive, &entry) == ARCHIVE_OK) {
+    int r;
+    while ((r = archive_read_next_header(archive, &entry)) == ARCHIVE_OK) {
         #ifdef _WIN32
             std::string pathname = wideToString(archive_entry_pathname_w(entry));
         #else
             std::string pathname = archive_entry_pathname(entry);
         #endif
-        files.push_back(normalizePath(pathname));
+
+        Entry item;
+        item.path = normalizePath(pathname);
+        item.size = archive_entry_size_is_set(entry)
+            ? static_cast<std::uint64_t>(archive_entry_size(entry)) : 0;
+        item.lba = -1;
+        item.ordinal = next_ordinal++;
+        item.directory = archive_entry_filetype(entry) == AE_IFDIR;
+        item.mapped = false;
+        if (archive_entry_filetype(entry) == AE_IFLNK) {
+            #ifdef _WIN32
+                item.symlink = wideToString(archive_entry_symlink_w(entry));
+            #else
+                const char* target = archive_entry_symlink(entry);
+                item.symlink = target ? target : "";
+            #endif
+        }
+        item.mode = static_cast<std::uint32_t>(archive_entry_perm(entry));
+
+        lookup.emplace(indexKey(item.path), index.size());
+        index.push_back(std::move(item));
         archive_read_data_skip(archive);
+
+        if (!reportProgress(static_cast<std::uint64_t>(archive_filter_bytes(archive, -1)))) {
+            return false;
+        }
     }
 
-    // Reset archive position
-    close();
-    open();
-    return files;
+    if (r != ARCHIVE_EOF) {
+        last_error = archive_error_string(archive) ? archive_error_string(archive)
+                                                   : "Failed to index archive";
+        return false;
+    }
+    return true;
 }
 
-bool ISOReader::readFile(const std::string& filename, std::vector<char>& content) {
-    if (!archive) {
-        last_error = "Archive not opened";
+bool ISOReader::buildNativeIndex() {
+    const auto& files = image->files();
+    if (files.empty()) {
         return false;
     }
 
+    index.reserve(files.size());
+    for (const auto& file : files) {
+        Entry item;
+        item.path = normalizePath(file.path);
+        item.size = file.size;
+        item.lba = file.lba;
+        item.ordinal = npos;
+        item.directory = file.directory;
+        item.mapped = !file.directory && file.contiguous && file.symlink.empty();
+        item.symlink = file.symlink;
+        item.mode = file.mode;
+
+        lookup.emplace(indexKey(item.path), index.size());
+        index.push_back(std::move(item));
+    }
+    return true;
+}
+
+// Positions the stream on the given entry. Entries are visited in stream
+// order, so moving forward costs a header walk up to the target and only a
+// backwards jump needs the archive to be reopened.
+bool ISOReader::seekToEntry(const Entry& target) {
+    if (!archive || target.ordinal == npos || target.ordinal < next_ordinal) {
+        if (!openArchive()) {
+            return false;
+        }
+    }
+
+    // Entries indexed by the native parser have no stream position, so
+    // those are matched by name instead
+    const std::string key = indexKey(target.path);
     struct archive_entry* entry;
-    std::string normalized_filename = normalizePath(filename);
-    
     while (archive_read_next_header(archive, &entry) == ARCHIVE_OK) {
-        std::string current_file;
-        #ifdef _WIN32
-            current_file = wideToString(archive_entry_pathname_w(entry));
-        #else
-            current_file = archive_entry_pathname(entry);
-        #endif
-        current_file = normalizePath(current_file);
-
-        if (normalized_filename == current_file) {
-            const size_t size = static_cast<size_t>(archive_entry_size(entry));
-            content.resize(size);
-            
-            const ssize_t read_size = archive_read_data(archive, content.data(), size);
-            
-            // Reset archive position
-            close();
-            open();
-            
-            if (read_size < 0 || static_cast<size_t>(read_size) != size) {
-                last_error = "Failed to read complete file";
-                return false;
+        const std::size_t ordinal = next_ordinal++;
+        if (target.ordinal == npos) {
+            #ifdef _WIN32
+                std::string pathname = wideToString(archive_entry_pathname_w(entry));
+            #else
+                std::string pathname = archive_entry_pathname(entry);
+            #endif
+            if (indexKey(normalizePath(pathname)) == key) {
+                return true;
             }
+        } else if (ordinal == target.ordinal) {
             return true;
         }
         archive_read_data_skip(archive);
+
+        if (!reportProgress(static_cast<std::uint64_t>(archive_filter_bytes(archive, -1)))) {
+            closeArchive();
+            return false;
+        }
     }
 
-    last_error = "File not found in archive";
-    // Reset archive position
-    close();
-    open();
+    last_error = "Archive changed since it was indexed";
+    closeArchive();
+    return false;
+}
+
+std::vector<std::string> ISOReader::listFiles() {
+    std::vector<std::string> files;
+    if (!archive && index.empty()) {
+        last_error = "Archive not opened";
+        return files;
+    }
+
+    files.reserve(index.size());
+    for (const auto& item : index) {
+        files.push_back(item.path);
+    }
+    return files;
+}
+
+bool ISOReader::contains(const std::string& filename) const {
+    return findEntry(filename) != nullptr;
+}
+
+const ISOReader::Entry* ISOReader::findEntry(const std::string& filename) const {
+    auto it = lookup.find(indexKey(normalizePath(filename)));
+    return it == lookup.end() ? nullptr : &index[it->second];
+}
+
+bool ISOReader::readFile(const std::string& filename, std::vector<char>& content) {
+    content.clear();
+    const Entry* item = findEntry(filename);
+    if (item) {
+        content.reserve(static_cast<size_t>(item->size));
+    }
+    return extractTo(filename, [&content](const char* data, std::size_t size) {
+        content.insert(content.end(), data, data + size);
+        return true;
+    });
+}
+
+bool ISOReader::extractTo(const std::string& filename, const Sink& sink) {
+    const Entry* item = lookupForRead(filename);
+    return item && streamEntry(*item, 0, item->size, sink);
+}
+
+bool ISOReader::readRange(const std::string& filename, std::uint64_t offset, std::size_t length,
+                          std::vector<char>& content) {
+    content.clear();
+    const Entry* item = lookupForRead(filename);
+    if (!item) {
+        return false;
+    }
+    if (offset >= item->size) {
+        return true;
+    }
+    content.reserve(static_cast<size_t>(std::min<std::uint64_t>(length, item->size - offset)));
+    return streamEntry(*item, offset, length, [&content](const char* data, std::size_t size) {
+        content.insert(content.end(), data, data + size);
+        return true;
+    });
+}
+
+const ISOReader::Entry* ISOReader::lookupForRead(const std::string& filename) {
+    if (!archive && index.empty()) {
+        last_error = "Archive not opened";
+        return nullptr;
+    }
+    if (cancelled) {
+        return nullptr;
+    }
+
+    const Entry* item = findEntry(filename);
+    if (!item) {
+        last_error = "File not found in archive";
+    }
+    return item;
+}
+
+// Feeds [offset, offset + length) of the entry to the sink. Mapped entries
+// are handed out straight from the mapping; everything else goes through
+// one pooled buffer, so memory use doesn't depend on the file size.
+bool ISOReader::streamEntry(const Entry& item, std::uint64_t offset, std::uint64_t length, const Sink& sink) {
+    offset = std::min(offset, item.size);
+    length = std::min(length, item.size - offset);
+    const std::size_t chunk_size = buffer_pool->bufferSize();
+
+    if (item.mapped) {
+        ByteSpan data = view(item.path);
+        if (data.size() == item.size) {
+            const std::uint64_t base = static_cast<std::uint64_t>(item.lba) * ISO9660Image::SECTOR_SIZE;
+            for (std::uint64_t done = 0; done < length;) {
+                ByteSpan chunk = data.subspan(static_cast<size_t>(offset + done),
+                                              static_cast<size_t>(std::min<std::uint64_t>(chunk_size, length - done)));
+                if (!sink(reinterpret_cast<const char*>(chunk.data()), chunk.size())) {
+                    last_error = "Extraction stopped by the caller";
+                    return false;
+                }
+                done += chunk.size();
+                if (!reportProgress(base + offset + done)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+
+    if (!seekToEntry(item)) {
+        return false;
+    }
+
+    // libarchive can't seek inside an ISO entry, so the bytes before the
+    // range are read and dropped
+    BufferPool::Lease buffer = buffer_pool->acquire();
+    const std::uint64_t end = offset + length;
+    std::uint64_t position = 0;
+    while (position < end) {
+        const ssize_t read_size = archive_read_data(archive, buffer.data(),
+                                                    static_cast<size_t>(std::min<std::uint64_t>(buffer.size(), end - position)));
+        if (read_size <= 0) {
+            break;
+        }
+
+        const std::uint64_t chunk_end = position + static_cast<std::uint64_t>(read_size);
+        if (chunk_end > offset) {
+            const std::uint64_t skip = offset > position ? offset - position : 0;
+            if (!sink(buffer.data() + skip, static_cast<size_t>(read_size - skip))) {
+                last_error = "Extraction stopped by the caller";
+                return false;
+            }
+        }
+        position = chunk_end;
+
+        if (!reportProgress(static_cast<std::uint64_t>(archive_filter_bytes(archive, -1)))) {
+            break;
+        }
+    }
+
+    if (position != end) {
+        if (!cancelled) {
+            last_error = "Failed to read complete file";
+        }
+        // Stream position is unknown after a short read
+        closeArchive();
+        return false;
+    }
+    return true;
+}
+
+ByteSpan ISOReader::view(const std::string& filename) {
+    const Entry* item = findEntry(filename);
+    if (!item) {
+        last_error = "File not found in archive";
+        return ByteSpan();
+    }
+    if (!image || !item->mapped) {
+        last_error = "File is not available as a mapped view";
+        return ByteSpan();
+    }
+    return view(*item);
+}
+
+ByteSpan ISOReader::view(const Entry& entry) const {
+    if (!image || !entry.mapped) {
+        return ByteSpan();
+    }
+
+    ISO9660Image::File file;
+    file.path = entry.path;
+    file.size = entry.size;
+    file.lba = static_cast<std::uint32_t>(entry.lba);
+    file.directory = false;
+    file.contiguous = true;
+    file.mode = entry.mode;
+    return image->extent(file);
+}
+
+bool ISOReader::readBootCatalog(std::vector<char>& content) {
+    if (image) {
+        if (image->bootCatalogLba() == 0) {
+            last_error = "Image has no El Torito boot record";
+            return false;
+        }
+        ByteSpan sector = image->sectors(image->bootCatalogLba(), 1);
+        if (sector.empty()) {
+            last_error = "Boot catalog lies outside the image";
+            return false;
+        }
+        content.assign(reinterpret_cast<const char*>(sector.data()),
+                       reinterpret_cast<const char*>(sector.data()) + sector.size());
+        return true;
+    }
+
+    // libarchive exposes the catalog as a regular file
+    for (const auto& item : index) {
+        std::string name = item.path.substr(item.path.find_last_of(PATH_SEPARATOR[0]) + 1);
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        if (!item.directory && (name == "boot.cat" || name == "boot.catalog")) {
+            return readFile(item.path, content);
+        }
+    }
+    last_error = "Image has no El Torito boot catalog";
     return false;
 }
 
+std::string ISOReader::volumeId() const {
+    return image ? image->volumeId() : std::string();
+}
+
 std::string ISOReader::getLastError() const {
     return last_error;
 }
 
-std::string ISOReader::normalizePath(const std::string& path) const {
+std::string ISOReader::normalizePath(const std::string& path) {
     std::string normalized = path;
     #ifdef _WIN32
         std::replace(normalized.begin(), normalized.end(), '/', '\\');
@@ -159,6 +484,27 @@ std::string ISOReader::normalizePath(const std::string& path) const {
     return normalized;
 }
 
+// Lookup key: normalized path without leading "./" or separators, so
+// "/etc/os-release", "./etc/os-release" and "etc/os-release" all match.
+std::string ISOReader::indexKey(const std::string& path) const {
+    const char sep = PATH_SEPARATOR[0];
+    size_t start = 0;
+    while (start < path.size()) {
+        if (path[start] == sep) {
+            ++start;
+        } else if (path[start] == '.' && start + 1 < path.size() && path[start + 1] == sep) {
+            start += 2;
+        } else {
+            break;
+        }
+    }
+    size_t end = path.size();
+    while (end > start && path[end - 1] == sep) {
+        --end;
+    }
+    return path.substr(start, end - start);
+}
+
 #ifdef _WIN32
 std::string ISOReader::wideToString(const wchar_t* wide) const {
     if (!wide) return "";
@@ -3,12 +3,39 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include "BufferPool.h"
+#include "ISO9660Image.h"
 
 // Forward declaration to avoid including archive.h in header
 struct archive;
 
 class ISOReader {
 public:
+    // One entry of the directory index built by open()
+    struct Entry {
+        std::string path;      // Normalized path as returned by listFiles()
+        std::uint64_t size;    // File size in bytes
+        std::int64_t lba;      // Extent LBA, -1 when the backend can't tell
+        std::size_t ordinal;   // Header position in the libarchive stream, npos if unknown
+        bool directory;
+        bool mapped;           // Data is available as a zero-copy view
+        std::string symlink;   // Link target, empty unless the entry is a symlink
+        std::uint32_t mode;    // Permission bits, 0 when the image doesn't record them
+    };
+
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    // Called with the current byte offset into the image while the stream is
+    // walked. Returning false cancels the operation in progress.
+    using ProgressCallback = std::function<bool(std::uint64_t position, std::uint64_t total)>;
+
+    // Receives file data in order, one buffer-sized chunk per call.
+    // Returning false stops the extraction.
+    using Sink = std::function<bool(const char* data, std::size_t size)>;
+
     explicit ISOReader(const std::string& path);
     ~ISOReader();
 
@@ -25,12 +52,50 @@ public:
     void close();
     std::vector<std::string> listFiles();
     bool readFile(const std::string& filename, std::vector<char>& content);
+
+    // Streaming reads in bounded memory. readRange returns fewer bytes when
+    // the range runs past the end of the file.
+    bool extractTo(const std::string& filename, const Sink& sink);
+    bool readRange(const std::string& filename, std::uint64_t offset, std::size_t length,
+                   std::vector<char>& content);
+    void setBufferPool(BufferPool& pool) { buffer_pool = &pool; }
+
+    // Index lookups, served without touching the image
+    bool contains(const std::string& filename) const;
+    const Entry* findEntry(const std::string& filename) const;
+    const std::vector<Entry>& entries() const { return index; }
+
+    // Zero-copy view of a file; empty when the native parser can't serve it
+    ByteSpan view(const std::string& filename);
+    // Same for an entry of the index. Only reads the mapping, so several
+    // threads may call it on one reader at once.
+    ByteSpan view(const Entry& entry) const;
+    bool isNative() const { return image != nullptr; }
+
+    // El Torito boot catalog sector, if the image has one
+    bool readBootCatalog(std::vector<char>& content);
+    std::string volumeId() const;
+
+    void setProgressCallback(ProgressCallback callback) { progress = std::move(callback); }
+    bool wasCancelled() const { return cancelled; }
     
     // Get error message if operation fails
     std::string getLastError() const;
 
+    // Converts separators to the host convention used by the index
+    static std::string normalizePath(const std::string& path);
+
 private:
-    std::string normalizePath(const std::string& path) const;
+    std::string indexKey(const std::string& path) const;
+
+    bool openArchive();
+    void closeArchive();
+    bool buildIndex();
+    bool buildNativeIndex();
+    bool seekToEntry(const Entry& entry);
+    bool reportProgress(std::uint64_t position);
+    const Entry* lookupForRead(const std::string& filename);
+    bool streamEntry(const Entry& item, std::uint64_t offset, std::uint64_t length, const Sink& sink);
     
     #ifdef _WIN32
     std::string wideToString(const wchar_t* wide) const;
@@ -38,6 +103,17 @@ private:
     #endif
 
     std::string iso_path;
+    std::unique_ptr<ISO9660Image> image;  // Native backend, null when libarchive is used
     struct archive* archive;
     std::string last_error;
+
+    // Directory index, built once per open()
+    std::vector<Entry> index;
+    std::unordered_map<std::string, std::size_t> lookup;
+    std::size_t next_ordinal;  // Ordinal of the header the stream returns next
+
+    ProgressCallback progress;
+    std::uint64_t image_size;
+    bool cancelled;
+    BufferPool* buffer_pool;  // Not owned
 };
\ No newline at end of file
@@ -0,0 +1,299 @@
+#include "IsoProfileCache.h"
+#include <wx/dir.h>
+#include <wx/file.h>
+#include <wx/filename.h>
+#include <wx/log.h>
+#include <wx/stdpaths.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const wxFileOffset SECTOR_SIZE = 2048;
+const int FIRST_DESCRIPTOR = 16;
+const int MAX_DESCRIPTORS = 64;
+
+// FNV-1a, 64 bit
+const unsigned long long FNV_OFFSET = 1469598103934665603ULL;
+const unsigned long long FNV_PRIME = 1099511628211ULL;
+
+unsigned long long HashBytes(unsigned long long hash, const void* data, size_t length) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+rapidjson::Value MakeString(const std::string& text, rapidjson::Document::AllocatorType& allocator) {
+    return rapidjson::Value(text.data(), static_cast<rapidjson::SizeType>(text.size()), allocator);
+}
+
+std::string GetString(const rapidjson::Value& value) {
+    return value.IsString() ? std::string(value.GetString(), value.GetStringLength()) : std::string();
+}
+
+} // namespace
+
+IsoProfileCache::IsoProfileCache() : m_configHash(FNV_OFFSET) {
+    m_cacheDir = wxStandardPaths::Get().GetUserDataDir() + wxFileName::GetPathSeparator() + "iso_cache";
+}
+
+void IsoProfileCache::SetConfig(const std::string& config) {
+    m_configHash = HashBytes(FNV_OFFSET, config.data(), config.size());
+}
+
+// Hashes the volume descriptor set (sectors 16 up to the terminator) together
+// with size, mtime and the settings. That is a few KB of I/O regardless of
+// the image size.
+wxString IsoProfileCache::Fingerprint(const wxString& isoPath) const {
+    wxFileName fileName(isoPath);
+    if (!fileName.FileExists()) return "";
+
+    wxFile file(isoPath);
+    if (!file.IsOpened()) return "";
+
+    unsigned long long hash = FNV_OFFSET;
+    std::vector<char> sector(SECTOR_SIZE);
+    for (int i = 0; i < MAX_DESCRIPTORS; ++i) {
+        if (file.Seek((FIRST_DESCRIPTOR + i) * SECTOR_SIZE) == wxInvalidOffset) break;
+        if (file.Read(sector.data(), SECTOR_SIZE) != SECTOR_SIZE) break;
+
+        hash = HashBytes(hash, sector.data(), sector.size());
+        if (static_cast<unsigned char>(sector[0]) == 255 || std::memcmp(sector.data() + 1, "CD001", 5) != 0) {
+            break;
+        }
+    }
+
+    unsigned long long size = fileName.GetSize().GetValue();
+    long long mtime = fileName.GetModificationTime().GetValue().GetValue();
+    hash = HashBytes(hash, &size, sizeof(size));
+    hash = HashBytes(hash, &mtime, sizeof(mtime));
+    hash = HashBytes(hash, &m_configHash, sizeof(m_configHash));
+
+    return wxString::Format("%016llx", hash);
+}
+
+bool IsoProfileCache::Load(const wxString& fingerprint, const wxString& isoPath, Entry& entry) const {
+    if (fingerprint.IsEmpty()) return false;
+
+    wxString path = GetEntryPath(fingerprint);
+    if (!wxFileExists(path)) return false;
+
+    wxFile file(path);
+    if (!file.IsOpened()) return false;
+
+    std::vector<char> json(static_cast<size_t>(file.Length()) + 1, '\0');
+    if (file.Read(json.data(), json.size() - 1) != static_cast<ssize_t>(json.size() - 1)) return false;
+
+    rapidjson::Document doc;
+    doc.Parse(json.data());
+    if (doc.HasParseError() || !doc.IsObject()) {
+        wxLogDebug("Discarding unreadable ISO cache entry: %s", path);
+        wxRemoveFile(path);
+        return false;
+    }
+    if (!doc.HasMember("version") || !doc["version"].IsInt() || doc["version"].GetInt() != CACHE_VERSION ||
+        !doc.HasMember("fingerprint") || wxString::FromUTF8(GetString(doc["fingerprint"]).c_str()) != fingerprint) {
+        wxRemoveFile(path);
+        return false;
+    }
+
+    if (!JsonToProfile(doc, isoPath, entry)) return false;
+
+    // Keep recently used entries from being pruned
+    wxFileName(path).Touch();
+    return true;
+}
+
+bool IsoProfileCache::Store(const wxString& fingerprint, const Entry& entry) {
+    if (fingerprint.IsEmpty() || !entry.profile) return false;
+    if (!EnsureCacheDirectory()) return false;
+
+    rapidjson::Document doc = ProfileToJson(fingerprint, entry);
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    doc.Accept(writer);
+
+    // Write then rename, so a crash never leaves a truncated entry behind
+    wxString path = GetEntryPath(fingerprint);
+    wxString tempPath = path + ".tmp";
+    {
+        wxFile file(tempPath, wxFile::write);
+        if (!file.IsOpened() || !file.Write(buffer.GetString(), buffer.GetSize())) {
+            wxLogDebug("Failed to write ISO cache entry: %s", tempPath);
+            return false;
+        }
+    }
+    if (!wxRenameFile(tempPath, path, true)) {
+        wxRemoveFile(tempPath);
+        return false;
+    }
+
+    Prune();
+    return true;
+}
+
+wxString IsoProfileCache::GetEntryPath(const wxString& fingerprint) const {
+    return m_cacheDir + wxFileName::GetPathSeparator() + fingerprint + ".json";
+}
+
+bool IsoProfileCache::EnsureCacheDirectory() const {
+    if (wxDirExists(m_cacheDir)) return true;
+    if (!wxFileName::Mkdir(m_cacheDir, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL)) {
+        wxLogDebug("Failed to create ISO cache directory: %s", m_cacheDir);
+        return false;
+    }
+    return true;
+}
+
+// Drops the least recently used entries beyond MAX_ENTRIES
+void IsoProfileCache::Prune() const {
+    wxArrayString files;
+    wxDir::GetAllFiles(m_cacheDir, &files, "*.json", wxDIR_FILES);
+    if (files.GetCount() <= MAX_ENTRIES) return;
+
+    std::vector<std::pair<wxDateTime, wxString>> entries;
+    for (const wxString& file : files) {
+        entries.emplace_back(wxFileName(file).GetModificationTime(), file);
+    }
+    std::sort(entries.begin(), entries.end(),
+              [](const auto& a, const auto& b) { return a.first.IsEarlierThan(b.first); });
+
+    for (size_t i = 0; i + MAX_ENTRIES < entries.size(); ++i) {
+        wxRemoveFile(entries[i].second);
+    }
+}
+
+rapidjson::Document IsoProfileCache::ProfileToJson(const wxString& fingerprint, const Entry& entry) const {
+    const IsoProfile& profile = *entry.profile;
+    rapidjson::Document doc;
+    doc.SetObject();
+    auto& allocator = doc.GetAllocator();
+
+    doc.AddMember("version", CACHE_VERSION, allocator);
+    doc.AddMember("fingerprint", rapidjson::Value(fingerprint.ToUTF8().data(), allocator), allocator);
+    doc.AddMember("distribution", rapidjson::Value(entry.distribution.ToUTF8().data(), allocator), allocator);
+    doc.AddMember("volume_id", MakeString(profile.volumeId(), allocator), allocator);
+    doc.AddMember("file_count", static_cast<uint64_t>(profile.fileCount()), allocator);
+
+    rapidjson::Value filesystems(rapidjson::kArrayType);
+    for (const auto& fs : profile.filesystems()) {
+        rapidjson::Value item(rapidjson::kObjectType);
+        item.AddMember("path", MakeString(fs.path, allocator), allocator);
+        item.AddMember("size", static_cast<uint64_t>(fs.size), allocator);
+        filesystems.PushBack(item, allocator);
+    }
+    doc.AddMember("filesystems", filesystems, allocator);
+
+    auto textFiles = [&](const std::vector<IsoProfile::TextFile>& files) {
+        rapidjson::Value array(rapidjson::kArrayType);
+        for (const auto& text : files) {
+            rapidjson::Value item(rapidjson::kObjectType);
+            item.AddMember("path", MakeString(text.path, allocator), allocator);
+            item.AddMember("content", MakeString(text.content, allocator), allocator);
+            array.PushBack(item, allocator);
+        }
+        return array;
+    };
+    doc.AddMember("grubenv", textFiles(profile.grubEnvFiles()), allocator);
+    doc.AddMember("release", textFiles(profile.releaseFiles()), allocator);
+
+    rapidjson::Value boot(rapidjson::kArrayType);
+    for (const auto& bootEntry : profile.bootCatalog()) {
+        rapidjson::Value item(rapidjson::kObjectType);
+        item.AddMember("platform", static_cast<unsigned>(bootEntry.platform), allocator);
+        item.AddMember("bootable", bootEntry.bootable, allocator);
+        item.AddMember("media", static_cast<unsigned>(bootEntry.mediaType), allocator);
+        item.AddMember("lba", bootEntry.loadLba, allocator);
+        item.AddMember("sectors", static_cast<unsigned>(bootEntry.sectorCount), allocator);
+        item.AddMember("path", MakeString(bootEntry.path, allocator), allocator);
+        boot.PushBack(item, allocator);
+    }
+    doc.AddMember("boot", boot, allocator);
+
+    // The index can hold 100k entries, so each one is a compact array
+    rapidjson::Value files(rapidjson::kArrayType);
+    files.Reserve(static_cast<rapidjson::SizeType>(profile.files().size()), allocator);
+    for (const auto& file : profile.files()) {
+        rapidjson::Value item(rapidjson::kArrayType);
+        item.PushBack(MakeString(file.path, allocator), allocator);
+        item.PushBack(static_cast<uint64_t>(file.size), allocator);
+        item.PushBack(static_cast<int64_t>(file.lba), allocator);
+        item.PushBack(file.directory, allocator);
+        files.PushBack(item, allocator);
+    }
+    doc.AddMember("files", files, allocator);
+
+    return doc;
+}
+
+bool IsoProfileCache::JsonToProfile(const rapidjson::Document& doc, const wxString& isoPath, Entry& entry) const {
+    std::shared_ptr<IsoProfile> profile(new IsoProfile());
+    profile->m_isoPath = isoPath.ToStdString();
+
+    if (doc.HasMember("volume_id"))
+        profile->m_volumeId = GetString(doc["volume_id"]);
+    if (doc.HasMember("file_count") && doc["file_count"].IsUint64())
+        profile->m_fileCount = doc["file_count"].GetUint64();
+
+    if (doc.HasMember("filesystems") && doc["filesystems"].IsArray()) {
+        for (const auto& item : doc["filesystems"].GetArray()) {
+            if (!item.IsObject() || !item.HasMember("path") || !item.HasMember("size") || !item["size"].IsUint64())
+                return false;
+            profile->m_filesystems.push_back({GetString(item["path"]), item["size"].GetUint64()});
+        }
+    }
+
+    auto textFiles = [](const rapidjson::Value& array, std::vector<IsoProfile::TextFile>& out) {
+        if (!array.IsArray()) return false;
+        for (const auto& item : array.GetArray()) {
+            if (!item.IsObject() || !item.HasMember("path") || !item.HasMember("content"))
+                return false;
+            out.push_back({GetString(item["path"]), GetString(item["content"])});
+        }
+        return true;
+    };
+    if (doc.HasMember("grubenv") && !textFiles(doc["grubenv"], profile->m_grubEnvFiles))
+        return false;
+    if (doc.HasMember("release") && !textFiles(doc["release"], profile->m_releaseFiles))
+        return false;
+
+    if (doc.HasMember("boot") && doc["boot"].IsArray()) {
+        for (const auto& item : doc["boot"].GetArray()) {
+            if (!item.IsObject() || !item.HasMember("platform") || !item["platform"].IsUint() ||
+                !item.HasMember("lba") || !item["lba"].IsUint())
+                return false;
+            if ((item.HasMember("media") && !item["media"].IsUint()) ||
+                (item.HasMember("sectors") && !item["sectors"].IsUint()))
+                return false;
+            IsoProfile::BootEntry bootEntry;
+            bootEntry.platform = static_cast<uint8_t>(item["platform"].GetUint());
+            bootEntry.bootable = item.HasMember("bootable") && item["bootable"].IsBool() && item["bootable"].GetBool();
+            bootEntry.mediaType = item.HasMember("media") ? static_cast<uint8_t>(item["media"].GetUint()) : 0;
+            bootEntry.loadLba = item["lba"].GetUint();
+            bootEntry.sectorCount = item.HasMember("sectors") ? static_cast<uint16_t>(item["sectors"].GetUint()) : 0;
+            bootEntry.path = item.HasMember("path") ? GetString(item["path"]) : std::string();
+            profile->m_bootCatalog.push_back(bootEntry);
+        }
+    }
+
+    if (doc.HasMember("files") && doc["files"].IsArray()) {
+        const auto& files = doc["files"];
+        profile->m_files.reserve(files.Size());
+        for (const auto& item : files.GetArray()) {
+            if (!item.IsArray() || item.Size() != 4 || !item[1].IsUint64() || !item[2].IsInt64() || !item[3].IsBool())
+                return false;
+            profile->m_files.push_back({GetString(item[0]), item[1].GetUint64(), item[2].GetInt64(), item[3].GetBool()});
+        }
+    }
+
+    entry.profile = profile;
+    entry.distribution = doc.HasMember("distribution") ? wxString::FromUTF8(GetString(doc["distribution"]).c_str())
+                                                       : wxString();
+    return true;
+}
@@ -0,0 +1,49 @@
+#ifndef ISO_PROFILE_CACHE_H
+#define ISO_PROFILE_CACHE_H
+
+#include <wx/string.h>
+#include <rapidjson/document.h>
+#include <memory>
+#include "ISOInspector.h"
+
+// Persists ISOInspector results in the user data dir so a known image is
+// detected without being read again. Entries are keyed by a fingerprint of
+// the volume descriptors, the file size and the modification time, so any
+// change to the image produces a new key. The settings the profile and the
+// distribution were worked out with are part of the key as well, so editing
+// config.yaml doesn't bring back results it would no longer produce.
+class IsoProfileCache {
+public:
+    struct Entry {
+        std::shared_ptr<const IsoProfile> profile;
+        wxString distribution;  // Empty until detection has run once
+    };
+
+    IsoProfileCache();
+
+    // The text of the settings detection depends on, mixed into every
+    // fingerprint from then on
+    void SetConfig(const std::string& config);
+
+    // Returns an empty string if the file can't be read
+    wxString Fingerprint(const wxString& isoPath) const;
+
+    bool Load(const wxString& fingerprint, const wxString& isoPath, Entry& entry) const;
+    bool Store(const wxString& fingerprint, const Entry& entry);
+
+private:
+    wxString GetEntryPath(const wxString& fingerprint) const;
+    bool EnsureCacheDirectory() const;
+    void Prune() const;
+
+    rapidjson::Document ProfileToJson(const wxString& fingerprint, const Entry& entry) const;
+    bool JsonToProfile(const rapidjson::Document& doc, const wxString& isoPath, Entry& entry) const;
+
+    wxString m_cacheDir;
+    unsigned long long m_configHash;
+
+    static const int CACHE_VERSION = 1;
+    static const size_t MAX_ENTRIES = 32;
+};
+
+#endif // ISO_PROFILE_CACHE_H
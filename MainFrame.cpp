@@ -1,5 +1,5 @@
 #include "MainFrame.h"
-#include "ISOReader.h"
+#include "ISOInspector.h"
 #include "SettingsDialog.h"
 #include <wx/filedlg.h>
 #include <wx/dirdlg.h>
@@ -7,6 +7,8 @@
 #include <wx/tokenzr.h>
 #include <algorithm>
 #include "FilesystemSelectionDialog.h"
+#include "ISOReader.h"
+#include "SquashFSReader.h"
 #include <filesystem>
 #include <wx/artprov.h>
 #include <wx/bmpbuttn.h>
@@ -15,6 +17,8 @@
 #include <wx/filename.h>
 #include "SystemTheme.h"
 #include "DesktopTab.h"
+#include "ContainerManager.h"
+#include "ContainerReaper.h"
 #include <wx/textfile.h> // Add this line
 
 BEGIN_EVENT_TABLE(MainFrame, wxFrame)
@@ -27,7 +31,7 @@ EVT_BUTTON(ID_SETTINGS, MainFrame::OnSettings)
 END_EVENT_TABLE()
 
 MainFrame::MainFrame(const wxString &title)
-    : wxFrame()
+    : wxFrame(), m_detectThread(nullptr), m_nextAfterDetect(false)
 {
     Create(NULL, wxID_ANY, title, wxDefaultPosition, wxDefaultSize,
            wxCAPTION | wxCLOSE_BOX | wxMINIMIZE_BOX | wxSYSTEM_MENU | wxNO_BORDER | wxCLIP_CHILDREN);
@@ -85,6 +89,7 @@ MainFrame::MainFrame(const wxString &title)
     {
         SetStatusText("Failed to load configuration file. Using default values.");
     }
+    StartContainerPool();
 
     CreateFrameControls();
 
@@ -105,10 +110,21 @@ MainFrame::MainFrame(const wxString &title)
 
     // Bind custom event to handler
     Bind(FILE_COPY_COMPLETE_EVENT, &MainFrame::OnGUIDetected, this);
+    Bind(ISO_DETECT_PROGRESS, &MainFrame::OnDetectProgress, this);
+    Bind(ISO_DETECT_COMPLETE, &MainFrame::OnDetectComplete, this);
+    Bind(CONTAINER_REMOVED, &MainFrame::OnContainerRemoved, this);
+    ContainerReaper::Get().SetListener(this);
 }
 
 MainFrame::~MainFrame()
 {
+    StopDetection();
+
+    // Closed project windows may still be removing their containers
+    ContainerReaper::Get().SetListener(nullptr);
+    ContainerReaper::Get().Drain();
+    ContainerManager::Get().StopPool();
+
     // Unregister from ThemeConfig when window is destroyed
     ThemeConfig::Get().UnregisterWindow(this);
 }
@@ -299,7 +315,12 @@ void MainFrame::OnBrowseISO(wxCommandEvent &event)
     if (openFileDialog.ShowModal() == wxID_CANCEL)
         return;
 
+    // A detection still running belongs to the previous image
+    if (m_detectThread)
+        m_detectThread->Cancel();
+
     m_isoPathCtrl->SetValue(openFileDialog.GetPath());
+    m_isoProfile.reset();
     m_distroCtrl->SetValue("");
     m_progressGauge->SetValue(0);
     SetStatusText("ISO file selected. Click Detect to analyze.");
@@ -351,9 +372,17 @@ void MainFrame::OnNextButton(wxCommandEvent &event)
         return;
     }
 
-    // Search for SquashFS files in the ISO
+    // Search for SquashFS files in the ISO once detection has a profile
+    StartDetection(m_isoPathCtrl->GetValue(), true);
+}
+
+void MainFrame::ContinueToNext(const IsoProfile &profile)
+{
+    wxString projectName = m_projectNameCtrl->GetValue();
+    projectName.Replace(" ", "");
+
     wxArrayString squashfsFiles;
-    if (!SearchSquashFS(m_isoPathCtrl->GetValue(), squashfsFiles))
+    if (!SearchSquashFS(profile, squashfsFiles))
     {
         wxMessageBox("No SquashFS/SFS files found in the ISO.\nThe ISO might not be a Linux distribution or might be corrupted.",
                      "Error", wxOK | wxICON_ERROR);
@@ -367,6 +396,16 @@ void MainFrame::OnNextButton(wxCommandEvent &event)
         wxArrayString prioritizedFiles;
         wxArrayString descriptions;
 
+        // Preview each candidate from its superblock and /etc/os-release.
+        // Only with the mapped backend: libarchive would walk the stream.
+        ISOReader reader(profile.isoPath());
+        const bool canPreview = reader.open() && reader.isNative();
+        for (const auto &fs : profile.filesystems())
+        {
+            descriptions.Add(canPreview ? DescribeFilesystem(reader, fs)
+                                        : wxFileName::GetHumanReadableSize(wxULongLong(fs.size)));
+        }
+
         // Create prioritized list with descriptions
         for (const wxString &file : squashfsFiles)
         {
@@ -387,7 +426,7 @@ void MainFrame::OnNextButton(wxCommandEvent &event)
         // Show custom selection dialog
         FilesystemSelectionDialog dialog(this,
                                          "Multiple filesystem files found. Please select the one to use:",
-                                         prioritizedFiles);
+                                         prioritizedFiles, descriptions);
 
         if (dialog.ShowModal() == wxID_OK)
         {
@@ -447,6 +486,14 @@ void MainFrame::OnNextButton(wxCommandEvent &event)
 
 void MainFrame::OnCancel(wxCommandEvent &event)
 {
+    if (m_detectThread)
+    {
+        m_detectThread->Cancel();
+        m_statusText->SetLabel("Cancelling detection...");
+        SetStatusText("Cancelling detection...");
+        return;
+    }
+
     wxWindowList &windows = wxTopLevelWindows;
     for (wxWindowList::iterator it = windows.begin(); it != windows.end(); ++it)
     {
@@ -478,6 +525,8 @@ bool MainFrame::LoadConfig()
         if (std::filesystem::exists(exePath))
         {
             m_config = YAML::LoadFile(exePath.string());
+            m_distroDetector = DistroDetector::fromConfig(m_config);
+            m_profileCache.SetConfig(GetDetectionConfig());
             return true;
         }
 
@@ -485,6 +534,8 @@ bool MainFrame::LoadConfig()
         if (std::filesystem::exists(buildPath))
         {
             m_config = YAML::LoadFile(buildPath.string());
+            m_distroDetector = DistroDetector::fromConfig(m_config);
+            m_profileCache.SetConfig(GetDetectionConfig());
             return true;
         }
         return false;
@@ -497,41 +548,173 @@ bool MainFrame::LoadConfig()
     }
 }
 
-bool MainFrame::SearchSquashFS(const wxString &isoPath, wxArrayString &foundFiles)
+void MainFrame::OnContainerRemoved(wxCommandEvent &event)
 {
-    try
+    if (event.GetInt())
+        SetStatusText("Removed container " + event.GetString().Left(12));
+    else
+        SetStatusText("Container " + event.GetString().Left(12) + " will be removed on the next start");
+}
+
+// Keeps idle builder containers ready so a new project doesn't wait for one
+void MainFrame::StartContainerPool()
+{
+    size_t size = 0;
+    long idleMinutes = 30;
+    const auto &pool = m_config["container_pool"];
+    if (pool && pool.IsMap())
     {
-        ISOReader reader(isoPath.ToStdString());
-        if (!reader.open())
+        try
         {
-            wxMessageBox("Failed to open ISO file: " + wxString(reader.getLastError()),
-                         "Error", wxOK | wxICON_ERROR);
-            return false;
+            if (pool["size"])
+                size = pool["size"].as<size_t>();
+            if (pool["idle_ttl_minutes"])
+                idleMinutes = pool["idle_ttl_minutes"].as<long>();
         }
-
-        auto files = reader.listFiles();
-        bool found = false;
-
-        for (const auto &file : files)
+        catch (const YAML::Exception &e)
         {
-            wxString wxFile = wxString::FromUTF8(file);
-            wxString extension = wxFileName(wxFile).GetExt().Lower();
-
-            if (extension == "squashfs" || extension == "sfs" || extension == "img" || extension == "cramfs")
-            {
-                foundFiles.Add(wxFile);
-                found = true;
-            }
+            wxLogWarning("Invalid container_pool settings: %s", e.what());
+            return;
         }
+    }
+    ContainerManager::Get().StartPool(size, std::chrono::minutes(std::max(idleMinutes, 1L)));
+}
+
+ISOInspector::Options MainFrame::GetInspectorOptions() const
+{
+    ISOInspector::Options options;
+    const auto &grubenvPaths = m_config["grubenv_paths"];
+    if (grubenvPaths && grubenvPaths.IsSequence())
+    {
+        for (const auto &pathNode : grubenvPaths)
+            options.grubenvPaths.push_back(pathNode.as<std::string>());
+    }
+    const auto &releasePaths = m_config["release_paths"];
+    if (releasePaths && releasePaths.IsSequence())
+    {
+        for (const auto &pathNode : releasePaths)
+            options.releasePaths.push_back(pathNode.as<std::string>());
+    }
+    return options;
+}
+
+// The sections of config.yaml that detection results depend on: the files
+// read from the ISO and the patterns naming the distribution
+std::string MainFrame::GetDetectionConfig() const
+{
+    YAML::Emitter out;
+    out << YAML::BeginSeq;
+    for (const char *section : {"grubenv_paths", "release_paths", "distributions"})
+        out << (m_config[section] ? m_config[section] : YAML::Node(YAML::NodeType::Null));
+    out << YAML::EndSeq;
+    return out.c_str();
+}
+
+// Inspects the ISO on a worker thread so the window stays responsive on
+// large images. Detect and Next share the resulting profile; an image
+// already inspected this session is answered without starting a thread.
+void MainFrame::StartDetection(const wxString &isoPath, bool continueToNext)
+{
+    if (m_detectThread)
+    {
+        SetStatusText("Detection is already running");
+        return;
+    }
+
+    m_nextAfterDetect = continueToNext;
+    if (m_isoProfile && m_isoProfile->isoPath() == isoPath.ToStdString() &&
+        m_profileCache.Fingerprint(isoPath) == m_isoFingerprint)
+    {
+        OnDetectionFinished();
+        return;
+    }
+
+    m_detectThread = new ISODetectThread(this, isoPath, GetInspectorOptions(), m_profileCache);
+    if (m_detectThread->Run() != wxTHREAD_NO_ERROR)
+    {
+        delete m_detectThread;
+        m_detectThread = nullptr;
+        wxMessageBox("Failed to start ISO detection.", "Error", wxOK | wxICON_ERROR);
+        return;
+    }
+
+    m_progressGauge->SetValue(0);
+    m_statusText->SetLabel("Analyzing ISO file...");
+}
 
-        return found;
+void MainFrame::StopDetection()
+{
+    if (!m_detectThread)
+        return;
+
+    // Cancellation is checked between headers and reads, so this is short
+    m_detectThread->Cancel();
+    m_detectThread->Wait();
+    delete m_detectThread;
+    m_detectThread = nullptr;
+}
+
+void MainFrame::OnDetectProgress(wxCommandEvent &event)
+{
+    if (!m_detectThread)
+        return;
+
+    m_progressGauge->SetValue(event.GetInt());
+    m_statusText->SetLabel(event.GetString());
+    SetStatusText(event.GetString());
+}
+
+void MainFrame::OnDetectComplete(wxCommandEvent &event)
+{
+    std::unique_ptr<ISODetectResult> result(static_cast<ISODetectResult *>(event.GetClientData()));
+    StopDetection();
+    if (!result)
+        return;
+
+    // Also covers an image replaced through Browse while it was being read
+    if (result->cancelled || result->isoPath != m_isoPathCtrl->GetValue())
+    {
+        m_distroCtrl->SetValue("");
+        m_progressGauge->SetValue(0);
+        m_statusText->SetLabel("Detection cancelled");
+        SetStatusText("Detection cancelled");
+        return;
     }
-    catch (const std::exception &e)
+
+    if (!result->profile)
     {
-        wxMessageBox("Error reading ISO: " + wxString(e.what()),
+        m_distroCtrl->SetValue("Detection failed - Could not read ISO");
+        m_progressGauge->SetValue(0);
+        m_statusText->SetLabel("Failed to read ISO file");
+        wxMessageBox("Failed to open ISO file: " + result->error,
                      "Error", wxOK | wxICON_ERROR);
-        return false;
+        return;
+    }
+
+    m_isoProfile = result->profile;
+    m_isoFingerprint = result->fingerprint;
+    m_cachedDistribution = result->distribution;
+    if (!result->fromCache)
+        m_profileCache.Store(m_isoFingerprint, {m_isoProfile, wxString()});
+
+    OnDetectionFinished();
+}
+
+void MainFrame::OnDetectionFinished()
+{
+    if (m_nextAfterDetect)
+        ContinueToNext(*m_isoProfile);
+    else
+        ShowDistribution(*m_isoProfile);
+}
+
+bool MainFrame::SearchSquashFS(const IsoProfile &profile, wxArrayString &foundFiles)
+{
+    for (const auto &fs : profile.filesystems())
+    {
+        foundFiles.Add(wxString::FromUTF8(fs.path));
     }
+    return !profile.filesystems().empty();
 }
 
 void MainFrame::OnDetect(wxCommandEvent &event)
@@ -545,13 +728,28 @@ void MainFrame::OnDetect(wxCommandEvent &event)
     }
 
     m_distroCtrl->SetValue("Detecting...");
-    m_progressGauge->SetValue(10);
-    m_statusText->SetLabel("Analyzing ISO file...");
-    Update();
+    StartDetection(isoPath, false);
+}
+
+void MainFrame::ShowDistribution(const IsoProfile &profile)
+{
+    if (!m_cachedDistribution.IsEmpty())
+    {
+        m_distroCtrl->SetValue(m_cachedDistribution);
+        m_progressGauge->SetValue(100);
+        m_statusText->SetLabel("Detection completed using cached result");
+
+        if (m_projectNameCtrl->IsEmpty())
+        {
+            m_projectNameCtrl->SetValue(m_cachedDistribution);
+        }
+        return;
+    }
 
     wxString distributionName;
-    if (SearchGrubEnv(isoPath, distributionName))
+    if (SearchGrubEnv(profile, distributionName))
     {
+        RememberDistribution(distributionName);
         m_distroCtrl->SetValue(distributionName);
         m_progressGauge->SetValue(100);
         m_statusText->SetLabel("Detection completed successfully using grubenv");
@@ -564,7 +762,7 @@ void MainFrame::OnDetect(wxCommandEvent &event)
     }
 
     wxString releaseContent;
-    if (!SearchReleaseFile(isoPath, releaseContent))
+    if (!SearchReleaseFile(profile, releaseContent))
     {
         m_distroCtrl->SetValue("Detection failed - No identification files found");
         m_progressGauge->SetValue(0);
@@ -572,11 +770,8 @@ void MainFrame::OnDetect(wxCommandEvent &event)
         return;
     }
 
-    m_progressGauge->SetValue(50);
-    m_statusText->SetLabel("Reading distribution information...");
-    Update();
-
     wxString distribution = DetectDistribution(releaseContent);
+    RememberDistribution(distribution);
     m_distroCtrl->SetValue(distribution);
     m_progressGauge->SetValue(100);
     m_statusText->SetLabel("Detection completed successfully using release file");
@@ -587,179 +782,72 @@ void MainFrame::OnDetect(wxCommandEvent &event)
     }
 }
 
-bool MainFrame::SearchReleaseFile(const wxString &isoPath, wxString &releaseContent)
+void MainFrame::RememberDistribution(const wxString &distribution)
 {
-    try
-    {
-        ISOReader reader(isoPath.ToStdString());
-        if (!reader.open())
-            return false;
-
-        const auto &releasePaths = m_config["release_paths"];
-        if (releasePaths && releasePaths.IsSequence())
-        {
-            for (const auto &pathNode : releasePaths)
-            {
-                std::vector<char> content;
-                std::string path = pathNode.as<std::string>();
-                if (reader.readFile(path, content))
-                {
-                    releaseContent = wxString(content.data(), content.size());
-                    return true;
-                }
-            }
-        }
+    if (!m_isoProfile || distribution.IsEmpty())
+        return;
 
-        auto files = reader.listFiles();
-        for (const auto &file : files)
-        {
-            std::string lowerFile = file;
-            std::transform(lowerFile.begin(), lowerFile.end(), lowerFile.begin(), ::tolower);
-
-            if (lowerFile.find("release") != std::string::npos ||
-                lowerFile.find("version") != std::string::npos)
-            {
-                std::vector<char> content;
-                if (reader.readFile(file, content))
-                {
-                    releaseContent = wxString(content.data(), content.size());
-                    return true;
-                }
-            }
-        }
-        return false;
-    }
-    catch (const std::exception &e)
-    {
-        wxMessageBox("Error reading ISO: " + wxString(e.what()), "Error", wxOK | wxICON_ERROR);
-        return false;
-    }
+    m_cachedDistribution = distribution;
+    m_profileCache.Store(m_isoFingerprint, {m_isoProfile, distribution});
 }
 
-bool MainFrame::SearchGrubEnv(const wxString &isoPath, wxString &distributionName)
+// One line summary of a filesystem image: size, compressor, inode count
+// and the release named in its os-release, all without touching data blocks
+// beyond the one holding os-release.
+wxString MainFrame::DescribeFilesystem(ISOReader &reader, const IsoProfile::Filesystem &fs)
 {
-    try
-    {
-        ISOReader reader(isoPath.ToStdString());
-        if (!reader.open())
-            return false;
+    wxString description = wxFileName::GetHumanReadableSize(wxULongLong(fs.size));
 
-        const auto &grubenvPaths = m_config["grubenv_paths"];
-        if (grubenvPaths && grubenvPaths.IsSequence())
-        {
-            for (const auto &pathNode : grubenvPaths)
-            {
-                std::vector<char> content;
-                std::string path = pathNode.as<std::string>();
-                if (reader.readFile(path, content))
-                {
-                    wxString envContent(content.data(), content.size());
-                    distributionName = ExtractNameFromGrubEnv(envContent);
-                    if (!distributionName.IsEmpty())
-                        return true;
-                }
-            }
-        }
+    SquashFSReader squashfs(reader, fs.path);
+    if (!squashfs.open())
+        return description;
 
-        auto files = reader.listFiles();
-        for (const auto &file : files)
-        {
-            std::string lowerFile = file;
-            std::transform(lowerFile.begin(), lowerFile.end(), lowerFile.begin(), ::tolower);
-
-            if (lowerFile.find("grubenv") != std::string::npos)
-            {
-                std::vector<char> content;
-                if (reader.readFile(file, content))
-                {
-                    wxString envContent(content.data(), content.size());
-                    distributionName = ExtractNameFromGrubEnv(envContent);
-                    if (!distributionName.IsEmpty())
-                        return true;
-                }
-            }
-        }
-        return false;
-    }
-    catch (const std::exception &e)
+    const auto &sb = squashfs.superblock();
+    description += wxString::Format(", %s, %u KiB blocks, %u inodes",
+                                    squashfs.compressionName(), sb.blockSize / 1024, sb.inodeCount);
+    if (!squashfs.canDecompress())
+        return description;
+
+    std::vector<char> osRelease;
+    if (squashfs.readFile("etc/os-release", osRelease) || squashfs.readFile("usr/lib/os-release", osRelease))
     {
-        wxMessageBox("Error reading ISO: " + wxString(e.what()), "Error", wxOK | wxICON_ERROR);
-        return false;
+        wxString release = ExtractNameFromGrubEnv(wxString::FromUTF8(osRelease.data(), osRelease.size()));
+        if (!release.IsEmpty())
+            description += ", " + release;
     }
+    return description;
 }
 
-wxString MainFrame::ExtractNameFromGrubEnv(const wxString &content)
+bool MainFrame::SearchReleaseFile(const IsoProfile &profile, wxString &releaseContent)
 {
-    wxString name;
-    wxString version;
-
-    wxStringTokenizer tokenizer(content, "\n");
-    while (tokenizer.HasMoreTokens())
-    {
-        wxString line = tokenizer.GetNextToken().Trim(true).Trim(false);
+    if (profile.releaseFiles().empty())
+        return false;
 
-        if (line.StartsWith("NAME="))
-        {
-            name = line.Mid(5);
-            name.Replace("\"", "");
-        }
-        else if (line.StartsWith("VERSION="))
-        {
-            version = line.Mid(8);
-            version.Replace("\"", "");
-        }
-    }
+    const auto &release = profile.releaseFiles().front();
+    releaseContent = wxString(release.content.data(), release.content.size());
+    return true;
+}
 
-    if (!name.IsEmpty() && !version.IsEmpty())
-    {
-        return name + " " + version;
-    }
-    else if (!name.IsEmpty())
+bool MainFrame::SearchGrubEnv(const IsoProfile &profile, wxString &distributionName)
+{
+    for (const auto &grubenv : profile.grubEnvFiles())
     {
-        return name;
+        wxString envContent(grubenv.content.data(), grubenv.content.size());
+        distributionName = ExtractNameFromGrubEnv(envContent);
+        if (!distributionName.IsEmpty())
+            return true;
     }
-    return "";
+    return false;
 }
 
-wxString MainFrame::DetectDistribution(const wxString &releaseContent)
+wxString MainFrame::ExtractNameFromGrubEnv(const wxString &content)
 {
-    wxString lowerContent = releaseContent.Lower();
+    return wxString::FromUTF8(DistroDetector::nameFromOsRelease(content.ToStdString(wxConvUTF8)));
+}
 
-    const auto &distributions = m_config["distributions"];
-    if (distributions && distributions.IsSequence())
-    {
-        for (const auto &distro : distributions)
-        {
-            if (!distro["pattern"] || !distro["name"])
-                continue;
-
-            wxString pattern = wxString::FromUTF8(distro["pattern"].as<std::string>());
-            if (lowerContent.Contains(pattern))
-            {
-                wxString name = wxString::FromUTF8(distro["name"].as<std::string>());
-
-                wxString version;
-                int versionPos = lowerContent.Find("version");
-                if (versionPos != wxNOT_FOUND)
-                {
-                    wxString remaining = releaseContent.Mid(versionPos + 7);
-                    for (size_t i = 0; i < remaining.Length(); i++)
-                    {
-                        if (isdigit(remaining[i]) || remaining[i] == '.')
-                        {
-                            version += remaining[i];
-                        }
-                        else if (!version.IsEmpty())
-                        {
-                            break;
-                        }
-                    }
-                }
-                return version.IsEmpty() ? name : name + " " + version;
-            }
-        }
-    }
-    return "Unknown Distribution";
+wxString MainFrame::DetectDistribution(const wxString &releaseContent)
+{
+    return wxString::FromUTF8(m_distroDetector.detect(releaseContent.ToStdString(wxConvUTF8)));
 }
 
 void MainFrame::OnGUIDetected(wxCommandEvent &event)
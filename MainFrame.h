@@ -7,12 +7,17 @@
 #include <yaml-cpp/yaml.h>
 #include <vector>
 #include <string>
+#include <memory>
 #include "CustomTitleBar.h"  // Includes MyButton definition now
 #include "CustomStatusBar.h"
 #include "SecondWindow.h"
 #include "WindowIDs.h"
 #include "SettingsManager.h"
 #include "DesktopTab.h"
+#include "ISOInspector.h"
+#include "IsoProfileCache.h"
+#include "ISODetectThread.h"
+#include "DistroDetector.h"
 
 #ifdef __WXMSW__
   #include <dwmapi.h>
@@ -25,6 +30,8 @@
   #endif
 #endif
 
+class ISOReader;
+
 class MainFrame : public wxFrame {
 public:
    MainFrame(const wxString& title);
@@ -33,7 +40,7 @@ public:
    void SetStatusText(const wxString& text);
 
 private:
-   bool SearchSquashFS(const wxString& isoPath, wxArrayString& foundFiles);
+   bool SearchSquashFS(const IsoProfile& profile, wxArrayString& foundFiles);
    void CreateFrameControls();
    void OpenSecondWindow();
    wxString m_currentISOPath;
@@ -45,12 +52,26 @@ private:
    void OnCancel(wxCommandEvent& event);
    void OnSettings(wxCommandEvent& event);
 
-   bool SearchReleaseFile(const wxString& isoPath, wxString& releaseContent);
-   bool SearchGrubEnv(const wxString& isoPath, wxString& distributionName);
+   // Detection runs on m_detectThread; Next reuses it when no profile is ready
+   void StartDetection(const wxString& isoPath, bool continueToNext);
+   void StopDetection();
+   void OnDetectProgress(wxCommandEvent& event);
+   void OnDetectComplete(wxCommandEvent& event);
+   void OnContainerRemoved(wxCommandEvent& event);
+   void OnDetectionFinished();
+   void ShowDistribution(const IsoProfile& profile);
+   void ContinueToNext(const IsoProfile& profile);
+   wxString DescribeFilesystem(ISOReader& reader, const IsoProfile::Filesystem& fs);
+   ISOInspector::Options GetInspectorOptions() const;
+   std::string GetDetectionConfig() const;
+   bool SearchReleaseFile(const IsoProfile& profile, wxString& releaseContent);
+   bool SearchGrubEnv(const IsoProfile& profile, wxString& distributionName);
+   void RememberDistribution(const wxString& distribution);
    wxString ExtractNameFromGrubEnv(const wxString& content);
    wxString DetectDistribution(const wxString& releaseContent);
    
    bool LoadConfig();
+   void StartContainerPool();
    void CreateSettingsMenu();
    
    wxPanel* CreateLogoPanel(wxWindow* parent);
@@ -70,6 +91,13 @@ private:
    CustomTitleBar* m_titleBar;
    CustomStatusBar* m_statusBar;
    YAML::Node m_config;
+   DistroDetector m_distroDetector;                 // Built from m_config by LoadConfig
+   std::shared_ptr<const IsoProfile> m_isoProfile;  // Result of the last inspection
+   wxString m_isoFingerprint;                       // Cache key of m_isoProfile
+   wxString m_cachedDistribution;                   // Distribution remembered for it
+   IsoProfileCache m_profileCache;
+   ISODetectThread* m_detectThread;                 // Null when no detection is running
+   bool m_nextAfterDetect;                          // Detection was started by Next
 
    // Settings manager
    SettingsManager m_settingsManager;
@@ -0,0 +1,200 @@
+#include "PipelineState.h"
+#include "Sha256.h"
+#include <wx/datetime.h>
+#include <wx/file.h>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+#include <wx/log.h>
+#include <wx/time.h>
+#include <rapidjson/document.h>
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+const int VERSION = 1;
+const wxFileOffset FINGERPRINT_CHUNK = 1024 * 1024;
+
+using JsonWriter = rapidjson::PrettyWriter<rapidjson::StringBuffer>;
+
+void WriteString(JsonWriter& writer, const wxString& value) {
+    const wxScopedCharBuffer utf8 = value.utf8_str();
+    writer.String(utf8.data(), static_cast<rapidjson::SizeType>(utf8.length()));
+}
+
+wxString ToString(const rapidjson::Value& value) {
+    return wxString::FromUTF8(value.GetString(), value.GetStringLength());
+}
+
+// Hashes up to FINGERPRINT_CHUNK bytes from offset
+bool HashChunk(wxFile& file, wxFileOffset offset, Sha256& hash) {
+    std::vector<char> buffer(static_cast<size_t>(FINGERPRINT_CHUNK));
+    if (file.Seek(offset) == wxInvalidOffset) {
+        return false;
+    }
+    const ssize_t read = file.Read(buffer.data(), buffer.size());
+    if (read < 0) {
+        return false;
+    }
+    hash.Update(buffer.data(), static_cast<size_t>(read));
+    return true;
+}
+
+} // namespace
+
+const char* const PipelineState::FILE_NAME = "pipeline_state.json";
+
+PipelineState::PipelineState(const wxString& projectDir)
+    : m_path(wxFileName(projectDir, FILE_NAME).GetFullPath()) {}
+
+bool PipelineState::Load() {
+    m_stages.clear();
+    wxFile file;
+    if (!wxFileExists(m_path) || !file.Open(m_path)) {
+        return false;
+    }
+    std::string data(static_cast<size_t>(file.Length()), '\0');
+    if (!data.empty() && file.Read(&data[0], data.size()) != static_cast<ssize_t>(data.size())) {
+        wxLogWarning("Could not read %s", m_path);
+        return false;
+    }
+
+    rapidjson::Document doc;
+    doc.Parse(data.c_str(), data.size());
+    if (doc.HasParseError() || !doc.IsObject() || !doc.HasMember("version") || !doc["version"].IsInt() ||
+        doc["version"].GetInt() != VERSION || !doc.HasMember("stages") || !doc["stages"].IsObject()) {
+        wxLogWarning("Ignoring the unreadable build checkpoints in %s", m_path);
+        return false;
+    }
+
+    for (const auto& item : doc["stages"].GetObject()) {
+        const rapidjson::Value& record = item.value;
+        if (!record.IsObject() || !record.HasMember("key") || !record["key"].IsString()) {
+            continue;
+        }
+        Stage stage;
+        stage.key = ToString(record["key"]);
+        if (record.HasMember("finished_ms") && record["finished_ms"].IsInt64()) {
+            stage.finished = record["finished_ms"].GetInt64();
+        }
+        if (record.HasMember("outputs") && record["outputs"].IsObject()) {
+            for (const auto& output : record["outputs"].GetObject()) {
+                if (output.value.IsString()) {
+                    stage.outputs[ToString(output.name)] = ToString(output.value);
+                }
+            }
+        }
+        m_stages[ToString(item.name)] = stage;
+    }
+    return true;
+}
+
+bool PipelineState::Find(const wxString& name, Stage& stage) const {
+    auto it = m_stages.find(name);
+    if (it == m_stages.end()) {
+        return false;
+    }
+    stage = it->second;
+    return true;
+}
+
+bool PipelineState::IsCurrent(const wxString& name, const wxString& key) const {
+    auto it = m_stages.find(name);
+    return it != m_stages.end() && !key.IsEmpty() && it->second.key == key;
+}
+
+bool PipelineState::Record(const wxString& name, const wxString& key, const std::map<wxString, wxString>& outputs) {
+    Load();
+    Stage& stage = m_stages[name];
+    stage.key = key;
+    stage.finished = wxGetUTCTimeMillis().GetValue();
+    stage.outputs = outputs;
+    return Save();
+}
+
+bool PipelineState::Invalidate(const wxString& name) {
+    Load();
+    if (m_stages.erase(name) == 0) {
+        return true;
+    }
+    return Save();
+}
+
+// Written to a temporary file that then replaces the old one, so a crash
+// leaves one or the other
+bool PipelineState::Save() const {
+    rapidjson::StringBuffer buffer;
+    JsonWriter writer(buffer);
+    writer.SetIndent(' ', 4);
+    writer.StartObject();
+    writer.Key("version");
+    writer.Int(VERSION);
+    writer.Key("stages");
+    writer.StartObject();
+    for (const auto& item : m_stages) {
+        WriteString(writer, item.first);
+        writer.StartObject();
+        writer.Key("key");
+        WriteString(writer, item.second.key);
+        writer.Key("finished_ms");
+        writer.Int64(item.second.finished);
+        writer.Key("outputs");
+        writer.StartObject();
+        for (const auto& output : item.second.outputs) {
+            WriteString(writer, output.first);
+            WriteString(writer, output.second);
+        }
+        writer.EndObject();
+        writer.EndObject();
+    }
+    writer.EndObject();
+    writer.EndObject();
+
+    const wxString tempPath = m_path + ".tmp";
+    wxFile file;
+    if (!file.Create(tempPath, true) || file.Write(buffer.GetString(), buffer.GetSize()) != buffer.GetSize() ||
+        !file.Close()) {
+        wxLogWarning("Could not write the build checkpoints to %s", tempPath);
+        wxRemoveFile(tempPath);
+        return false;
+    }
+    if (!wxRenameFile(tempPath, m_path, true)) {
+        wxRemoveFile(tempPath);
+        return false;
+    }
+    return true;
+}
+
+wxString PipelineState::Key(std::initializer_list<wxString> inputs) {
+    Sha256 hash;
+    for (const wxString& input : inputs) {
+        const wxScopedCharBuffer utf8 = input.utf8_str();
+        const std::string length = std::to_string(utf8.length()) + ":";
+        hash.Update(length.data(), length.size());
+        hash.Update(utf8.data(), utf8.length());
+    }
+    return wxString::FromAscii(hash.HexDigest().c_str());
+}
+
+// Empty if the file can't be read
+wxString PipelineState::Fingerprint(const wxString& path) {
+    wxFile file;
+    if (!wxFileExists(path) || !file.Open(path)) {
+        return wxEmptyString;
+    }
+    const wxFileOffset size = file.Length();
+    const wxDateTime modified = wxFileName(path).GetModificationTime();
+    if (size == wxInvalidOffset || !modified.IsValid()) {
+        return wxEmptyString;
+    }
+
+    Sha256 hash;
+    if (!HashChunk(file, 0, hash) ||
+        (size > FINGERPRINT_CHUNK && !HashChunk(file, size - FINGERPRINT_CHUNK, hash))) {
+        return wxEmptyString;
+    }
+    return Key({wxString::Format("%lld", static_cast<long long>(size)), modified.GetValue().ToString(),
+                wxString::FromAscii(hash.HexDigest().c_str())});
+}
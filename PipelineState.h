@@ -0,0 +1,54 @@
+#ifndef PIPELINE_STATE_H
+#define PIPELINE_STATE_H
+
+#include <wx/string.h>
+#include <initializer_list>
+#include <map>
+
+// Checkpoints of a project's build pipeline, kept in
+// <project>/pipeline_state.json so that a build interrupted by a crash
+// resumes where it stopped. Each finished stage is recorded with its key,
+// a hash of its inputs that includes the keys of the stages it builds on,
+// and the outputs it left. A stage whose key is unchanged and whose
+// outputs still exist needn't run again.
+//
+// The GUI checkpoints the host-side stages and BuildPipeline the ones in
+// the container, each through its own instance, in the same file. Every
+// change rereads the file, so neither drops the other's records, and
+// replaces it whole. An instance isn't thread-safe.
+class PipelineState {
+public:
+    struct Stage {
+        wxString key;
+        long long finished = 0;  // Milliseconds since the epoch
+        std::map<wxString, wxString> outputs;
+    };
+
+    explicit PipelineState(const wxString& projectDir);
+
+    // A missing or unreadable file is an empty state
+    bool Load();
+
+    bool Find(const wxString& name, Stage& stage) const;
+    bool IsCurrent(const wxString& name, const wxString& key) const;
+    bool Record(const wxString& name, const wxString& key, const std::map<wxString, wxString>& outputs);
+    bool Invalidate(const wxString& name);
+
+    wxString GetPath() const { return m_path; }
+
+    // SHA-256 of the inputs, each length-prefixed so they can't run together
+    static wxString Key(std::initializer_list<wxString> inputs);
+    // Stands in for the content of a file too large to hash at every start:
+    // its size, modification time and the hash of its first and last MiB
+    static wxString Fingerprint(const wxString& path);
+
+    static const char* const FILE_NAME;
+
+private:
+    bool Save() const;
+
+    wxString m_path;
+    std::map<wxString, Stage> m_stages;
+};
+
+#endif // PIPELINE_STATE_H
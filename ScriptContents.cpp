@@ -1,12 +1,456 @@
-// ScriptContents.cpp - Add this new file
-const char* SETUP_CHROOT_SCRIPT = R"(#!/bin/bash
-# Content of setup_chroot.sh
-)";
-
-const char* CREATE_ISO_SCRIPT = R"(#!/bin/bash
-# Content of create_iso.sh
-)";
-
-const char* SETUP_OUTPUT_SCRIPT = R"(#!/bin/bash
-# Content of setup_output.sh
-)";
\ No newline at end of file
+// ScriptContents.cpp - The scripts BuildPipeline runs in the build container.
+// ScriptManager::Render fills in the @NAME@ placeholders before they are
+// copied in.
+
+// Reports a command as a stage (see BuildStage.h). GNU time supplies CPU
+// time, block I/O (in 512-byte blocks) and peak RSS of the largest process;
+// without it only the timestamps are sent.
+const char* RUN_STAGE_FUNCTION = R"SCRIPT(
+run_stage() {
+    local name=$1 start end status stats user sys rss blocks_in blocks_out ok=true metrics=""
+    shift
+    start=$(date +%s%3N)
+    echo "@@STAGE {\"event\":\"started\",\"stage\":\"$name\",\"ts_ms\":$start}"
+    if [ -x /usr/bin/time ]; then
+        stats=$(mktemp)
+        /usr/bin/time -o "$stats" -f '%U %S %M %I %O' "$@"
+        status=$?
+        read -r user sys rss blocks_in blocks_out < <(tail -n 1 "$stats")
+        rm -f "$stats"
+        if [[ "$rss$blocks_in$blocks_out" =~ ^[0-9]+$ ]]; then
+            metrics=$(awk -v u="$user" -v s="$sys" 'BEGIN { printf ",\"cpu_ms\":%.0f", (u + s) * 1000 }')
+            metrics+=",\"peak_rss_kb\":$rss,\"read_bytes\":$((blocks_in * 512)),\"written_bytes\":$((blocks_out * 512))"
+        fi
+    else
+        "$@"
+        status=$?
+    fi
+    end=$(date +%s%3N)
+    [ $status -eq 0 ] || ok=false
+    echo "@@STAGE {\"event\":\"finished\",\"stage\":\"$name\",\"ok\":$ok,\"ts_ms\":$end,\"start_ms\":$start$metrics}"
+    return $status
+}
+)SCRIPT";
+
+// Checkpoints of the chroot stages. BuildPipeline passes the stages that
+// needn't run again in DONE_STAGES and the key of every stage in
+// KEY_<stage>; a stage that finishes reports its key back.
+const char* CHECKPOINT_FUNCTIONS = R"SCRIPT(
+stage_done() {
+    [[ " $DONE_STAGES " == *" $1 "* ]]
+}
+
+checkpoint() {
+    local key="KEY_$1"
+    echo "@@STAGE {\"event\":\"artifact\",\"stage\":\"$1\",\"kind\":\"checkpoint\",\"value\":\"${!key}\"}"
+}
+)SCRIPT";
+
+const char* SETUP_OUTPUT_SCRIPT = R"SCRIPT(#!/bin/bash
+@RUN_STAGE_FUNCTION@
+mkdir -p ~/custom_iso
+
+# The builder image made by the GUI comes with these installed
+if [ "@INSTALL_TOOLS@" = "1" ]; then
+    run_stage apt bash -c "apt-get update && apt-get install -y squashfs-tools xorriso isolinux syslinux-utils genisoimage e2fsprogs time"
+fi
+)SCRIPT";
+
+// Prepares the chroot: the ISO tree, the root filesystem on an overlay, its
+// mounts and the agent that runs the GUI's scripts in it
+const char* SETUP_CHROOT_SCRIPT = R"SCRIPT(#!/bin/bash
+@RUN_STAGE_FUNCTION@
+@CHECKPOINT_FUNCTIONS@
+echo "Starting setup_chroot.sh..."
+SELECTED_FS="@SELECTED_FS@"
+
+if stage_done iso_tree; then
+    echo "ISO tree unchanged since the last run"
+elif [ "@ISO_TREE@" = "2" ]; then
+    # A pooled container has no /base.iso, so the host extracted the
+    # selected filesystem into the bind-mounted ~/custom_iso as well
+    echo "Using ISO tree extracted on the host"
+    checkpoint iso_tree
+elif [ "@ISO_TREE@" = "1" ]; then
+    # The host already extracted everything but the selected filesystem
+    # into the bind-mounted ~/custom_iso
+    echo "Using ISO tree extracted on the host"
+    mkdir -p "$(dirname "/root/custom_iso/$SELECTED_FS")"
+    run_stage extract_fs xorriso -osirrox on -indev /base.iso -extract "/$SELECTED_FS" "/root/custom_iso/$SELECTED_FS" &&
+        checkpoint iso_tree
+else
+    mkdir -p /mnt/iso
+    mountpoint -q /mnt/iso || mount -o loop,ro /base.iso /mnt/iso
+    run_stage copy_iso cp -av /mnt/iso/* ~/custom_iso/ && checkpoint iso_tree
+fi
+
+# Symlinks the host couldn't create (NTFS without the privilege), listed by
+# the extractor as NUL-terminated path and target pairs
+SKIPPED_LINKS=/root/custom_iso/.linuxisopro-symlinks
+if [ -f "$SKIPPED_LINKS" ]; then
+    echo "Restoring symlinks the host couldn't create"
+    while IFS= read -r -d '' link && IFS= read -r -d '' target; do
+        mkdir -p "$(dirname "/root/custom_iso/$link")"
+        ln -sfn "$target" "/root/custom_iso/$link"
+    done < "$SKIPPED_LINKS"
+    rm -f "$SKIPPED_LINKS"
+fi
+cd /root/custom_iso || exit 1
+SQUASHFS_PATH="/root/custom_iso/$SELECTED_FS"
+echo "Using filesystem: $SQUASHFS_PATH"
+
+if [ ! -f "$SQUASHFS_PATH" ]; then
+    echo "ERROR: Selected filesystem $SQUASHFS_PATH not found!"
+    find . -name "*.squashfs" -o -name "*.sfs" | sort
+    exit 1
+fi
+
+# The chroot runs on an overlay: a copy of the original squashfs, mounted
+# read-only, is the lower layer and every change lands in the upper layer.
+# Both live on a sparse ext4 image, since overlayfs can't put its upper
+# layer on the container's own overlay root or on the bind mount.
+OVERLAY_DIR=/overlay
+mkdir -p "$OVERLAY_DIR" squashfs-root
+if [ -f /overlay.img ] && ! mountpoint -q "$OVERLAY_DIR"; then
+    mount -o loop /overlay.img "$OVERLAY_DIR"
+fi
+
+mount_overlay() {
+    { mountpoint -q "$OVERLAY_DIR/lower" ||
+        mount -t squashfs -o loop,ro "$OVERLAY_DIR/base.squashfs" "$OVERLAY_DIR/lower"; } &&
+    mount -t overlay overlay \
+        -o "lowerdir=$OVERLAY_DIR/lower,upperdir=$OVERLAY_DIR/upper,workdir=$OVERLAY_DIR/work" squashfs-root
+}
+
+# The chroot of an interrupted build is mounted again as it was, changes
+# included; one from an extracted filesystem is still in place
+if stage_done rootfs &&
+    { mountpoint -q squashfs-root || { [ -f "$OVERLAY_DIR/base.squashfs" ] && mount_overlay; } ||
+        [ -e squashfs-root/bin ]; }; then
+    echo "Reusing the chroot of the last run"
+else
+    # Start from the original filesystem. Whatever is still mounted in the
+    # old chroot, such as the ISO tree on output, must not be deleted.
+    umount -R -l squashfs-root 2>/dev/null
+    umount "$OVERLAY_DIR/lower" 2>/dev/null
+    rm -rf --one-file-system squashfs-root "$OVERLAY_DIR/lower" "$OVERLAY_DIR/upper" "$OVERLAY_DIR/work" \
+        "$OVERLAY_DIR/base.squashfs"
+    mkdir -p squashfs-root
+    if ! mountpoint -q "$OVERLAY_DIR"; then
+        truncate -s 64G /overlay.img && mkfs.ext4 -q -F /overlay.img && mount -o loop /overlay.img "$OVERLAY_DIR"
+    fi
+    mkdir -p "$OVERLAY_DIR/lower" "$OVERLAY_DIR/upper" "$OVERLAY_DIR/work"
+    if mountpoint -q "$OVERLAY_DIR" &&
+        run_stage copy_squashfs cp "$SQUASHFS_PATH" "$OVERLAY_DIR/base.squashfs" &&
+        mount_overlay; then
+        echo "Chroot is on an overlay of $SQUASHFS_PATH"
+        checkpoint rootfs
+    else
+        echo "Overlay not available, extracting the filesystem instead"
+        umount "$OVERLAY_DIR/lower" 2>/dev/null
+        rm -f "$OVERLAY_DIR/base.squashfs"
+        run_stage unsquashfs unsquashfs -f -d squashfs-root "$SQUASHFS_PATH" && checkpoint rootfs || exit 1
+    fi
+fi
+
+mountpoint -q squashfs-root/proc || mount -t proc none squashfs-root/proc
+mountpoint -q squashfs-root/sys || mount -t sysfs none squashfs-root/sys
+mountpoint -q squashfs-root/dev || mount -o bind /dev squashfs-root/dev
+mountpoint -q squashfs-root/dev/pts || mount -o bind /dev/pts squashfs-root/dev/pts
+
+mkdir -p squashfs-root/output
+
+mountpoint -q squashfs-root/output || mount --bind ~/custom_iso squashfs-root/output
+
+if [ -L "squashfs-root/etc/resolv.conf" ]; then
+    rm -f squashfs-root/etc/resolv.conf
+fi
+cp /etc/resolv.conf squashfs-root/etc/
+
+# The agent lives on a tmpfs over /run, so neither the upper layer nor a
+# full rebuild picks it up; earlier versions left it in /usr/local/sbin
+rm -f squashfs-root/usr/local/sbin/linuxisopro-agent
+mkdir -p squashfs-root/run
+mountpoint -q squashfs-root/run || mount -t tmpfs -o mode=0755 none squashfs-root/run
+cat > squashfs-root/run/linuxisopro-agent << 'AGENT_EOF'
+#!/bin/bash
+# Runs scripts for the LinuxISOPro GUI, several at a time. Requests on
+# stdin are "<id> <bytes>\n<script>" to run a script and "<id> -\n" to
+# stop one. Each reply is one line: "<id> O <text>" or "<id> E <text>" for
+# a line of stdout or stderr, "<id> X <status>" once the script exited.
+LC_ALL=C
+export -n LC_ALL
+set -m
+declare -A running
+
+emit() {
+    local line part parts
+    while IFS= read -r line || [ -n "$line" ]; do
+        IFS=$'\r' read -ra parts <<< "$line"
+        for part in "${parts[@]}"; do
+            [ -n "$part" ] && printf '%s %s %s\n' "$1" "$2" "${part:0:4000}"
+        done
+    done
+}
+
+run() {
+    local dir status
+    dir=$(mktemp -d) && mkfifo "$dir/out" "$dir/err" || { printf '%s X 126\n' "$1"; return; }
+    emit "$1" O < "$dir/out" &
+    emit "$1" E < "$dir/err" &
+    bash -c "$2" > "$dir/out" 2> "$dir/err" < /dev/null
+    status=$?
+    wait
+    rm -rf "$dir"
+    printf '%s X %s\n' "$1" "$status"
+}
+
+# Forgets the scripts that exited, their process group IDs may be reused
+prune() {
+    local id live
+    live=$'\n'"$(jobs -pr)"$'\n'
+    for id in "${!running[@]}"; do
+        [[ $live == *$'\n'"${running[$id]}"$'\n'* ]] || unset "running[$id]"
+    done
+}
+
+printf '0 R linuxisopro-agent 1\n'
+while read -r id size; do
+    if [ "$size" = "-" ]; then
+        prune
+        if [ -n "${running[$id]}" ]; then
+            kill -TERM -- "-${running[$id]}" 2>/dev/null && printf '%s X 143\n' "$id"
+            unset "running[$id]"
+        fi
+        continue
+    fi
+    IFS= read -r -N "$size" script || break
+    run "$id" "$script" &
+    running[$id]=$!
+done
+prune
+for pid in "${running[@]}"; do
+    kill -TERM -- "-$pid" 2>/dev/null
+done
+wait
+AGENT_EOF
+
+chmod +x squashfs-root/run/linuxisopro-agent
+echo "Chroot ready"
+)SCRIPT";
+
+// Installs flatpak and Flathub in the chroot. A failure is reported but
+// doesn't fail the build.
+const char* INSTALL_PACKAGES_SCRIPT = R"SCRIPT(#!/bin/bash
+@RUN_STAGE_FUNCTION@
+@CHECKPOINT_FUNCTIONS@
+cd /root/custom_iso || exit 1
+
+if stage_done packages; then
+    echo "Flatpak was set up by the last run"
+    exit 0
+fi
+
+cat > squashfs-root/tmp/install_flatpak.sh << 'EOF'
+#!/bin/bash
+set -e
+
+echo "Detecting package manager..."
+if command -v apt-get >/dev/null 2>&1; then
+    echo "Detected apt-get (Debian/Ubuntu/Mint)"
+    apt-get update
+    apt-get install -y flatpak || echo "Failed to install flatpak, continuing anyway"
+elif command -v pacman >/dev/null 2>&1; then
+    echo "Detected pacman (Arch/Manjaro)"
+    mkdir -p /var/cache/pacman/pkg
+    if ! pacman-key --list-keys >/dev/null 2>&1; then
+        pacman-key --init
+        pacman-key --populate archlinux
+    fi
+    pacman -Sy --needed --noconfirm flatpak || echo "Failed to install flatpak, continuing anyway"
+elif command -v dnf >/dev/null 2>&1; then
+    echo "Detected dnf (Fedora/RHEL)"
+    dnf -y install flatpak || echo "Failed to install flatpak, continuing anyway"
+elif command -v zypper >/dev/null 2>&1; then
+    echo "Detected zypper (openSUSE)"
+    zypper --non-interactive install flatpak || echo "Failed to install flatpak, continuing anyway"
+elif command -v apk >/dev/null 2>&1; then
+    echo "Detected apk (Alpine)"
+    apk add flatpak || echo "Failed to install flatpak, continuing anyway"
+elif command -v xbps-install >/dev/null 2>&1; then
+    echo "Detected xbps-install (Void)"
+    xbps-install -y flatpak || echo "Failed to install flatpak, continuing anyway"
+else
+    echo "Unknown package manager. Cannot install packages."
+fi
+
+if command -v flatpak >/dev/null 2>&1; then
+    echo "Setting up Flathub repository..."
+    flatpak remote-add --if-not-exists flathub https://flathub.org/repo/flathub.flatpakrepo || \
+    echo "Failed to add Flathub, continuing anyway"
+else
+    echo "Flatpak not found, skipping Flathub setup"
+fi
+EOF
+
+chmod +x squashfs-root/tmp/install_flatpak.sh
+
+echo "Attempting to install flatpak..."
+if run_stage flatpak chroot squashfs-root /tmp/install_flatpak.sh; then
+    checkpoint packages
+else
+    echo "Package installation failed, continuing anyway"
+fi
+exit 0
+)SCRIPT";
+
+// Prints "Detected GUI environment: <name>" for the desktop installed in
+// the chroot
+const char* DETECT_GUI_SCRIPT = R"SCRIPT(#!/bin/bash
+echo "Detecting the GUI environment in the chroot environment..."
+chroot /root/custom_iso/squashfs-root /bin/bash -c '
+    declare -A GUI_ENV_MAP=(
+        ["GNOME"]="/usr/bin/gnome-shell"
+        ["KDE"]="/usr/bin/plasmashell"
+        ["Plasma"]="/usr/bin/plasmashell"
+        ["XFCE"]="/usr/bin/xfwm4"
+        ["LXDE"]="/usr/bin/lxsession"
+        ["LXQt"]="/usr/bin/lxqt-session"
+        ["Cinnamon"]="/usr/bin/cinnamon-session"
+        ["MATE"]="/usr/bin/mate-session"
+        ["Enlightenment"]="/usr/bin/enlightenment"
+        ["i3"]="/usr/bin/i3"
+        ["Sway"]="/usr/bin/sway"
+        ["Awesome"]="/usr/bin/awesome"
+        ["bspwm"]="/usr/bin/bspwm"
+    )
+
+    SESSION_NAME="Unknown"
+
+    for ENV in "${!GUI_ENV_MAP[@]}"; do
+        DETECT_PATH=${GUI_ENV_MAP[$ENV]}
+        if [ -f "$DETECT_PATH" ]; then
+            SESSION_NAME=$ENV
+            break
+        fi
+    done
+
+    if [ "$SESSION_NAME" == "Unknown" ]; then
+        for xsessions_dir in /usr/share/xsessions /etc/X11/sessions /usr/local/share/xsessions; do
+            if [ -d "$xsessions_dir" ] && [ "$(ls -A $xsessions_dir 2>/dev/null)" ]; then
+                SESSION_NAME=$(grep -m 1 "Name=" $xsessions_dir/*.desktop 2>/dev/null | cut -d"=" -f2 | head -n 1)
+                [ -n "$SESSION_NAME" ] && break
+            fi
+        done
+    fi
+
+    if [ "$SESSION_NAME" == "Unknown" ]; then
+        for wm in i3 sway dwm spectrwm openbox fluxbox icewm jwm; do
+            if command -v $wm >/dev/null 2>&1; then
+                SESSION_NAME=$wm
+                break
+            fi
+        done
+    fi
+
+    [ -z "$SESSION_NAME" ] && SESSION_NAME="Unknown"
+
+    echo "Detected GUI environment: $SESSION_NAME"
+    echo "$SESSION_NAME" > /output/detected_gui.txt
+'
+)SCRIPT";
+
+const char* CREATE_ISO_SCRIPT = R"SCRIPT(#!/bin/bash
+@RUN_STAGE_FUNCTION@
+echo "Starting create_iso.sh..."
+
+# Arguments: "--delta" to pack only what changed when the live system can
+# stack it on the original filesystem, then the compressor, block size and
+# thread count of the chosen build profile for mksquashfs
+DELTA=0
+if [ "$1" = "--delta" ]; then
+    DELTA=1
+    shift
+fi
+MKSQUASHFS_ARGS=("$@")
+if [ ${#MKSQUASHFS_ARGS[@]} -eq 0 ]; then
+    MKSQUASHFS_ARGS=(-comp xz -processors "$(nproc)")
+fi
+
+WORKDIR=~/custom_iso
+echo "Changing to the working directory: $WORKDIR"
+cd "$WORKDIR" || { echo "Failed to change to $WORKDIR"; exit 1; }
+
+SQUASHFS_PATH="@SELECTED_FS@"
+SQUASHFS_DIR=$(dirname "$SQUASHFS_PATH")
+# Classic casper mounts every casper/*.squashfs, later names on top of
+# earlier ones. Layered ISOs (minimal.squashfs, minimal.standard.squashfs,
+# ...) mount only the layers their boot entries name in layerfs-path and
+# would silently ignore the changes, so they always get a full rebuild.
+DELTA_PATH="$SQUASHFS_DIR/zz-changes.squashfs"
+CLASSIC_CASPER=0
+if [ "$SQUASHFS_PATH" = "casper/filesystem.squashfs" ] &&
+    ! grep -rqs "layerfs-path" boot isolinux EFI 2>/dev/null; then
+    CLASSIC_CASPER=1
+fi
+echo "mksquashfs options: ${MKSQUASHFS_ARGS[*]}"
+
+# The chroot stays mounted, so the ISO can be rebuilt after more changes
+ON_OVERLAY=0
+if [ "$(findmnt -n -o FSTYPE --mountpoint "$WORKDIR/squashfs-root")" = "overlay" ]; then
+    ON_OVERLAY=1
+fi
+
+if [ $DELTA -eq 1 ] && [ $ON_OVERLAY -eq 1 ] && [ $CLASSIC_CASPER -eq 1 ]; then
+    # The upper layer holds exactly the changes, deletions included as
+    # overlayfs whiteouts, so this takes time in proportion to them
+    echo "Packing the changes into $DELTA_PATH"
+    run_stage mksquashfs mksquashfs /overlay/upper "$DELTA_PATH" -noappend -xattrs "${MKSQUASHFS_ARGS[@]}" || { echo "Failed to create squashfs"; exit 1; }
+else
+    if [ $DELTA -eq 1 ]; then
+        echo "Delta builds need the overlay chroot and a classic casper/filesystem.squashfs ISO, rebuilding the whole filesystem"
+    fi
+    echo "Rebuilding filesystem: $SQUASHFS_PATH"
+    # -e takes the rest of the arguments, so it comes last
+    run_stage mksquashfs mksquashfs squashfs-root "$SQUASHFS_PATH.new" -noappend "${MKSQUASHFS_ARGS[@]}" \
+        -wildcards -e 'proc/*' 'sys/*' 'dev/*' 'run/*' 'output/*' || { echo "Failed to create squashfs"; exit 1; }
+    mv -f "$SQUASHFS_PATH.new" "$SQUASHFS_PATH" || { echo "Failed to replace $SQUASHFS_PATH"; exit 1; }
+    rm -f "$DELTA_PATH"
+fi
+
+if [ -d casper ]; then
+    echo "Updating filesystem.size..."
+    run_stage filesystem_size bash -c "du -sx --block-size=1 squashfs-root | cut -f1 > casper/filesystem.size" || { echo "Failed to update filesystem.size"; exit 1; }
+fi
+
+echo "Creating the ISO using xorriso..."
+run_stage xorriso xorriso -as mkisofs \
+    -r -V "Custom Linux Mint" \
+    -J -l \
+    -b isolinux/isolinux.bin -c isolinux/boot.cat \
+    -no-emul-boot -boot-load-size 4 -boot-info-table \
+    -eltorito-alt-boot \
+    -e EFI/boot/bootx64.efi -no-emul-boot \
+    -m squashfs-root -m custom_linuxmint.iso \
+    -o custom_linuxmint.iso . || { echo "Failed to create ISO"; exit 1; }
+
+echo "Verifying the ISO file..."
+if [ ! -f custom_linuxmint.iso ]; then
+    echo "ISO file not found."
+    exit 1
+fi
+
+ISO_SIZE=$(du -h custom_linuxmint.iso | cut -f1)
+echo "ISO file created successfully. Size: $ISO_SIZE"
+
+if command -v isohybrid >/dev/null 2>&1; then
+    echo "Making the ISO hybrid using isohybrid..."
+    run_stage isohybrid isohybrid --uefi custom_linuxmint.iso || echo "Failed to make ISO hybrid (optional step)."
+else
+    echo "isohybrid command not found, skipping hybridization step."
+fi
+
+echo '@@STAGE {"event":"artifact","stage":"iso","kind":"iso","value":"/root/custom_iso/custom_linuxmint.iso"}'
+
+echo "create_iso.sh completed successfully."
+)SCRIPT";
@@ -7,6 +7,10 @@
 extern const char* SETUP_CHROOT_SCRIPT;
 extern const char* CREATE_ISO_SCRIPT;
 extern const char* SETUP_OUTPUT_SCRIPT;
+extern const char* INSTALL_PACKAGES_SCRIPT;
+extern const char* DETECT_GUI_SCRIPT;
+extern const char* RUN_STAGE_FUNCTION;
+extern const char* CHECKPOINT_FUNCTIONS;
 
 ScriptManager& ScriptManager::Get() {
     static ScriptManager instance;
@@ -22,7 +26,9 @@ void ScriptManager::InitializeScripts() {
     m_scriptContents = {
         {"setup_chroot.sh", SETUP_CHROOT_SCRIPT},
         {"create_iso.sh", CREATE_ISO_SCRIPT},
-        {"setup_output.sh", SETUP_OUTPUT_SCRIPT}
+        {"setup_output.sh", SETUP_OUTPUT_SCRIPT},
+        {"install_packages.sh", INSTALL_PACKAGES_SCRIPT},
+        {"detect_gui.sh", DETECT_GUI_SCRIPT}
     };
 }
 
@@ -60,10 +66,27 @@ bool ScriptManager::ExtractScriptToTemp(const wxString& scriptName) {
     }
     
     wxString path = GetTempScriptPath(scriptName);
-    return WriteScriptToFile(path, it->second);
+    return WriteScriptToFile(path, Render(scriptName));
 }
 
 wxString ScriptManager::GetTempScriptPath(const wxString& scriptName) const {
     return m_tempDir + wxFileName::GetPathSeparator() + scriptName;
 }
 
+wxString ScriptManager::Render(const wxString& scriptName, const std::map<wxString, wxString>& values) const {
+    auto it = m_scriptContents.find(scriptName);
+    if (it == m_scriptContents.end()) {
+        wxLogError("Unknown script: %s", scriptName);
+        return wxEmptyString;
+    }
+
+    wxString content = it->second;
+    content.Replace("@RUN_STAGE_FUNCTION@", RUN_STAGE_FUNCTION);
+    content.Replace("@CHECKPOINT_FUNCTIONS@", CHECKPOINT_FUNCTIONS);
+    for (const auto& value : values) {
+        content.Replace("@" + value.first + "@", value.second);
+    }
+    // bash chokes on carriage returns, which a Windows checkout may add
+    content.Replace("\r\n", "\n");
+    return content;
+}
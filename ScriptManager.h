@@ -12,6 +12,11 @@ public:
     bool ExtractScriptToTemp(const wxString& scriptName);
     wxString GetTempScriptPath(const wxString& scriptName) const;
 
+    // Content of an embedded script with its @NAME@ placeholders filled in:
+    // the shared shell functions, then the given values. Empty for an
+    // unknown script.
+    wxString Render(const wxString& scriptName, const std::map<wxString, wxString>& values = {}) const;
+
 private:
     ScriptManager();
     wxString m_tempDir;
@@ -3,9 +3,16 @@
 #include "MongoDBPanel.h" // <<< Include the separated header
 #include "WindowIDs.h"    // <<< Ensure this includes ID_MONGODB_PANEL_CLOSE
 #include "CustomEvents.h" // <<< Include for FILE_COPY_COMPLETE_EVENT etc.
+#include "ISOExtractor.h"
+#include "BuilderImage.h"
+#include "ContainerReaper.h"
+#include "BuildStage.h"
+#include "ArtifactDownloadThread.h"
+#include "BuildTimelineDialog.h"
+#include "DockerClient.h"
+#include "SettingsManager.h"
 #include <wx/utils.h>
 #include <wx/statline.h>
-#include <wx/process.h>
 #include <wx/dcbuffer.h>
 #include <wx/filename.h>
 #include <wx/file.h>
@@ -17,6 +24,7 @@
 #include <fstream>       // For std::ifstream (used indirectly)
 #include <sstream>       // For std::stringstream (used indirectly)
 #include <string>        // For std::string
+#include <memory>        // For std::unique_ptr
 #include <wx/graphics.h> // For wxGraphicsContext in OverlayFrame
 
 // MongoDB includes needed by SecondWindow (minimal if panel handles logic)
@@ -35,148 +43,8 @@
 // Initialize static member
 mongocxx::instance SecondWindow::m_mongoInstance{};
 
-//---------------------------------------------------------------------
-// PythonProcess class
-class PythonProcess : public wxProcess
-{
-public:
-    PythonProcess(SecondWindow *parent) : wxProcess(parent), m_parent(parent) {}
-
-    virtual void OnTerminate(int pid, int status) override
-    {
-        if (m_parent)
-        {
-            m_parent->CloseOverlay();
-            wxString containerIdPath = wxFileName(m_parent->GetProjectDir(), "container_id.txt").GetFullPath();
-            wxFile file;
-            if (file.Open(containerIdPath))
-            {
-                wxString containerId;
-                file.ReadAll(&containerId);
-                containerId.Trim();
-
-                // Update FlatpakStore and SQLTab if they exist
-                if (m_parent->GetFlatpakStore())
-                {
-                    m_parent->GetFlatpakStore()->SetContainerId(containerId);
-                    wxLogDebug("Updated FlatpakStore container ID in SecondWindow: %s", containerId);
-                }
-                if (m_parent->GetSQLTab())
-                {
-                    m_parent->GetSQLTab()->SetContainerId(containerId);
-                    wxLogDebug("Updated SQLTab container ID: %s", containerId);
-                }
-
-                // Detect GUI Environment
-                wxString guiDetectCommand = wxString::Format("docker exec %s cat /root/custom_iso/detected_gui.txt", containerId);
-                wxArrayString output, errors;
-                int exitCode = wxExecute(guiDetectCommand, output, errors, wxEXEC_SYNC | wxEXEC_HIDE_CONSOLE);
-
-                if (exitCode == 0 && !output.IsEmpty())
-                {
-                    wxString guiName = output[0];
-                    guiName.Trim(true).Trim(false);
-                    guiName.Replace("\n", ""); // Clean up potential newline
-
-                    wxLogDebug("Detected GUI environment before event: %s", guiName);
-
-                    // Save GUI name locally
-                    wxString localGuiPath = wxFileName(m_parent->GetProjectDir(), "detected_gui.txt").GetFullPath();
-                    wxFile guiFile;
-                    if (guiFile.Create(localGuiPath, true) && guiFile.IsOpened())
-                    {
-                        guiFile.Write(guiName);
-                        guiFile.Close();
-                        wxLogDebug("GUI name saved to file: %s", localGuiPath);
-                    }
-
-                    // Notify DesktopTab
-                    if (m_parent->GetDesktopTab())
-                    {
-                        wxCommandEvent *guiEvent = new wxCommandEvent(FILE_COPY_COMPLETE_EVENT);
-                        guiEvent->SetString(guiName);
-                        wxLogDebug("Posting event with GUI name: %s", guiName);
-                        wxPostEvent(m_parent->GetDesktopTab(), *guiEvent);
-                        delete guiEvent; // Clean up the event object
-                    }
-                }
-                else
-                {
-                    wxLogError("Failed to detect GUI environment or no output. ExitCode: %d", exitCode);
-                }
-                // Execute initial command in terminal if applicable
-                m_parent->ExecuteDockerCommand(containerId);
-            }
-            else
-            {
-                wxLogError("Could not open container_id.txt file: %s", containerIdPath);
-            }
-        }
-    }
-
-private:
-    SecondWindow *m_parent;
-};
-//---------------------------------------------------------------------
-
-//---------------------------------------------------------------------
-// DockerExecProcess class
-class DockerExecProcess : public wxProcess
-{
-public:
-    DockerExecProcess(SecondWindow *parent) : wxProcess(parent), m_parent(parent) {}
-
-    virtual void OnTerminate(int pid, int status) override
-    {
-        if (m_parent)
-        {
-            m_parent->CloseOverlay();
-            if (status == 0)
-            {
-                wxString containerIdPath = wxFileName(m_parent->GetProjectDir(), "container_id.txt").GetFullPath();
-                wxFile file;
-                if (file.Open(containerIdPath))
-                {
-                    wxString containerId;
-                    file.ReadAll(&containerId);
-                    containerId.Trim();
-
-                    wxString sourcePath = wxString::Format("%s:/root/custom_iso/custom_linuxmint.iso", containerId);
-                    wxString destPath = m_parent->GetProjectDir();
-                    wxString copyCommand = wxString::Format("docker cp \"%s\" \"%s\"", sourcePath, destPath);
-                    int copyStatus = wxExecute(copyCommand, wxEXEC_SYNC | wxEXEC_HIDE_CONSOLE);
-
-                    if (copyStatus == 0)
-                    {
-                        wxMessageBox("ISO created and copied to project directory successfully!", "Success", wxOK | wxICON_INFORMATION);
-                    }
-                    else
-                    {
-                        wxMessageBox("ISO creation succeeded but failed to copy to host.", "Error", wxICON_ERROR);
-                    }
-                }
-                else
-                {
-                    wxLogError("Could not open container_id.txt during ISO copy phase.");
-                    wxMessageBox("ISO creation succeeded but failed read container ID to copy.", "Error", wxICON_ERROR);
-                }
-            }
-            else
-            {
-                wxLogError("ISO creation process failed with status: %d", status);
-                wxMessageBox("ISO creation process failed!", "Error", wxICON_ERROR);
-            }
-            // Re-enable the 'Next' button regardless of success/failure
-            wxButton *nextButton = wxDynamicCast(m_parent->FindWindow(ID_NEXT_BUTTON), wxButton);
-            if (nextButton)
-                nextButton->Enable();
-        }
-    }
-
-private:
-    SecondWindow *m_parent;
-};
-//---------------------------------------------------------------------
+wxDEFINE_EVENT(ISO_EXTRACT_COMPLETE, wxCommandEvent);
+wxDEFINE_EVENT(BUILDER_IMAGE_READY, wxCommandEvent);
 
 //---------------------------------------------------------------------
 // OverlayFrame class
@@ -211,6 +79,13 @@ public:
         Show(true);
     }
 
+    // Line shown under the animation, e.g. copy progress
+    void SetStatus(const wxString &status)
+    {
+        m_status = status;
+        Refresh();
+    }
+
     ~OverlayFrame()
     {
         // Unbind events when the overlay is destroyed
@@ -261,6 +136,15 @@ private:
 
         // Draw the loading animation centered
         DrawLoadingAnimation(dc, size);
+
+        if (!m_status.IsEmpty())
+        {
+            dc.SetTextForeground(*wxWHITE);
+            wxSize textSize = dc.GetTextExtent(m_status);
+            int radius = std::min(size.GetWidth(), size.GetHeight()) / 6;
+            dc.DrawText(m_status, (size.GetWidth() - textSize.GetWidth()) / 2,
+                        size.GetHeight() / 2 + radius + radius / 2);
+        }
     }
 
     // *** Uses the OLD DrawLoadingAnimation logic ***
@@ -294,6 +178,7 @@ private:
     }
 
     double m_animationAngle;
+    wxString m_status;
     wxTimer m_timer;
     wxWindow *m_parentWindow; // Pointer to the window this overlay covers
 };
@@ -302,39 +187,85 @@ private:
 // Event table for SecondWindow
 wxBEGIN_EVENT_TABLE(SecondWindow, wxFrame)
     EVT_CLOSE(SecondWindow::OnClose)
-        EVT_TIMER(wxID_ANY, SecondWindow::OnCloseTimer) // Catch any timer event for the close timer
     EVT_BUTTON(ID_TERMINAL_TAB, SecondWindow::OnTabChanged)
         EVT_BUTTON(ID_SQL_TAB, SecondWindow::OnTabChanged)
             EVT_BUTTON(ID_MONGODB_BUTTON, SecondWindow::OnMongoDBButton)  // Handles click on main MongoDB button
     EVT_BUTTON(ID_MONGODB_PANEL_CLOSE, SecondWindow::OnMongoDBPanelClose) // Handles close request *from* the panel
     EVT_BUTTON(ID_NEXT_BUTTON, SecondWindow::OnNext)
+    EVT_CHOICE(ID_BUILD_PROFILE, SecondWindow::OnBuildProfileChanged)
+    EVT_BUTTON(ID_TIMELINE_BUTTON, SecondWindow::OnTimelineButton)
         wxEND_EVENT_TABLE()
 
-    //---------------------------------------------------------------------
-    // ContainerCleanupThread class
-    class ContainerCleanupThread : public wxThread
+//---------------------------------------------------------------------
+// ISOExtractThread class
+// Writes the ISO tree, minus the excluded filesystem if any, into the tree
+// directory. Posts ISO_EXTRACT_COMPLETE with GetInt() != 0 on success.
+class ISOExtractThread : public wxThread
 {
 public:
-    ContainerCleanupThread(const wxString &containerId)
-        : wxThread(wxTHREAD_DETACHED), m_containerId(containerId) {}
+    ISOExtractThread(wxEvtHandler *handler, const wxString &isoPath, const wxString &treeDir,
+                     const wxString &excludePath, std::atomic<bool> &cancel)
+        : wxThread(wxTHREAD_JOINABLE), m_handler(handler), m_isoPath(isoPath.Clone()),
+          m_treeDir(treeDir.Clone()), m_excludePath(excludePath.Clone()), m_cancel(cancel) {}
 
 protected:
     virtual ExitCode Entry() override
     {
-        wxLogDebug("ContainerCleanupThread::Entry - Starting cleanup thread for container: %s", m_containerId);
-        if (m_containerId.IsEmpty())
+        ISOExtractor::Options options;
+        if (!m_excludePath.IsEmpty())
+            options.exclude.push_back(m_excludePath.ToStdString());
+        options.progress = [this](std::uint64_t, std::uint64_t)
         {
-            wxLogDebug("ContainerCleanupThread::Entry - Container ID is empty, exiting thread.");
-            return (ExitCode)0;
-        }
-        // Use ContainerManager to perform cleanup
-        ContainerManager::Get().CleanupContainer(m_containerId);
-        wxLogDebug("ContainerCleanupThread::Entry - Cleanup thread finished for container: %s", m_containerId);
+            return !m_cancel && !TestDestroy();
+        };
+
+        ISOExtractor extractor(m_isoPath.ToStdString(), options);
+        const bool ok = extractor.extractTo(m_treeDir.ToStdString());
+
+        wxCommandEvent event(ISO_EXTRACT_COMPLETE);
+        event.SetInt(ok ? 1 : 0);
+        event.SetString(ok ? wxString() : wxString::FromUTF8(extractor.getLastError().c_str()));
+        wxQueueEvent(m_handler, event.Clone());
+        return (ExitCode)0;
+    }
+
+private:
+    wxEvtHandler *m_handler;
+    wxString m_isoPath;
+    wxString m_treeDir;
+    wxString m_excludePath;
+    std::atomic<bool> &m_cancel;
+};
+//---------------------------------------------------------------------
+
+//---------------------------------------------------------------------
+// BuilderImageThread class
+// Makes sure the builder image exists, building it if needed. Posts
+// BUILDER_IMAGE_READY with the tag, or an empty string if there is none.
+class BuilderImageThread : public wxThread
+{
+public:
+    BuilderImageThread(wxEvtHandler *handler, std::atomic<bool> &cancel)
+        : wxThread(wxTHREAD_JOINABLE), m_handler(handler), m_cancel(cancel) {}
+
+protected:
+    virtual ExitCode Entry() override
+    {
+        auto onLine = [](int, const wxString &line)
+        {
+            wxLogDebug("Builder image: %s", line);
+        };
+        const bool ok = BuilderImage::Ensure(onLine, &m_cancel);
+
+        wxCommandEvent event(BUILDER_IMAGE_READY);
+        event.SetString(ok ? BuilderImage::Tag() : wxString());
+        wxQueueEvent(m_handler, event.Clone());
         return (ExitCode)0;
     }
 
 private:
-    wxString m_containerId;
+    wxEvtHandler *m_handler;
+    std::atomic<bool> &m_cancel;
 };
 //---------------------------------------------------------------------
 
@@ -352,7 +283,6 @@ SecondWindow::SecondWindow(wxWindow *parent,
                   wxMAXIMIZE_BOX | wxRESIZE_BORDER),
       m_isoPath(isoPath),
       m_projectDir(projectDir),
-      m_threadRunning(false),
       m_overlay(nullptr),
       m_desktopTab(desktopTab), // Store the passed DesktopTab pointer
       m_terminalTab(nullptr),   // Initialize pointers
@@ -360,9 +290,22 @@ SecondWindow::SecondWindow(wxWindow *parent,
       m_terminalPanel(nullptr),
       m_flatpakStore(nullptr), // Initialize FlatpakStore pointer
       m_mongoPanel(nullptr),
-      m_cleanupThread(nullptr),
+      m_extractThread(nullptr),
+      m_extractCancel(false),
+      m_builderThread(nullptr),
+      m_builderCancel(false),
+      m_extractPending(false),
+      m_builderPending(false),
+      m_pipeline(projectDir),
+      m_backendThread(nullptr),
+      m_containerReady(false),
+      m_isoThread(nullptr),
+      m_profileChoice(nullptr),
+      m_downloadThread(nullptr),
+      m_timeline(BuildTimeline::NewPath(projectDir)),
+      m_isoRuns(0),
+      m_timelineDialog(nullptr),
       m_isClosing(false),
-      m_closeTimer(nullptr),
       m_lastTab(nullptr)
 #ifdef __WXMSW__
       ,
@@ -387,18 +330,40 @@ SecondWindow::SecondWindow(wxWindow *parent,
     m_lastTab = m_terminalTab;                 // Set initial last visible tab
     Show(true);
 
-    // Show overlay while Python script runs
+    // Show overlay while the backend sets up the container
     m_overlay = new OverlayFrame(this);
 
-    // Start the backend Python process
-    StartPythonExecutable();
+    Bind(ISO_EXTRACT_COMPLETE, &SecondWindow::OnISOExtractComplete, this);
+    Bind(BUILDER_IMAGE_READY, &SecondWindow::OnBuilderImageReady, this);
+    Bind(BUILD_STAGE, &SecondWindow::OnBackendStage, this, ID_BACKEND_EXEC);
+    Bind(DOCKER_EXEC_OUTPUT, &SecondWindow::OnBackendOutput, this, ID_BACKEND_EXEC);
+    Bind(DOCKER_EXEC_COMPLETE, &SecondWindow::OnBackendComplete, this, ID_BACKEND_EXEC);
+    Bind(BUILD_STAGE, &SecondWindow::OnCreateISOStage, this, ID_CREATE_ISO_EXEC);
+    Bind(DOCKER_EXEC_COMPLETE, &SecondWindow::OnCreateISOComplete, this, ID_CREATE_ISO_EXEC);
+    Bind(ARTIFACT_DOWNLOAD_PROGRESS, &SecondWindow::OnArtifactDownloadProgress, this);
+    Bind(ARTIFACT_DOWNLOAD_COMPLETE, &SecondWindow::OnArtifactDownloadComplete, this);
+
+    // Extract the ISO tree on the host and prepare the builder image, then
+    // start the backend. A container from the warm pool
+    // already runs the image. A build of this project that was interrupted
+    // resumes in the container it had instead, if the backend finds it.
+    m_pipeline.Load();
+    PipelineState::Stage resumed;
+    if (!m_pipeline.Find("container", resumed))
+        ContainerManager::Get().ClaimPooledContainer(m_pooledContainerId, m_pooledTreeDir);
+    StartISOExtraction();
+    if (m_pooledContainerId.IsEmpty())
+        StartBuilderImage();
+    else
+        m_builderImage = BuilderImage::Tag();
+    StartBackendWhenReady();
 
     // Initialize Windows Terminal if on Windows
 #ifdef __WXMSW__
     if (m_winTerminalManager)
     {
-        // Post-initialization command if needed after Python script provides container ID
-        // This might need to be deferred until OnTerminate of PythonProcess
+        // Post-initialization command if needed after the backend provides container ID
+        // This might need to be deferred until the backend reports the container ready
         // m_winTerminalManager->SendCommand(L"echo Terminal Ready\r\n");
     }
 #endif
@@ -408,46 +373,52 @@ SecondWindow::~SecondWindow()
 {
     wxLogDebug("SecondWindow::~SecondWindow - START");
 
-    // Stop and delete the close timer if it exists
-    if (m_closeTimer)
+    if (m_extractThread)
     {
-        if (m_closeTimer->IsRunning())
-        {
-            m_closeTimer->Stop();
-        }
-        delete m_closeTimer;
-        m_closeTimer = nullptr;
-        wxLogDebug("SecondWindow::~SecondWindow - Closed timer deleted.");
+        m_extractCancel = true;
+        m_extractThread->Wait();
+        delete m_extractThread;
+        m_extractThread = nullptr;
     }
 
-    // Ensure the Python backend thread/process is signaled to stop if applicable
-    CleanupThread(); // (This function might need implementation depending on Python process management)
+    if (m_builderThread)
+    {
+        m_builderCancel = true;
+        m_builderThread->Wait();
+        delete m_builderThread;
+        m_builderThread = nullptr;
+    }
 
-    // Wait for the cleanup thread if it's running
-    if (m_cleanupThread)
+    // Cancelling stops the backend at its current transfer or exec
+    if (m_backendThread)
     {
-        wxLogDebug("SecondWindow::~SecondWindow - Waiting for container cleanup thread to finish.");
-        if (m_cleanupThread->IsRunning())
-        {
-            m_cleanupThread->Wait(); // Block until the thread completes
-        }
-        delete m_cleanupThread; // Delete the thread object
-        m_cleanupThread = nullptr;
-        wxLogDebug("SecondWindow::~SecondWindow - Container cleanup thread finished and deleted.");
+        m_backendThread->Cancel();
+        m_backendThread->Wait();
+        delete m_backendThread;
+        m_backendThread = nullptr;
     }
 
-    // Optional: Explicitly clean up the container if the thread didn't run/finish
-    // This is a fallback, the thread is the preferred way.
-    if (!m_containerId.IsEmpty())
+    if (m_isoThread)
     {
-        // NOTE: Removing synchronous cleanup here as the thread *should* handle it.
-        // If issues arise where containers aren't cleaned up on close, this might be re-added
-        // with careful checks (e.g., check if thread existed and ran).
-        wxLogDebug("SecondWindow::~SecondWindow - Skipping synchronous container cleanup (handled by thread).");
+        m_isoThread->Cancel();
+        m_isoThread->Wait();
+        delete m_isoThread;
+        m_isoThread = nullptr;
     }
-    else
+
+    if (m_downloadThread)
     {
-        wxLogDebug("SecondWindow::~SecondWindow - m_containerId is empty, skipping synchronous cleanup.");
+        m_downloadThread->Cancel();
+        m_downloadThread->Wait();
+        delete m_downloadThread;
+        m_downloadThread = nullptr;
+    }
+
+    // Destroyed without going through OnClose
+    if (!m_containerId.IsEmpty())
+    {
+        ContainerReaper::Get().Remove(m_containerId);
+        m_pipeline.Invalidate("container");
     }
 
 #ifdef __WXMSW__
@@ -471,80 +442,311 @@ void SecondWindow::CloseOverlay()
     }
 }
 
-void SecondWindow::StartPythonExecutable()
+wxString SecondWindow::ReadSelectedFilesystem() const
+{
+    AppSettings settings;
+    SettingsManager settingsManager;
+    if (!settingsManager.LoadSettings(settings, m_projectDir + wxFILE_SEP_PATH + "settings.json"))
+        return wxEmptyString;
+
+    wxString fsFilePath = m_projectDir + wxFILE_SEP_PATH + settings.projectName + "_selected_fs.txt";
+    wxFile file;
+    wxString selected;
+    if (!wxFileExists(fsFilePath) || !file.Open(fsFilePath) || !file.ReadAll(&selected))
+        return wxEmptyString;
+
+    selected = selected.BeforeFirst('\n').Trim(true).Trim(false);
+    if (selected.Contains(" ("))
+        selected = selected.BeforeFirst('(').Trim(true);
+    return selected;
+}
+
+// Extracts everything but the selected filesystem to <project>/iso_tree with
+// several readers in parallel. The container bind-mounts that directory, so
+// it no longer needs a loop mount and a serial copy of the whole tree.
+//
+// A pooled container was created before the ISO was known and can't mount
+// it, so its tree gets the selected filesystem as well. That costs its size
+// in host disk space and extraction time, but spares streaming the whole ISO
+// into the container.
+void SecondWindow::StartISOExtraction()
+{
+    wxString treeDir = GetISOTreeTarget();
+    if (m_projectDir.IsEmpty() || m_isoPath.IsEmpty() || !wxFileExists(m_isoPath))
+        return; // The backend reports the invalid paths
+
+    // The tree of an earlier run is reused while the ISO and the selected
+    // filesystem are the same. Building an ISO changes the tree only where
+    // a new container's setup_chroot.sh restores it.
+    const wxString fingerprint = PipelineState::Fingerprint(m_isoPath);
+    m_extractKey = fingerprint.IsEmpty() ? wxString()
+                                         : PipelineState::Key({"extract_iso", fingerprint, ReadSelectedFilesystem()});
+    PipelineState::Stage checkpoint;
+    if (m_pooledTreeDir.IsEmpty() && m_pipeline.IsCurrent("extract_iso", m_extractKey) &&
+        m_pipeline.Find("extract_iso", checkpoint) && wxDirExists(checkpoint.outputs["tree"]))
+    {
+        wxLogMessage("Reusing the ISO tree in %s", checkpoint.outputs["tree"]);
+        m_isoTreeDir = checkpoint.outputs["tree"];
+        return;
+    }
+    m_pipeline.Invalidate("extract_iso");
+
+    // A previous build leaves its output ISO in the tree. A pooled tree is
+    // still empty, and removing it would detach it from the container.
+    if (m_pooledTreeDir.IsEmpty() && wxDirExists(treeDir) && !wxFileName::Rmdir(treeDir, wxPATH_RMDIR_RECURSIVE))
+    {
+        wxLogWarning("Could not clear %s, copying the ISO tree inside the container instead.", treeDir);
+        return;
+    }
+
+    m_extractCancel = false;
+    const wxString excludePath = m_pooledTreeDir.IsEmpty() ? ReadSelectedFilesystem() : wxString();
+    m_extractThread = new ISOExtractThread(this, m_isoPath, treeDir, excludePath, m_extractCancel);
+    if (m_extractThread->Run() != wxTHREAD_NO_ERROR)
+    {
+        wxLogError("Failed to start ISO extraction thread.");
+        delete m_extractThread;
+        m_extractThread = nullptr;
+        return;
+    }
+    m_extractPending = true;
+    m_timeline.Begin("host", "extract_iso");
+}
+
+void SecondWindow::OnISOExtractComplete(wxCommandEvent &event)
+{
+    if (m_extractThread)
+    {
+        m_extractThread->Wait();
+        delete m_extractThread;
+        m_extractThread = nullptr;
+    }
+    m_extractPending = false;
+    if (m_isClosing)
+    {
+        DestroyWhenIdle();
+        return;
+    }
+    m_timeline.End("host", "extract_iso", event.GetInt() != 0, event.GetString());
+    UpdateTimeline();
+
+    if (event.GetInt())
+    {
+        m_isoTreeDir = GetISOTreeTarget();
+        if (!m_extractKey.IsEmpty())
+            m_pipeline.Record("extract_iso", m_extractKey, {{"tree", m_isoTreeDir}});
+    }
+    else
+        wxLogWarning("Host-side ISO extraction failed (%s), copying inside the container instead.", event.GetString());
+    StartBackendWhenReady();
+}
+
+// A pooled container has its tree directory mounted already
+wxString SecondWindow::GetISOTreeTarget() const
 {
-    wxString pythonExePath = "script.exe"; // Ensure this is in PATH or provide full path
+    if (!m_pooledTreeDir.IsEmpty())
+        return m_pooledTreeDir;
+    return m_projectDir + wxFILE_SEP_PATH + "iso_tree";
+}
 
-    // Check if the executable exists
-    if (!wxFileName::FileExists(pythonExePath))
+void SecondWindow::StartBuilderImage()
+{
+    m_builderCancel = false;
+    m_builderThread = new BuilderImageThread(this, m_builderCancel);
+    if (m_builderThread->Run() != wxTHREAD_NO_ERROR)
     {
-        pythonExePath = wxFileName::GetCwd() + wxFILE_SEP_PATH + "script.exe"; // Try current dir
-        if (!wxFileName::FileExists(pythonExePath))
+        wxLogError("Failed to start builder image thread.");
+        delete m_builderThread;
+        m_builderThread = nullptr;
+        return;
+    }
+    m_builderPending = true;
+    m_timeline.Begin("host", "builder_image");
+}
+
+void SecondWindow::OnBuilderImageReady(wxCommandEvent &event)
+{
+    if (m_builderThread)
+    {
+        m_builderThread->Wait();
+        delete m_builderThread;
+        m_builderThread = nullptr;
+    }
+    m_builderPending = false;
+    if (m_isClosing)
+    {
+        DestroyWhenIdle();
+        return;
+    }
+
+    // Without the image the backend installs the tools in a plain container
+    m_builderImage = event.GetString();
+    m_timeline.End("host", "builder_image", !m_builderImage.IsEmpty());
+    UpdateTimeline();
+    if (m_builderImage.IsEmpty())
+        wxLogWarning("Builder image unavailable, installing the ISO tools in the container instead.");
+    StartBackendWhenReady();
+}
+
+void SecondWindow::StartBackendWhenReady()
+{
+    if (m_extractPending || m_builderPending || m_isClosing)
+        return;
+    StartBuildPipeline();
+}
+
+// Registers the container the backend set up; closing the window removes it
+void SecondWindow::SetContainerId(const wxString &containerId)
+{
+    m_containerId = containerId;
+    ContainerManager::Get().SaveContainerId(containerId, m_isoPath, m_projectDir);
+}
+
+// Stage events of the backend. It reports the container once it runs and
+// the desktop once the chroot is inspected; the backend stage finishing
+// means the container is ready for use.
+void SecondWindow::OnBackendStage(wxCommandEvent &event)
+{
+    std::unique_ptr<BuildStage> stage(static_cast<BuildStage *>(event.GetClientData()));
+    if (!stage || m_isClosing)
+        return;
+
+    if (stage->event == BuildStage::Event::Started || stage->event == BuildStage::Event::Finished)
+    {
+        m_timeline.Record("backend", *stage);
+        UpdateTimeline();
+    }
+
+    switch (stage->event)
+    {
+    case BuildStage::Event::Started:
+        wxLogDebug("Backend stage started: %s", stage->stage);
+        break;
+    case BuildStage::Event::Progress:
+        wxLogDebug("Backend stage %s: %d%% %s", stage->stage, stage->percent, stage->message);
+        break;
+    case BuildStage::Event::Artifact:
+        if (stage->kind == "container")
         {
-            wxMessageBox("Error: script.exe not found!\nPlease ensure it is in the application directory or system PATH.",
-                         "Executable Not Found", wxOK | wxICON_ERROR);
-            CloseOverlay(); // Close overlay if we can't start
-            // Optionally close the window or disable functionality
-            // GetParent()->Close(); // Example: Close the parent (MainFrame)
-            return;
+            SetContainerId(stage->value);
+            if (m_flatpakStore)
+                m_flatpakStore->SetContainerId(stage->value);
+            if (m_sqlTab)
+                m_sqlTab->SetContainerId(stage->value);
         }
+        else if (stage->kind == "gui")
+        {
+            SaveDetectedGui(stage->value);
+        }
+        break;
+    case BuildStage::Event::Finished:
+        wxLogDebug("Backend stage finished: %s (%s)", stage->stage, stage->ok ? "ok" : stage->message);
+        if (stage->stage == "backend" && stage->ok && !m_containerReady)
+        {
+            m_containerReady = true;
+            CloseOverlay();
+            ExecuteDockerCommand(m_containerId);
+        }
+        break;
     }
+}
 
-    // Ensure project and ISO paths are valid before proceeding
-    if (m_projectDir.IsEmpty() || !wxDirExists(m_projectDir))
+void SecondWindow::OnBackendOutput(wxCommandEvent &event)
+{
+    wxLogDebug("[backend] %s", event.GetString());
+}
+
+void SecondWindow::OnBackendComplete(wxCommandEvent &event)
+{
+    if (m_backendThread)
     {
-        wxMessageBox("Error: Project directory is invalid or does not exist.\nPath: " + m_projectDir,
-                     "Invalid Project Directory", wxOK | wxICON_ERROR);
-        CloseOverlay();
-        return;
+        m_backendThread->Wait();
+        delete m_backendThread;
+        m_backendThread = nullptr;
     }
-    if (m_isoPath.IsEmpty() || !wxFileExists(m_isoPath))
+    if (m_isClosing)
     {
-        wxMessageBox("Error: ISO file path is invalid or the file does not exist.\nPath: " + m_isoPath,
-                     "Invalid ISO Path", wxOK | wxICON_ERROR);
-        CloseOverlay();
+        DestroyWhenIdle();
         return;
     }
 
-    wxString command = wxString::Format("\"%s\" --project-dir \"%s\" --iso-path \"%s\"",
-                                        pythonExePath, m_projectDir, m_isoPath);
-    wxLogDebug("Executing Python command: %s", command);
+    wxLogDebug("Backend finished with %d", event.GetInt());
+    if (!m_containerReady)
+    {
+        CloseOverlay();
+        wxLogError("Setting up the container stopped before it was ready: %s", event.GetString());
+        wxMessageBox("Setting up the build container failed. See the log for details.", "Error", wxICON_ERROR);
+    }
+}
 
-    PythonProcess *proc = new PythonProcess(this);                           // Use our custom process class
-    long pid = wxExecute(command, wxEXEC_ASYNC | wxEXEC_HIDE_CONSOLE, proc); // Run hidden
+// Keeps the desktop the backend detected for the other tabs and tells the
+// DesktopTab
+void SecondWindow::SaveDetectedGui(const wxString &guiName)
+{
+    if (guiName.IsEmpty() || guiName == "Unknown")
+    {
+        wxLogError("Failed to detect GUI environment.");
+        return;
+    }
+    wxLogDebug("Detected GUI environment before event: %s", guiName);
 
-    if (pid == 0)
+    wxString localGuiPath = wxFileName(m_projectDir, "detected_gui.txt").GetFullPath();
+    wxFile guiFile;
+    if (guiFile.Create(localGuiPath, true) && guiFile.IsOpened())
     {
-        wxLogError("Failed to start Python executable: %s", command);
-        wxMessageBox("Failed to launch the backend process (script.exe)!", "Execution Error", wxICON_ERROR);
-        delete proc;             // Clean up the process object
-        CloseOverlay();          // Close the loading overlay
-        m_threadRunning = false; // Ensure flag is reset
-        // Consider disabling further actions or closing the window here
+        guiFile.Write(guiName);
+        guiFile.Close();
+        wxLogDebug("GUI name saved to file: %s", localGuiPath);
     }
-    else
+
+    if (m_desktopTab)
     {
-        wxLogDebug("Python executable started successfully, PID: %ld", pid);
-        m_threadRunning = true; // Indicate the process is running
+        wxCommandEvent guiEvent(FILE_COPY_COMPLETE_EVENT);
+        guiEvent.SetString(guiName);
+        wxLogDebug("Posting event with GUI name: %s", guiName);
+        wxPostEvent(m_desktopTab, guiEvent);
     }
 }
 
-// This function might need more implementation if the Python process needs explicit stopping
-void SecondWindow::CleanupThread()
+// Sets up the container in-process; see BuildPipeline for its stages
+void SecondWindow::StartBuildPipeline()
 {
-    wxLogDebug("SecondWindow::CleanupThread - START");
-    if (m_threadRunning)
+    // Ensure project and ISO paths are valid before proceeding
+    if (m_projectDir.IsEmpty() || !wxDirExists(m_projectDir))
     {
-        wxLogDebug("SecondWindow::CleanupThread - Backend process was running, setting flag to false.");
-        // If PythonProcess has a PID, you might send a signal here if graceful termination is needed
-        // e.g., if (python_pid > 0) wxKill(python_pid, wxSIGTERM);
-        m_threadRunning = false;
+        wxMessageBox("Error: Project directory is invalid or does not exist.\nPath: " + m_projectDir,
+                     "Invalid Project Directory", wxOK | wxICON_ERROR);
+        CloseOverlay();
+        return;
     }
-    else
+    if (m_isoPath.IsEmpty() || !wxFileExists(m_isoPath))
     {
-        wxLogDebug("SecondWindow::CleanupThread - Backend process flag was already false.");
+        wxMessageBox("Error: ISO file path is invalid or the file does not exist.\nPath: " + m_isoPath,
+                     "Invalid ISO Path", wxOK | wxICON_ERROR);
+        CloseOverlay();
+        return;
+    }
+
+    BuildPipeline::Options options;
+    options.projectDir = m_projectDir;
+    options.isoPath = m_isoPath;
+    options.isoTreeDir = m_isoTreeDir;
+    options.isoTreeComplete = !m_pooledTreeDir.IsEmpty() && m_isoTreeDir == m_pooledTreeDir;
+    options.selectedFs = ReadSelectedFilesystem();
+    options.image = m_builderImage;
+    options.pooledContainerId = m_pooledContainerId;
+    wxLogDebug("Starting the build pipeline for %s", m_projectDir);
+
+    m_containerReady = false;
+    m_backendThread = new BuildPipeline(this, ID_BACKEND_EXEC, options);
+    if (m_backendThread->Run() != wxTHREAD_NO_ERROR)
+    {
+        wxLogError("Failed to start the build pipeline thread");
+        wxMessageBox("Failed to start setting up the build container!", "Execution Error", wxICON_ERROR);
+        delete m_backendThread;
+        m_backendThread = nullptr;
+        CloseOverlay(); // Close the loading overlay
     }
-    wxLogDebug("SecondWindow::CleanupThread - END");
 }
 
 void SecondWindow::ExecuteDockerCommand(const wxString &containerId)
@@ -715,7 +917,21 @@ void SecondWindow::CreateControls()
     bottomButtonFont.SetWeight(wxFONTWEIGHT_BOLD);
     nextButton->SetFont(bottomButtonFont);
 
+    wxArrayString profiles;
+    profiles.Add("Dev build (fast, zstd)");
+    profiles.Add("Release build (small, xz)");
+    m_profileChoice = new wxChoice(buttonPanel, ID_BUILD_PROFILE, wxDefaultPosition, wxDefaultSize, profiles);
+    AppSettings settings;
+    SettingsManager settingsManager;
+    settingsManager.LoadSettings(settings, m_projectDir + wxFILE_SEP_PATH + "settings.json");
+    const wxString profileName = settings.buildProfile.IsEmpty() ? wxString(BuildProfile::DEFAULT_NAME) : settings.buildProfile;
+    m_profileChoice->SetSelection(BuildProfile::FromName(profileName).name == "dev" ? 0 : 1);
+
+    wxButton *timelineButton = new wxButton(buttonPanel, ID_TIMELINE_BUTTON, "Build Timeline");
+    buttonSizer->Add(timelineButton, 0, wxALL | wxALIGN_CENTER_VERTICAL, 10);
+
     buttonSizer->AddStretchSpacer(1);                                     // Push button to the right
+    buttonSizer->Add(m_profileChoice, 0, wxTOP | wxBOTTOM | wxALIGN_CENTER_VERTICAL, 10);
     buttonSizer->Add(nextButton, 0, wxALL | wxALIGN_CENTER_VERTICAL, 10); // Add padding
     buttonPanel->SetSizer(buttonSizer);
 
@@ -748,181 +964,264 @@ void SecondWindow::OnClose(wxCloseEvent &event)
     }
     wxLogDebug("SecondWindow::OnClose - Starting close process.");
     m_isClosing = true;
+    m_extractCancel = true; // Stop a host-side extraction still in progress
+    m_builderCancel = true;
+    if (m_backendThread)
+        m_backendThread->Cancel();
+    if (m_isoThread)
+        m_isoThread->Cancel();
+    if (m_downloadThread)
+        m_downloadThread->Cancel();
     Hide(); // Hide the window immediately
 
-    // Start the asynchronous cleanup
-    CleanupContainerAsync();
-
-    // Start a timer to periodically check if the cleanup thread is done
-    if (!m_closeTimer)
+    // The reaper removes the container in the background, so closing
+    // doesn't wait for Docker
+    if (!m_containerId.IsEmpty())
     {
-        m_closeTimer = new wxTimer(this); // Use 'this' as the owner
+        ContainerReaper::Get().Remove(m_containerId);
+        m_containerId.Clear();
+        m_pipeline.Invalidate("container");
     }
-    // Start timer with a reasonable interval (e.g., 200ms)
-    m_closeTimer->Start(200);
 
-    // Don't destroy the window yet, let the timer handle it
-    // event.Skip(false); // Prevent immediate destruction if default is to destroy
+    DestroyWhenIdle();
 }
 
-void SecondWindow::OnCloseTimer(wxTimerEvent &event)
+// Destroys the window once no worker thread is left. Each one reports its
+// completion by event, whose handler calls this again while closing.
+void SecondWindow::DestroyWhenIdle()
 {
-    wxLogDebug("SecondWindow::OnCloseTimer - Check");
-    // Check if the cleanup thread exists and is still running
-    if (m_cleanupThread && m_cleanupThread->IsRunning())
+    if (m_extractThread || m_builderThread || m_backendThread || m_isoThread || m_downloadThread)
     {
-        wxLogDebug("SecondWindow::OnCloseTimer - Cleanup thread still running, waiting...");
-        return; // Wait for the next timer event
+        wxLogDebug("SecondWindow::DestroyWhenIdle - Waiting for worker threads.");
+        return;
     }
+    wxLogDebug("SecondWindow::DestroyWhenIdle - Calling Destroy().");
+    Destroy();
+}
+
+void SecondWindow::OnNext(wxCommandEvent &event)
+{
+    wxButton *nextButton = wxDynamicCast(FindWindow(ID_NEXT_BUTTON), wxButton);
+    if (nextButton)
+        nextButton->Disable(); // Disable button immediately
 
-    // If timer is running, stop it
-    if (m_closeTimer && m_closeTimer->IsRunning())
+    // The backend reports the container as a stage artifact
+    wxString containerId = m_containerId;
+    if (containerId.IsEmpty() || !m_containerReady || m_isoThread || m_downloadThread)
     {
-        m_closeTimer->Stop();
-        wxLogDebug("SecondWindow::OnCloseTimer - Timer stopped.");
+        wxLogError("OnNext: The build container is not ready.");
+        wxMessageBox("Error: Container information not found. Has the initial setup completed?", "Configuration Error", wxICON_ERROR);
+        if (nextButton)
+            nextButton->Enable(); // Re-enable button
+        return;
     }
 
-    wxLogDebug("SecondWindow::OnCloseTimer - Cleanup thread finished or not running, proceeding to destroy window.");
-    // Use CallAfter to ensure destruction happens safely outside the event handler
-    CallAfter(&SecondWindow::DoDestroy);
+    // Show overlay
+    if (m_overlay)
+    { // Destroy existing overlay if any
+        m_overlay->Destroy();
+        m_overlay = nullptr;
+    }
+    m_overlay = new OverlayFrame(this);
+    wxLogDebug("OnNext: Overlay shown.");
+
+    // Execute the ISO creation script
+    ContainerManager::Get().SetContainerState(containerId, ContainerRegistry::State::Building);
+    wxLogDebug("OnNext: Executing /create_iso.sh in %s", containerId);
+
+    const BuildProfile profile = GetBuildProfile();
+    wxLogDebug("OnNext: Build profile %s", profile.Describe());
+    SaveBuildProfile(profile, true);
+
+    wxArrayString command;
+    command.Add("/create_iso.sh");
+    for (const wxString &arg : profile.CreateIsoArgs())
+        command.Add(arg);
+    m_isoArtifact.Clear();
+    ++m_isoRuns;
+    m_isoThread = new DockerExecThread(this, ID_CREATE_ISO_EXEC, containerId, command);
+    if (m_isoThread->Run() != wxTHREAD_NO_ERROR)
+    {
+        wxLogError("OnNext: Failed to start create_iso.sh");
+        wxMessageBox("Failed to start the ISO creation process!", "Execution Error", wxICON_ERROR);
+        delete m_isoThread;
+        m_isoThread = nullptr;
+        ContainerManager::Get().SetContainerState(containerId, ContainerRegistry::State::Ready);
+        CloseOverlay(); // Close the loading overlay
+        if (nextButton)
+            nextButton->Enable(); // Re-enable button
+    }
+    // The button is re-enabled in OnCreateISOComplete
 }
 
-void SecondWindow::DoDestroy()
+BuildProfile SecondWindow::GetBuildProfile() const
 {
-    wxLogDebug("SecondWindow::DoDestroy - Calling Destroy().");
-    Destroy(); // Actually destroy the window object
+    if (m_profileChoice && m_profileChoice->GetSelection() == 0)
+        return BuildProfile::Dev();
+    return BuildProfile::Release();
 }
 
-void SecondWindow::CleanupContainerAsync()
+// Records the profile, and with built the mksquashfs settings it applies
+void SecondWindow::SaveBuildProfile(const BuildProfile &profile, bool built)
 {
-    wxLogDebug("SecondWindow::CleanupContainerAsync - Attempting to start cleanup thread.");
-    if (m_containerId.IsEmpty())
+    const wxString settingsPath = m_projectDir + wxFILE_SEP_PATH + "settings.json";
+    AppSettings settings;
+    SettingsManager settingsManager;
+    if (!settingsManager.LoadSettings(settings, settingsPath))
     {
-        wxLogDebug("SecondWindow::CleanupContainerAsync - No container ID, skipping cleanup thread.");
-        // If closing, ensure the close timer logic progresses IF the timer exists
-        if (m_isClosing && m_closeTimer && !m_closeTimer->IsRunning())
-        {
-            // If timer isn't running somehow, force destroy check
-            CallAfter(&SecondWindow::DoDestroy);
-        }
+        wxLogWarning("Could not read %s to record the build profile", settingsPath);
         return;
     }
 
-    // Check if thread already exists and is running
-    if (m_cleanupThread && m_cleanupThread->IsRunning())
+    settings.buildProfile = profile.name;
+    if (built)
     {
-        wxLogDebug("SecondWindow::CleanupContainerAsync - Cleanup thread is already running.");
-        return; // Don't start another one
+        settings.squashfsComp = profile.compressor;
+        settings.squashfsLevel = profile.level;
+        settings.squashfsBlockSize = profile.blockSize;
+        settings.squashfsProcessors = profile.processors;
     }
+    if (!settingsManager.SaveSettings(settings, settingsPath))
+        wxLogWarning("Could not save the build profile to %s", settingsPath);
+}
 
-    // Clean up old thread object if it exists but isn't running
-    if (m_cleanupThread)
-    {
-        // No need to Wait() here, as we checked IsRunning() above
-        delete m_cleanupThread;
-        m_cleanupThread = nullptr;
-        wxLogDebug("SecondWindow::CleanupContainerAsync - Deleted previous (non-running) cleanup thread object.");
-    }
+void SecondWindow::OnBuildProfileChanged(wxCommandEvent &event)
+{
+    SaveBuildProfile(GetBuildProfile(), false);
+}
 
-    // Create and run the new cleanup thread
-    m_cleanupThread = new ContainerCleanupThread(m_containerId);
-    if (m_cleanupThread->Run() != wxTHREAD_NO_ERROR)
-    {
-        wxLogError("SecondWindow::CleanupContainerAsync - Failed to create or run container cleanup thread.");
-        delete m_cleanupThread; // Clean up if Run failed
-        m_cleanupThread = nullptr;
+// create_iso.sh reports where it left the ISO
+void SecondWindow::OnCreateISOStage(wxCommandEvent &event)
+{
+    std::unique_ptr<BuildStage> stage(static_cast<BuildStage *>(event.GetClientData()));
+    if (!stage)
+        return;
 
-        // If we are in the closing sequence, and couldn't start the thread,
-        // allow the close process to continue via the timer check.
-        if (m_isClosing && m_closeTimer && !m_closeTimer->IsRunning())
-        {
-            CallAfter(&SecondWindow::DoDestroy); // Force destroy check if timer isn't running
-        }
+    if (stage->event == BuildStage::Event::Artifact && stage->kind == "iso")
+    {
+        m_isoArtifact = stage->value;
     }
-    else
+    else if (stage->event == BuildStage::Event::Started || stage->event == BuildStage::Event::Finished)
     {
-        wxLogDebug("SecondWindow::CleanupContainerAsync - Cleanup thread started successfully for container %s.", m_containerId);
+        m_timeline.Record(GetIsoRunGroup(), *stage);
+        UpdateTimeline();
     }
 }
 
-void SecondWindow::OnNext(wxCommandEvent &event)
+void SecondWindow::OnCreateISOComplete(wxCommandEvent &event)
 {
-    wxButton *nextButton = wxDynamicCast(FindWindow(ID_NEXT_BUTTON), wxButton);
-    if (nextButton)
-        nextButton->Disable(); // Disable button immediately
-
-    wxString containerId;
-    wxString containerIdPath = wxFileName(m_projectDir, "container_id.txt").GetFullPath();
-    wxLogDebug("OnNext: Checking for container ID at: %s", containerIdPath);
-
-    if (wxFileExists(containerIdPath))
+    if (m_isoThread)
     {
-        wxFile file;
-        if (file.Open(containerIdPath))
-        {
-            file.ReadAll(&containerId);
-            containerId.Trim();
-            wxLogDebug("OnNext: Read container ID: %s", containerId);
-            file.Close(); // Close the file
-        }
-        else
-        {
-            wxLogError("OnNext: Container ID file exists but could not be opened!");
-            wxMessageBox("Error: Could not read container information.", "File Error", wxICON_ERROR);
-            if (nextButton)
-                nextButton->Enable(); // Re-enable button on error
-            return;
-        }
+        m_isoThread->Wait();
+        delete m_isoThread;
+        m_isoThread = nullptr;
     }
-    else
+    if (m_isClosing)
     {
-        wxLogError("OnNext: Container ID file not found!");
-        wxMessageBox("Error: Container information not found. Has the initial setup completed?", "Configuration Error", wxICON_ERROR);
-        if (nextButton)
-            nextButton->Enable(); // Re-enable button
+        DestroyWhenIdle();
         return;
     }
 
-    // Ensure container ID is not empty after reading
-    if (containerId.IsEmpty())
+    wxButton *nextButton = wxDynamicCast(FindWindow(ID_NEXT_BUTTON), wxButton);
+    if (event.GetInt() != 0 || m_isoArtifact.IsEmpty())
     {
-        wxLogError("OnNext: Container ID is empty after reading the file!");
-        wxMessageBox("Error: Container information is invalid.", "Configuration Error", wxICON_ERROR);
+        CloseOverlay();
+        ContainerManager::Get().SetContainerState(m_containerId, ContainerRegistry::State::Ready);
+        wxLogError("ISO creation process failed with status: %d %s", event.GetInt(), event.GetString());
+        wxMessageBox("ISO creation process failed!", "Error", wxICON_ERROR);
         if (nextButton)
             nextButton->Enable();
         return;
     }
 
-    // Show overlay
-    if (m_overlay)
-    { // Destroy existing overlay if any
-        m_overlay->Destroy();
-        m_overlay = nullptr;
+    // The copy streams in the background; the overlay shows its progress.
+    // An ISO written to the bind-mounted tree is on the host already and is
+    // only moved into the project directory.
+    wxString hostPath;
+    const wxString treePath = wxString(BuildPipeline::ISO_TREE_PATH) + "/";
+    if (!m_isoTreeDir.IsEmpty() && m_isoArtifact.StartsWith(treePath))
+        hostPath = m_isoTreeDir + wxFILE_SEP_PATH + m_isoArtifact.Mid(treePath.length());
+    ContainerManager::Get().SetContainerState(m_containerId, ContainerRegistry::State::Done);
+    m_downloadThread = new ArtifactDownloadThread(this, m_containerId, m_isoArtifact, m_projectDir, hostPath);
+    if (m_downloadThread->Run() != wxTHREAD_NO_ERROR)
+    {
+        delete m_downloadThread;
+        m_downloadThread = nullptr;
+        CloseOverlay();
+        wxLogError("Failed to start copying the ISO");
+        wxMessageBox("ISO creation succeeded but failed to copy to host.", "Error", wxICON_ERROR);
+        if (nextButton)
+            nextButton->Enable();
+        return;
     }
-    m_overlay = new OverlayFrame(this);
-    wxLogDebug("OnNext: Overlay shown.");
+    m_timeline.Begin(GetIsoRunGroup(), "download");
+}
 
-    // Execute the ISO creation script
-    wxString command = wxString::Format("docker exec %s /create_iso.sh", containerId);
-    wxLogDebug("OnNext: Executing ISO creation command: %s", command);
+void SecondWindow::OnArtifactDownloadProgress(wxCommandEvent &event)
+{
+    if (m_overlay && !m_isClosing)
+        m_overlay->SetStatus(event.GetString());
+}
 
-    DockerExecProcess *proc = new DockerExecProcess(this); // Handles OnTerminate
-    long pid = wxExecute(command, wxEXEC_ASYNC | wxEXEC_HIDE_CONSOLE, proc);
+void SecondWindow::OnArtifactDownloadComplete(wxCommandEvent &event)
+{
+    std::unique_ptr<ArtifactDownloadResult> result(static_cast<ArtifactDownloadResult *>(event.GetClientData()));
+    if (m_downloadThread)
+    {
+        m_downloadThread->Wait();
+        delete m_downloadThread;
+        m_downloadThread = nullptr;
+    }
+    if (m_isClosing)
+    {
+        DestroyWhenIdle();
+        return;
+    }
 
-    if (pid == 0)
+    CloseOverlay();
+    m_timeline.End(GetIsoRunGroup(), "download", result && result->error.IsEmpty() && !result->cancelled,
+                   result ? result->error : wxString());
+    UpdateTimeline();
+    if (result && result->error.IsEmpty() && !result->cancelled)
     {
-        wxLogError("OnNext: Failed to start docker exec for create_iso.sh");
-        wxMessageBox("Failed to start the ISO creation process!", "Execution Error", wxICON_ERROR);
-        delete proc;    // Clean up process object
-        CloseOverlay(); // Close the loading overlay
-        if (nextButton)
-            nextButton->Enable(); // Re-enable button
+        wxLogDebug("ISO copied to %s, SHA-256 %s", result->path, result->sha256);
+        wxMessageBox(wxString::Format("ISO created and copied to project directory successfully!\n\n%s\nSHA-256: %s",
+                                      result->path, result->sha256),
+                     "Success", wxOK | wxICON_INFORMATION);
     }
-    else
+    else if (result && !result->cancelled)
     {
-        wxLogDebug("OnNext: ISO creation process started, PID: %ld", pid);
-        // The button will be re-enabled in DockerExecProcess::OnTerminate
+        wxLogError("Copying the ISO failed: %s", result->error);
+        wxMessageBox("ISO creation succeeded but failed to copy to host.", "Error", wxICON_ERROR);
     }
+
+    // Re-enable the 'Next' button regardless of success/failure
+    wxButton *nextButton = wxDynamicCast(FindWindow(ID_NEXT_BUTTON), wxButton);
+    if (nextButton)
+        nextButton->Enable();
+}
+
+wxString SecondWindow::GetIsoRunGroup() const
+{
+    return wxString::Format("iso %d", m_isoRuns);
+}
+
+// Saved on every change, so the file is complete up to the last stage even
+// if the application dies mid-build
+void SecondWindow::UpdateTimeline()
+{
+    m_timeline.Save();
+    if (m_timelineDialog)
+        m_timelineDialog->UpdateTimeline();
+}
+
+void SecondWindow::OnTimelineButton(wxCommandEvent &event)
+{
+    if (!m_timelineDialog)
+        m_timelineDialog = new BuildTimelineDialog(this, m_timeline);
+    m_timelineDialog->UpdateTimeline();
+    m_timelineDialog->Show();
+    m_timelineDialog->Raise();
 }
 
 void SecondWindow::OnTabChanged(wxCommandEvent &event)
@@ -3,6 +3,7 @@
 
 #include <wx/wx.h>
 #include <wx/thread.h>
+#include <atomic>
 // #include <wx/listctrl.h> // No longer needed directly here after separating MongoDBPanel
 #include "DesktopTab.h"
 #include "ConfigTab.h"
@@ -10,6 +11,11 @@
 #include "OSDetector.h"
 #include "ContainerManager.h"
 #include "FlatpakStore.h"
+#include "DockerExecThread.h"
+#include "BuildPipeline.h"
+#include "BuildProfile.h"
+#include "BuildTimeline.h"
+#include "PipelineState.h"
 #include "WindowIDs.h"         // <<< Make sure this is included for the IDs
 #include <mongocxx/client.hpp> // Keep MongoDB includes needed by SecondWindow itself
 #include <mongocxx/instance.hpp>
@@ -21,6 +27,8 @@
 // Forward declarations
 class OverlayFrame;
 class MongoDBPanel; // <<< Forward Declaration
+class ArtifactDownloadThread;
+class BuildTimelineDialog;
 
 // --- SecondWindow Definition ---
 class SecondWindow : public wxFrame
@@ -40,6 +48,8 @@ public:
     DesktopTab *GetDesktopTab() const { return m_desktopTab; }
     FlatpakStore *GetFlatpakStore() const { return m_flatpakStore; }
     SQLTab *GetSQLTab() const { return m_sqlTab; }
+    void SetContainerId(const wxString &containerId);
+    wxString GetContainerId() const { return m_containerId; }
 
 private:
     wxPanel *m_mainPanel;
@@ -52,7 +62,6 @@ private:
     wxString m_isoPath;
     wxString m_projectDir;
     wxString m_containerId;
-    bool m_threadRunning;
 
     OverlayFrame *m_overlay;
     OSDetector m_osDetector;
@@ -61,11 +70,74 @@ private:
 
     static mongocxx::instance m_mongoInstance;
 
-    wxThread *m_cleanupThread;
-    void CleanupContainerAsync();
+    // Host-side extraction of the ISO tree, bind-mounted into the container
+    wxThread *m_extractThread;
+    std::atomic<bool> m_extractCancel;
+    void StartISOExtraction();
+    wxString GetISOTreeTarget() const;
+    void OnISOExtractComplete(wxCommandEvent &event);
+    wxString ReadSelectedFilesystem() const;
+
+    // Prebuilt image for the container, made alongside the extraction. The
+    // backend starts once neither is pending.
+    wxThread *m_builderThread;
+    std::atomic<bool> m_builderCancel;
+    wxString m_builderImage;
+    wxString m_isoTreeDir;
+    bool m_extractPending;
+    bool m_builderPending;
+    void StartBuilderImage();
+    void OnBuilderImageReady(wxCommandEvent &event);
+    void StartBackendWhenReady();
+
+    // Idle container claimed from ContainerManager's pool, if there was one.
+    // Its /root/custom_iso is m_pooledTreeDir on the host.
+    wxString m_pooledContainerId;
+    wxString m_pooledTreeDir;
+
+    // Checkpoints of this project's build, shared with the backend. The
+    // host-side extraction is skipped while its key, m_extractKey, matches.
+    PipelineState m_pipeline;
+    wxString m_extractKey;
+
+    // The backend, which sets up the container and reports its stages.
+    // The container is ready once the backend stage finishes.
+    BuildPipeline *m_backendThread;
+    bool m_containerReady;
+    void OnBackendStage(wxCommandEvent &event);
+    void OnBackendOutput(wxCommandEvent &event);
+    void OnBackendComplete(wxCommandEvent &event);
+    void SaveDetectedGui(const wxString &guiName);
+
+    // create_iso.sh, run when Next is pressed
+    DockerExecThread *m_isoThread;
+    wxString m_isoArtifact;
+    void OnCreateISOStage(wxCommandEvent &event);
+    void OnCreateISOComplete(wxCommandEvent &event);
+
+    // Squashfs build profile for create_iso.sh, kept in the project's
+    // settings.json together with the settings of the last build
+    wxChoice *m_profileChoice;
+    BuildProfile GetBuildProfile() const;
+    void SaveBuildProfile(const BuildProfile &profile, bool built);
+    void OnBuildProfileChanged(wxCommandEvent &event);
+
+    // Then copies the ISO it made into the project directory
+    ArtifactDownloadThread *m_downloadThread;
+    void OnArtifactDownloadProgress(wxCommandEvent &event);
+    void OnArtifactDownloadComplete(wxCommandEvent &event);
+
+    // Stage timings of this window's build and each ISO made from it,
+    // saved under the project directory as they come in
+    BuildTimeline m_timeline;
+    int m_isoRuns;
+    BuildTimelineDialog *m_timelineDialog;
+    wxString GetIsoRunGroup() const;
+    void UpdateTimeline();
+    void OnTimelineButton(wxCommandEvent &event);
 
     bool m_isClosing;
-    wxTimer *m_closeTimer;
+    void DestroyWhenIdle();
 
     wxWindow *m_lastTab;
 
@@ -74,8 +146,7 @@ private:
 #endif
 
     void CreateControls();
-    void StartPythonExecutable();
-    void CleanupThread();
+    void StartBuildPipeline();
 
     // Event Handlers for SecondWindow
     void OnClose(wxCloseEvent &event);
@@ -83,8 +154,6 @@ private:
     void OnTabChanged(wxCommandEvent &event);
     void OnMongoDBButton(wxCommandEvent &event);
     void OnMongoDBPanelClose(wxCommandEvent &event); // Handles close request
-    void OnCloseTimer(wxTimerEvent &event);
-    void DoDestroy();
 
     wxDECLARE_EVENT_TABLE();
 };
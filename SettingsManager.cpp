@@ -92,6 +92,19 @@ rapidjson::Document SettingsManager::SettingsToJson(const AppSettings& settings)
         rapidjson::Value(settings.detectedDistro.ToUTF8().data(), allocator), 
         allocator);
 
+    // Build profile and the mksquashfs settings used last
+    doc.AddMember("build_profile",
+        rapidjson::Value(settings.buildProfile.ToUTF8().data(), allocator),
+        allocator);
+    doc.AddMember("squashfs_comp",
+        rapidjson::Value(settings.squashfsComp.ToUTF8().data(), allocator),
+        allocator);
+    doc.AddMember("squashfs_level", settings.squashfsLevel, allocator);
+    doc.AddMember("squashfs_block_size",
+        rapidjson::Value(settings.squashfsBlockSize.ToUTF8().data(), allocator),
+        allocator);
+    doc.AddMember("squashfs_processors", settings.squashfsProcessors, allocator);
+
     return doc;
 }
 
@@ -108,6 +121,16 @@ AppSettings SettingsManager::JsonToSettings(const rapidjson::Document& doc) cons
         settings.version = wxString::FromUTF8(doc["version"].GetString());
     if (doc.HasMember("detected_distro")) 
         settings.detectedDistro = wxString::FromUTF8(doc["detected_distro"].GetString());
+    if (doc.HasMember("build_profile") && doc["build_profile"].IsString())
+        settings.buildProfile = wxString::FromUTF8(doc["build_profile"].GetString());
+    if (doc.HasMember("squashfs_comp") && doc["squashfs_comp"].IsString())
+        settings.squashfsComp = wxString::FromUTF8(doc["squashfs_comp"].GetString());
+    if (doc.HasMember("squashfs_level") && doc["squashfs_level"].IsInt())
+        settings.squashfsLevel = doc["squashfs_level"].GetInt();
+    if (doc.HasMember("squashfs_block_size") && doc["squashfs_block_size"].IsString())
+        settings.squashfsBlockSize = wxString::FromUTF8(doc["squashfs_block_size"].GetString());
+    if (doc.HasMember("squashfs_processors") && doc["squashfs_processors"].IsInt())
+        settings.squashfsProcessors = doc["squashfs_processors"].GetInt();
 
     return settings;
 }
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include "Sha256.h"
+#include <cstdio>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const std::uint32_t ROUND_CONSTANTS[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+inline std::uint32_t RotateRight(std::uint32_t value, int bits) {
+    return (value >> bits) | (value << (32 - bits));
+}
+
+} // namespace
+
+Sha256::Sha256()
+    : m_state{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19},
+      m_bufferFill(0), m_length(0) {
+}
+
+void Sha256::Update(const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    m_length += size;
+
+    if (m_bufferFill > 0) {
+        size_t take = std::min(size, sizeof(m_buffer) - m_bufferFill);
+        std::memcpy(m_buffer + m_bufferFill, bytes, take);
+        m_bufferFill += take;
+        bytes += take;
+        size -= take;
+        if (m_bufferFill < sizeof(m_buffer)) {
+            return;
+        }
+        Transform(m_buffer);
+        m_bufferFill = 0;
+    }
+
+    // Whole blocks straight from the caller's buffer
+    for (; size >= sizeof(m_buffer); bytes += sizeof(m_buffer), size -= sizeof(m_buffer)) {
+        Transform(bytes);
+    }
+
+    std::memcpy(m_buffer, bytes, size);
+    m_bufferFill = size;
+}
+
+std::string Sha256::HexDigest() {
+    const std::uint64_t bits = m_length * 8;
+    const unsigned char pad = 0x80;
+    Update(&pad, 1);
+    const unsigned char zero = 0;
+    while (m_bufferFill != 56) {
+        Update(&zero, 1);
+    }
+    unsigned char lengthBytes[8];
+    for (int i = 0; i < 8; ++i) {
+        lengthBytes[i] = static_cast<unsigned char>(bits >> (56 - 8 * i));
+    }
+    Update(lengthBytes, sizeof(lengthBytes));
+
+    std::string hex;
+    char digits[9];
+    for (std::uint32_t word : m_state) {
+        std::snprintf(digits, sizeof(digits), "%08x", static_cast<unsigned int>(word));
+        hex += digits;
+    }
+    return hex;
+}
+
+void Sha256::Transform(const unsigned char* block) {
+    std::uint32_t w[64];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = (std::uint32_t(block[i * 4]) << 24) | (std::uint32_t(block[i * 4 + 1]) << 16) |
+               (std::uint32_t(block[i * 4 + 2]) << 8) | std::uint32_t(block[i * 4 + 3]);
+    }
+    for (int i = 16; i < 64; ++i) {
+        std::uint32_t s0 = RotateRight(w[i - 15], 7) ^ RotateRight(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        std::uint32_t s1 = RotateRight(w[i - 2], 17) ^ RotateRight(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    std::uint32_t a = m_state[0], b = m_state[1], c = m_state[2], d = m_state[3];
+    std::uint32_t e = m_state[4], f = m_state[5], g = m_state[6], h = m_state[7];
+    for (int i = 0; i < 64; ++i) {
+        std::uint32_t s1 = RotateRight(e, 6) ^ RotateRight(e, 11) ^ RotateRight(e, 25);
+        std::uint32_t choose = (e & f) ^ (~e & g);
+        std::uint32_t t1 = h + s1 + choose + ROUND_CONSTANTS[i] + w[i];
+        std::uint32_t s0 = RotateRight(a, 2) ^ RotateRight(a, 13) ^ RotateRight(a, 22);
+        std::uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+        std::uint32_t t2 = s0 + majority;
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    m_state[0] += a;
+    m_state[1] += b;
+    m_state[2] += c;
+    m_state[3] += d;
+    m_state[4] += e;
+    m_state[5] += f;
+    m_state[6] += g;
+    m_state[7] += h;
+}
@@ -0,0 +1,30 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Incremental SHA-256 (FIPS 180-4), for checksumming artifacts while they
+// are streamed. Feed data with Update() in any chunk sizes, then call
+// HexDigest() once.
+class Sha256 {
+public:
+    Sha256();
+
+    void Update(const void* data, size_t size);
+
+    // Lower-case hex, as printed by sha256sum. Finishes the hash; Update()
+    // must not be called afterwards.
+    std::string HexDigest();
+
+private:
+    void Transform(const unsigned char* block);
+
+    std::uint32_t m_state[8];
+    unsigned char m_buffer[64];
+    size_t m_bufferFill;
+    std::uint64_t m_length;  // Bytes hashed so far
+};
+
+#endif // SHA256_H
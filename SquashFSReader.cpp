@@ -0,0 +1,545 @@
+#include "SquashFSReader.h"
+#include "ISOReader.h"
+#include <algorithm>
+
+#ifdef SQUASHFS_HAVE_ZLIB
+    #include <zlib.h>
+#endif
+#ifdef SQUASHFS_HAVE_LZMA
+    #include <lzma.h>
+#endif
+#ifdef SQUASHFS_HAVE_LZ4
+    #include <lz4.h>
+#endif
+#ifdef SQUASHFS_HAVE_ZSTD
+    #include <zstd.h>
+#endif
+
+namespace {
+
+const std::uint32_t SQUASHFS_MAGIC = 0x73717368;  // "hsqs"
+const std::size_t SUPERBLOCK_SIZE = 96;
+const std::uint32_t NO_FRAGMENT = 0xFFFFFFFF;
+const std::uint32_t DATA_UNCOMPRESSED = 1u << 24;
+const std::uint16_t METADATA_UNCOMPRESSED = 0x8000;
+
+// Extended inode types
+const std::uint16_t EXT_DIRECTORY = 8;
+const std::uint16_t EXT_FILE = 9;
+const std::uint16_t EXT_SYMLINK = 10;
+
+std::uint16_t le16(const unsigned char* p) {
+    return static_cast<std::uint16_t>(p[0] | (p[1] << 8));
+}
+
+std::uint32_t le32(const unsigned char* p) {
+    return static_cast<std::uint32_t>(p[0]) | (static_cast<std::uint32_t>(p[1]) << 8) |
+           (static_cast<std::uint32_t>(p[2]) << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+}
+
+std::uint64_t le64(const unsigned char* p) {
+    return static_cast<std::uint64_t>(le32(p)) | (static_cast<std::uint64_t>(le32(p + 4)) << 32);
+}
+
+// Splits a path into components, applying "." and ".."
+std::vector<std::string> splitPath(const std::string& path) {
+    std::vector<std::string> parts;
+    size_t start = 0;
+    while (start <= path.size()) {
+        size_t end = path.find_first_of("/\\", start);
+        if (end == std::string::npos) {
+            end = path.size();
+        }
+        std::string part = path.substr(start, end - start);
+        if (part == "..") {
+            if (!parts.empty()) {
+                parts.pop_back();
+            }
+        } else if (!part.empty() && part != ".") {
+            parts.push_back(part);
+        }
+        start = end + 1;
+    }
+    return parts;
+}
+
+} // namespace
+
+SquashFSReader::SquashFSReader(ISOReader& reader, const std::string& imagePath)
+    : reader(reader), image_path(imagePath), sb(), opened(false) {}
+
+bool SquashFSReader::open() {
+    opened = false;
+    metadata_cache.clear();
+
+    std::vector<unsigned char> raw;
+    if (!readBytes(0, SUPERBLOCK_SIZE, raw) || raw.size() < SUPERBLOCK_SIZE) {
+        last_error = "Image is too small for a SquashFS superblock";
+        return false;
+    }
+    const unsigned char* p = raw.data();
+    if (le32(p) != SQUASHFS_MAGIC) {
+        last_error = "Not a SquashFS image";
+        return false;
+    }
+
+    sb.inodeCount = le32(p + 4);
+    sb.modificationTime = le32(p + 8);
+    sb.blockSize = le32(p + 12);
+    sb.fragmentCount = le32(p + 16);
+    sb.compression = le16(p + 20);
+    sb.flags = le16(p + 24);
+    sb.versionMajor = le16(p + 28);
+    sb.versionMinor = le16(p + 30);
+    sb.rootInode = le64(p + 32);
+    sb.bytesUsed = le64(p + 40);
+    sb.inodeTableStart = le64(p + 64);
+    sb.directoryTableStart = le64(p + 72);
+    sb.fragmentTableStart = le64(p + 80);
+
+    if (sb.versionMajor != 4) {
+        last_error = "Unsupported SquashFS version " + std::to_string(sb.versionMajor);
+        return false;
+    }
+    if (sb.blockSize == 0 || sb.blockSize > (1u << 20)) {
+        last_error = "Invalid SquashFS block size";
+        return false;
+    }
+    opened = true;
+    return true;
+}
+
+std::string SquashFSReader::compressionName() const {
+    switch (sb.compression) {
+        case 1: return "gzip";
+        case 2: return "lzma";
+        case 3: return "lzo";
+        case 4: return "xz";
+        case 5: return "lz4";
+        case 6: return "zstd";
+        default: return "unknown";
+    }
+}
+
+bool SquashFSReader::canDecompress() const {
+    switch (sb.compression) {
+    #ifdef SQUASHFS_HAVE_ZLIB
+        case 1: return true;
+    #endif
+    #ifdef SQUASHFS_HAVE_LZMA
+        case 4: return true;
+    #endif
+    #ifdef SQUASHFS_HAVE_LZ4
+        case 5: return true;
+    #endif
+    #ifdef SQUASHFS_HAVE_ZSTD
+        case 6: return true;
+    #endif
+        default: return false;
+    }
+}
+
+bool SquashFSReader::listDirectory(const std::string& path, std::vector<DirEntry>& entries) {
+    entries.clear();
+    Inode inode;
+    if (!resolve(path, inode)) {
+        return false;
+    }
+    if (inode.type != DIRECTORY) {
+        last_error = "Not a directory: " + path;
+        return false;
+    }
+    return readDirectory(inode, entries);
+}
+
+bool SquashFSReader::readFile(const std::string& path, std::vector<char>& content, std::size_t maxSize) {
+    content.clear();
+    Inode inode;
+    if (!resolve(path, inode)) {
+        return false;
+    }
+    if (inode.type != FILE) {
+        last_error = "Not a regular file: " + path;
+        return false;
+    }
+    if (inode.fileSize > maxSize) {
+        last_error = "File is too large to preview: " + path;
+        return false;
+    }
+
+    const std::size_t size = static_cast<std::size_t>(inode.fileSize);
+    content.reserve(size);
+
+    std::vector<unsigned char> block;
+    std::uint64_t position = inode.blocksStart;
+    for (std::uint32_t sizeField : inode.blockSizes) {
+        const std::size_t wanted = std::min<std::size_t>(sb.blockSize, size - content.size());
+        if ((sizeField & ~DATA_UNCOMPRESSED) == 0) {
+            // Sparse block
+            content.insert(content.end(), wanted, '\0');
+            continue;
+        }
+        if (!readDataBlock(position, sizeField, block)) {
+            return false;
+        }
+        position += sizeField & ~DATA_UNCOMPRESSED;
+        content.insert(content.end(), block.begin(), block.begin() + std::min(wanted, block.size()));
+    }
+
+    if (inode.fragment != NO_FRAGMENT && content.size() < size) {
+        // Fragment table: an array of pointers to metadata blocks holding
+        // 16-byte entries, 512 per block
+        std::vector<unsigned char> pointer;
+        if (!readBytes(sb.fragmentTableStart + (inode.fragment / 512) * 8, 8, pointer) || pointer.size() < 8) {
+            last_error = "Failed to read fragment table";
+            return false;
+        }
+        std::vector<unsigned char> entry;
+        if (!readMetadata(le64(pointer.data()), 0, static_cast<std::uint16_t>((inode.fragment % 512) * 16), 16, entry)) {
+            return false;
+        }
+        if (!readDataBlock(le64(entry.data()), le32(entry.data() + 8), block)) {
+            return false;
+        }
+        const std::size_t tail = size - content.size();
+        if (inode.fragmentOffset + tail > block.size()) {
+            last_error = "Fragment is shorter than the file tail";
+            return false;
+        }
+        content.insert(content.end(), block.begin() + inode.fragmentOffset,
+                       block.begin() + inode.fragmentOffset + tail);
+    }
+
+    if (content.size() != size) {
+        last_error = "Failed to read complete file: " + path;
+        return false;
+    }
+    return true;
+}
+
+bool SquashFSReader::readInode(std::uint64_t ref, Inode& inode) {
+    const std::uint64_t block = ref >> 16;
+    const std::uint16_t offset = static_cast<std::uint16_t>(ref & 0xFFFF);
+
+    std::vector<unsigned char> raw;
+    if (!readMetadata(sb.inodeTableStart, block, offset, 16, raw)) {
+        return false;
+    }
+    const std::uint16_t type = le16(raw.data());
+
+    inode = Inode();
+    switch (type) {
+        case DIRECTORY:
+            if (!readMetadata(sb.inodeTableStart, block, offset, 32, raw)) return false;
+            inode.type = DIRECTORY;
+            inode.dirBlock = le32(raw.data() + 16);
+            inode.dirSize = le16(raw.data() + 24);
+            inode.dirOffset = le16(raw.data() + 26);
+            return true;
+
+        case EXT_DIRECTORY:
+            if (!readMetadata(sb.inodeTableStart, block, offset, 40, raw)) return false;
+            inode.type = DIRECTORY;
+            inode.dirSize = le32(raw.data() + 20);
+            inode.dirBlock = le32(raw.data() + 24);
+            inode.dirOffset = le16(raw.data() + 34);
+            return true;
+
+        case FILE:
+        case EXT_FILE: {
+            const std::size_t fixed = type == FILE ? 32 : 56;
+            if (!readMetadata(sb.inodeTableStart, block, offset, fixed, raw)) return false;
+            inode.type = FILE;
+            if (type == FILE) {
+                inode.blocksStart = le32(raw.data() + 16);
+                inode.fragment = le32(raw.data() + 20);
+                inode.fragmentOffset = le32(raw.data() + 24);
+                inode.fileSize = le32(raw.data() + 28);
+            } else {
+                inode.blocksStart = le64(raw.data() + 16);
+                inode.fileSize = le64(raw.data() + 24);
+                inode.fragment = le32(raw.data() + 44);
+                inode.fragmentOffset = le32(raw.data() + 48);
+            }
+
+            const std::uint64_t count = inode.fragment == NO_FRAGMENT
+                ? (inode.fileSize + sb.blockSize - 1) / sb.blockSize
+                : inode.fileSize / sb.blockSize;
+            if (count > 0) {
+                if (!readMetadata(sb.inodeTableStart, block, offset, fixed + count * 4, raw)) return false;
+                inode.blockSizes.reserve(count);
+                for (std::uint64_t i = 0; i < count; ++i) {
+                    inode.blockSizes.push_back(le32(raw.data() + fixed + i * 4));
+                }
+            }
+            return true;
+        }
+
+        case SYMLINK:
+        case EXT_SYMLINK: {
+            if (!readMetadata(sb.inodeTableStart, block, offset, 24, raw)) return false;
+            const std::uint32_t length = le32(raw.data() + 20);
+            if (length > 4096 || !readMetadata(sb.inodeTableStart, block, offset, 24 + length, raw)) {
+                last_error = "Invalid symlink inode";
+                return false;
+            }
+            inode.type = SYMLINK;
+            inode.target.assign(reinterpret_cast<const char*>(raw.data() + 24), length);
+            return true;
+        }
+
+        default:
+            // Devices, fifos and sockets carry nothing a preview needs
+            inode.type = type;
+            return true;
+    }
+}
+
+bool SquashFSReader::readDirectory(const Inode& dir, std::vector<DirEntry>& entries) {
+    // The stored size counts the implicit "." and ".." entries
+    if (dir.dirSize <= 3) {
+        return true;
+    }
+    std::vector<unsigned char> raw;
+    if (!readMetadata(sb.directoryTableStart, dir.dirBlock, dir.dirOffset, dir.dirSize - 3, raw)) {
+        return false;
+    }
+
+    std::size_t pos = 0;
+    while (pos + 12 <= raw.size()) {
+        const std::uint32_t count = le32(raw.data() + pos) + 1;
+        const std::uint32_t start = le32(raw.data() + pos + 4);
+        pos += 12;
+        for (std::uint32_t i = 0; i < count; ++i) {
+            if (pos + 8 > raw.size()) {
+                last_error = "Truncated directory listing";
+                return false;
+            }
+            const std::uint16_t offset = le16(raw.data() + pos);
+            const std::uint16_t type = le16(raw.data() + pos + 4);
+            const std::size_t nameSize = static_cast<std::size_t>(le16(raw.data() + pos + 6)) + 1;
+            pos += 8;
+            if (pos + nameSize > raw.size()) {
+                last_error = "Truncated directory listing";
+                return false;
+            }
+
+            DirEntry entry;
+            entry.name.assign(reinterpret_cast<const char*>(raw.data() + pos), nameSize);
+            entry.inode = (static_cast<std::uint64_t>(start) << 16) | offset;
+            entry.type = type;
+            entries.push_back(std::move(entry));
+            pos += nameSize;
+        }
+    }
+    return true;
+}
+
+// Walks the path from the root inode, following symlinks on the way
+bool SquashFSReader::resolve(const std::string& path, Inode& inode, int depth) {
+    if (!opened) {
+        last_error = "Image not opened";
+        return false;
+    }
+    if (depth > MAX_SYMLINK_DEPTH) {
+        last_error = "Too many levels of symbolic links: " + path;
+        return false;
+    }
+
+    const std::vector<std::string> parts = splitPath(path);
+    if (!readInode(sb.rootInode, inode)) {
+        return false;
+    }
+
+    std::vector<DirEntry> entries;
+    for (std::size_t i = 0; i < parts.size(); ++i) {
+        if (inode.type != DIRECTORY) {
+            last_error = "Not a directory on the way to " + path;
+            return false;
+        }
+        entries.clear();
+        if (!readDirectory(inode, entries)) {
+            return false;
+        }
+        auto it = std::find_if(entries.begin(), entries.end(),
+                               [&](const DirEntry& entry) { return entry.name == parts[i]; });
+        if (it == entries.end()) {
+            last_error = "No such file in filesystem image: " + path;
+            return false;
+        }
+        if (!readInode(it->inode, inode)) {
+            return false;
+        }
+
+        if (inode.type == SYMLINK) {
+            std::string target;
+            if (inode.target.empty() || inode.target[0] != '/') {
+                for (std::size_t j = 0; j < i; ++j) {
+                    target += "/" + parts[j];
+                }
+                target += "/";
+            }
+            target += inode.target;
+            for (std::size_t j = i + 1; j < parts.size(); ++j) {
+                target += "/" + parts[j];
+            }
+            return resolve(target, inode, depth + 1);
+        }
+    }
+    return true;
+}
+
+bool SquashFSReader::readMetadata(std::uint64_t tableStart, std::uint64_t block, std::uint16_t offset,
+                                  std::size_t length, std::vector<unsigned char>& out) {
+    out.clear();
+    out.reserve(length);
+
+    std::uint64_t position = tableStart + block;
+    std::size_t skip = offset;
+    while (out.size() < length) {
+        const std::vector<unsigned char>* data = nullptr;
+        std::uint64_t next = 0;
+        if (!metadataBlock(position, data, next)) {
+            return false;
+        }
+        if (skip >= data->size()) {
+            last_error = "Metadata offset past the end of its block";
+            return false;
+        }
+        const std::size_t take = std::min(length - out.size(), data->size() - skip);
+        out.insert(out.end(), data->begin() + skip, data->begin() + skip + take);
+        skip = 0;
+        position = next;
+    }
+    return true;
+}
+
+// Metadata blocks start with a 16-bit header: the stored size, with the top
+// bit set when the block is stored uncompressed
+bool SquashFSReader::metadataBlock(std::uint64_t position, const std::vector<unsigned char>*& data, std::uint64_t& next) {
+    auto cached = metadata_cache.find(position);
+    if (cached != metadata_cache.end()) {
+        data = &cached->second.data;
+        next = cached->second.next;
+        return true;
+    }
+
+    std::vector<unsigned char> header;
+    if (!readBytes(position, 2, header) || header.size() < 2) {
+        last_error = "Failed to read metadata block header";
+        return false;
+    }
+    const std::uint16_t field = le16(header.data());
+    const std::size_t size = field & 0x7FFF;
+    if (size == 0 || size > METADATA_SIZE) {
+        last_error = "Invalid metadata block";
+        return false;
+    }
+
+    std::vector<unsigned char> stored;
+    if (!readBytes(position + 2, size, stored) || stored.size() < size) {
+        last_error = "Failed to read metadata block";
+        return false;
+    }
+
+    CachedBlock block;
+    block.next = position + 2 + size;
+    if (field & METADATA_UNCOMPRESSED) {
+        block.data = std::move(stored);
+    } else if (!decompress(stored.data(), stored.size(), block.data, METADATA_SIZE)) {
+        return false;
+    }
+
+    auto inserted = metadata_cache.emplace(position, std::move(block)).first;
+    data = &inserted->second.data;
+    next = inserted->second.next;
+    return true;
+}
+
+bool SquashFSReader::readDataBlock(std::uint64_t position, std::uint32_t sizeField, std::vector<unsigned char>& out) {
+    const std::size_t size = sizeField & ~DATA_UNCOMPRESSED;
+    if (size > sb.blockSize) {
+        last_error = "Invalid data block size";
+        return false;
+    }
+
+    std::vector<unsigned char> stored;
+    if (!readBytes(position, size, stored) || stored.size() < size) {
+        last_error = "Failed to read data block";
+        return false;
+    }
+    if (sizeField & DATA_UNCOMPRESSED) {
+        out = std::move(stored);
+        return true;
+    }
+    return decompress(stored.data(), stored.size(), out, sb.blockSize);
+}
+
+// in and inSize go unused in a build without any decompressor library
+bool SquashFSReader::decompress([[maybe_unused]] const unsigned char* in, [[maybe_unused]] std::size_t inSize,
+                                std::vector<unsigned char>& out, std::size_t maxOut) {
+    out.resize(maxOut);
+    switch (sb.compression) {
+    #ifdef SQUASHFS_HAVE_ZLIB
+        case 1: {
+            uLongf outSize = static_cast<uLongf>(maxOut);
+            if (uncompress(out.data(), &outSize, in, static_cast<uLong>(inSize)) != Z_OK) {
+                break;
+            }
+            out.resize(outSize);
+            return true;
+        }
+    #endif
+    #ifdef SQUASHFS_HAVE_LZMA
+        case 4: {
+            std::uint64_t memlimit = UINT64_MAX;
+            size_t inPos = 0;
+            size_t outPos = 0;
+            if (lzma_stream_buffer_decode(&memlimit, 0, nullptr, in, &inPos, inSize,
+                                          out.data(), &outPos, maxOut) != LZMA_OK) {
+                break;
+            }
+            out.resize(outPos);
+            return true;
+        }
+    #endif
+    #ifdef SQUASHFS_HAVE_LZ4
+        case 5: {
+            const int result = LZ4_decompress_safe(reinterpret_cast<const char*>(in), reinterpret_cast<char*>(out.data()),
+                                                   static_cast<int>(inSize), static_cast<int>(maxOut));
+            if (result < 0) {
+                break;
+            }
+            out.resize(static_cast<std::size_t>(result));
+            return true;
+        }
+    #endif
+    #ifdef SQUASHFS_HAVE_ZSTD
+        case 6: {
+            const size_t result = ZSTD_decompress(out.data(), maxOut, in, inSize);
+            if (ZSTD_isError(result)) {
+                break;
+            }
+            out.resize(result);
+            return true;
+        }
+    #endif
+        default:
+            last_error = "No " + compressionName() + " decompressor in this build";
+            out.clear();
+            return false;
+    }
+    last_error = "Corrupt " + compressionName() + " block";
+    out.clear();
+    return false;
+}
+
+bool SquashFSReader::readBytes(std::uint64_t offset, std::size_t length, std::vector<unsigned char>& out) {
+    std::vector<char> raw;
+    if (!reader.readRange(image_path, offset, length, raw)) {
+        last_error = reader.getLastError();
+        return false;
+    }
+    out.assign(raw.begin(), raw.end());
+    return true;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ISOReader;
+
+// Read-only SquashFS 4.0 parser that works on a filesystem image inside an
+// ISO through ISOReader::readRange. Only the superblock is read on open();
+// the inode and directory tables are decoded on demand, so previewing a
+// multi-GB image costs a handful of small reads.
+class SquashFSReader {
+public:
+    struct Superblock {
+        std::uint32_t inodeCount;
+        std::uint32_t modificationTime;
+        std::uint32_t blockSize;
+        std::uint32_t fragmentCount;
+        std::uint16_t compression;
+        std::uint16_t flags;
+        std::uint16_t versionMajor;
+        std::uint16_t versionMinor;
+        std::uint64_t rootInode;
+        std::uint64_t bytesUsed;
+        std::uint64_t inodeTableStart;
+        std::uint64_t directoryTableStart;
+        std::uint64_t fragmentTableStart;
+    };
+
+    struct DirEntry {
+        std::string name;
+        std::uint64_t inode;   // Inode reference: metadata block << 16 | offset
+        std::uint16_t type;    // Basic inode type
+        bool directory() const { return type == DIRECTORY; }
+    };
+
+    // Basic inode types
+    static constexpr std::uint16_t DIRECTORY = 1;
+    static constexpr std::uint16_t FILE = 2;
+    static constexpr std::uint16_t SYMLINK = 3;
+
+    SquashFSReader(ISOReader& reader, const std::string& imagePath);
+
+    bool open();
+    const Superblock& superblock() const { return sb; }
+
+    // "gzip", "xz", ... as mksquashfs names them
+    std::string compressionName() const;
+    // False when this build can't decompress the image's metadata
+    bool canDecompress() const;
+
+    bool listDirectory(const std::string& path, std::vector<DirEntry>& entries);
+    // Follows symlinks; refuses files larger than maxSize
+    bool readFile(const std::string& path, std::vector<char>& content, std::size_t maxSize = 1024 * 1024);
+
+    std::string getLastError() const { return last_error; }
+
+private:
+    struct Inode {
+        std::uint16_t type;
+        // Directories
+        std::uint32_t dirBlock;
+        std::uint16_t dirOffset;
+        std::uint32_t dirSize;
+        // Regular files
+        std::uint64_t blocksStart;
+        std::uint64_t fileSize;
+        std::uint32_t fragment;
+        std::uint32_t fragmentOffset;
+        std::vector<std::uint32_t> blockSizes;
+        // Symlinks
+        std::string target;
+    };
+
+    bool readInode(std::uint64_t ref, Inode& inode);
+    bool readDirectory(const Inode& dir, std::vector<DirEntry>& entries);
+    bool resolve(const std::string& path, Inode& inode, int depth = 0);
+    bool readMetadata(std::uint64_t tableStart, std::uint64_t block, std::uint16_t offset,
+                      std::size_t length, std::vector<unsigned char>& out);
+    bool metadataBlock(std::uint64_t position, const std::vector<unsigned char>*& data, std::uint64_t& next);
+    bool readDataBlock(std::uint64_t position, std::uint32_t sizeField, std::vector<unsigned char>& out);
+    bool decompress(const unsigned char* in, std::size_t inSize, std::vector<unsigned char>& out, std::size_t maxOut);
+    bool readBytes(std::uint64_t offset, std::size_t length, std::vector<unsigned char>& out);
+
+    struct CachedBlock {
+        std::vector<unsigned char> data;
+        std::uint64_t next;
+    };
+
+    ISOReader& reader;
+    std::string image_path;
+    Superblock sb;
+    bool opened;
+    std::string last_error;
+    std::unordered_map<std::uint64_t, CachedBlock> metadata_cache;
+
+    static constexpr std::size_t METADATA_SIZE = 8192;
+    static constexpr int MAX_SYMLINK_DEPTH = 8;
+};
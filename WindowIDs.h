@@ -22,6 +22,8 @@ enum
     // --- SecondWindow Button IDs ---
     ID_NEXT_BUTTON,    // Button in SecondWindow to trigger "Create ISO"
     ID_MONGODB_BUTTON, // Button in SecondWindow top bar to show MongoDB panel
+    ID_BUILD_PROFILE,  // Choice next to "Create ISO" picking the squashfs build profile
+    ID_TIMELINE_BUTTON, // Button in SecondWindow's bottom bar showing the build timeline
 
     // --- MongoDBPanel Communication ID ---
     // ID used for the event sent *from* MongoDBPanel *to* SecondWindow when its internal close button is clicked.
@@ -45,7 +47,12 @@ enum
     // --- FlatpakStore Timer IDs (from FlatpakStore.h) ---
     ID_BATCH_TIMER = 4001,
     ID_LAYOUT_TIMER,
-    ID_SHOW_INSTALLED_BUTTON // Button within FlatpakStore
+    ID_SHOW_INSTALLED_BUTTON, // Button within FlatpakStore
+
+    // --- DockerExecThread and BuildPipeline IDs, carried by DOCKER_EXEC_* events ---
+    ID_BACKEND_EXEC = 5001,    // SecondWindow running the build pipeline
+    ID_DESKTOP_INSTALL_EXEC,   // DesktopTab installing a desktop environment
+    ID_CREATE_ISO_EXEC         // SecondWindow running create_iso.sh
 
     // Add other IDs...
 };
@@ -0,0 +1,361 @@
+#include "SyntheticIso.h"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <set>
+#include <system_error>
+
+namespace {
+
+constexpr std::uint32_t SECTOR_SIZE = 2048;
+constexpr std::uint32_t PVD_LBA = 16;
+constexpr std::uint32_t PATH_TABLE_LBA = 18;
+constexpr std::uint8_t FLAG_DIRECTORY = 0x02;
+
+// Bump when the generated layout changes so cached images are rebuilt
+constexpr int IMAGE_VERSION = 1;
+
+struct Directory {
+    std::set<std::string> subdirectories;
+    std::vector<std::size_t> files;
+    std::string parent;
+    std::uint16_t number = 0;
+    std::uint32_t lba = 0;
+    std::uint32_t size = 0;
+};
+
+std::uint32_t sectorsFor(std::uint64_t size) {
+    return static_cast<std::uint32_t>((size + SECTOR_SIZE - 1) / SECTOR_SIZE);
+}
+
+void putLe16(std::uint8_t* p, std::uint16_t value) {
+    p[0] = static_cast<std::uint8_t>(value);
+    p[1] = static_cast<std::uint8_t>(value >> 8);
+}
+
+void putLe32(std::uint8_t* p, std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        p[i] = static_cast<std::uint8_t>(value >> (8 * i));
+    }
+}
+
+void putBe32(std::uint8_t* p, std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        p[3 - i] = static_cast<std::uint8_t>(value >> (8 * i));
+    }
+}
+
+// Both-byte-order fields (ECMA-119 7.2.3 and 7.3.3)
+void putBoth16(std::uint8_t* p, std::uint16_t value) {
+    putLe16(p, value);
+    p[2] = static_cast<std::uint8_t>(value >> 8);
+    p[3] = static_cast<std::uint8_t>(value);
+}
+
+void putBoth32(std::uint8_t* p, std::uint32_t value) {
+    putLe32(p, value);
+    putBe32(p + 4, value);
+}
+
+void putText(std::uint8_t* p, std::size_t length, const std::string& text) {
+    std::memset(p, ' ', length);
+    std::memcpy(p, text.data(), std::min(length, text.size()));
+}
+
+std::size_t recordLength(std::size_t nameLength) {
+    return 33 + nameLength + ((nameLength & 1) ? 0 : 1);
+}
+
+void putRecord(std::uint8_t* p, std::uint32_t lba, std::uint32_t size, std::uint8_t flags,
+               const std::string& name) {
+    p[0] = static_cast<std::uint8_t>(recordLength(name.size()));
+    putBoth32(p + 2, lba);
+    putBoth32(p + 10, size);
+    p[25] = flags;
+    putBoth16(p + 28, 1);
+    p[32] = static_cast<std::uint8_t>(name.size());
+    std::memcpy(p + 33, name.data(), name.size());
+}
+
+std::string parentOf(const std::string& path) {
+    size_t slash = path.rfind('/');
+    return slash == std::string::npos ? std::string() : path.substr(0, slash);
+}
+
+std::string nameOf(const std::string& path) {
+    size_t slash = path.rfind('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+void addLiveLayout(SyntheticIsoBuilder& builder, std::uint64_t squashfsSize) {
+    builder.addFile(".disk/info", "Ubuntu 24.04 LTS \"Noble Numbat\" - Release amd64");
+    builder.addFile("boot/grub/grub.cfg",
+                    "menuentry \"Try or Install Ubuntu\" {\n"
+                    "\tlinux /casper/vmlinuz boot=casper quiet splash ---\n"
+                    "\tinitrd /casper/initrd\n}\n");
+    builder.addFile("boot/grub/grubenv", "# GRUB Environment Block\n" + std::string(1000, '#'));
+    builder.addFile("etc/os-release", syntheticOsRelease());
+    builder.addFile("casper/vmlinuz", 1024 * 1024);
+    builder.addFile("casper/initrd", 1024 * 1024);
+    builder.addFile("casper/filesystem.squashfs", squashfsSize);
+    for (int i = 0; i < 200; ++i) {
+        std::string package = "lib" + std::to_string(i);
+        builder.addFile("pool/main/l/" + package + "/" + package + "_1.0_amd64.deb", 8 * 1024);
+    }
+}
+
+bool generate(SyntheticImage image, const std::string& path) {
+    SyntheticIsoBuilder builder;
+    switch (image) {
+    case SyntheticImage::Small:
+        addLiveLayout(builder, 6ull * 1024 * 1024);
+        break;
+    case SyntheticImage::Large:
+        addLiveLayout(builder, 1024ull * 1024 * 1024);
+        break;
+    case SyntheticImage::ManyFiles:
+        addLiveLayout(builder, 1024 * 1024);
+        for (int dir = 0; dir < 100; ++dir) {
+            for (int file = 0; file < 1000; ++file) {
+                std::string name = "data/d" + std::to_string(dir) + "/f" + std::to_string(file) + ".txt";
+                builder.addFile(name, "synthetic file " + name + "\n");
+            }
+        }
+        break;
+    }
+    return builder.write(path);
+}
+
+} // namespace
+
+void SyntheticIsoBuilder::addFile(const std::string& path, const std::string& content) {
+    files.push_back({path, content, content.size()});
+}
+
+void SyntheticIsoBuilder::addFile(const std::string& path, std::uint64_t size) {
+    files.push_back({path, std::string(), size});
+}
+
+bool SyntheticIsoBuilder::write(const std::string& isoPath) {
+    std::map<std::string, Directory> directories;
+    directories[std::string()];
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        std::string dir = parentOf(files[i].path);
+        directories[dir].files.push_back(i);
+        while (!dir.empty()) {
+            std::string parent = parentOf(dir);
+            directories[dir].parent = parent;
+            directories[parent].subdirectories.insert(dir);
+            dir = parent;
+        }
+    }
+
+    // Path table order: breadth-first, so every parent precedes its children
+    std::vector<std::string> order;
+    std::deque<std::string> pending{std::string()};
+    while (!pending.empty()) {
+        std::string dir = pending.front();
+        pending.pop_front();
+        directories[dir].number = static_cast<std::uint16_t>(order.size() + 1);
+        order.push_back(dir);
+        for (const auto& sub : directories[dir].subdirectories) {
+            pending.push_back(sub);
+        }
+    }
+
+    std::uint32_t pathTableSize = 0;
+    for (const auto& dir : order) {
+        std::size_t idLength = dir.empty() ? 1 : nameOf(dir).size();
+        pathTableSize += static_cast<std::uint32_t>(8 + idLength + (idLength & 1));
+    }
+
+    // Directory extents follow the path table, file data follows them.
+    // Records never straddle a sector boundary.
+    std::uint32_t lba = PATH_TABLE_LBA + sectorsFor(pathTableSize);
+    for (const auto& dir : order) {
+        Directory& entry = directories[dir];
+        std::uint32_t pos = 68;  // "." and ".."
+        auto place = [&pos](std::size_t length) {
+            if (pos % SECTOR_SIZE + length > SECTOR_SIZE) {
+                pos = (pos / SECTOR_SIZE + 1) * SECTOR_SIZE;
+            }
+            pos += static_cast<std::uint32_t>(length);
+        };
+        for (const auto& sub : entry.subdirectories) {
+            place(recordLength(nameOf(sub).size()));
+        }
+        for (std::size_t file : entry.files) {
+            place(recordLength(nameOf(files[file].path).size()));
+        }
+        entry.lba = lba;
+        entry.size = sectorsFor(pos) * SECTOR_SIZE;
+        lba += sectorsFor(pos);
+    }
+    const std::uint32_t metadataSectors = lba;
+
+    std::vector<std::uint32_t> fileLba(files.size());
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        if (files[i].size > 0xFFFFFFFFull) {
+            last_error = "File too large for a single extent: " + files[i].path;
+            return false;
+        }
+        fileLba[i] = lba;
+        lba += sectorsFor(files[i].size);
+    }
+    const std::uint32_t totalSectors = lba;
+
+    std::vector<std::uint8_t> metadata(static_cast<std::size_t>(metadataSectors) * SECTOR_SIZE);
+    const Directory& root = directories[std::string()];
+
+    std::uint8_t* pvd = metadata.data() + PVD_LBA * SECTOR_SIZE;
+    pvd[0] = 1;
+    std::memcpy(pvd + 1, "CD001", 5);
+    pvd[6] = 1;
+    putText(pvd + 8, 32, "LINUX");
+    putText(pvd + 40, 32, "SYNTHETIC_BENCH");
+    putBoth32(pvd + 80, totalSectors);
+    putBoth16(pvd + 120, 1);
+    putBoth16(pvd + 124, 1);
+    putBoth16(pvd + 128, SECTOR_SIZE);
+    putBoth32(pvd + 132, pathTableSize);
+    putLe32(pvd + 140, PATH_TABLE_LBA);
+    putRecord(pvd + 156, root.lba, root.size, FLAG_DIRECTORY, std::string(1, '\0'));
+    pvd[881] = 1;
+
+    std::uint8_t* terminator = metadata.data() + (PVD_LBA + 1) * SECTOR_SIZE;
+    terminator[0] = 255;
+    std::memcpy(terminator + 1, "CD001", 5);
+    terminator[6] = 1;
+
+    std::uint8_t* table = metadata.data() + PATH_TABLE_LBA * SECTOR_SIZE;
+    for (const auto& dir : order) {
+        const Directory& entry = directories[dir];
+        std::string id = dir.empty() ? std::string(1, '\0') : nameOf(dir);
+        table[0] = static_cast<std::uint8_t>(id.size());
+        putLe32(table + 2, entry.lba);
+        putLe16(table + 6, dir.empty() ? 1 : directories[entry.parent].number);
+        std::memcpy(table + 8, id.data(), id.size());
+        table += 8 + id.size() + (id.size() & 1);
+    }
+
+    for (const auto& dir : order) {
+        const Directory& entry = directories[dir];
+        const Directory& parent = dir.empty() ? entry : directories[entry.parent];
+        std::uint8_t* extent = metadata.data() + static_cast<std::size_t>(entry.lba) * SECTOR_SIZE;
+        std::uint32_t pos = 0;
+        auto emit = [&](std::uint32_t recordLba, std::uint32_t size, std::uint8_t flags, const std::string& name) {
+            std::size_t length = recordLength(name.size());
+            if (pos % SECTOR_SIZE + length > SECTOR_SIZE) {
+                pos = (pos / SECTOR_SIZE + 1) * SECTOR_SIZE;
+            }
+            putRecord(extent + pos, recordLba, size, flags, name);
+            pos += static_cast<std::uint32_t>(length);
+        };
+        emit(entry.lba, entry.size, FLAG_DIRECTORY, std::string(1, '\0'));
+        emit(parent.lba, parent.size, FLAG_DIRECTORY, std::string(1, '\1'));
+        for (const auto& sub : entry.subdirectories) {
+            const Directory& child = directories[sub];
+            emit(child.lba, child.size, FLAG_DIRECTORY, nameOf(sub));
+        }
+        for (std::size_t file : entry.files) {
+            emit(fileLba[file], static_cast<std::uint32_t>(files[file].size), 0, nameOf(files[file].path));
+        }
+    }
+
+    std::ofstream out(isoPath, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        last_error = "Cannot create " + isoPath;
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(metadata.data()), static_cast<std::streamsize>(metadata.size()));
+
+    // Files without content stay holes; small files are padded in place so
+    // consecutive writes don't need a seek each
+    static const char zeros[SECTOR_SIZE] = {};
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        if (files[i].content.empty()) {
+            continue;
+        }
+        const std::uint64_t offset = static_cast<std::uint64_t>(fileLba[i]) * SECTOR_SIZE;
+        if (static_cast<std::uint64_t>(out.tellp()) != offset) {
+            out.seekp(static_cast<std::streamoff>(offset));
+        }
+        out.write(files[i].content.data(), static_cast<std::streamsize>(files[i].content.size()));
+        std::size_t padding = (SECTOR_SIZE - files[i].content.size() % SECTOR_SIZE) % SECTOR_SIZE;
+        out.write(zeros, static_cast<std::streamsize>(padding));
+    }
+    out.close();
+    if (!out) {
+        last_error = "Failed writing " + isoPath;
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::resize_file(isoPath, static_cast<std::uintmax_t>(totalSectors) * SECTOR_SIZE, ec);
+    if (ec) {
+        last_error = "Failed sizing " + isoPath + ": " + ec.message();
+        return false;
+    }
+    return true;
+}
+
+const char* syntheticImageName(SyntheticImage image) {
+    switch (image) {
+    case SyntheticImage::Small:
+        return "10MB";
+    case SyntheticImage::Large:
+        return "1GB";
+    case SyntheticImage::ManyFiles:
+        return "100k_files";
+    }
+    return "unknown";
+}
+
+const std::string& syntheticImagePath(SyntheticImage image) {
+    static std::map<SyntheticImage, std::string> paths;
+    auto it = paths.find(image);
+    if (it != paths.end()) {
+        return it->second;
+    }
+
+    std::error_code ec;
+    std::filesystem::path dir = std::filesystem::temp_directory_path(ec) / "linuxisopro-bench";
+    std::filesystem::create_directories(dir, ec);
+    std::filesystem::path path =
+        dir / (std::string(syntheticImageName(image)) + "-v" + std::to_string(IMAGE_VERSION) + ".iso");
+
+    std::string result;
+    if (std::filesystem::exists(path, ec)) {
+        result = path.string();
+    } else {
+        std::filesystem::path partial = path;
+        partial += ".part";
+        if (generate(image, partial.string())) {
+            std::filesystem::rename(partial, path, ec);
+            if (!ec) {
+                result = path.string();
+            }
+        }
+        std::filesystem::remove(partial, ec);
+    }
+    return paths.emplace(image, result).first->second;
+}
+
+const std::string& syntheticOsRelease() {
+    static const std::string content =
+        "PRETTY_NAME=\"Ubuntu 24.04 LTS\"\n"
+        "NAME=\"Ubuntu\"\n"
+        "VERSION_ID=\"24.04\"\n"
+        "VERSION=\"24.04 LTS (Noble Numbat)\"\n"
+        "VERSION_CODENAME=noble\n"
+        "ID=ubuntu\n"
+        "ID_LIKE=debian\n"
+        "HOME_URL=\"https://www.ubuntu.com/\"\n"
+        "SUPPORT_URL=\"https://help.ubuntu.com/\"\n"
+        "BUG_REPORT_URL=\"https://bugs.launchpad.net/ubuntu/\"\n"
+        "UBUNTU_CODENAME=noble\n";
+    return content;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Writes plain ISO9660 images (primary descriptor, L path table, no Rock
+// Ridge or Joliet) for the benchmarks. Names are stored as given, so the
+// native parser reports them unchanged. Files without content are left as
+// holes, which keeps the large images cheap to create.
+class SyntheticIsoBuilder {
+public:
+    void addFile(const std::string& path, const std::string& content);
+    void addFile(const std::string& path, std::uint64_t size);
+
+    bool write(const std::string& isoPath);
+    std::string getLastError() const { return last_error; }
+
+private:
+    struct File {
+        std::string path;
+        std::string content;
+        std::uint64_t size;
+    };
+
+    std::vector<File> files;
+    std::string last_error;
+};
+
+// Images shared by all benchmarks of a run
+enum class SyntheticImage {
+    Small,       // ~10 MB: live image layout with a small squashfs
+    Large,       // ~1 GB: the same layout with a 1 GiB squashfs
+    ManyFiles,   // 100k small files in 100 directories
+};
+
+const char* syntheticImageName(SyntheticImage image);
+
+// Path of the image, generated in the temp directory on first use and
+// reused by later runs. Empty if it could not be written.
+const std::string& syntheticImagePath(SyntheticImage image);
+
+// Release text written to etc/os-release in every image
+const std::string& syntheticOsRelease();
@@ -0,0 +1,203 @@
+#include <benchmark/benchmark.h>
+#include <yaml-cpp/yaml.h>
+#include "SyntheticIso.h"
+#include "ISOReader.h"
+#include "ISOInspector.h"
+#include "DistroDetector.h"
+#include <algorithm>
+
+// Microbenchmarks for the ISO indexing and detection paths. Each image
+// benchmark takes the image as its argument (0 = 10 MB, 1 = 1 GB,
+// 2 = 100k files); the images are generated on first use.
+
+namespace {
+
+const YAML::Node& config() {
+    static const YAML::Node node = YAML::LoadFile(LINUXISOPRO_CONFIG);
+    return node;
+}
+
+// Same options MainFrame::GetInspectorOptions builds
+ISOInspector::Options inspectorOptions() {
+    ISOInspector::Options options;
+    for (const auto& path : config()["grubenv_paths"]) {
+        options.grubenvPaths.push_back(path.as<std::string>());
+    }
+    for (const auto& path : config()["release_paths"]) {
+        options.releasePaths.push_back(path.as<std::string>());
+    }
+    return options;
+}
+
+bool openImage(benchmark::State& state, ISOReader& reader) {
+    if (reader.open()) {
+        return true;
+    }
+    state.SkipWithError(reader.getLastError().c_str());
+    return false;
+}
+
+// Resolves the image for the argument, marking the run as failed if it
+// couldn't be generated
+const std::string* imageFor(benchmark::State& state) {
+    const auto image = static_cast<SyntheticImage>(state.range(0));
+    state.SetLabel(syntheticImageName(image));
+    const std::string& path = syntheticImagePath(image);
+    if (path.empty()) {
+        state.SkipWithError("Could not generate the synthetic image");
+        return nullptr;
+    }
+    return &path;
+}
+
+void allImages(benchmark::internal::Benchmark* bench) {
+    bench->ArgName("image")
+        ->Arg(static_cast<int>(SyntheticImage::Small))
+        ->Arg(static_cast<int>(SyntheticImage::Large))
+        ->Arg(static_cast<int>(SyntheticImage::ManyFiles))
+        ->Unit(benchmark::kMicrosecond);
+}
+
+// open() maps the image and builds the directory index
+void BM_ISOReaderOpen(benchmark::State& state) {
+    const std::string* path = imageFor(state);
+    if (!path) return;
+    for (auto _ : state) {
+        ISOReader reader(*path);
+        if (!openImage(state, reader)) break;
+        benchmark::DoNotOptimize(reader.entries().size());
+    }
+}
+BENCHMARK(BM_ISOReaderOpen)->Apply(allImages);
+
+void BM_ISOReaderListFiles(benchmark::State& state) {
+    const std::string* path = imageFor(state);
+    if (!path) return;
+    ISOReader reader(*path);
+    if (!openImage(state, reader)) return;
+    size_t files = 0;
+    for (auto _ : state) {
+        auto list = reader.listFiles();
+        files = list.size();
+        benchmark::DoNotOptimize(list.data());
+    }
+    state.counters["files"] = static_cast<double>(files);
+}
+BENCHMARK(BM_ISOReaderListFiles)->Apply(allImages);
+
+void BM_ISOReaderReadFileHit(benchmark::State& state) {
+    const std::string* path = imageFor(state);
+    if (!path) return;
+    ISOReader reader(*path);
+    if (!openImage(state, reader)) return;
+    std::vector<char> content;
+    for (auto _ : state) {
+        if (!reader.readFile("etc/os-release", content)) {
+            state.SkipWithError(reader.getLastError().c_str());
+            break;
+        }
+        benchmark::DoNotOptimize(content.data());
+    }
+}
+BENCHMARK(BM_ISOReaderReadFileHit)->Apply(allImages);
+
+void BM_ISOReaderReadFileMiss(benchmark::State& state) {
+    const std::string* path = imageFor(state);
+    if (!path) return;
+    ISOReader reader(*path);
+    if (!openImage(state, reader)) return;
+    std::vector<char> content;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(reader.readFile("etc/missing-release", content));
+    }
+}
+BENCHMARK(BM_ISOReaderReadFileMiss)->Apply(allImages);
+
+void BM_NormalizePath(benchmark::State& state) {
+    const std::string paths[] = {
+        "etc/os-release",
+        "boot\\grub\\grubenv",
+        "pool/main/l/lib42/lib42_1.0_amd64.deb",
+        "casper\\filesystem.squashfs",
+    };
+    for (auto _ : state) {
+        for (const auto& path : paths) {
+            benchmark::DoNotOptimize(ISOReader::normalizePath(path));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * 4);
+}
+BENCHMARK(BM_NormalizePath);
+
+// Arg 0 matches the first pattern, 1 the last one, 2 nothing at all
+void BM_DetectDistribution(benchmark::State& state) {
+    static const std::string releases[] = {
+        syntheticOsRelease(),
+        "NAME=\"Linux Mint\"\nVERSION=\"21.3 (Virginia)\"\nID=linuxmint\nPRETTY_NAME=\"Linux Mint 21.3\"\n",
+        "NAME=\"Custom OS\"\nVERSION=\"1.0\"\nID=custom\nPRETTY_NAME=\"Custom OS 1.0\"\n",
+    };
+    const DistroDetector detector = DistroDetector::fromConfig(config());
+    const std::string& release = releases[state.range(0)];
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(detector.detect(release));
+    }
+}
+BENCHMARK(BM_DetectDistribution)->ArgName("release")->DenseRange(0, 2);
+
+// Detection cost as the signature table grows with derivatives, for a
+// release that matches no entry (the worst case)
+void BM_DetectDistributionSignatures(benchmark::State& state) {
+    std::vector<DistroDetector::Distribution> distributions =
+        DistroDetector::fromConfig(config()).distributions();
+    for (int i = 0; static_cast<int>(distributions.size()) < state.range(0); ++i) {
+        distributions.push_back({"derivative-" + std::to_string(i) + " linux", "Derivative " + std::to_string(i)});
+    }
+    const DistroDetector detector(std::move(distributions));
+    const std::string release = "NAME=\"Custom OS\"\nVERSION=\"1.0\"\nID=custom\nPRETTY_NAME=\"Custom OS 1.0\"\n";
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(detector.detect(release));
+    }
+}
+BENCHMARK(BM_DetectDistributionSignatures)->ArgName("signatures")->RangeMultiplier(4)->Range(16, 1024);
+
+// The grubenv step of Detect, on a 1 KiB environment block padded with '#'
+// the way GRUB writes it
+void BM_DetectFromGrubEnv(benchmark::State& state) {
+    std::string grubenv = "# GRUB Environment Block\n" + syntheticOsRelease();
+    grubenv.resize(std::max<size_t>(grubenv.size(), 1024), '#');
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(DistroDetector::nameFromOsRelease(grubenv));
+    }
+}
+BENCHMARK(BM_DetectFromGrubEnv);
+
+// What Detect does for an image not in the profile cache: inspect, then
+// grubenv, then the first release file
+void BM_DetectFlow(benchmark::State& state) {
+    const std::string* path = imageFor(state);
+    if (!path) return;
+    const DistroDetector detector = DistroDetector::fromConfig(config());
+    const ISOInspector::Options options = inspectorOptions();
+    for (auto _ : state) {
+        ISOInspector inspector(options);
+        auto profile = inspector.inspect(*path);
+        if (!profile) {
+            state.SkipWithError(inspector.getLastError().c_str());
+            break;
+        }
+        std::string distribution;
+        for (const auto& grubenv : profile->grubEnvFiles()) {
+            distribution = DistroDetector::nameFromOsRelease(grubenv.content);
+            if (!distribution.empty()) break;
+        }
+        if (distribution.empty() && !profile->releaseFiles().empty()) {
+            distribution = detector.detect(profile->releaseFiles().front().content);
+        }
+        benchmark::DoNotOptimize(distribution);
+    }
+}
+BENCHMARK(BM_DetectFlow)->Apply(allImages);
+
+} // namespace
+
+BENCHMARK_MAIN();